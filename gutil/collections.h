@@ -16,6 +16,7 @@
 #define GUTIL_COLLECTIONS_H
 
 #include <string>
+#include <utility>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -30,7 +31,7 @@ namespace gutil {
 // Returns a const copy of the value associated with a given key if it exists,
 // or a status failure if it does not.
 //
-// WARNING: prefer FindOrNull if the value can be large to avoid the copy.
+// WARNING: prefer FindPtrOrStatus if the value can be large to avoid the copy.
 template <typename M>
 absl::StatusOr<const typename M::mapped_type> FindOrStatus(
     const M &m, const typename M::key_type &k) {
@@ -49,6 +50,17 @@ absl::StatusOr<typename M::mapped_type *> FindPtrOrStatus(
   return absl::NotFoundError("Key not found");
 }
 
+// Returns a const non-null pointer of the value associated with a given key if
+// it exists, or a status failure if it does not. Typically used as
+//   ASSIGN_OR_RETURN(const auto *value, FindPtrOrStatus(m, k), _ << "...");
+template <typename M>
+absl::StatusOr<const typename M::mapped_type *> FindPtrOrStatus(
+    const M &m, const typename M::key_type &k) {
+  auto it = m.find(k);
+  if (it != m.end()) return &it->second;
+  return absl::NotFoundError("Key not found");
+}
+
 // Returns a const pointer of the value associated with a given key if it
 // exists, or a nullptr if it does not.
 template <typename M>
@@ -122,6 +134,18 @@ absl::Status InsertIfUnique(google::protobuf::Map<K, V> *map, K key,
   return absl::OkStatus();
 }
 
+// Same as above, but moves `val` into the map instead of copying it.
+template <typename K, typename V>
+absl::Status InsertIfUnique(google::protobuf::Map<K, V> *map, K key, V &&val,
+                            const std::string &error_message) {
+  if (map->find(key) != map->end()) {
+    return absl::Status(absl::StatusCode::kInvalidArgument, error_message);
+  }
+  (*map)[key] = std::move(val);
+
+  return absl::OkStatus();
+}
+
 }  // namespace gutil
 
 #endif  // GUTIL_COLLECTIONS_H
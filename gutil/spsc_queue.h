@@ -0,0 +1,81 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GUTIL_SPSC_QUEUE_H
+#define GUTIL_SPSC_QUEUE_H
+
+#include <stddef.h>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace gutil {
+
+// A bounded, lock-free queue for exactly one producer thread and one consumer
+// thread. TryPush must only be called by the producer, and TryPop only by the
+// consumer.
+template <typename T>
+class SpscQueue {
+ public:
+  // Creates a queue holding up to `capacity` elements, rounded up to a power
+  // of two.
+  explicit SpscQueue(size_t capacity)
+      : slots_(RoundUpToPowerOfTwo(capacity)), mask_(slots_.size() - 1) {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  size_t capacity() const { return slots_.size(); }
+
+  // Appends `value` and returns true, or returns false and leaves `value`
+  // unchanged if the queue is full.
+  bool TryPush(T&& value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Moves the oldest element to `value` and returns true, or returns false if
+  // the queue is empty.
+  bool TryPop(T* value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) return false;
+    *value = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t power = 1;
+    while (power < n) power *= 2;
+    return power;
+  }
+
+  std::vector<T> slots_;
+  const size_t mask_;
+  // The producer and consumer positions are on separate cache lines, so that
+  // the two threads do not contend for the same line.
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+}  // namespace gutil
+
+#endif  // GUTIL_SPSC_QUEUE_H
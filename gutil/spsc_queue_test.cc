@@ -0,0 +1,83 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gutil/spsc_queue.h"
+
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace gutil {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(SpscQueue, RoundsCapacityUpToPowerOfTwo) {
+  EXPECT_EQ(SpscQueue<int>(1).capacity(), 1);
+  EXPECT_EQ(SpscQueue<int>(5).capacity(), 8);
+  EXPECT_EQ(SpscQueue<int>(64).capacity(), 64);
+}
+
+TEST(SpscQueue, PopsInPushOrderUntilEmpty) {
+  SpscQueue<int> queue(4);
+  std::vector<int> popped;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 3; ++i) EXPECT_TRUE(queue.TryPush(round * 3 + i));
+    int value;
+    while (queue.TryPop(&value)) popped.push_back(value);
+  }
+  EXPECT_THAT(popped, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8));
+}
+
+TEST(SpscQueue, RejectsPushWhenFull) {
+  SpscQueue<std::unique_ptr<int>> queue(2);
+  EXPECT_TRUE(queue.TryPush(absl::make_unique<int>(1)));
+  EXPECT_TRUE(queue.TryPush(absl::make_unique<int>(2)));
+  auto rejected = absl::make_unique<int>(3);
+  EXPECT_FALSE(queue.TryPush(std::move(rejected)));
+  ASSERT_NE(rejected, nullptr);
+  std::unique_ptr<int> value;
+  ASSERT_TRUE(queue.TryPop(&value));
+  EXPECT_EQ(*value, 1);
+  EXPECT_TRUE(queue.TryPush(std::move(rejected)));
+}
+
+TEST(SpscQueue, TransfersAllElementsBetweenThreads) {
+  constexpr int kNumElements = 100000;
+  SpscQueue<int> queue(16);
+  std::thread producer([&queue] {
+    for (int i = 0; i < kNumElements; ++i) {
+      while (!queue.TryPush(int{i})) std::this_thread::yield();
+    }
+  });
+  std::vector<int> popped;
+  popped.reserve(kNumElements);
+  while (popped.size() < kNumElements) {
+    int value;
+    if (queue.TryPop(&value)) {
+      popped.push_back(value);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  for (int i = 0; i < kNumElements; ++i) ASSERT_EQ(popped[i], i);
+}
+
+}  // namespace
+}  // namespace gutil
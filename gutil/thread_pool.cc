@@ -0,0 +1,122 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gutil/thread_pool.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace gutil {
+
+ThreadPool::ThreadPool(int num_threads) {
+  threads_.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this] { Work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  for (auto& thread : threads_) thread.join();
+}
+
+void ThreadPool::Schedule(std::function<void()> fn) {
+  absl::MutexLock lock(&mutex_);
+  queue_.push_back(std::move(fn));
+}
+
+bool ThreadPool::HasWorkOrIsStopping() {
+  return stopping_ || !queue_.empty();
+}
+
+void ThreadPool::Work() {
+  while (true) {
+    std::function<void()> fn;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &ThreadPool::HasWorkOrIsStopping));
+      if (queue_.empty()) return;
+      fn = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    fn();
+  }
+}
+
+namespace {
+
+// The state shared between the calling thread of ParallelFor and the
+// functions it schedules. Scheduled functions may only start running after
+// ParallelFor returned, so they own the state jointly with the caller.
+struct ParallelForState {
+  ParallelForState(int n, int num_chunks, const std::function<void(int)>* fn)
+      : n(n), num_chunks(num_chunks), fn(fn) {}
+
+  // Runs chunks until there are none left.
+  void Work() {
+    for (int chunk = next_chunk++; chunk < num_chunks; chunk = next_chunk++) {
+      const int begin = int64_t{chunk} * n / num_chunks;
+      const int end = int64_t{chunk + 1} * n / num_chunks;
+      for (int i = begin; i < end; ++i) (*fn)(i);
+      absl::MutexLock lock(&mutex);
+      ++finished_chunks;
+    }
+  }
+
+  bool AllChunksFinished() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+    return finished_chunks == num_chunks;
+  }
+
+  const int n;
+  const int num_chunks;
+  // Only valid while there are unfinished chunks.
+  const std::function<void(int)>* const fn;
+  std::atomic<int> next_chunk{0};
+  absl::Mutex mutex;
+  int finished_chunks ABSL_GUARDED_BY(mutex) = 0;
+};
+
+// Number of chunks per thread, to balance the load when calls take different
+// amounts of time.
+constexpr int kChunksPerThread = 4;
+
+}  // namespace
+
+void ParallelFor(ThreadPool* pool, int n, const std::function<void(int)>& fn) {
+  if (pool == nullptr || pool->num_threads() == 0 || n <= 1) {
+    for (int i = 0; i < n; ++i) fn(i);
+    return;
+  }
+  const int num_chunks =
+      std::min(n, kChunksPerThread * (pool->num_threads() + 1));
+  auto state = std::make_shared<ParallelForState>(n, num_chunks, &fn);
+  const int num_helpers = std::min(pool->num_threads(), num_chunks - 1);
+  for (int i = 0; i < num_helpers; ++i) {
+    pool->Schedule([state] { state->Work(); });
+  }
+  state->Work();
+
+  absl::MutexLock lock(&state->mutex);
+  state->mutex.Await(
+      absl::Condition(state.get(), &ParallelForState::AllChunksFinished));
+}
+
+}  // namespace gutil
@@ -0,0 +1,62 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GUTIL_THREAD_POOL_H
+#define GUTIL_THREAD_POOL_H
+
+#include <deque>
+#include <functional>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace gutil {
+
+// A fixed-size pool of threads running scheduled functions in FIFO order.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads);
+
+  // Waits for all scheduled functions to finish.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int num_threads() const { return threads_.size(); }
+
+  // Runs `fn` on one of the threads of the pool.
+  void Schedule(std::function<void()> fn);
+
+ private:
+  bool HasWorkOrIsStopping() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void Work();
+
+  absl::Mutex mutex_;
+  std::deque<std::function<void()>> queue_ ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<std::thread> threads_;
+};
+
+// Calls `fn(i)` for every i in [0, n) and returns once all calls returned.
+// Calls are made from the threads of `pool` and from the calling thread, so it
+// is safe to call ParallelFor from a thread of `pool`. If `pool` is nullptr,
+// all calls are made from the calling thread, in order.
+void ParallelFor(ThreadPool* pool, int n, const std::function<void(int)>& fn);
+
+}  // namespace gutil
+
+#endif  // GUTIL_THREAD_POOL_H
@@ -0,0 +1,62 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gutil/thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace gutil {
+namespace {
+
+using ::testing::Each;
+using ::testing::ElementsAre;
+
+TEST(ThreadPool, RunsAllScheduledFunctions) {
+  std::atomic<int> calls{0};
+  {
+    ThreadPool pool(4);
+    for (int i = 0; i < 100; ++i) pool.Schedule([&calls] { ++calls; });
+  }
+  EXPECT_EQ(calls, 100);
+}
+
+TEST(ParallelFor, CallsFunctionOnceForEveryIndex) {
+  ThreadPool pool(4);
+  for (int n : {0, 1, 2, 3, 17, 1000}) {
+    std::vector<int> calls(n, 0);
+    ParallelFor(&pool, n, [&calls](int i) { ++calls[i]; });
+    EXPECT_THAT(calls, Each(1)) << "n = " << n;
+  }
+}
+
+TEST(ParallelFor, RunsOnCallingThreadWithoutPool) {
+  std::vector<int> order;
+  ParallelFor(nullptr, 5, [&order](int i) { order.push_back(i); });
+  EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST(ParallelFor, CanBeNestedInPoolThreads) {
+  ThreadPool pool(2);
+  std::vector<std::vector<int>> calls(8, std::vector<int>(100, 0));
+  ParallelFor(&pool, calls.size(), [&](int i) {
+    ParallelFor(&pool, calls[i].size(), [&](int j) { ++calls[i][j]; });
+  });
+  for (const auto& inner_calls : calls) EXPECT_THAT(inner_calls, Each(1));
+}
+
+}  // namespace
+}  // namespace gutil
@@ -0,0 +1,224 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks for converting MAC, IPv4 and IPv6 addresses between their string
+// and byte string representations, comparing the formatters and parsers of
+// p4_pdpi/utils/ir.h with the libc functions they replace.
+//
+// Usage: address_benchmark [--benchmark_filter=...]
+
+#include <arpa/inet.h>
+#include <netinet/ether.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "benchmark/benchmark.h"
+#include "glog/logging.h"
+#include "p4_pdpi/utils/ir.h"
+
+namespace pdpi {
+namespace {
+
+// Number of distinct addresses that every benchmark cycles through.
+constexpr int kNumAddresses = 1024;
+
+// Returns kNumAddresses distinct byte strings of the given size, with runs of
+// zeros like those of real addresses.
+std::vector<std::string> MakeByteStrings(int size) {
+  std::vector<std::string> byte_strings;
+  for (int i = 0; i < kNumAddresses; ++i) {
+    std::string bytes(size, '\x00');
+    bytes[0] = 0x20;
+    bytes[1] = 0x01;
+    bytes[size - 2] = i >> 8;
+    bytes[size - 1] = i & 0xff;
+    byte_strings.push_back(bytes);
+  }
+  return byte_strings;
+}
+
+// Returns the string representations of `byte_strings`.
+std::vector<std::string> Format(
+    const std::vector<std::string>& byte_strings,
+    absl::StatusOr<std::string> (*format)(absl::string_view)) {
+  std::vector<std::string> strings;
+  for (const std::string& bytes : byte_strings) {
+    absl::StatusOr<std::string> string = format(bytes);
+    CHECK(string.ok()) << string.status();
+    strings.push_back(*string);
+  }
+  return strings;
+}
+
+// The libc based conversions, as they were implemented before.
+
+std::string LibcNormalizedByteStringToMac(const std::string& bytes) {
+  struct ether_addr byte_string;
+  for (int i = 0; i < bytes.size(); ++i) {
+    byte_string.ether_addr_octet[i] = bytes[i] & 0xFF;
+  }
+  std::vector<std::string> parts =
+      absl::StrSplit(ether_ntoa(&byte_string), ':');
+  for (std::string& part : parts) {
+    if (part.size() == 1) part = absl::StrCat("0", part);
+  }
+  return absl::StrJoin(parts, ":");
+}
+
+std::string LibcMacToNormalizedByteString(const std::string& mac) {
+  struct ether_addr* byte_string = ether_aton(mac.c_str());
+  return std::string(reinterpret_cast<const char*>(byte_string), 6);
+}
+
+std::string LibcNormalizedByteStringToIp(int family, const std::string& bytes) {
+  char result[INET6_ADDRSTRLEN];
+  CHECK(inet_ntop(family, bytes.c_str(), result, sizeof(result)) != nullptr);
+  return std::string(result);
+}
+
+std::string LibcIpToNormalizedByteString(int family, const std::string& ip) {
+  char result[kNumBytesInIpv6];
+  CHECK_EQ(inet_pton(family, ip.c_str(), result), 1);
+  return std::string(result,
+                     family == AF_INET ? kNumBytesInIpv4 : kNumBytesInIpv6);
+}
+
+// Runs `convert` on all `inputs` in turn.
+template <typename Convert>
+void RunConversions(benchmark::State& state,
+                    const std::vector<std::string>& inputs, Convert convert) {
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(convert(inputs[i]));
+    i = (i + 1) % inputs.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+const std::vector<std::string>& MacBytes() {
+  static const auto* const kBytes =
+      new std::vector<std::string>(MakeByteStrings(kNumBytesInMac));
+  return *kBytes;
+}
+const std::vector<std::string>& Ipv4Bytes() {
+  static const auto* const kBytes =
+      new std::vector<std::string>(MakeByteStrings(kNumBytesInIpv4));
+  return *kBytes;
+}
+const std::vector<std::string>& Ipv6Bytes() {
+  static const auto* const kBytes =
+      new std::vector<std::string>(MakeByteStrings(kNumBytesInIpv6));
+  return *kBytes;
+}
+const std::vector<std::string>& Macs() {
+  static const auto* const kStrings = new std::vector<std::string>(
+      Format(MacBytes(), NormalizedByteStringToMac));
+  return *kStrings;
+}
+const std::vector<std::string>& Ipv4s() {
+  static const auto* const kStrings = new std::vector<std::string>(
+      Format(Ipv4Bytes(), NormalizedByteStringToIpv4));
+  return *kStrings;
+}
+const std::vector<std::string>& Ipv6s() {
+  static const auto* const kStrings = new std::vector<std::string>(
+      Format(Ipv6Bytes(), NormalizedByteStringToIpv6));
+  return *kStrings;
+}
+
+void BM_NormalizedByteStringToMac(benchmark::State& state) {
+  RunConversions(state, MacBytes(), [](const std::string& bytes) {
+    return NormalizedByteStringToMac(bytes);
+  });
+}
+
+void BM_NormalizedByteStringToMacLibc(benchmark::State& state) {
+  RunConversions(state, MacBytes(), LibcNormalizedByteStringToMac);
+}
+
+void BM_MacToNormalizedByteString(benchmark::State& state) {
+  RunConversions(state, Macs(), MacToNormalizedByteString);
+}
+
+void BM_MacToNormalizedByteStringLibc(benchmark::State& state) {
+  RunConversions(state, Macs(), LibcMacToNormalizedByteString);
+}
+
+void BM_NormalizedByteStringToIpv4(benchmark::State& state) {
+  RunConversions(state, Ipv4Bytes(), [](const std::string& bytes) {
+    return NormalizedByteStringToIpv4(bytes);
+  });
+}
+
+void BM_NormalizedByteStringToIpv4Libc(benchmark::State& state) {
+  RunConversions(state, Ipv4Bytes(), [](const std::string& bytes) {
+    return LibcNormalizedByteStringToIp(AF_INET, bytes);
+  });
+}
+
+void BM_Ipv4ToNormalizedByteString(benchmark::State& state) {
+  RunConversions(state, Ipv4s(), Ipv4ToNormalizedByteString);
+}
+
+void BM_Ipv4ToNormalizedByteStringLibc(benchmark::State& state) {
+  RunConversions(state, Ipv4s(), [](const std::string& ipv4) {
+    return LibcIpToNormalizedByteString(AF_INET, ipv4);
+  });
+}
+
+void BM_NormalizedByteStringToIpv6(benchmark::State& state) {
+  RunConversions(state, Ipv6Bytes(), [](const std::string& bytes) {
+    return NormalizedByteStringToIpv6(bytes);
+  });
+}
+
+void BM_NormalizedByteStringToIpv6Libc(benchmark::State& state) {
+  RunConversions(state, Ipv6Bytes(), [](const std::string& bytes) {
+    return LibcNormalizedByteStringToIp(AF_INET6, bytes);
+  });
+}
+
+void BM_Ipv6ToNormalizedByteString(benchmark::State& state) {
+  RunConversions(state, Ipv6s(), Ipv6ToNormalizedByteString);
+}
+
+void BM_Ipv6ToNormalizedByteStringLibc(benchmark::State& state) {
+  RunConversions(state, Ipv6s(), [](const std::string& ipv6) {
+    return LibcIpToNormalizedByteString(AF_INET6, ipv6);
+  });
+}
+
+BENCHMARK(BM_NormalizedByteStringToMac);
+BENCHMARK(BM_NormalizedByteStringToMacLibc);
+BENCHMARK(BM_MacToNormalizedByteString);
+BENCHMARK(BM_MacToNormalizedByteStringLibc);
+BENCHMARK(BM_NormalizedByteStringToIpv4);
+BENCHMARK(BM_NormalizedByteStringToIpv4Libc);
+BENCHMARK(BM_Ipv4ToNormalizedByteString);
+BENCHMARK(BM_Ipv4ToNormalizedByteStringLibc);
+BENCHMARK(BM_NormalizedByteStringToIpv6);
+BENCHMARK(BM_NormalizedByteStringToIpv6Libc);
+BENCHMARK(BM_Ipv6ToNormalizedByteString);
+BENCHMARK(BM_Ipv6ToNormalizedByteStringLibc);
+
+}  // namespace
+}  // namespace pdpi
+
+BENCHMARK_MAIN();
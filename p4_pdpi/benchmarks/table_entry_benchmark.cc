@@ -0,0 +1,371 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks for translating table entries between PI, IR and PD, using the
+// P4Info of testdata/main.p4.
+//
+// Usage: table_entry_benchmark [--benchmark_filter=...] <p4info file>
+//
+// Besides time, every benchmark reports the number of heap allocations and
+// allocated bytes per translated entry. These are counted by replacing the
+// global operator new below, which is why this has to be its own binary.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_format.h"
+#include "benchmark/benchmark.h"
+#include "glog/logging.h"
+#include "google/protobuf/arena.h"
+#include "gutil/testing.h"
+#include "gutil/thread_pool.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/pd.h"
+#include "p4_pdpi/testing/main_p4_pd.pb.h"
+#include "p4_pdpi/testing/main_p4_pd_conversions.h"
+
+namespace {
+
+std::atomic<int64_t> allocation_count{0};
+std::atomic<int64_t> allocated_bytes{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace pdpi {
+namespace {
+
+// Batch sizes benchmarked for every translation. A batch of 1 measures the
+// per-entry cost with warm caches; the larger ones correspond to bulk
+// programming of a switch.
+constexpr int kBatchSizes[] = {1, 10000, 100000};
+
+// The kinds of table entries that are benchmarked, one per table of main.p4
+// exercising a distinct combination of match kinds.
+enum EntryKind {
+  kExact,
+  kLpm,
+  kTernary,
+  kOptional,
+  kWcmp,
+  kNumEntryKinds,
+};
+
+const IrP4Info* global_info = nullptr;
+const CompiledIrP4Info* global_compiled_info = nullptr;
+
+// Returns an IPv4 address that is unique for each i < 2^24.
+std::string Ipv4(int i) {
+  return absl::StrFormat("10.%d.%d.%d", (i >> 16) & 0xff, (i >> 8) & 0xff,
+                         i & 0xff);
+}
+
+// Returns an IPv6 address that is unique for each i < 2^32.
+std::string Ipv6(int i) {
+  return absl::StrFormat("2001:db8::%x:%x", (i >> 16) & 0xffff, i & 0xffff);
+}
+
+std::string Hex(int i) { return absl::StrFormat("0x%x", i); }
+
+// Returns the i-th PD table entry of the given kind. Entries with different i
+// have different match keys.
+pdpi::TableEntry MakePdEntry(EntryKind kind, int i) {
+  pdpi::TableEntry pd;
+  switch (kind) {
+    case kExact: {
+      auto& entry = *pd.mutable_exact_table_entry();
+      entry.mutable_match()->set_normal(Hex(i & 0x3ff));
+      entry.mutable_match()->set_ipv4(Ipv4(i));
+      entry.mutable_match()->set_ipv6(Ipv6(i));
+      entry.mutable_match()->set_mac("00:11:22:33:44:55");
+      entry.mutable_match()->set_str("hello");
+      entry.mutable_action()->mutable_noaction();
+      break;
+    }
+    case kLpm: {
+      auto& entry = *pd.mutable_lpm1_table_entry();
+      entry.mutable_match()->mutable_ipv4()->set_value(Ipv4(i));
+      entry.mutable_match()->mutable_ipv4()->set_prefix_length(32);
+      entry.mutable_action()->mutable_noaction();
+      break;
+    }
+    case kTernary: {
+      auto& entry = *pd.mutable_ternary_table_entry();
+      entry.mutable_match()->mutable_normal()->set_value(Hex(i & 0x3ff));
+      entry.mutable_match()->mutable_normal()->set_mask("0x3ff");
+      entry.mutable_match()->mutable_ipv4()->set_value(Ipv4(i));
+      entry.mutable_match()->mutable_ipv4()->set_mask("255.255.255.255");
+      entry.mutable_match()->mutable_ipv6()->set_value(Ipv6(i));
+      entry.mutable_match()->mutable_ipv6()->set_mask(
+          "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff");
+      entry.mutable_match()->mutable_mac()->set_value("11:22:33:44:55:66");
+      entry.mutable_match()->mutable_mac()->set_mask("ff:ff:ff:ff:ff:ff");
+      entry.set_priority(32);
+      entry.mutable_action()->mutable_do_thing_3()->set_arg1(Hex(i));
+      entry.mutable_action()->mutable_do_thing_3()->set_arg2("0x251");
+      break;
+    }
+    case kOptional: {
+      auto& entry = *pd.mutable_optional_table_entry();
+      entry.mutable_match()->mutable_ipv6()->set_value(Ipv6(i));
+      entry.mutable_match()->mutable_ipv4()->set_value(Ipv4(i));
+      entry.set_priority(32);
+      entry.mutable_action()->mutable_do_thing_1()->set_arg1(Hex(i));
+      entry.mutable_action()->mutable_do_thing_1()->set_arg2("0x10");
+      break;
+    }
+    case kWcmp: {
+      auto& entry = *pd.mutable_wcmp_table_entry();
+      entry.mutable_match()->mutable_ipv4()->set_value(Ipv4(i));
+      entry.mutable_match()->mutable_ipv4()->set_prefix_length(32);
+      for (int weight = 1; weight <= 4; ++weight) {
+        auto& action = *entry.add_actions();
+        action.set_weight(weight);
+        action.mutable_do_thing_1()->set_arg1(Hex(i));
+        action.mutable_do_thing_1()->set_arg2(Hex(weight));
+      }
+      break;
+    }
+    case kNumEntryKinds:
+      break;
+  }
+  return pd;
+}
+
+std::string EntryKindName(EntryKind kind) {
+  switch (kind) {
+    case kExact:
+      return "exact_table";
+    case kLpm:
+      return "lpm1_table";
+    case kTernary:
+      return "ternary_table";
+    case kOptional:
+      return "optional_table";
+    case kWcmp:
+      return "wcmp_table";
+    case kNumEntryKinds:
+      break;
+  }
+  return "unknown";
+}
+
+// The same batch of entries in all three representations.
+struct Batch {
+  std::vector<pdpi::TableEntry> pd;
+  std::vector<IrTableEntry> ir;
+  std::vector<p4::v1::TableEntry> pi;
+};
+
+// Returns the batch of the given kind and size, creating it on first use.
+// Batches are shared by all benchmarks, so each is only built once.
+const Batch& GetBatch(EntryKind kind, int size) {
+  static auto* batches = new absl::flat_hash_map<std::pair<int, int>, Batch>();
+  auto it = batches->find({kind, size});
+  if (it != batches->end()) return it->second;
+
+  Batch& batch = (*batches)[{kind, size}];
+  batch.pd.reserve(size);
+  batch.ir.reserve(size);
+  batch.pi.reserve(size);
+  for (int i = 0; i < size; ++i) {
+    batch.pd.push_back(MakePdEntry(kind, i));
+    const auto ir = PdTableEntryToIr(*global_info, batch.pd.back());
+    CHECK(ir.ok()) << ir.status();
+    batch.ir.push_back(*ir);
+    const auto pi = IrTableEntryToPi(*global_info, batch.ir.back());
+    CHECK(pi.ok()) << pi.status();
+    batch.pi.push_back(*pi);
+  }
+  return batch;
+}
+
+// Runs `translate_batch` on the batch selected by the benchmark arguments
+// (entry kind, batch size) once per iteration, and reports time, allocations
+// and allocated bytes per entry.
+template <typename Input, typename TranslateBatch>
+void RunBatchBenchmark(benchmark::State& state,
+                       const std::vector<Input> Batch::*inputs,
+                       TranslateBatch translate_batch) {
+  const auto kind = static_cast<EntryKind>(state.range(0));
+  const int size = state.range(1);
+  const std::vector<Input>& batch = GetBatch(kind, size).*inputs;
+  state.SetLabel(EntryKindName(kind));
+
+  const int64_t allocations_before = allocation_count.load();
+  const int64_t bytes_before = allocated_bytes.load();
+  for (auto _ : state) translate_batch(batch);
+  const double entries = static_cast<double>(state.iterations()) * size;
+  state.SetItemsProcessed(state.iterations() * size);
+  state.counters["time/entry"] = benchmark::Counter(
+      entries, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  state.counters["allocs/entry"] =
+      (allocation_count.load() - allocations_before) / entries;
+  state.counters["bytes/entry"] =
+      (allocated_bytes.load() - bytes_before) / entries;
+}
+
+// Same as above, but runs `translate` on every entry of the batch.
+template <typename Input, typename Translate>
+void RunTranslationBenchmark(benchmark::State& state,
+                             const std::vector<Input> Batch::*inputs,
+                             Translate translate) {
+  RunBatchBenchmark(state, inputs, [&](const std::vector<Input>& batch) {
+    for (const Input& input : batch) {
+      benchmark::DoNotOptimize(translate(input));
+    }
+  });
+}
+
+void BM_PiTableEntryToIr(benchmark::State& state) {
+  RunTranslationBenchmark(state, &Batch::pi,
+                          [](const p4::v1::TableEntry& pi) {
+                            return PiTableEntryToIr(*global_info, pi);
+                          });
+}
+
+void BM_IrTableEntryToPi(benchmark::State& state) {
+  RunTranslationBenchmark(state, &Batch::ir, [](const IrTableEntry& ir) {
+    return IrTableEntryToPi(*global_info, ir);
+  });
+}
+
+void BM_PiTableEntryToIrCompiled(benchmark::State& state) {
+  RunTranslationBenchmark(state, &Batch::pi,
+                          [](const p4::v1::TableEntry& pi) {
+                            return PiTableEntryToIr(*global_compiled_info, pi);
+                          });
+}
+
+void BM_IrTableEntryToPiCompiled(benchmark::State& state) {
+  RunTranslationBenchmark(state, &Batch::ir, [](const IrTableEntry& ir) {
+    return IrTableEntryToPi(*global_compiled_info, ir);
+  });
+}
+
+// Translates every entry of the batch into messages allocated on one arena per
+// iteration, which is freed at once at the end of the iteration.
+void BM_PiTableEntryToIrArena(benchmark::State& state) {
+  RunBatchBenchmark(
+      state, &Batch::pi, [](const std::vector<p4::v1::TableEntry>& batch) {
+        google::protobuf::Arena arena;
+        for (const p4::v1::TableEntry& pi : batch) {
+          auto* ir =
+              google::protobuf::Arena::CreateMessage<IrTableEntry>(&arena);
+          benchmark::DoNotOptimize(PiTableEntryToIr(*global_info, pi, ir));
+        }
+      });
+}
+
+// Translates the whole batch with one call of the batch API per iteration,
+// using a pool of `state.range(2)` threads.
+void BM_PiTableEntriesToIr(benchmark::State& state) {
+  gutil::ThreadPool pool(state.range(2));
+  RunBatchBenchmark(state, &Batch::pi,
+                    [&](const std::vector<p4::v1::TableEntry>& batch) {
+                      benchmark::DoNotOptimize(
+                          PiTableEntriesToIr(*global_info, batch, &pool));
+                    });
+}
+
+void BM_PdTableEntryToIr(benchmark::State& state) {
+  RunTranslationBenchmark(state, &Batch::pd, [](const pdpi::TableEntry& pd) {
+    return PdTableEntryToIr(*global_info, pd);
+  });
+}
+
+void BM_IrTableEntryToPd(benchmark::State& state) {
+  RunTranslationBenchmark(state, &Batch::ir, [](const IrTableEntry& ir) {
+    pdpi::TableEntry pd;
+    return IrTableEntryToPd(*global_info, ir, &pd);
+  });
+}
+
+// Uses the conversions that pdgen generated for the PD proto of main.p4.
+void BM_PdTableEntryToIrGenerated(benchmark::State& state) {
+  RunTranslationBenchmark(state, &Batch::pd, [](const pdpi::TableEntry& pd) {
+    return PdTableEntryToIr(pd);
+  });
+}
+
+void BM_IrTableEntryToPdGenerated(benchmark::State& state) {
+  RunTranslationBenchmark(state, &Batch::ir, [](const IrTableEntry& ir) {
+    pdpi::TableEntry pd;
+    return IrTableEntryToPd(ir, &pd);
+  });
+}
+
+void AllEntryKindsAndBatchSizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"kind", "entries"});
+  for (int kind = 0; kind < kNumEntryKinds; ++kind) {
+    for (int size : kBatchSizes) benchmark->Args({kind, size});
+  }
+}
+
+BENCHMARK(BM_PiTableEntryToIr)->Apply(AllEntryKindsAndBatchSizes);
+BENCHMARK(BM_IrTableEntryToPi)->Apply(AllEntryKindsAndBatchSizes);
+BENCHMARK(BM_PiTableEntryToIrCompiled)->Apply(AllEntryKindsAndBatchSizes);
+BENCHMARK(BM_IrTableEntryToPiCompiled)->Apply(AllEntryKindsAndBatchSizes);
+BENCHMARK(BM_PiTableEntryToIrArena)->Apply(AllEntryKindsAndBatchSizes);
+BENCHMARK(BM_PiTableEntriesToIr)
+    ->Apply([](benchmark::internal::Benchmark* benchmark) {
+      benchmark->ArgNames({"kind", "entries", "threads"});
+      for (int size : {10000, 100000}) {
+        for (int threads : {0, 1, 4, 16}) {
+          benchmark->Args({kTernary, size, threads});
+        }
+      }
+    })
+    ->UseRealTime();
+BENCHMARK(BM_PdTableEntryToIr)->Apply(AllEntryKindsAndBatchSizes);
+BENCHMARK(BM_IrTableEntryToPd)->Apply(AllEntryKindsAndBatchSizes);
+BENCHMARK(BM_PdTableEntryToIrGenerated)->Apply(AllEntryKindsAndBatchSizes);
+BENCHMARK(BM_IrTableEntryToPdGenerated)->Apply(AllEntryKindsAndBatchSizes);
+
+}  // namespace
+}  // namespace pdpi
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  CHECK(argc == 2);  // Usage: table_entry_benchmark <p4info file>.
+  const auto p4info =
+      gutil::ParseProtoFileOrDie<p4::config::v1::P4Info>(argv[1]);
+  absl::StatusOr<pdpi::IrP4Info> info = pdpi::CreateIrP4Info(p4info);
+  CHECK(info.ok()) << info.status();
+  pdpi::global_info = &*info;
+  const pdpi::CompiledIrP4Info compiled_info(*info);
+  pdpi::global_compiled_info = &compiled_info;
+
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
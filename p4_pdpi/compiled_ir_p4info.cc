@@ -0,0 +1,116 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/compiled_ir_p4info.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/utils/ir.h"
+
+namespace pdpi {
+namespace {
+
+template <typename T>
+const T* FindByName(const NameIndex<T>& index, absl::string_view name) {
+  auto it = index.find(name);
+  return it == index.end() ? nullptr : it->second;
+}
+
+}  // namespace
+
+CompiledIrAction::CompiledIrAction(const IrActionDefinition& definition)
+    : definition_(&definition) {
+  std::vector<std::pair<uint32_t, const ParamDefinition*>> params;
+  params.reserve(definition.params_by_id().size());
+  for (const auto& [id, param] : definition.params_by_id()) {
+    params.push_back({id, &param});
+    params_by_name_[param.param().name()] = &param;
+  }
+  params_by_id_ = IdIndex<ParamDefinition>(params);
+}
+
+const CompiledIrAction::ParamDefinition* CompiledIrAction::FindParamByName(
+    absl::string_view name) const {
+  return FindByName(params_by_name_, name);
+}
+
+CompiledIrTable::CompiledIrTable(const IrTableDefinition& definition)
+    : definition_(&definition),
+      num_mandatory_matches_(0),
+      requires_priority_(RequiresPriority(definition)) {
+  std::vector<std::pair<uint32_t, const IrMatchFieldDefinition*>> match_fields;
+  match_fields.reserve(definition.match_fields_by_id().size());
+  for (const auto& [id, match_field] : definition.match_fields_by_id()) {
+    match_fields.push_back({id, &match_field});
+    match_fields_by_name_[match_field.match_field().name()] = &match_field;
+    if (match_field.match_field().match_type() ==
+        p4::config::v1::MatchField::EXACT) {
+      ++num_mandatory_matches_;
+    }
+  }
+  match_fields_by_id_ = IdIndex<IrMatchFieldDefinition>(match_fields);
+
+  // Indices are only built once all actions are in place, since adding
+  // actions may move them.
+  entry_actions_.reserve(definition.entry_actions().size());
+  for (const auto& action_reference : definition.entry_actions()) {
+    entry_actions_.emplace_back(action_reference.action());
+  }
+  std::vector<std::pair<uint32_t, const CompiledIrAction*>> actions;
+  actions.reserve(entry_actions_.size());
+  for (const auto& action : entry_actions_) {
+    actions.push_back({action.definition().preamble().id(), &action});
+    entry_actions_by_name_[action.definition().preamble().alias()] = &action;
+  }
+  entry_actions_by_id_ = IdIndex<CompiledIrAction>(actions);
+}
+
+const IrMatchFieldDefinition* CompiledIrTable::FindMatchFieldByName(
+    absl::string_view name) const {
+  return FindByName(match_fields_by_name_, name);
+}
+
+const CompiledIrAction* CompiledIrTable::FindEntryActionByName(
+    absl::string_view name) const {
+  return FindByName(entry_actions_by_name_, name);
+}
+
+CompiledIrP4Info::CompiledIrP4Info(IrP4Info info)
+    : CompiledIrP4Info(std::make_shared<const IrP4Info>(std::move(info))) {}
+
+CompiledIrP4Info::CompiledIrP4Info(std::shared_ptr<const IrP4Info> info)
+    : info_(std::move(info)) {
+  tables_.reserve(info_->tables_by_id().size());
+  for (const auto& [id, table] : info_->tables_by_id()) {
+    tables_.emplace_back(table);
+  }
+  std::vector<std::pair<uint32_t, const CompiledIrTable*>> tables;
+  tables.reserve(tables_.size());
+  for (const auto& table : tables_) {
+    tables.push_back({table.definition().preamble().id(), &table});
+    tables_by_name_[table.definition().preamble().alias()] = &table;
+  }
+  tables_by_id_ = IdIndex<CompiledIrTable>(tables);
+}
+
+const CompiledIrTable* CompiledIrP4Info::FindTableByName(
+    absl::string_view name) const {
+  return FindByName(tables_by_name_, name);
+}
+
+}  // namespace pdpi
@@ -0,0 +1,196 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef P4_PDPI_COMPILED_IR_P4INFO_H
+#define P4_PDPI_COMPILED_IR_P4INFO_H
+// An immutable, pointer-based index over an IrP4Info for use on the hot path of
+// translating many table entries. All lookups that the IrP4Info answers with
+// protobuf map lookups (tables by ID or name, match fields, actions, params)
+// are answered from dense arrays indexed by P4 ID or from hash maps keyed by
+// string views into the IrP4Info, without copying any definition.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+// Maps P4 IDs to pointers. When the low 24 bits of the IDs (i.e. the IDs
+// without their P4Info type prefix) are compact, as they are for IDs assigned
+// by p4c and for match field and param IDs, they are used to index a dense
+// array. Sparse IDs fall back to a hash map.
+template <typename T>
+class IdIndex {
+ public:
+  IdIndex() = default;
+
+  // The IDs in `entries` must be unique.
+  explicit IdIndex(const std::vector<std::pair<uint32_t, const T*>>& entries) {
+    uint32_t max_slot = 0;
+    for (const auto& [id, value] : entries) {
+      max_slot = std::max(max_slot, id & kSlotMask);
+    }
+    if (max_slot < kMaxSlack * entries.size() + kMaxSlack) {
+      dense_.resize(max_slot + 1, {0, nullptr});
+      for (const auto& [id, value] : entries) {
+        auto& slot = dense_[id & kSlotMask];
+        if (slot.second != nullptr) {
+          // Two IDs only differ in their type prefix.
+          dense_.clear();
+          break;
+        }
+        slot = {id, value};
+      }
+    }
+    if (dense_.empty()) sparse_.insert(entries.begin(), entries.end());
+  }
+
+  // Returns the value for the given ID, or nullptr if there is none.
+  const T* Find(uint32_t id) const {
+    if (sparse_.empty()) {
+      const uint32_t slot = id & kSlotMask;
+      if (slot < dense_.size() && dense_[slot].first == id) {
+        return dense_[slot].second;
+      }
+      return nullptr;
+    }
+    auto it = sparse_.find(id);
+    return it == sparse_.end() ? nullptr : it->second;
+  }
+
+ private:
+  static constexpr uint32_t kSlotMask = 0xffffff;
+  // The dense array is used as long as at most 1 in kMaxSlack slots is used.
+  static constexpr uint32_t kMaxSlack = 4;
+
+  std::vector<std::pair<uint32_t, const T*>> dense_;
+  absl::flat_hash_map<uint32_t, const T*> sparse_;
+};
+
+// Maps names to pointers. Names are views into the indexed IrP4Info.
+template <typename T>
+using NameIndex = absl::flat_hash_map<absl::string_view, const T*>;
+
+// The compiled form of an IrActionDefinition.
+class CompiledIrAction {
+ public:
+  using ParamDefinition = IrActionDefinition::IrActionParamDefinition;
+
+  explicit CompiledIrAction(const IrActionDefinition& definition);
+
+  const IrActionDefinition& definition() const { return *definition_; }
+  int num_params() const { return definition_->params_by_id().size(); }
+
+  // Return the param definition, or nullptr if the action has no such param.
+  const ParamDefinition* FindParamById(uint32_t id) const {
+    return params_by_id_.Find(id);
+  }
+  const ParamDefinition* FindParamByName(absl::string_view name) const;
+
+ private:
+  const IrActionDefinition* definition_;
+  IdIndex<ParamDefinition> params_by_id_;
+  NameIndex<ParamDefinition> params_by_name_;
+};
+
+// The compiled form of an IrTableDefinition.
+class CompiledIrTable {
+ public:
+  explicit CompiledIrTable(const IrTableDefinition& definition);
+
+  // Not copyable, since the indices point into the table itself.
+  CompiledIrTable(const CompiledIrTable&) = delete;
+  CompiledIrTable& operator=(const CompiledIrTable&) = delete;
+  CompiledIrTable(CompiledIrTable&&) = default;
+  CompiledIrTable& operator=(CompiledIrTable&&) = default;
+
+  const IrTableDefinition& definition() const { return *definition_; }
+
+  // Returns the match field definition, or nullptr if the table has no such
+  // match field.
+  const IrMatchFieldDefinition* FindMatchFieldById(uint32_t id) const {
+    return match_fields_by_id_.Find(id);
+  }
+  const IrMatchFieldDefinition* FindMatchFieldByName(
+      absl::string_view name) const;
+
+  // Returns the action if it can be used in entries of this table (i.e. it is
+  // not a default-only action), or nullptr otherwise.
+  const CompiledIrAction* FindEntryActionById(uint32_t id) const {
+    return entry_actions_by_id_.Find(id);
+  }
+  const CompiledIrAction* FindEntryActionByName(absl::string_view name) const;
+
+  // Number of match fields that every entry must specify, i.e. exact matches.
+  int num_mandatory_matches() const { return num_mandatory_matches_; }
+  // Whether entries require a priority, i.e. there are ternary, optional or
+  // range matches.
+  bool requires_priority() const { return requires_priority_; }
+
+ private:
+  const IrTableDefinition* definition_;
+  IdIndex<IrMatchFieldDefinition> match_fields_by_id_;
+  NameIndex<IrMatchFieldDefinition> match_fields_by_name_;
+  std::vector<CompiledIrAction> entry_actions_;
+  IdIndex<CompiledIrAction> entry_actions_by_id_;
+  NameIndex<CompiledIrAction> entry_actions_by_name_;
+  int num_mandatory_matches_;
+  bool requires_priority_;
+};
+
+// The compiled form of an IrP4Info. It shares ownership of the IrP4Info it
+// indexes, so it can be moved around freely, but not copied.
+//
+// CreateIrP4Info still returns a plain IrP4Info, since it is part of the
+// serialized and cached interfaces (e.g. GetCachedIrP4Info, IR P4Info
+// artifacts); use CreateCompiledIrP4Info in ir.h to create both at once.
+class CompiledIrP4Info {
+ public:
+  // Takes ownership of `info`; pass an rvalue to avoid copying it.
+  explicit CompiledIrP4Info(IrP4Info info);
+  // Shares ownership of `info`, e.g. as returned by GetCachedIrP4Info, without
+  // copying it. `info` must not be null.
+  explicit CompiledIrP4Info(std::shared_ptr<const IrP4Info> info);
+
+  CompiledIrP4Info(const CompiledIrP4Info&) = delete;
+  CompiledIrP4Info& operator=(const CompiledIrP4Info&) = delete;
+  CompiledIrP4Info(CompiledIrP4Info&&) = default;
+  CompiledIrP4Info& operator=(CompiledIrP4Info&&) = default;
+
+  const IrP4Info& info() const { return *info_; }
+
+  // Returns the table, or nullptr if there is no such table.
+  const CompiledIrTable* FindTableById(uint32_t id) const {
+    return tables_by_id_.Find(id);
+  }
+  const CompiledIrTable* FindTableByName(absl::string_view name) const;
+
+ private:
+  // Held by pointer so that the indices stay valid when this object is moved.
+  std::shared_ptr<const IrP4Info> info_;
+  std::vector<CompiledIrTable> tables_;
+  IdIndex<CompiledIrTable> tables_by_id_;
+  NameIndex<CompiledIrTable> tables_by_name_;
+};
+
+}  // namespace pdpi
+
+#endif  // P4_PDPI_COMPILED_IR_P4INFO_H
@@ -14,26 +14,365 @@
 
 #include "p4_pdpi/connection_management.h"
 
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
 
+#include "absl/base/call_once.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "grpcpp/channel.h"
+#include "grpcpp/completion_queue.h"
 #include "grpcpp/create_channel.h"
+#include "gutil/spsc_queue.h"
 #include "gutil/status.h"
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
 
 namespace pdpi {
 using ::p4::v1::P4Runtime;
 
-// Create P4Runtime Stub.
-std::unique_ptr<P4Runtime::Stub> CreateP4RuntimeStub(
+namespace {
+
+// An asynchronous RPC in flight. Its address is the tag of all its operations
+// on the completion queue.
+class AsyncRpc {
+ public:
+  virtual ~AsyncRpc() = default;
+
+  // Called on the polling thread when an operation of the RPC completed with
+  // the given `ok` value. Returns true once the RPC is finished.
+  virtual bool Proceed(bool ok) = 0;
+
+  grpc::ClientContext& context() { return context_; }
+
+ private:
+  grpc::ClientContext context_;
+};
+
+// A unary RPC, which only has a single operation.
+template <typename Response>
+class AsyncUnaryRpc : public AsyncRpc {
+ public:
+  explicit AsyncUnaryRpc(std::function<void(const grpc::Status&)> done)
+      : done_(std::move(done)) {}
+
+  // Starts the RPC with the given reader.
+  void Start(
+      std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader) {
+    reader_ = std::move(reader);
+    reader_->Finish(&response_, &status_, this);
+  }
+
+  bool Proceed(bool ok) override {
+    done_(status_);
+    return true;
+  }
+
+ private:
+  std::function<void(const grpc::Status&)> done_;
+  std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader_;
+  // Empty message; intentionally discarded.
+  Response response_;
+  grpc::Status status_;
+};
+
+// A Read RPC, which reads responses until the stream ends and then finishes.
+class AsyncReadRpc : public AsyncRpc {
+ public:
+  AsyncReadRpc(std::function<void(p4::v1::ReadResponse&)> on_response,
+               std::function<void(const grpc::Status&)> done)
+      : on_response_(std::move(on_response)), done_(std::move(done)) {}
+
+  // Starts the RPC with the given reader, which must not have been started.
+  void Start(
+      std::unique_ptr<grpc::ClientAsyncReader<p4::v1::ReadResponse>> reader) {
+    reader_ = std::move(reader);
+    reader_->StartCall(this);
+  }
+
+  bool Proceed(bool ok) override {
+    switch (state_) {
+      case State::kStarting:
+        if (!ok) return Finish();
+        state_ = State::kReading;
+        reader_->Read(&response_, this);
+        return false;
+      case State::kReading:
+        if (!ok) return Finish();
+        on_response_(response_);
+        response_.Clear();
+        reader_->Read(&response_, this);
+        return false;
+      case State::kFinishing:
+        done_(status_);
+        return true;
+    }
+    return true;
+  }
+
+ private:
+  enum class State { kStarting, kReading, kFinishing };
+
+  bool Finish() {
+    state_ = State::kFinishing;
+    reader_->Finish(&status_, this);
+    return false;
+  }
+
+  std::function<void(p4::v1::ReadResponse&)> on_response_;
+  std::function<void(const grpc::Status&)> done_;
+  std::unique_ptr<grpc::ClientAsyncReader<p4::v1::ReadResponse>> reader_;
+  State state_ = State::kStarting;
+  p4::v1::ReadResponse response_;
+  grpc::Status status_;
+};
+
+}  // namespace
+
+class AsyncRpcPoller {
+ public:
+  AsyncRpcPoller() = default;
+
+  // Cancels all RPCs in flight and waits for them to finish.
+  ~AsyncRpcPoller() {
+    {
+      absl::MutexLock lock(&mutex_);
+      for (AsyncRpc* rpc : rpcs_in_flight_) rpc->context().TryCancel();
+      // Cancelled RPCs may still start operations until they are finished, so
+      // the completion queue can only be shut down after that.
+      mutex_.Await(absl::Condition(this, &AsyncRpcPoller::NoRpcsInFlight));
+    }
+    completion_queue_.Shutdown();
+    absl::call_once(start_polling_, [this] { Poll(); });
+    if (polling_thread_.joinable()) polling_thread_.join();
+  }
+
+  grpc::CompletionQueue* completion_queue() { return &completion_queue_; }
+
+  // Registers `rpc` as in flight, taking ownership of it, and makes sure the
+  // completion queue is polled. Must be called before the first operation of
+  // `rpc` is started.
+  template <typename Rpc>
+  Rpc* Add(std::unique_ptr<Rpc> rpc) {
+    absl::call_once(start_polling_, [this] {
+      polling_thread_ = std::thread([this] { Poll(); });
+    });
+    absl::MutexLock lock(&mutex_);
+    rpcs_in_flight_.insert(rpc.get());
+    return rpc.release();
+  }
+
+ private:
+  bool NoRpcsInFlight() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return rpcs_in_flight_.empty();
+  }
+
+  // Runs the completed operations until the completion queue is shut down.
+  void Poll() {
+    void* tag;
+    bool ok;
+    while (completion_queue_.Next(&tag, &ok)) {
+      auto* rpc = static_cast<AsyncRpc*>(tag);
+      if (!rpc->Proceed(ok)) continue;
+      absl::MutexLock lock(&mutex_);
+      rpcs_in_flight_.erase(rpc);
+      delete rpc;
+    }
+  }
+
+  grpc::CompletionQueue completion_queue_;
+  // The polling thread is started by the first RPC.
+  absl::once_flag start_polling_;
+  std::thread polling_thread_;
+  absl::Mutex mutex_;
+  // Owned.
+  absl::flat_hash_set<AsyncRpc*> rpcs_in_flight_ ABSL_GUARDED_BY(mutex_);
+};
+
+class StreamChannelReader {
+ public:
+  // Starts reading `stream`, which must outlive the reader and must not be
+  // read otherwise. Cancels `context`, the context of `stream`, to stop.
+  StreamChannelReader(
+      PacketIoOptions options, grpc::ClientContext* context,
+      grpc::ClientReaderWriter<p4::v1::StreamMessageRequest,
+                               p4::v1::StreamMessageResponse>* stream)
+      : options_(std::move(options)),
+        context_(context),
+        stream_(stream),
+        packet_ins_(std::max(options_.packet_in_queue_capacity, 1)),
+        thread_([this] { Read(); }) {}
+
+  // Cancels the stream channel and waits for the reading thread to stop.
+  ~StreamChannelReader() {
+    context_->TryCancel();
+    thread_.join();
+  }
+
+  bool TryReadPacketIn(ReceivedPacketIn* packet) {
+    return packet_ins_.TryPop(packet);
+  }
+
+  int64_t dropped_packet_ins() const {
+    return dropped_packet_ins_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Reads messages until the stream ends.
+  void Read() {
+    p4::v1::StreamMessageResponse response;
+    while (stream_->Read(&response)) {
+      if (response.has_packet()) {
+        ReceivedPacketIn packet;
+        packet.pi.Swap(response.mutable_packet());
+        if (options_.ir_p4info != nullptr) {
+          packet.ir = PiPacketInToIr(*options_.ir_p4info, packet.pi);
+        }
+        if (!packet_ins_.TryPush(std::move(packet))) {
+          dropped_packet_ins_.fetch_add(1, std::memory_order_relaxed);
+        }
+      } else if (options_.on_stream_message) {
+        options_.on_stream_message(response);
+      }
+    }
+  }
+
+  const PacketIoOptions options_;
+  grpc::ClientContext* const context_;
+  grpc::ClientReaderWriter<p4::v1::StreamMessageRequest,
+                           p4::v1::StreamMessageResponse>* const stream_;
+  // Written by the reading thread, read by the user of the session.
+  gutil::SpscQueue<ReceivedPacketIn> packet_ins_;
+  std::atomic<int64_t> dropped_packet_ins_{0};
+  // Declared last, since it uses all other members.
+  std::thread thread_;
+};
+
+P4RuntimeSession::P4RuntimeSession(uint32_t device_id,
+                                   std::unique_ptr<P4Runtime::Stub> stub,
+                                   absl::uint128 election_id)
+    : device_id_(device_id),
+      stub_(std::move(stub)),
+      stream_channel_context_(absl::make_unique<grpc::ClientContext>()),
+      stream_channel_(stub_->StreamChannel(stream_channel_context_.get())),
+      stream_channel_write_mutex_(absl::make_unique<absl::Mutex>()),
+      async_rpc_poller_(absl::make_unique<AsyncRpcPoller>()) {
+  election_id_.set_high(absl::Uint128High64(election_id));
+  election_id_.set_low(absl::Uint128Low64(election_id));
+}
+
+P4RuntimeSession::P4RuntimeSession(P4RuntimeSession&&) = default;
+
+P4RuntimeSession& P4RuntimeSession::operator=(P4RuntimeSession&& other) {
+  // Stop using the stub and stream channel before they are replaced.
+  stream_channel_reader_ = nullptr;
+  async_rpc_poller_ = nullptr;
+  device_id_ = other.device_id_;
+  election_id_ = std::move(other.election_id_);
+  stub_ = std::move(other.stub_);
+  stream_channel_context_ = std::move(other.stream_channel_context_);
+  stream_channel_ = std::move(other.stream_channel_);
+  stream_channel_write_mutex_ = std::move(other.stream_channel_write_mutex_);
+  async_rpc_poller_ = std::move(other.async_rpc_poller_);
+  stream_channel_reader_ = std::move(other.stream_channel_reader_);
+  return *this;
+}
+
+P4RuntimeSession::~P4RuntimeSession() = default;
+
+void P4RuntimeSession::AsyncWrite(
+    const p4::v1::WriteRequest& request,
+    std::function<void(const grpc::Status&)> done) {
+  auto* rpc = async_rpc_poller_->Add(
+      absl::make_unique<AsyncUnaryRpc<p4::v1::WriteResponse>>(
+          std::move(done)));
+  rpc->Start(stub_->AsyncWrite(&rpc->context(), request,
+                               async_rpc_poller_->completion_queue()));
+}
+
+void P4RuntimeSession::AsyncRead(
+    const p4::v1::ReadRequest& request,
+    std::function<void(p4::v1::ReadResponse&)> on_response,
+    std::function<void(const grpc::Status&)> done) {
+  auto* rpc = async_rpc_poller_->Add(absl::make_unique<AsyncReadRpc>(
+      std::move(on_response), std::move(done)));
+  rpc->Start(stub_->PrepareAsyncRead(&rpc->context(), request,
+                                     async_rpc_poller_->completion_queue()));
+}
+
+void P4RuntimeSession::AsyncSetForwardingPipelineConfig(
+    const p4::v1::SetForwardingPipelineConfigRequest& request,
+    std::function<void(const grpc::Status&)> done) {
+  auto* rpc = async_rpc_poller_->Add(
+      absl::make_unique<
+          AsyncUnaryRpc<p4::v1::SetForwardingPipelineConfigResponse>>(
+          std::move(done)));
+  rpc->Start(stub_->AsyncSetForwardingPipelineConfig(
+      &rpc->context(), request, async_rpc_poller_->completion_queue()));
+}
+
+std::shared_ptr<grpc::Channel> CreateP4RuntimeChannel(
     const std::string& address,
     const std::shared_ptr<grpc::ChannelCredentials>& credentials) {
   grpc::ChannelArguments args;
   args.SetInt(GRPC_ARG_MAX_METADATA_SIZE, P4GRPCMaxMetadataSize());
-  return P4Runtime::NewStub(
-      grpc::CreateCustomChannel(address, credentials, args));
+  return grpc::CreateCustomChannel(address, credentials, args);
+}
+
+absl::Status P4RuntimeSession::StartPacketIo(PacketIoOptions options) {
+  if (stream_channel_reader_ != nullptr) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "Packet IO was already started.";
+  }
+  stream_channel_reader_ = absl::make_unique<StreamChannelReader>(
+      std::move(options), stream_channel_context_.get(), stream_channel_.get());
+  return absl::OkStatus();
+}
+
+bool P4RuntimeSession::TryReadPacketIn(ReceivedPacketIn* packet) {
+  return stream_channel_reader_ != nullptr &&
+         stream_channel_reader_->TryReadPacketIn(packet);
+}
+
+int64_t P4RuntimeSession::DroppedPacketIns() const {
+  return stream_channel_reader_ == nullptr
+             ? 0
+             : stream_channel_reader_->dropped_packet_ins();
+}
+
+absl::Status P4RuntimeSession::SendPacketOuts(
+    absl::Span<const p4::v1::PacketOut> packets) {
+  absl::MutexLock lock(stream_channel_write_mutex_.get());
+  p4::v1::StreamMessageRequest request;
+  for (int i = 0; i < packets.size(); ++i) {
+    *request.mutable_packet() = packets[i];
+    // All but the last packet are buffered, so that they are sent together.
+    grpc::WriteOptions options;
+    if (i + 1 < packets.size()) options.set_buffer_hint();
+    if (!stream_channel_->Write(request, options)) {
+      return gutil::UnavailableErrorBuilder()
+             << "Failed to send packet " << i << " of " << packets.size()
+             << ", because the stream channel is closed.";
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Create P4Runtime Stub.
+std::unique_ptr<P4Runtime::Stub> CreateP4RuntimeStub(
+    const std::string& address,
+    const std::shared_ptr<grpc::ChannelCredentials>& credentials) {
+  return P4Runtime::NewStub(CreateP4RuntimeChannel(address, credentials));
 }
 
 // Creates a session with the switch, which lasts until the session object is
@@ -17,18 +17,26 @@
 
 #include <stdint.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include "absl/memory/memory.h"
 #include "absl/numeric/int128.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "grpcpp/channel.h"
 #include "grpcpp/security/credentials.h"
+#include "grpcpp/support/status.h"
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
 
 namespace pdpi {
 // The maximum metadata size that a P4Runtime client should accept.  This is
@@ -51,6 +59,33 @@ inline absl::uint128 TimeBasedElectionId() {
   return absl::MakeUint128(absl::ToUnixSeconds(absl::Now()), 0);
 }
 
+// Runs the asynchronous RPCs of a P4RuntimeSession. Defined in the .cc file.
+class AsyncRpcPoller;
+// Reads the stream channel of a P4RuntimeSession. Defined in the .cc file.
+class StreamChannelReader;
+
+// Options for the packet IO of a P4RuntimeSession.
+struct PacketIoOptions {
+  // The maximum number of received packets that are queued until they are
+  // read. Packets received while the queue is full are dropped.
+  int packet_in_queue_capacity = 4096;
+  // If set, received packets are also translated to IR, on the thread that
+  // reads the stream channel.
+  const IrP4Info* ir_p4info = nullptr;
+  // If set, called on the thread that reads the stream channel for every
+  // message from the switch that is not a packet, e.g. arbitration updates
+  // and stream errors.
+  std::function<void(const p4::v1::StreamMessageResponse&)> on_stream_message;
+};
+
+// A packet received from the switch.
+struct ReceivedPacketIn {
+  p4::v1::PacketIn pi;
+  // The IR translation of `pi`, or the reason it could not be translated.
+  // Only set if PacketIoOptions::ir_p4info is set.
+  absl::optional<absl::StatusOr<IrPacketIn>> ir;
+};
+
 // A P4Runtime session
 class P4RuntimeSession {
  public:
@@ -78,8 +113,12 @@ class P4RuntimeSession {
   P4RuntimeSession& operator=(const P4RuntimeSession&) = delete;
 
   // Allow move semantics.
-  P4RuntimeSession(P4RuntimeSession&&) = default;
-  P4RuntimeSession& operator=(P4RuntimeSession&&) = default;
+  P4RuntimeSession(P4RuntimeSession&&);
+  P4RuntimeSession& operator=(P4RuntimeSession&&);
+
+  // Cancels all asynchronous RPCs that are still in flight and waits for their
+  // callbacks to return, and stops the packet IO.
+  ~P4RuntimeSession();
 
   // Return the id of the node that this session belongs to.
   uint32_t DeviceId() const { return device_id_; }
@@ -88,17 +127,48 @@ class P4RuntimeSession {
   // Return the P4Runtime stub.
   p4::v1::P4Runtime::Stub& Stub() { return *stub_; }
 
+  // Asynchronous versions of the P4Runtime RPCs. They return immediately, and
+  // the callbacks are later called on a thread owned by the session, which
+  // polls a completion queue shared by all asynchronous RPCs of the session.
+  // This allows a single thread to have many RPCs in flight at once.
+  // Callbacks must not block on other asynchronous RPCs of the same session,
+  // since those can only complete once the callback returned.
+
+  // Sends a Write RPC and calls `done` with its status.
+  void AsyncWrite(const p4::v1::WriteRequest& request,
+                  std::function<void(const grpc::Status&)> done);
+  // Sends a Read RPC, calls `on_response` on every response of the reply
+  // stream as it arrives, and then calls `done` with the status of the RPC.
+  // `on_response` may modify (e.g. move from) the response it is given.
+  void AsyncRead(const p4::v1::ReadRequest& request,
+                 std::function<void(p4::v1::ReadResponse&)> on_response,
+                 std::function<void(const grpc::Status&)> done);
+  // Sends a SetForwardingPipelineConfig RPC and calls `done` with its status.
+  void AsyncSetForwardingPipelineConfig(
+      const p4::v1::SetForwardingPipelineConfigRequest& request,
+      std::function<void(const grpc::Status&)> done);
+
+  // Packet IO uses the stream channel of the session. Before packets can be
+  // received, StartPacketIo must be called (once), which starts a thread that
+  // reads all messages from the switch and queues the packets among them.
+  // Packets can be sent without calling StartPacketIo.
+
+  // Starts reading the stream channel.
+  absl::Status StartPacketIo(PacketIoOptions options = PacketIoOptions());
+  // Moves the oldest received packet that was not read yet to `packet` and
+  // returns true, or returns false if there is none. Never blocks. Must not be
+  // called concurrently, since the queue only supports a single reader.
+  bool TryReadPacketIn(ReceivedPacketIn* packet);
+  // Returns the number of received packets dropped because the queue was full.
+  int64_t DroppedPacketIns() const;
+  // Sends the given packets, coalescing them into as few network writes as
+  // possible. Returns an error if the stream channel is closed.
+  absl::Status SendPacketOuts(absl::Span<const p4::v1::PacketOut> packets);
+
  private:
   P4RuntimeSession(uint32_t device_id,
                    std::unique_ptr<p4::v1::P4Runtime::Stub> stub,
-                   absl::uint128 election_id)
-      : device_id_(device_id),
-        stub_(std::move(stub)),
-        stream_channel_context_(absl::make_unique<grpc::ClientContext>()),
-        stream_channel_(stub_->StreamChannel(stream_channel_context_.get())) {
-    election_id_.set_high(absl::Uint128High64(election_id));
-    election_id_.set_low(absl::Uint128Low64(election_id));
-  }
+                   absl::uint128 election_id);
 
   // The id of the node that this session belongs to.
   uint32_t device_id_;
@@ -113,8 +183,25 @@ class P4RuntimeSession {
   std::unique_ptr<grpc::ClientReaderWriter<p4::v1::StreamMessageRequest,
                                            p4::v1::StreamMessageResponse>>
       stream_channel_;
+
+  // Serializes writes to the stream channel. Heap allocated, so that the
+  // session remains movable.
+  std::unique_ptr<absl::Mutex> stream_channel_write_mutex_;
+
+  // Runs the asynchronous RPCs. Declared after the stub, so that RPCs in
+  // flight are cancelled before the stub is destroyed.
+  std::unique_ptr<AsyncRpcPoller> async_rpc_poller_;
+  // Reads the stream channel once packet IO was started. Declared after the
+  // stream channel, so that reading stops before the stream is destroyed.
+  std::unique_ptr<StreamChannelReader> stream_channel_reader_;
 };
 
+// Creates a gRPC channel suitable for P4Runtime. Stubs for several devices
+// behind the same address can share one channel.
+std::shared_ptr<grpc::Channel> CreateP4RuntimeChannel(
+    const std::string& address,
+    const std::shared_ptr<grpc::ChannelCredentials>& credentials);
+
 // Create P4Runtime stub.
 std::unique_ptr<p4::v1::P4Runtime::Stub> CreateP4RuntimeStub(
     const std::string& address,
@@ -14,19 +14,36 @@
 
 #include "p4_pdpi/entity_management.h"
 
+#include <stdint.h>
+
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "google/protobuf/repeated_field.h"
+#include "google/rpc/code.pb.h"
+#include "grpcpp/completion_queue.h"
 #include "gutil/status.h"
+#include "gutil/thread_pool.h"
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/connection_management.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/sequencing.h"
 #include "p4_pdpi/utils/ir.h"
 
 namespace pdpi {
@@ -41,21 +58,363 @@ using ::p4::v1::Update;
 using ::p4::v1::WriteRequest;
 using ::p4::v1::WriteResponse;
 
-absl::StatusOr<ReadResponse> SendPiReadRequest(
-    P4RuntimeSession* session, const ReadRequest& read_request) {
+namespace {
+
+// A Write RPC sent by SendUpdatesInBatches that has not been completed yet.
+struct PendingWrite {
+  // The range of updates sent in this RPC.
+  int first_update;
+  int num_updates;
+  grpc::ClientContext context;
+  // Empty message; intentionally discarded.
+  WriteResponse response;
+  grpc::Status status;
+  std::unique_ptr<grpc::ClientAsyncResponseReader<WriteResponse>> reader;
+};
+
+// Stores the status of each update of the completed `write` in `statuses`,
+// and the RPC-wide error of `write`, if any, in `rpc_wide_error`.
+absl::Status RecordWriteStatuses(const PendingWrite& write,
+                                 IrWriteResponse* statuses,
+                                 absl::Status* rpc_wide_error) {
+  ASSIGN_OR_RETURN(
+      IrWriteRpcStatus write_rpc_status,
+      GrpcStatusToIrWriteRpcStatus(write.status, write.num_updates),
+      _.SetPrepend() << "Invalid gRPC status w.r.t. P4RT specification: ");
+  for (int i = 0; i < write.num_updates; ++i) {
+    IrUpdateStatus* status = statuses->mutable_statuses(write.first_update + i);
+    if (write_rpc_status.has_rpc_wide_error()) {
+      status->set_code(static_cast<google::rpc::Code>(
+          write_rpc_status.rpc_wide_error().code()));
+      status->set_message(write_rpc_status.rpc_wide_error().message());
+    } else {
+      *status = write_rpc_status.rpc_response().statuses(i);
+    }
+  }
+  if (write_rpc_status.has_rpc_wide_error() && rpc_wide_error->ok()) {
+    *rpc_wide_error =
+        absl::Status(static_cast<absl::StatusCode>(
+                         write_rpc_status.rpc_wide_error().code()),
+                     write_rpc_status.rpc_wide_error().message());
+  }
+  return absl::OkStatus();
+}
+
+// Sends `num_updates` updates, where `make_update(i, update)` builds the i-th
+// update, as described in SendPiUpdates. Additionally stores the first RPC-wide
+// error in `rpc_wide_error`, if there was one.
+absl::StatusOr<IrWriteResponse> SendUpdatesInBatches(
+    P4RuntimeSession* session, int num_updates,
+    const std::function<void(int, Update*)>& make_update,
+    const WriteBatchOptions& options, absl::Status* rpc_wide_error) {
+  if (options.max_updates_per_request <= 0 ||
+      options.max_requests_in_flight <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Invalid WriteBatchOptions: max_updates_per_request ("
+           << options.max_updates_per_request
+           << ") and max_requests_in_flight ("
+           << options.max_requests_in_flight << ") must be positive.";
+  }
+  IrWriteResponse statuses;
+  statuses.mutable_statuses()->Reserve(num_updates);
+  for (int i = 0; i < num_updates; ++i) statuses.add_statuses();
+
+  grpc::CompletionQueue completion_queue;
+  absl::Status status;
+  int next_update = 0;
+  int requests_in_flight = 0;
+  // Keep sending requests while there is room, and stop sending requests
+  // after the first error, including RPC-wide errors of the switch: these
+  // usually affect all requests (e.g. after losing primaryship).
+  auto keep_sending = [&] {
+    return status.ok() && rpc_wide_error->ok() && next_update < num_updates;
+  };
+  while (requests_in_flight > 0 || keep_sending()) {
+    if (keep_sending() &&
+        requests_in_flight < options.max_requests_in_flight) {
+      auto write = absl::make_unique<PendingWrite>();
+      write->first_update = next_update;
+      write->num_updates = std::min(options.max_updates_per_request,
+                                    num_updates - next_update);
+      next_update += write->num_updates;
+
+      WriteRequest request;
+      request.set_device_id(session->DeviceId());
+      *request.mutable_election_id() = session->ElectionId();
+      request.mutable_updates()->Reserve(write->num_updates);
+      for (int i = 0; i < write->num_updates; ++i) {
+        make_update(write->first_update + i, request.add_updates());
+      }
+      write->reader = session->Stub().AsyncWrite(&write->context, request,
+                                                  &completion_queue);
+      write->reader->Finish(&write->response, &write->status, write.get());
+      // Owned by the completion queue until the RPC completes.
+      write.release();
+      ++requests_in_flight;
+      continue;
+    }
+
+    void* tag;
+    bool ok;
+    if (!completion_queue.Next(&tag, &ok)) {
+      return gutil::InternalErrorBuilder()
+             << "Completion queue shut down with " << requests_in_flight
+             << " Write RPCs in flight.";
+    }
+    std::unique_ptr<PendingWrite> write(static_cast<PendingWrite*>(tag));
+    --requests_in_flight;
+    if (status.ok()) {
+      status = RecordWriteStatuses(*write, &statuses, rpc_wide_error);
+    }
+  }
+  completion_queue.Shutdown();
+  void* tag;
+  bool ok;
+  while (completion_queue.Next(&tag, &ok)) {
+  }
+  RETURN_IF_ERROR(status);
+  for (int i = next_update; i < num_updates; ++i) {
+    IrUpdateStatus* update_status = statuses.mutable_statuses(i);
+    update_status->set_code(google::rpc::ABORTED);
+    update_status->set_message(absl::StrCat(
+        "Not sent, since an earlier Write RPC failed with an RPC-wide error: ",
+        rpc_wide_error->message()));
+  }
+  return statuses;
+}
+
+// Sends the updates built by `make_update` and returns an error if any of them
+// failed.
+absl::Status SendUpdatesInBatchesAndCheck(
+    P4RuntimeSession* session, int num_updates,
+    const std::function<void(int, Update*)>& make_update,
+    const WriteBatchOptions& options) {
+  absl::Status rpc_wide_error;
+  ASSIGN_OR_RETURN(IrWriteResponse statuses,
+                   SendUpdatesInBatches(session, num_updates, make_update,
+                                        options, &rpc_wide_error));
+  if (absl::c_all_of(statuses.statuses(), [](const IrUpdateStatus& status) {
+        return status.code() == google::rpc::OK;
+      })) {
+    return absl::OkStatus();
+  }
+  // Report RPC-wide errors as such, like WriteRpcGrpcStatusToAbslStatus.
+  RETURN_IF_ERROR(rpc_wide_error);
+  return gutil::UnknownErrorBuilder()
+         << IrWriteResponseToReadableMessage(statuses);
+}
+
+// Deletes `entries` with SendPiUpdatesInSequence.
+absl::Status DeleteInSequence(P4RuntimeSession* session,
+                              const P4InfoReferences& references,
+                              absl::Span<const TableEntry> entries,
+                              const WriteBatchOptions& options) {
+  std::vector<Update> deletes;
+  deletes.reserve(entries.size());
+  for (const TableEntry& entry : entries) {
+    Update& update = deletes.emplace_back();
+    update.set_type(Update::DELETE);
+    *update.mutable_entity()->mutable_table_entry() = entry;
+  }
+  return SendPiUpdatesInSequence(session, references, deletes, options);
+}
+
+// Clears tables that are read concurrently. The entries of a table are deleted
+// as soon as the table was read and the entries of all other tables that may
+// refer to them were deleted, by whichever thread made that happen, while other
+// tables may still be read.
+class TableClearer {
+ public:
+  // `table_ids` must be distinct and in increasing order.
+  TableClearer(P4RuntimeSession* session, const IrP4Info& info,
+               const P4InfoReferences& references,
+               std::vector<uint32_t> table_ids,
+               const WriteBatchOptions& options)
+      : session_(session),
+        info_(info),
+        references_(references),
+        table_ids_(std::move(table_ids)),
+        options_(options),
+        tables_(table_ids_.size()) {
+    absl::flat_hash_map<uint32_t, int> index_by_id;
+    for (int i = 0; i < table_ids_.size(); ++i) index_by_id[table_ids_[i]] = i;
+    for (int i = 0; i < table_ids_.size(); ++i) {
+      for (uint32_t referred_id : references_.ReferredTableIds(table_ids_[i])) {
+        auto it = index_by_id.find(referred_id);
+        // References between entries of the same table are sequenced by
+        // DeleteInSequence.
+        if (it == index_by_id.end() || it->second == i) continue;
+        tables_[i].referred.push_back(it->second);
+        ++tables_[it->second].num_referring;
+      }
+    }
+  }
+
+  // Reads the table at `index`, then deletes the entries of all tables that
+  // are ready to be deleted. Does nothing once any table failed to be cleared.
+  void ReadAndDelete(int index) {
+    {
+      absl::MutexLock lock(&mutex_);
+      if (failed_) return;
+    }
+    // The whole table is read before its entries are removed, since targets
+    // may not process writes while a read of the same table is in progress.
+    std::vector<TableEntry> entries;
+    absl::Status status = ReadPiTableEntries(
+        session_, table_ids_[index], [&entries](TableEntry& entry) {
+          entries.push_back(std::move(entry));
+          return absl::OkStatus();
+        });
+    {
+      absl::MutexLock lock(&mutex_);
+      Table& table = tables_[index];
+      table.read = true;
+      table.entries = std::move(entries);
+      if (!status.ok()) {
+        table.status = std::move(status);
+        failed_ = true;
+        return;
+      }
+    }
+    DeleteReadyTables();
+  }
+
+  // Deletes the entries of the tables that were read but are still referred
+  // to, which only happens if tables refer to each other in a cycle, all
+  // together. Then returns the first error, in table ID order, of a table that
+  // could not be cleared. Must be called after ReadAndDelete was called for
+  // all tables.
+  absl::Status Finish() {
+    std::vector<TableEntry> remaining_entries;
+    std::vector<std::string> remaining_aliases;
+    {
+      absl::MutexLock lock(&mutex_);
+      for (int i = 0; i < tables_.size(); ++i) {
+        RETURN_IF_ERROR(tables_[i].status).SetPrepend()
+            << "Failed to clear table '" << Alias(i) << "': ";
+        if (tables_[i].claimed) continue;
+        remaining_aliases.push_back(Alias(i));
+        for (TableEntry& entry : tables_[i].entries) {
+          remaining_entries.push_back(std::move(entry));
+        }
+      }
+    }
+    if (remaining_entries.empty()) return absl::OkStatus();
+    RETURN_IF_ERROR(DeleteInSequence(session_, references_, remaining_entries,
+                                     options_))
+            .SetPrepend()
+        << "Failed to clear tables '"
+        << absl::StrJoin(remaining_aliases, "', '") << "': ";
+    return absl::OkStatus();
+  }
+
+ private:
+  struct Table {
+    // Whether the table was read, and its entries if they were not deleted.
+    bool read = false;
+    std::vector<TableEntry> entries;
+    // Whether the deletion of the entries started.
+    bool claimed = false;
+    // The number of other tables that may refer to this table and whose
+    // entries were not deleted yet.
+    int num_referring = 0;
+    // The indices of the other tables this table may refer to.
+    std::vector<int> referred;
+    absl::Status status;
+  };
+
+  const std::string& Alias(int index) const {
+    return info_.tables_by_id().at(table_ids_[index]).preamble().alias();
+  }
+
+  // Deletes the entries of tables that are ready until there are none left.
+  void DeleteReadyTables() {
+    while (true) {
+      int index = -1;
+      std::vector<TableEntry> entries;
+      {
+        absl::MutexLock lock(&mutex_);
+        if (failed_) return;
+        for (int i = 0; i < tables_.size(); ++i) {
+          const Table& table = tables_[i];
+          if (table.read && !table.claimed && table.num_referring == 0) {
+            index = i;
+            break;
+          }
+        }
+        if (index == -1) return;
+        tables_[index].claimed = true;
+        entries = std::move(tables_[index].entries);
+      }
+      absl::Status status =
+          entries.empty()
+              ? absl::OkStatus()
+              : DeleteInSequence(session_, references_, entries, options_);
+      absl::MutexLock lock(&mutex_);
+      if (!status.ok()) {
+        tables_[index].status = std::move(status);
+        failed_ = true;
+        return;
+      }
+      for (int referred : tables_[index].referred) {
+        --tables_[referred].num_referring;
+      }
+    }
+  }
+
+  P4RuntimeSession* const session_;
+  const IrP4Info& info_;
+  const P4InfoReferences& references_;
+  const std::vector<uint32_t> table_ids_;
+  const WriteBatchOptions& options_;
+  absl::Mutex mutex_;
+  std::vector<Table> tables_ ABSL_GUARDED_BY(mutex_);
+  bool failed_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace
+
+absl::Status SendPiReadRequest(
+    P4RuntimeSession* session, const ReadRequest& read_request,
+    const std::function<absl::Status(ReadResponse&)>& on_response) {
   grpc::ClientContext context;
   auto reader = session->Stub().Read(&context, read_request);
 
-  ReadResponse response;
   ReadResponse partial_response;
   while (reader->Read(&partial_response)) {
-    response.MergeFrom(partial_response);
+    absl::Status status = on_response(partial_response);
+    if (!status.ok()) {
+      // The stream ends soon after cancellation. Drain it, since Finish must
+      // only be called once all messages were read.
+      context.TryCancel();
+      while (reader->Read(&partial_response)) {
+      }
+      reader->Finish().IgnoreError();
+      return status;
+    }
   }
 
   grpc::Status reader_status = reader->Finish();
   if (!reader_status.ok()) {
     return gutil::GrpcStatusToAbslStatus(reader_status);
   }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<ReadResponse> SendPiReadRequest(
+    P4RuntimeSession* session, const ReadRequest& read_request) {
+  ReadResponse response;
+  RETURN_IF_ERROR(SendPiReadRequest(
+      session, read_request, [&response](ReadResponse& partial_response) {
+        if (response.entities().empty()) {
+          response.Swap(&partial_response);
+        } else {
+          for (auto& entity : *partial_response.mutable_entities()) {
+            response.add_entities()->Swap(&entity);
+          }
+        }
+        return absl::OkStatus();
+      }));
   return response;
 }
 
@@ -69,46 +428,136 @@ absl::Status SendPiWriteRequest(P4RuntimeSession* session,
       write_request.updates_size());
 }
 
-absl::StatusOr<std::vector<TableEntry>> ReadPiTableEntries(
-    P4RuntimeSession* session) {
+absl::Status ReadPiTableEntries(
+    P4RuntimeSession* session,
+    const std::function<absl::Status(TableEntry&)>& on_entry) {
+  // Table ID 0 is a wildcard for all tables.
+  return ReadPiTableEntries(session, /*table_id=*/0, on_entry);
+}
+
+absl::Status ReadPiTableEntries(
+    P4RuntimeSession* session, uint32_t table_id,
+    const std::function<absl::Status(TableEntry&)>& on_entry) {
   ReadRequest read_request;
   read_request.set_device_id(session->DeviceId());
-  read_request.add_entities()->mutable_table_entry();
-  ASSIGN_OR_RETURN(ReadResponse read_response,
-                   SendPiReadRequest(session, read_request));
+  read_request.add_entities()->mutable_table_entry()->set_table_id(table_id);
+  return SendPiReadRequest(
+      session, read_request,
+      [&on_entry](ReadResponse& partial_response) -> absl::Status {
+        for (auto& entity : *partial_response.mutable_entities()) {
+          if (!entity.has_table_entry())
+            return gutil::InternalErrorBuilder()
+                   << "Entity in the read response has no table entry: "
+                   << entity.DebugString();
+          RETURN_IF_ERROR(on_entry(*entity.mutable_table_entry()));
+        }
+        return absl::OkStatus();
+      });
+}
 
-  std::vector<TableEntry> table_entries;
-  table_entries.reserve(read_response.entities().size());
-  for (const auto& entity : read_response.entities()) {
-    if (!entity.has_table_entry())
-      return gutil::InternalErrorBuilder()
-             << "Entity in the read response has no table entry: "
-             << entity.DebugString();
-    table_entries.push_back(std::move(entity.table_entry()));
+absl::StatusOr<IrWriteResponse> SendPiUpdates(
+    P4RuntimeSession* session, absl::Span<const Update> updates,
+    const WriteBatchOptions& options) {
+  absl::Status rpc_wide_error;
+  return SendUpdatesInBatches(
+      session, updates.size(),
+      [updates](int i, Update* update) { *update = updates[i]; }, options,
+      &rpc_wide_error);
+}
+
+absl::Status SendPiUpdatesInSequence(P4RuntimeSession* session,
+                                     const P4InfoReferences& references,
+                                     absl::Span<const Update> updates,
+                                     const WriteBatchOptions& options) {
+  ASSIGN_OR_RETURN(std::vector<std::vector<int>> batches,
+                   SequencePiUpdatesInBatches(references, updates));
+  for (const std::vector<int>& batch : batches) {
+    RETURN_IF_ERROR(SendUpdatesInBatchesAndCheck(
+        session, batch.size(),
+        [&](int i, Update* update) { *update = updates[batch[i]]; }, options));
   }
+  return absl::OkStatus();
+}
+
+absl::Status SendPiUpdatesInSequence(P4RuntimeSession* session,
+                                     const IrP4Info& info,
+                                     absl::Span<const Update> updates,
+                                     const WriteBatchOptions& options) {
+  ASSIGN_OR_RETURN(const P4InfoReferences references,
+                   P4InfoReferences::Create(info));
+  return SendPiUpdatesInSequence(session, references, updates, options);
+}
+
+absl::StatusOr<std::vector<TableEntry>> ReadPiTableEntries(
+    P4RuntimeSession* session) {
+  std::vector<TableEntry> table_entries;
+  RETURN_IF_ERROR(ReadPiTableEntries(
+      session, [&table_entries](TableEntry& table_entry) {
+        table_entries.push_back(std::move(table_entry));
+        return absl::OkStatus();
+      }));
   return table_entries;
 }
 
-absl::Status ClearTableEntries(P4RuntimeSession* session,
-                               const IrP4Info& info) {
-  ASSIGN_OR_RETURN(auto table_entries, ReadPiTableEntries(session));
-  // Early return if there is nothing to clear.
-  if (table_entries.empty()) return absl::OkStatus();
-  return RemovePiTableEntries(session, table_entries);
+absl::Status ReadIrTableEntries(
+    P4RuntimeSession* session, const IrP4Info& info,
+    const std::function<absl::Status(IrTableEntry&)>& on_entry) {
+  IrTableEntry ir_entry;
+  return ReadPiTableEntries(
+      session, [&](TableEntry& pi_entry) -> absl::Status {
+        RETURN_IF_ERROR(PiTableEntryToIr(info, pi_entry, &ir_entry));
+        return on_entry(ir_entry);
+      });
 }
 
-absl::Status RemovePiTableEntries(P4RuntimeSession* session,
-                                  absl::Span<const TableEntry> pi_entries) {
-  WriteRequest clear_request;
-  clear_request.set_device_id(session->DeviceId());
-  *clear_request.mutable_election_id() = session->ElectionId();
+absl::Status ClearTableEntries(P4RuntimeSession* session, const IrP4Info& info,
+                               const WriteBatchOptions& options,
+                               gutil::ThreadPool* pool) {
+  std::vector<uint32_t> table_ids;
+  table_ids.reserve(info.tables_by_id().size());
+  for (const auto& [table_id, table] : info.tables_by_id()) {
+    table_ids.push_back(table_id);
+  }
+  return ClearTableEntries(session, info, table_ids, options, pool);
+}
 
-  for (const auto& table_entry : pi_entries) {
-    Update* update = clear_request.add_updates();
-    update->set_type(Update::DELETE);
-    *update->mutable_entity()->mutable_table_entry() = table_entry;
+absl::Status ClearTableEntries(P4RuntimeSession* session, const IrP4Info& info,
+                               absl::Span<const uint32_t> table_ids,
+                               const WriteBatchOptions& options,
+                               gutil::ThreadPool* pool) {
+  std::vector<uint32_t> sorted_table_ids(table_ids.begin(), table_ids.end());
+  absl::c_sort(sorted_table_ids);
+  sorted_table_ids.erase(
+      std::unique(sorted_table_ids.begin(), sorted_table_ids.end()),
+      sorted_table_ids.end());
+  for (uint32_t table_id : sorted_table_ids) {
+    if (!info.tables_by_id().contains(table_id)) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Cannot clear table with ID " << table_id
+             << ", which does not exist in the P4Info.";
+    }
   }
-  return SendPiWriteRequest(session, clear_request);
+  ASSIGN_OR_RETURN(const P4InfoReferences references,
+                   P4InfoReferences::Create(info));
+
+  const int num_tables = sorted_table_ids.size();
+  TableClearer clearer(session, info, references, std::move(sorted_table_ids),
+                       options);
+  gutil::ParallelFor(pool, num_tables,
+                     [&clearer](int i) { clearer.ReadAndDelete(i); });
+  return clearer.Finish();
+}
+
+absl::Status RemovePiTableEntries(P4RuntimeSession* session,
+                                  absl::Span<const TableEntry> pi_entries,
+                                  const WriteBatchOptions& options) {
+  return SendUpdatesInBatchesAndCheck(
+      session, pi_entries.size(),
+      [pi_entries](int i, Update* update) {
+        update->set_type(Update::DELETE);
+        *update->mutable_entity()->mutable_table_entry() = pi_entries[i];
+      },
+      options);
 }
 
 absl::Status InstallPiTableEntry(P4RuntimeSession* session,
@@ -117,17 +566,15 @@ absl::Status InstallPiTableEntry(P4RuntimeSession* session,
 }
 
 absl::Status InstallPiTableEntries(P4RuntimeSession* session,
-                                   absl::Span<const TableEntry> pi_entries) {
-  WriteRequest batch_write_request;
-  batch_write_request.set_device_id(session->DeviceId());
-  *batch_write_request.mutable_election_id() = session->ElectionId();
-
-  for (const auto& pi_entry : pi_entries) {
-    Update* update = batch_write_request.add_updates();
-    update->set_type(Update::INSERT);
-    *update->mutable_entity()->mutable_table_entry() = pi_entry;
-  }
-  return SendPiWriteRequest(session, batch_write_request);
+                                   absl::Span<const TableEntry> pi_entries,
+                                   const WriteBatchOptions& options) {
+  return SendUpdatesInBatchesAndCheck(
+      session, pi_entries.size(),
+      [pi_entries](int i, Update* update) {
+        update->set_type(Update::INSERT);
+        *update->mutable_entity()->mutable_table_entry() = pi_entries[i];
+      },
+      options);
 }
 
 absl::Status SetForwardingPipelineConfig(P4RuntimeSession* session,
@@ -14,15 +14,20 @@
 
 #ifndef GOOGLE_P4_PDPI_ENTITY_MANAGEMENT_H_
 #define GOOGLE_P4_PDPI_ENTITY_MANAGEMENT_H_
+#include <stdint.h>
+
+#include <functional>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "gutil/thread_pool.h"
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/connection_management.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/sequencing.h"
 
 namespace pdpi {
 
@@ -30,28 +35,130 @@ namespace pdpi {
 absl::StatusOr<p4::v1::ReadResponse> SendPiReadRequest(
     P4RuntimeSession* session, const p4::v1::ReadRequest& read_request);
 
+// Sends a PI (program independent) read request and calls `on_response` on
+// every ReadResponse of the reply stream as soon as it arrives, instead of
+// merging them into one message. `on_response` may modify (e.g. move from) the
+// response it is given. If it returns an error, the read is cancelled and the
+// error is returned.
+absl::Status SendPiReadRequest(
+    P4RuntimeSession* session, const p4::v1::ReadRequest& read_request,
+    const std::function<absl::Status(p4::v1::ReadResponse&)>& on_response);
+
 // Sends a PI (program independent) write request.
 absl::Status SendPiWriteRequest(P4RuntimeSession* session,
                                 const p4::v1::WriteRequest& write_request);
 
+// Options for sending many updates to the switch in several Write RPCs.
+struct WriteBatchOptions {
+  // Maximum number of updates per WriteRequest. Keeps requests below the gRPC
+  // message size limit and their per-update errors below
+  // P4GRPCMaxMetadataSize().
+  int max_updates_per_request = 5000;
+  // Maximum number of Write RPCs that are in flight at the same time. With 1,
+  // each request is only sent once the previous one completed, so requests are
+  // applied in order. Larger values pipeline the requests, but only suit
+  // updates that do not depend on each other.
+  int max_requests_in_flight = 1;
+};
+
+// Sends the given PI (program independent) updates in WriteRequests of at most
+// `options.max_updates_per_request` updates each, with up to
+// `options.max_requests_in_flight` of them in flight at the same time. Returns
+// the status of every update, in the order of `updates`; the updates of a
+// request that failed with an RPC-wide error all get that error. No further
+// requests are sent after an RPC-wide error, and the updates that were not sent
+// get ABORTED. Returns an error only if the switch replied with a malformed
+// status.
+// Like the updates of a single WriteRequest, the updates of requests that are
+// in flight at the same time may be applied in any order, so they must not
+// depend on each other unless `options.max_requests_in_flight` is 1.
+absl::StatusOr<IrWriteResponse> SendPiUpdates(
+    P4RuntimeSession* session, absl::Span<const p4::v1::Update> updates,
+    const WriteBatchOptions& options = WriteBatchOptions());
+
+// Sends the batches of SequencePiUpdatesInBatches one after the other, each
+// with SendPiUpdates, so that no update breaks a reference between the given
+// updates (see sequencing.h). Returns an error if any update failed, as
+// described at RemovePiTableEntries, without sending the remaining batches.
+absl::Status SendPiUpdatesInSequence(
+    P4RuntimeSession* session, const P4InfoReferences& references,
+    absl::Span<const p4::v1::Update> updates,
+    const WriteBatchOptions& options = WriteBatchOptions());
+// Same as above, but creates the P4InfoReferences of `info` on every call.
+absl::Status SendPiUpdatesInSequence(
+    P4RuntimeSession* session, const IrP4Info& info,
+    absl::Span<const p4::v1::Update> updates,
+    const WriteBatchOptions& options = WriteBatchOptions());
+
 // Reads PI (program independent) table entries.
 absl::StatusOr<std::vector<p4::v1::TableEntry>> ReadPiTableEntries(
     P4RuntimeSession* session);
 
-// Removes PI (program independent) table entries on the switch.
+// Reads PI (program independent) table entries and calls `on_entry` on each of
+// them as they arrive, so that the entries of the switch never have to be held
+// in memory all at once. `on_entry` may modify (e.g. move from) the entry it is
+// given. If it returns an error, the read is cancelled and the error is
+// returned.
+absl::Status ReadPiTableEntries(
+    P4RuntimeSession* session,
+    const std::function<absl::Status(p4::v1::TableEntry&)>& on_entry);
+
+// Same as above, but only reads the entries of the table with the given ID.
+absl::Status ReadPiTableEntries(
+    P4RuntimeSession* session, uint32_t table_id,
+    const std::function<absl::Status(p4::v1::TableEntry&)>& on_entry);
+
+// Same as above, but translates each entry to IR before calling `on_entry`.
+// Returns an error if an entry cannot be translated.
+absl::Status ReadIrTableEntries(
+    P4RuntimeSession* session, const IrP4Info& info,
+    const std::function<absl::Status(IrTableEntry&)>& on_entry);
+
+// Removes PI (program independent) table entries on the switch, using
+// SendPiUpdates. Returns an error if any of the entries could not be removed:
+// the RPC-wide error if there was one, and otherwise an error that lists the
+// result of every entry, numbered from #1 in the order of `pi_entries` across
+// all requests (see IrWriteResponseToReadableMessage).
 absl::Status RemovePiTableEntries(
-    P4RuntimeSession* session, absl::Span<const p4::v1::TableEntry> pi_entries);
+    P4RuntimeSession* session, absl::Span<const p4::v1::TableEntry> pi_entries,
+    const WriteBatchOptions& options = WriteBatchOptions());
+
+// Clears the table entries of all tables in `info`. Each table is read on its
+// own, in parallel on the threads of `pool` and the calling thread, or one
+// after the other on the calling thread if `pool` is nullptr. The entries of a
+// table are removed with SendPiUpdatesInSequence, in requests of at most
+// `options.max_updates_per_request` updates, as soon as the table was read and
+// the entries of all tables that may refer to them (see sequencing.h) were
+// removed, while other tables are still being read. Tables that may refer to
+// each other in a cycle, and the tables they refer to, are cleared together
+// once all reads completed. Returns the first error, in table ID order, of a
+// table that could not be cleared; tables whose clearing has not started by
+// then are not cleared.
+absl::Status ClearTableEntries(
+    P4RuntimeSession* session, const IrP4Info& info,
+    const WriteBatchOptions& options = WriteBatchOptions(),
+    gutil::ThreadPool* pool = nullptr);
 
-// Clears the table entries
-absl::Status ClearTableEntries(P4RuntimeSession* session, const IrP4Info& info);
+// Same as above, but only clears the tables with the given IDs. References
+// from entries of other tables are not considered, so removing an entry that
+// such an entry refers to fails. Returns InvalidArgument, without clearing any
+// table, if a table is not in `info`.
+absl::Status ClearTableEntries(
+    P4RuntimeSession* session, const IrP4Info& info,
+    absl::Span<const uint32_t> table_ids,
+    const WriteBatchOptions& options = WriteBatchOptions(),
+    gutil::ThreadPool* pool = nullptr);
 
 // Installs the given PI (program independent) table entry on the switch.
 absl::Status InstallPiTableEntry(P4RuntimeSession* session,
                                  const p4::v1::TableEntry& pi_entry);
 
-// Installs the given PI (program independent) table entries on the switch.
+// Installs the given PI (program independent) table entries on the switch,
+// using SendPiUpdates. Returns an error if any of the entries could not be
+// installed, as described at RemovePiTableEntries.
 absl::Status InstallPiTableEntries(
-    P4RuntimeSession* session, absl::Span<const p4::v1::TableEntry> pi_entries);
+    P4RuntimeSession* session, absl::Span<const p4::v1::TableEntry> pi_entries,
+    const WriteBatchOptions& options = WriteBatchOptions());
 
 // Sets the forwarding pipeline from the given p4 info.
 absl::Status SetForwardingPipelineConfig(P4RuntimeSession* session,
@@ -0,0 +1,508 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/internal/pi_wire_format.h"
+
+#include <cstdint>
+#include <limits>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+
+namespace pdpi {
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+using ::gutil::InvalidArgumentErrorBuilder;
+
+// The fields of p4::v1::Entity are all members of its `entity` oneof.
+constexpr int kLastEntityField = 12;
+
+constexpr uint32_t VarintTag(int field_number) {
+  return WireFormatLite::MakeTag(field_number, WireFormatLite::WIRETYPE_VARINT);
+}
+
+constexpr uint32_t LengthDelimitedTag(int field_number) {
+  return WireFormatLite::MakeTag(field_number,
+                                 WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+}
+
+// Reads a uint32, int32 or enum varint field into `value`, truncating the
+// varint to 32 bits like protobuf parsers do.
+template <typename T>
+absl::Status ReadVarint(PiWireReader& reader, T* value) {
+  uint64_t varint;
+  RETURN_IF_ERROR(reader.ReadVarint(&varint));
+  *value = static_cast<T>(static_cast<int32_t>(varint));
+  return absl::OkStatus();
+}
+
+// Makes `type_case` the set field of a oneof before merging into `field`. As
+// with protobuf messages, merging into a field that was not set starts from an
+// empty field.
+template <typename Case, typename View>
+View* MutableOneofField(Case type_case, Case* current_case, View* field) {
+  if (*current_case != type_case) {
+    *current_case = type_case;
+    *field = View();
+  }
+  return field;
+}
+
+// Parses the serialized message `bytes` into `view`.
+template <typename View>
+absl::Status ParseView(absl::string_view bytes, View* view) {
+  if (bytes.size() > std::numeric_limits<int>::max()) {
+    return InvalidArgumentErrorBuilder()
+           << "Message of " << bytes.size() << " bytes is too large";
+  }
+  PiWireReader reader(bytes);
+  RETURN_IF_ERROR(view->MergeFrom(reader));
+  return reader.CheckEndOfMessage();
+}
+
+}  // namespace
+
+PiWireReader::PiWireReader(absl::string_view bytes)
+    : position_(bytes.data()), limit_(bytes.data() + bytes.size()) {}
+
+uint32_t PiWireReader::NextTagSlow() {
+  if (position_ == limit_) return 0;
+  // Like protobuf parsers, accept tags of up to 5 bytes and ignore the bits
+  // beyond the 32nd.
+  uint32_t tag = 0;
+  for (int shift = 0; shift < 35 && position_ != limit_; shift += 7) {
+    const uint8_t byte = static_cast<uint8_t>(*position_++);
+    tag |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      // Field number 0 is invalid.
+      if (WireFormatLite::GetTagFieldNumber(tag) == 0) break;
+      tag_ = tag;
+      return tag_;
+    }
+  }
+  invalid_tag_ = true;
+  return 0;
+}
+
+absl::Status PiWireReader::ReadVarintSlow(uint64_t* value) {
+  // Varints have at most 10 bytes. Like protobuf parsers, bits beyond the
+  // 64th are ignored.
+  uint64_t result = 0;
+  for (int shift = 0; shift < 70 && position_ != limit_; shift += 7) {
+    const uint8_t byte = static_cast<uint8_t>(*position_++);
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      return absl::OkStatus();
+    }
+  }
+  return InvalidArgumentErrorBuilder()
+         << "Invalid varint in field "
+         << WireFormatLite::GetTagFieldNumber(tag_);
+}
+
+absl::Status PiWireReader::ReadSize(int* size) {
+  uint64_t varint;
+  RETURN_IF_ERROR(ReadVarint(&varint));
+  if (varint > static_cast<uint64_t>(limit_ - position_)) {
+    return InvalidArgumentErrorBuilder()
+           << "Invalid length of field "
+           << WireFormatLite::GetTagFieldNumber(tag_);
+  }
+  *size = static_cast<int>(varint);
+  return absl::OkStatus();
+}
+
+absl::Status PiWireReader::ReadBytes(absl::string_view* value) {
+  int size;
+  RETURN_IF_ERROR(ReadSize(&size));
+  *value = absl::string_view(position_, size);
+  position_ += size;
+  return absl::OkStatus();
+}
+
+absl::Status PiWireReader::SkipField() {
+  switch (WireFormatLite::GetTagWireType(tag_)) {
+    case WireFormatLite::WIRETYPE_VARINT: {
+      uint64_t value;
+      return ReadVarint(&value);
+    }
+    case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+      absl::string_view value;
+      return ReadBytes(&value);
+    }
+    case WireFormatLite::WIRETYPE_FIXED64:
+      if (limit_ - position_ < 8) break;
+      position_ += 8;
+      return absl::OkStatus();
+    case WireFormatLite::WIRETYPE_FIXED32:
+      if (limit_ - position_ < 4) break;
+      position_ += 4;
+      return absl::OkStatus();
+    case WireFormatLite::WIRETYPE_START_GROUP:
+      return SkipGroup(/*depth=*/0);
+    default:
+      break;
+  }
+  return InvalidArgumentErrorBuilder()
+         << "Invalid field " << WireFormatLite::GetTagFieldNumber(tag_)
+         << " with wire type " << WireFormatLite::GetTagWireType(tag_);
+}
+
+absl::Status PiWireReader::SkipGroup(int depth) {
+  // Protobuf parsers limit the nesting of groups and messages to 100 levels.
+  if (depth >= 100) {
+    return InvalidArgumentErrorBuilder() << "Groups are nested too deeply";
+  }
+  const int field_number = WireFormatLite::GetTagFieldNumber(tag_);
+  while (NextTag() != 0) {
+    switch (WireFormatLite::GetTagWireType(tag_)) {
+      case WireFormatLite::WIRETYPE_END_GROUP:
+        if (WireFormatLite::GetTagFieldNumber(tag_) != field_number) break;
+        return absl::OkStatus();
+      case WireFormatLite::WIRETYPE_START_GROUP:
+        RETURN_IF_ERROR(SkipGroup(depth + 1));
+        continue;
+      default:
+        RETURN_IF_ERROR(SkipField());
+        continue;
+    }
+    break;
+  }
+  return InvalidArgumentErrorBuilder()
+         << "Unterminated group in field " << field_number;
+}
+
+absl::Status PiWireReader::CheckEndOfMessage() {
+  if (invalid_tag_ || position_ != limit_) {
+    return InvalidArgumentErrorBuilder() << "Invalid tag";
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiWireReader::EnterMessage(const char** limit) {
+  int size;
+  RETURN_IF_ERROR(ReadSize(&size));
+  *limit = limit_;
+  limit_ = position_ + size;
+  return absl::OkStatus();
+}
+
+absl::Status PiWireReader::LeaveMessage(const char* limit) {
+  RETURN_IF_ERROR(CheckEndOfMessage());
+  limit_ = limit;
+  return absl::OkStatus();
+}
+
+absl::Status PiFieldMatchView::Value::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    if (tag == LengthDelimitedTag(1)) {
+      RETURN_IF_ERROR(reader.ReadBytes(&value_));
+    } else {
+      RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiFieldMatchView::Ternary::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case LengthDelimitedTag(1):
+        RETURN_IF_ERROR(reader.ReadBytes(&value_));
+        break;
+      case LengthDelimitedTag(2):
+        RETURN_IF_ERROR(reader.ReadBytes(&mask_));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiFieldMatchView::Lpm::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case LengthDelimitedTag(1):
+        RETURN_IF_ERROR(reader.ReadBytes(&value_));
+        break;
+      case VarintTag(2):
+        RETURN_IF_ERROR(ReadVarint(reader, &prefix_len_));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiFieldMatchView::MergeFrom(PiWireReader& reader) {
+  using p4::v1::FieldMatch;
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case VarintTag(1):
+        RETURN_IF_ERROR(ReadVarint(reader, &field_id_));
+        break;
+      case LengthDelimitedTag(2):
+        RETURN_IF_ERROR(reader.ReadMessage(
+            MutableOneofField(FieldMatch::kExact, &type_case_, &exact_)));
+        break;
+      case LengthDelimitedTag(3):
+        RETURN_IF_ERROR(reader.ReadMessage(
+            MutableOneofField(FieldMatch::kTernary, &type_case_, &ternary_)));
+        break;
+      case LengthDelimitedTag(4):
+        RETURN_IF_ERROR(reader.ReadMessage(
+            MutableOneofField(FieldMatch::kLpm, &type_case_, &lpm_)));
+        break;
+      case LengthDelimitedTag(6):
+        type_case_ = FieldMatch::kRange;
+        RETURN_IF_ERROR(reader.SkipField());
+        break;
+      case LengthDelimitedTag(7):
+        RETURN_IF_ERROR(reader.ReadMessage(MutableOneofField(
+            FieldMatch::kOptional, &type_case_, &optional_)));
+        break;
+      case LengthDelimitedTag(100):
+        type_case_ = FieldMatch::kOther;
+        RETURN_IF_ERROR(reader.SkipField());
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiActionView::Param::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case VarintTag(2):
+        RETURN_IF_ERROR(ReadVarint(reader, &param_id_));
+        break;
+      case LengthDelimitedTag(3):
+        RETURN_IF_ERROR(reader.ReadBytes(&value_));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiActionView::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case VarintTag(1):
+        RETURN_IF_ERROR(ReadVarint(reader, &action_id_));
+        break;
+      case LengthDelimitedTag(4):
+        params_.emplace_back();
+        RETURN_IF_ERROR(reader.ReadMessage(&params_.back()));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiActionProfileActionView::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case LengthDelimitedTag(1):
+        RETURN_IF_ERROR(reader.ReadMessage(&action_));
+        break;
+      case VarintTag(2):
+        RETURN_IF_ERROR(ReadVarint(reader, &weight_));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiActionProfileActionSetView::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    if (tag == LengthDelimitedTag(1)) {
+      action_profile_actions_.emplace_back();
+      RETURN_IF_ERROR(reader.ReadMessage(&action_profile_actions_.back()));
+    } else {
+      RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiTableActionView::MergeFrom(PiWireReader& reader) {
+  using p4::v1::TableAction;
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case LengthDelimitedTag(1):
+        RETURN_IF_ERROR(reader.ReadMessage(
+            MutableOneofField(TableAction::kAction, &type_case_, &action_)));
+        break;
+      case VarintTag(2):
+        type_case_ = TableAction::kActionProfileMemberId;
+        RETURN_IF_ERROR(reader.SkipField());
+        break;
+      case VarintTag(3):
+        type_case_ = TableAction::kActionProfileGroupId;
+        RETURN_IF_ERROR(reader.SkipField());
+        break;
+      case LengthDelimitedTag(4):
+        RETURN_IF_ERROR(reader.ReadMessage(
+            MutableOneofField(TableAction::kActionProfileActionSet,
+                              &type_case_, &action_profile_action_set_)));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiTableEntryView::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case VarintTag(1):
+        RETURN_IF_ERROR(ReadVarint(reader, &table_id_));
+        break;
+      case LengthDelimitedTag(2):
+        match_.emplace_back();
+        RETURN_IF_ERROR(reader.ReadMessage(&match_.back()));
+        break;
+      case LengthDelimitedTag(3):
+        has_action_ = true;
+        RETURN_IF_ERROR(reader.ReadMessage(&action_));
+        break;
+      case VarintTag(4):
+        RETURN_IF_ERROR(ReadVarint(reader, &priority_));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiEntityView::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    if (tag == LengthDelimitedTag(2)) {
+      if (!has_table_entry_) {
+        has_table_entry_ = true;
+        table_entry_ = PiTableEntryView();
+      }
+      RETURN_IF_ERROR(reader.ReadMessage(&table_entry_));
+      continue;
+    }
+    if (WireFormatLite::GetTagWireType(tag) ==
+            WireFormatLite::WIRETYPE_LENGTH_DELIMITED &&
+        WireFormatLite::GetTagFieldNumber(tag) <= kLastEntityField) {
+      has_table_entry_ = false;
+    }
+    RETURN_IF_ERROR(reader.SkipField());
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiUpdateView::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case VarintTag(1):
+        RETURN_IF_ERROR(ReadVarint(reader, &type_));
+        break;
+      case LengthDelimitedTag(2):
+        RETURN_IF_ERROR(reader.ReadMessage(&entity_));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiUint128View::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case VarintTag(1):
+        RETURN_IF_ERROR(reader.ReadVarint(&high_));
+        break;
+      case VarintTag(2):
+        RETURN_IF_ERROR(reader.ReadVarint(&low_));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiWriteRequestView::Parse(absl::string_view bytes) {
+  RETURN_IF_ERROR(ParseView(bytes, this)).SetPrepend()
+      << "Failed to parse serialized p4.v1.WriteRequest: ";
+  return absl::OkStatus();
+}
+
+absl::Status PiWriteRequestView::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    switch (tag) {
+      case VarintTag(1):
+        RETURN_IF_ERROR(reader.ReadVarint(&device_id_));
+        break;
+      case VarintTag(2):
+        RETURN_IF_ERROR(reader.ReadVarint(&role_id_));
+        break;
+      case LengthDelimitedTag(3):
+        RETURN_IF_ERROR(reader.ReadMessage(&election_id_));
+        break;
+      case LengthDelimitedTag(4):
+        updates_.emplace_back();
+        RETURN_IF_ERROR(reader.ReadMessage(&updates_.back()));
+        break;
+      case VarintTag(5):
+        RETURN_IF_ERROR(ReadVarint(reader, &atomicity_));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PiReadResponseView::Parse(absl::string_view bytes) {
+  RETURN_IF_ERROR(ParseView(bytes, this)).SetPrepend()
+      << "Failed to parse serialized p4.v1.ReadResponse: ";
+  return absl::OkStatus();
+}
+
+absl::Status PiReadResponseView::MergeFrom(PiWireReader& reader) {
+  while (const uint32_t tag = reader.NextTag()) {
+    if (tag == LengthDelimitedTag(1)) {
+      entities_.emplace_back();
+      RETURN_IF_ERROR(reader.ReadMessage(&entities_.back()));
+    } else {
+      RETURN_IF_ERROR(reader.SkipField());
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace pdpi
@@ -0,0 +1,333 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_P4_PDPI_INTERNAL_PI_WIRE_FORMAT_H_
+#define GOOGLE_P4_PDPI_INTERNAL_PI_WIRE_FORMAT_H_
+
+// Read-only views of serialized P4Runtime messages, used to translate them to
+// IR without parsing them into p4::v1 messages first.
+//
+// Each view has the same accessors as the corresponding p4::v1 message, but
+// only for the fields that the PI to IR translation reads, so that the
+// translation can be templated on the message type. Bytes fields are not
+// copied: they point into the serialized message, which must outlive the view.
+//
+// Parsing follows the protobuf wire format semantics (e.g. the last value of a
+// singular field wins), so a view holds the same values as the p4::v1 message
+// parsed from the same bytes. Fields that are not read by the translation are
+// skipped without parsing their contents, so unlike the p4::v1 message, a view
+// can be parsed from bytes with malformed contents in such fields.
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+
+namespace pdpi {
+
+class PiWireReader;
+
+// A view of p4::v1::FieldMatch.
+class PiFieldMatchView {
+ public:
+  // A view of p4::v1::FieldMatch::{Exact, Optional}.
+  class Value {
+   public:
+    absl::string_view value() const { return value_; }
+
+    absl::Status MergeFrom(PiWireReader& reader);
+
+   private:
+    absl::string_view value_;
+  };
+
+  // A view of p4::v1::FieldMatch::Ternary.
+  class Ternary {
+   public:
+    absl::string_view value() const { return value_; }
+    absl::string_view mask() const { return mask_; }
+
+    absl::Status MergeFrom(PiWireReader& reader);
+
+   private:
+    absl::string_view value_;
+    absl::string_view mask_;
+  };
+
+  // A view of p4::v1::FieldMatch::LPM.
+  class Lpm {
+   public:
+    absl::string_view value() const { return value_; }
+    int32_t prefix_len() const { return prefix_len_; }
+
+    absl::Status MergeFrom(PiWireReader& reader);
+
+   private:
+    absl::string_view value_;
+    int32_t prefix_len_ = 0;
+  };
+
+  uint32_t field_id() const { return field_id_; }
+  bool has_exact() const { return type_case_ == p4::v1::FieldMatch::kExact; }
+  bool has_ternary() const {
+    return type_case_ == p4::v1::FieldMatch::kTernary;
+  }
+  bool has_lpm() const { return type_case_ == p4::v1::FieldMatch::kLpm; }
+  bool has_optional() const {
+    return type_case_ == p4::v1::FieldMatch::kOptional;
+  }
+  const Value& exact() const { return exact_; }
+  const Ternary& ternary() const { return ternary_; }
+  const Lpm& lpm() const { return lpm_; }
+  const Value& optional() const { return optional_; }
+
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  uint32_t field_id_ = 0;
+  p4::v1::FieldMatch::FieldMatchTypeCase type_case_ =
+      p4::v1::FieldMatch::FIELD_MATCH_TYPE_NOT_SET;
+  Value exact_;
+  Ternary ternary_;
+  Lpm lpm_;
+  Value optional_;
+};
+
+// A view of p4::v1::Action.
+class PiActionView {
+ public:
+  // A view of p4::v1::Action::Param.
+  class Param {
+   public:
+    uint32_t param_id() const { return param_id_; }
+    absl::string_view value() const { return value_; }
+
+    absl::Status MergeFrom(PiWireReader& reader);
+
+   private:
+    uint32_t param_id_ = 0;
+    absl::string_view value_;
+  };
+
+  uint32_t action_id() const { return action_id_; }
+  const std::vector<Param>& params() const { return params_; }
+
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  uint32_t action_id_ = 0;
+  std::vector<Param> params_;
+};
+
+// A view of p4::v1::ActionProfileAction.
+class PiActionProfileActionView {
+ public:
+  const PiActionView& action() const { return action_; }
+  int32_t weight() const { return weight_; }
+
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  PiActionView action_;
+  int32_t weight_ = 0;
+};
+
+// A view of p4::v1::ActionProfileActionSet.
+class PiActionProfileActionSetView {
+ public:
+  const std::vector<PiActionProfileActionView>& action_profile_actions()
+      const {
+    return action_profile_actions_;
+  }
+
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  std::vector<PiActionProfileActionView> action_profile_actions_;
+};
+
+// A view of p4::v1::TableAction.
+class PiTableActionView {
+ public:
+  p4::v1::TableAction::TypeCase type_case() const { return type_case_; }
+  const PiActionView& action() const { return action_; }
+  const PiActionProfileActionSetView& action_profile_action_set() const {
+    return action_profile_action_set_;
+  }
+
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  p4::v1::TableAction::TypeCase type_case_ = p4::v1::TableAction::TYPE_NOT_SET;
+  PiActionView action_;
+  PiActionProfileActionSetView action_profile_action_set_;
+};
+
+// A view of p4::v1::TableEntry.
+class PiTableEntryView {
+ public:
+  uint32_t table_id() const { return table_id_; }
+  const std::vector<PiFieldMatchView>& match() const { return match_; }
+  bool has_action() const { return has_action_; }
+  const PiTableActionView& action() const { return action_; }
+  int32_t priority() const { return priority_; }
+
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  uint32_t table_id_ = 0;
+  std::vector<PiFieldMatchView> match_;
+  bool has_action_ = false;
+  PiTableActionView action_;
+  int32_t priority_ = 0;
+};
+
+// A view of p4::v1::Entity.
+class PiEntityView {
+ public:
+  bool has_table_entry() const { return has_table_entry_; }
+  const PiTableEntryView& table_entry() const { return table_entry_; }
+
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  bool has_table_entry_ = false;
+  PiTableEntryView table_entry_;
+};
+
+// A view of p4::v1::Update.
+class PiUpdateView {
+ public:
+  p4::v1::Update::Type type() const { return type_; }
+  const PiEntityView& entity() const { return entity_; }
+
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  p4::v1::Update::Type type_ = p4::v1::Update::UNSPECIFIED;
+  PiEntityView entity_;
+};
+
+// A view of p4::v1::Uint128.
+class PiUint128View {
+ public:
+  uint64_t high() const { return high_; }
+  uint64_t low() const { return low_; }
+
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  uint64_t high_ = 0;
+  uint64_t low_ = 0;
+};
+
+// A view of p4::v1::WriteRequest.
+class PiWriteRequestView {
+ public:
+  uint64_t device_id() const { return device_id_; }
+  uint64_t role_id() const { return role_id_; }
+  const PiUint128View& election_id() const { return election_id_; }
+  const std::vector<PiUpdateView>& updates() const { return updates_; }
+  p4::v1::WriteRequest::Atomicity atomicity() const { return atomicity_; }
+
+  // Parses the serialized p4::v1::WriteRequest `bytes` into this view, which
+  // must be empty. Returns InvalidArgument if `bytes` is malformed.
+  absl::Status Parse(absl::string_view bytes);
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  uint64_t device_id_ = 0;
+  uint64_t role_id_ = 0;
+  PiUint128View election_id_;
+  std::vector<PiUpdateView> updates_;
+  p4::v1::WriteRequest::Atomicity atomicity_ =
+      p4::v1::WriteRequest::CONTINUE_ON_ERROR;
+};
+
+// A view of p4::v1::ReadResponse.
+class PiReadResponseView {
+ public:
+  const std::vector<PiEntityView>& entities() const { return entities_; }
+
+  // Parses the serialized p4::v1::ReadResponse `bytes` into this view, which
+  // must be empty. Returns InvalidArgument if `bytes` is malformed.
+  absl::Status Parse(absl::string_view bytes);
+  absl::Status MergeFrom(PiWireReader& reader);
+
+ private:
+  std::vector<PiEntityView> entities_;
+};
+
+// Reads the fields of a serialized message for the MergeFrom methods above.
+class PiWireReader {
+ public:
+  explicit PiWireReader(absl::string_view bytes);
+
+  // Returns the tag of the next field of the current message, or 0 if there is
+  // none or the tag is invalid.
+  uint32_t NextTag() {
+    // Fast path for the tags of fields 1 to 15, which take a single byte.
+    if (position_ != limit_ && static_cast<uint8_t>(*position_) >= 0x08 &&
+        static_cast<uint8_t>(*position_) < 0x80) {
+      tag_ = static_cast<uint8_t>(*position_++);
+      return tag_;
+    }
+    return NextTagSlow();
+  }
+
+  // Reads the value of the field whose tag was returned by the last call to
+  // NextTag. The wire type of the tag must match the type of the value.
+  absl::Status ReadVarint(uint64_t* value) {
+    // Fast path for values below 128, which take a single byte.
+    if (position_ != limit_ && static_cast<uint8_t>(*position_) < 0x80) {
+      *value = static_cast<uint8_t>(*position_++);
+      return absl::OkStatus();
+    }
+    return ReadVarintSlow(value);
+  }
+  absl::Status ReadBytes(absl::string_view* value);
+  template <typename View>
+  absl::Status ReadMessage(View* view) {
+    const char* limit;
+    RETURN_IF_ERROR(EnterMessage(&limit));
+    RETURN_IF_ERROR(view->MergeFrom(*this));
+    return LeaveMessage(limit);
+  }
+  absl::Status SkipField();
+
+  // Returns an error if NextTag stopped at an invalid tag, or if not all bytes
+  // of the current message were read.
+  absl::Status CheckEndOfMessage();
+
+ private:
+  uint32_t NextTagSlow();
+  absl::Status ReadVarintSlow(uint64_t* value);
+  absl::Status EnterMessage(const char** limit);
+  absl::Status LeaveMessage(const char* limit);
+  absl::Status ReadSize(int* size);
+  absl::Status SkipGroup(int depth);
+
+  // The next byte to read, and the end of the current message.
+  const char* position_;
+  const char* limit_;
+  uint32_t tag_ = 0;
+  bool invalid_tag_ = false;
+};
+
+}  // namespace pdpi
+
+#endif  // GOOGLE_P4_PDPI_INTERNAL_PI_WIRE_FORMAT_H_
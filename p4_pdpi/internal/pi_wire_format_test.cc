@@ -0,0 +1,192 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/internal/pi_wire_format.h"
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "google/protobuf/unknown_field_set.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "p4/v1/p4runtime.pb.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::IsEmpty;
+
+// Returns `bytes` serialized as the length-delimited field `field_number` of a
+// message.
+std::string LengthDelimitedField(int field_number, const std::string& bytes) {
+  google::protobuf::UnknownFieldSet fields;
+  fields.AddLengthDelimited(field_number, bytes);
+  std::string result;
+  fields.SerializeToString(&result);
+  return result;
+}
+
+TEST(PiWireFormatTest, ParsesWriteRequest) {
+  const auto write_request = gutil::ParseProtoOrDie<p4::v1::WriteRequest>(R"pb(
+    device_id: 7
+    role_id: 2
+    election_id { high: 1 low: 3 }
+    atomicity: ROLLBACK_ON_ERROR
+    updates {
+      type: MODIFY
+      entity {
+        table_entry {
+          table_id: 33554433
+          match {
+            field_id: 1
+            ternary { value: "\x01" mask: "\x0f" }
+          }
+          match {
+            field_id: 2
+            lpm { value: "\x0a\x00" prefix_len: 8 }
+          }
+          priority: 10
+          counter_data { byte_count: 10 }
+          action {
+            action { action_id: 16777217 params { param_id: 1 value: "ab" } }
+          }
+        }
+      }
+    }
+  )pb");
+  PiWriteRequestView view;
+  ASSERT_OK(view.Parse(write_request.SerializeAsString()));
+  EXPECT_EQ(view.device_id(), 7);
+  EXPECT_EQ(view.role_id(), 2);
+  EXPECT_EQ(view.election_id().high(), 1);
+  EXPECT_EQ(view.election_id().low(), 3);
+  EXPECT_EQ(view.atomicity(), p4::v1::WriteRequest::ROLLBACK_ON_ERROR);
+  ASSERT_EQ(view.updates().size(), 1);
+  const PiUpdateView& update = view.updates()[0];
+  EXPECT_EQ(update.type(), p4::v1::Update::MODIFY);
+  ASSERT_TRUE(update.entity().has_table_entry());
+  const PiTableEntryView& entry = update.entity().table_entry();
+  EXPECT_EQ(entry.table_id(), 33554433);
+  EXPECT_EQ(entry.priority(), 10);
+  ASSERT_EQ(entry.match().size(), 2);
+  EXPECT_TRUE(entry.match()[0].has_ternary());
+  EXPECT_EQ(entry.match()[0].ternary().value(), "\x01");
+  EXPECT_EQ(entry.match()[0].ternary().mask(), "\x0f");
+  EXPECT_TRUE(entry.match()[1].has_lpm());
+  EXPECT_EQ(entry.match()[1].lpm().value(), std::string("\x0a\x00", 2));
+  EXPECT_EQ(entry.match()[1].lpm().prefix_len(), 8);
+  ASSERT_TRUE(entry.has_action());
+  EXPECT_EQ(entry.action().type_case(), p4::v1::TableAction::kAction);
+  EXPECT_EQ(entry.action().action().action_id(), 16777217);
+  ASSERT_EQ(entry.action().action().params().size(), 1);
+  EXPECT_EQ(entry.action().action().params()[0].value(), "ab");
+}
+
+TEST(PiWireFormatTest, MergesLikeProtobuf) {
+  // Repeated occurrences of a table entry are merged: the last value of a
+  // singular field wins, and setting another field of a oneof clears the
+  // previous one.
+  p4::v1::TableEntry first;
+  first.set_priority(1);
+  first.add_match()->mutable_exact()->set_value("a");
+  first.mutable_action()->mutable_action()->set_action_id(1);
+  p4::v1::TableEntry second;
+  second.set_priority(2);
+  second.mutable_action()->set_action_profile_member_id(5);
+  p4::v1::TableEntry third;
+  third.mutable_action()->mutable_action()->add_params()->set_value("b");
+  const std::string bytes = LengthDelimitedField(
+      1, LengthDelimitedField(2, first.SerializeAsString() +
+                                     second.SerializeAsString() +
+                                     third.SerializeAsString()));
+  p4::v1::ReadResponse expected;
+  ASSERT_TRUE(expected.ParseFromString(bytes));
+  const p4::v1::TableEntry& expected_entry = expected.entities(0).table_entry();
+
+  PiReadResponseView view;
+  ASSERT_OK(view.Parse(bytes));
+  ASSERT_EQ(view.entities().size(), 1);
+  const PiTableEntryView& entry = view.entities()[0].table_entry();
+  EXPECT_EQ(entry.priority(), expected_entry.priority());
+  ASSERT_EQ(entry.match().size(), expected_entry.match_size());
+  EXPECT_EQ(entry.match()[0].exact().value(),
+            expected_entry.match(0).exact().value());
+  EXPECT_EQ(entry.action().type_case(), expected_entry.action().type_case());
+  EXPECT_EQ(entry.action().action().action_id(),
+            expected_entry.action().action().action_id());
+  ASSERT_EQ(entry.action().action().params().size(),
+            expected_entry.action().action().params_size());
+  EXPECT_EQ(entry.action().action().params()[0].value(),
+            expected_entry.action().action().params(0).value());
+}
+
+TEST(PiWireFormatTest, OtherEntityClearsTableEntry) {
+  p4::v1::Entity table_entry;
+  table_entry.mutable_table_entry()->set_table_id(1);
+  p4::v1::Entity member;
+  member.mutable_action_profile_member()->set_member_id(1);
+  const std::string bytes = LengthDelimitedField(
+      1, table_entry.SerializeAsString() + member.SerializeAsString());
+  p4::v1::ReadResponse expected;
+  ASSERT_TRUE(expected.ParseFromString(bytes));
+  ASSERT_FALSE(expected.entities(0).has_table_entry());
+
+  PiReadResponseView view;
+  ASSERT_OK(view.Parse(bytes));
+  ASSERT_EQ(view.entities().size(), 1);
+  EXPECT_FALSE(view.entities()[0].has_table_entry());
+}
+
+TEST(PiWireFormatTest, SkipsUnknownFields) {
+  p4::v1::WriteRequest write_request;
+  write_request.set_device_id(1);
+  write_request.GetReflection()
+      ->MutableUnknownFields(&write_request)
+      ->AddLengthDelimited(1000, "unknown");
+  PiWriteRequestView view;
+  ASSERT_OK(view.Parse(write_request.SerializeAsString()));
+  EXPECT_EQ(view.device_id(), 1);
+  EXPECT_THAT(view.updates(), IsEmpty());
+}
+
+TEST(PiWireFormatTest, RejectsMalformedBytes) {
+  const auto write_request = gutil::ParseProtoOrDie<p4::v1::WriteRequest>(R"pb(
+    updates {
+      type: INSERT
+      entity { table_entry { table_id: 1 } }
+    }
+  )pb");
+  const std::string bytes = write_request.SerializeAsString();
+  for (int size = 1; size < bytes.size(); ++size) {
+    PiWriteRequestView view;
+    EXPECT_THAT(view.Parse(bytes.substr(0, size)),
+                StatusIs(absl::StatusCode::kInvalidArgument))
+        << "truncated to " << size << " bytes";
+  }
+  // Field number 0.
+  EXPECT_THAT(PiWriteRequestView().Parse(std::string("\x00\x01", 2)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  // Unterminated varint.
+  EXPECT_THAT(PiWriteRequestView().Parse("\x08\xff"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  // Unmatched end of group.
+  EXPECT_THAT(PiWriteRequestView().Parse("\x0c"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace pdpi
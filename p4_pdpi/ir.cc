@@ -17,28 +17,45 @@
 #include <ctype.h>
 #include <stdint.h>
 
+#include <list>
+#include <memory>
 #include <optional>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "google/protobuf/any.pb.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/map.h"
+#include "google/protobuf/message.h"
 #include "google/protobuf/repeated_field.h"
 #include "google/rpc/code.pb.h"
 #include "google/rpc/status.pb.h"
 #include "gutil/collections.h"
 #include "gutil/status.h"
+#include "gutil/thread_pool.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/config/v1/p4types.pb.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
+#include "p4_pdpi/internal/ordered_protobuf_map.h"
+#include "p4_pdpi/internal/pi_wire_format.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/utils/ir.h"
 
@@ -57,6 +74,25 @@ using ::pdpi::IrP4Info;
 using ::pdpi::IrTableDefinition;
 
 namespace {
+// Serializes `message` to `bytes`, always in the same way for equal messages.
+bool SerializeDeterministically(const google::protobuf::Message &message,
+                                std::string *bytes) {
+  bytes->clear();
+  google::protobuf::io::StringOutputStream stream(bytes);
+  google::protobuf::io::CodedOutputStream coded_stream(&stream);
+  coded_stream.SetSerializationDeterministic(true);
+  return message.SerializeToCodedStream(&coded_stream);
+}
+
+// Returns true if `a` and `b` are equal. Much cheaper than MessageDifferencer,
+// which relies on reflection.
+bool Equal(const google::protobuf::Message &a,
+           const google::protobuf::Message &b) {
+  std::string a_bytes, b_bytes;
+  return SerializeDeterministically(a, &a_bytes) &&
+         SerializeDeterministically(b, &b_bytes) && a_bytes == b_bytes;
+}
+
 // Helper for GetFormat that extracts the necessary info from a P4Info
 // element. T could be p4::config::v1::ControllerPacketMetadata::Metadata,
 // p4::config::v1::MatchField, or p4::config::v1::Action::Param (basically
@@ -68,11 +104,11 @@ StatusOr<Format> GetFormatForP4InfoElement(const T &element,
   bool is_sdn_string = false;
   if (element.has_type_name()) {
     const auto &name = element.type_name().name();
-    ASSIGN_OR_RETURN(const auto &named_type,
-                     gutil::FindOrStatus(type_info.new_types(), name),
+    ASSIGN_OR_RETURN(const auto *named_type,
+                     gutil::FindPtrOrStatus(type_info.new_types(), name),
                      _ << "Type definition for \"" << name << "\" not found");
-    if (named_type.has_translated_type()) {
-      if (named_type.translated_type().sdn_type_case() ==
+    if (named_type->has_translated_type()) {
+      if (named_type->translated_type().sdn_type_case() ==
           p4::config::v1::P4NewTypeTranslation::kSdnString) {
         is_sdn_string = true;
       }
@@ -178,158 +214,285 @@ absl::Status ValidateMatchFieldDefinition(const IrMatchFieldDefinition &match) {
   }
 }
 
-}  // namespace
+// Translates an action definition to IR.
+StatusOr<IrActionDefinition> CreateIrActionDefinition(
+    const p4::config::v1::Action &action, const P4TypeInfo &type_info) {
+  IrActionDefinition ir_action;
+  *ir_action.mutable_preamble() = action.preamble();
+  for (const auto &param : action.params()) {
+    IrActionDefinition::IrActionParamDefinition ir_param;
+    *ir_param.mutable_param() = param;
+    ASSIGN_OR_RETURN(const auto &format,
+                     GetFormatForP4InfoElement(param, type_info));
+    ir_param.set_format(format);
+    RETURN_IF_ERROR(gutil::InsertIfUnique(
+        ir_action.mutable_params_by_id(), param.id(), ir_param,
+        absl::StrCat("Found several parameters with the same ID ", param.id(),
+                     " for action ", action.preamble().alias())));
+    RETURN_IF_ERROR(gutil::InsertIfUnique(
+        ir_action.mutable_params_by_name(), param.name(), ir_param,
+        absl::StrCat("Found several parameters with the same name \"",
+                     param.name(), "\" for action \"",
+                     action.preamble().alias(), "\"")));
+  }
+  return ir_action;
+}
 
-StatusOr<IrP4Info> CreateIrP4Info(const p4::config::v1::P4Info &p4_info) {
-  IrP4Info info;
-  const P4TypeInfo &type_info = p4_info.type_info();
+// Translates a table definition to IR, except for its direct counter and
+// meter. The actions of the table must have been added to `info` already.
+StatusOr<IrTableDefinition> CreateIrTableDefinition(
+    const p4::config::v1::Table &table, const IrP4Info &info,
+    const P4TypeInfo &type_info) {
+  IrTableDefinition ir_table_definition;
+  *ir_table_definition.mutable_preamble() = table.preamble();
+  for (const auto &match_field : table.match_fields()) {
+    IrMatchFieldDefinition ir_match_definition;
+    *ir_match_definition.mutable_match_field() = match_field;
+    ASSIGN_OR_RETURN(const auto &format,
+                     GetFormatForP4InfoElement(match_field, type_info));
+    ir_match_definition.set_format(format);
+    RETURN_IF_ERROR(ValidateMatchFieldDefinition(ir_match_definition))
+        << "Table " << table.preamble().alias() << " has invalid match field";
 
-  // Translate all action definitions to IR.
-  for (const auto &action : p4_info.actions()) {
-    IrActionDefinition ir_action;
-    *ir_action.mutable_preamble() = action.preamble();
-    for (const auto &param : action.params()) {
-      IrActionDefinition::IrActionParamDefinition ir_param;
-      *ir_param.mutable_param() = param;
-      ASSIGN_OR_RETURN(const auto &format,
-                       GetFormatForP4InfoElement(param, type_info));
-      ir_param.set_format(format);
-      RETURN_IF_ERROR(gutil::InsertIfUnique(
-          ir_action.mutable_params_by_id(), param.id(), ir_param,
-          absl::StrCat("Found several parameters with the same ID ", param.id(),
-                       " for action ", action.preamble().alias())));
-      RETURN_IF_ERROR(gutil::InsertIfUnique(
-          ir_action.mutable_params_by_name(), param.name(), ir_param,
-          absl::StrCat("Found several parameters with the same name \"",
-                       param.name(), "\" for action \"",
-                       action.preamble().alias(), "\"")));
-    }
     RETURN_IF_ERROR(gutil::InsertIfUnique(
-        info.mutable_actions_by_id(), action.preamble().id(), ir_action,
-        absl::StrCat("Found several actions with the same ID: ",
-                     action.preamble().id())));
+        ir_table_definition.mutable_match_fields_by_id(), match_field.id(),
+        ir_match_definition,
+        absl::StrCat("Found several match fields with the same ID ",
+                     match_field.id(), " in table \"",
+                     table.preamble().alias(), "\"")));
     RETURN_IF_ERROR(gutil::InsertIfUnique(
-        info.mutable_actions_by_name(), action.preamble().alias(), ir_action,
-        absl::StrCat("Found several actions with the same name: ",
-                     action.preamble().name())));
+        ir_table_definition.mutable_match_fields_by_name(), match_field.name(),
+        ir_match_definition,
+        absl::StrCat("Found several match fields with the same name \"",
+                     match_field.name(), "\" in table \"",
+                     table.preamble().alias(), "\"")));
   }
 
-  // Translate all table definitions to IR.
-  for (const auto &table : p4_info.tables()) {
-    IrTableDefinition ir_table_definition;
-    uint32_t table_id = table.preamble().id();
-    *ir_table_definition.mutable_preamble() = table.preamble();
-    for (const auto &match_field : table.match_fields()) {
-      IrMatchFieldDefinition ir_match_definition;
-      *ir_match_definition.mutable_match_field() = match_field;
-      ASSIGN_OR_RETURN(const auto &format,
-                       GetFormatForP4InfoElement(match_field, type_info));
-      ir_match_definition.set_format(format);
-      RETURN_IF_ERROR(ValidateMatchFieldDefinition(ir_match_definition))
-          << "Table " << table.preamble().alias() << " has invalid match field";
-
-      RETURN_IF_ERROR(gutil::InsertIfUnique(
-          ir_table_definition.mutable_match_fields_by_id(), match_field.id(),
-          ir_match_definition,
-          absl::StrCat("Found several match fields with the same ID ",
-                       match_field.id(), " in table \"",
-                       table.preamble().alias(), "\"")));
-      RETURN_IF_ERROR(gutil::InsertIfUnique(
-          ir_table_definition.mutable_match_fields_by_name(),
-          match_field.name(), ir_match_definition,
-          absl::StrCat("Found several match fields with the same name \"",
-                       match_field.name(), "\" in table \"",
-                       table.preamble().alias(), "\"")));
-    }
-
-    // Is WCMP table?
-    const bool is_wcmp = table.implementation_id() != 0;
-    const bool has_oneshot = absl::c_any_of(
-        table.preamble().annotations(),
-        [](const std::string &annotation) { return annotation == "@oneshot"; });
-    if (is_wcmp != has_oneshot) {
-      return UnimplementedErrorBuilder()
-             << "A WCMP table must have a @oneshot annotation, but \""
-             << table.preamble().alias()
-             << "\" is not valid. is_wcmp = " << is_wcmp
-             << ", has_oneshot = " << has_oneshot << "";
-    }
-    if (is_wcmp) {
-      ir_table_definition.set_uses_oneshot(true);
+  // Is WCMP table?
+  const bool is_wcmp = table.implementation_id() != 0;
+  const bool has_oneshot = absl::c_any_of(
+      table.preamble().annotations(),
+      [](const std::string &annotation) { return annotation == "@oneshot"; });
+  if (is_wcmp != has_oneshot) {
+    return UnimplementedErrorBuilder()
+           << "A WCMP table must have a @oneshot annotation, but \""
+           << table.preamble().alias()
+           << "\" is not valid. is_wcmp = " << is_wcmp
+           << ", has_oneshot = " << has_oneshot << "";
+  }
+  if (is_wcmp) {
+    ir_table_definition.set_uses_oneshot(true);
+    ASSIGN_OR_RETURN(
+        const uint32_t weight_proto_id,
+        GetNumberInAnnotation(table.preamble().annotations(),
+                              "weight_proto_id"),
+        _ << "WCMP table \"" << table.preamble().alias()
+          << "\" does not have a valid @weight_proto_id annotation");
+    ir_table_definition.set_weight_proto_id(weight_proto_id);
+  }
+
+  for (const auto &action_ref : table.action_refs()) {
+    // Make sure the action is defined
+    ASSIGN_OR_RETURN(
+        const auto *action,
+        gutil::FindPtrOrStatus(info.actions_by_id(), action_ref.id()),
+        _ << "Missing definition for action with id " << action_ref.id());
+    // Built in place, since action definitions can be large.
+    IrActionReference *ir_action_reference =
+        action_ref.scope() == p4::config::v1::ActionRef::DEFAULT_ONLY
+            ? ir_table_definition.add_default_only_actions()
+            : ir_table_definition.add_entry_actions();
+    *ir_action_reference->mutable_ref() = action_ref;
+    *ir_action_reference->mutable_action() = *action;
+    if (action_ref.scope() != p4::config::v1::ActionRef::DEFAULT_ONLY) {
+      uint32_t proto_id = 0;
       ASSIGN_OR_RETURN(
-          const uint32_t weight_proto_id,
-          GetNumberInAnnotation(table.preamble().annotations(),
-                                "weight_proto_id"),
-          _ << "WCMP table \"" << table.preamble().alias()
-            << "\" does not have a valid @weight_proto_id annotation");
-      ir_table_definition.set_weight_proto_id(weight_proto_id);
+          proto_id, GetNumberInAnnotation(action_ref.annotations(), "proto_id"),
+          _ << "Action \"" << action->preamble().name() << "\" in table \""
+            << table.preamble().alias()
+            << "\" does not have a valid @proto_id annotation");
+      ir_action_reference->set_proto_id(proto_id);
     }
+  }
+  if (table.const_default_action_id() != 0) {
+    const uint32_t const_default_action_id = table.const_default_action_id();
+    const IrActionReference *const_default_action_reference = nullptr;
 
-    p4::config::v1::ActionRef default_action_ref;
-    for (const auto &action_ref : table.action_refs()) {
-      IrActionReference ir_action_reference;
-      *ir_action_reference.mutable_ref() = action_ref;
-      // Make sure the action is defined
-      ASSIGN_OR_RETURN(
-          *ir_action_reference.mutable_action(),
-          gutil::FindOrStatus(info.actions_by_id(), action_ref.id()),
-          _ << "Missing definition for action with id " << action_ref.id());
-      if (action_ref.scope() == p4::config::v1::ActionRef::DEFAULT_ONLY) {
-        *ir_table_definition.add_default_only_actions() = ir_action_reference;
-      } else {
-        uint32_t proto_id = 0;
-        ASSIGN_OR_RETURN(
-            proto_id,
-            GetNumberInAnnotation(action_ref.annotations(), "proto_id"),
-            _ << "Action \"" << ir_action_reference.action().preamble().name()
-              << "\" in table \"" << table.preamble().alias()
-              << "\" does not have a valid @proto_id annotation");
-        ir_action_reference.set_proto_id(proto_id);
-        *ir_table_definition.add_entry_actions() = ir_action_reference;
+    // The const_default_action should always point to a table action.
+    for (const auto &action : ir_table_definition.default_only_actions()) {
+      if (action.ref().id() == const_default_action_id) {
+        const_default_action_reference = &action;
+        break;
       }
     }
-    if (table.const_default_action_id() != 0) {
-      const uint32_t const_default_action_id = table.const_default_action_id();
-      IrActionReference const_default_action_reference;
-
-      // The const_default_action should always point to a table action.
-      for (const auto &action : ir_table_definition.default_only_actions()) {
+    if (const_default_action_reference == nullptr) {
+      for (const auto &action : ir_table_definition.entry_actions()) {
         if (action.ref().id() == const_default_action_id) {
-          const_default_action_reference = action;
+          const_default_action_reference = &action;
           break;
         }
       }
-      if (const_default_action_reference.ref().id() == 0) {
-        for (const auto &action : ir_table_definition.entry_actions()) {
-          if (action.ref().id() == const_default_action_id) {
-            const_default_action_reference = action;
-            break;
-          }
-        }
-      }
-      if (const_default_action_reference.ref().id() == 0) {
-        return gutil::InvalidArgumentErrorBuilder()
-               << "Table \"" << table.preamble().alias()
-               << "\" default action id " << table.const_default_action_id()
-               << " does not match any of the table's actions";
+    }
+    if (const_default_action_reference == nullptr) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Table \"" << table.preamble().alias()
+             << "\" default action id " << table.const_default_action_id()
+             << " does not match any of the table's actions";
+    }
+
+    *ir_table_definition.mutable_const_default_action() =
+        const_default_action_reference->action();
+  }
+
+  ir_table_definition.set_size(table.size());
+  return ir_table_definition;
+}
+
+// The IrP4Info of a previous P4Info, which provides the IR definitions of the
+// actions and tables that are unchanged in a new P4Info.
+class PreviousIrP4Info {
+ public:
+  PreviousIrP4Info(const IrP4Info &info,
+                   const p4::config::v1::P4Info &p4_info,
+                   const p4::config::v1::P4Info &new_p4_info)
+      : info_(info) {
+    // Formats depend on the type info, so nothing can be reused if it changed.
+    if (!Equal(p4_info.type_info(), new_p4_info.type_info())) {
+      return;
+    }
+    for (const auto &action : p4_info.actions()) {
+      actions_by_id_[action.preamble().id()] = &action;
+    }
+    for (const auto &table : p4_info.tables()) {
+      tables_by_id_[table.preamble().id()] = &table;
+    }
+    for (const auto &action : new_p4_info.actions()) {
+      const uint32_t id = action.preamble().id();
+      const auto it = actions_by_id_.find(id);
+      if (it != actions_by_id_.end() && Equal(*it->second, action)) {
+        unchanged_action_ids_.insert(id);
       }
+    }
+  }
 
-      *ir_table_definition.mutable_const_default_action() =
-          const_default_action_reference.action();
+  // Returns the IR definition of `action`, if it is unchanged, or nullptr.
+  const IrActionDefinition *FindUnchanged(
+      const p4::config::v1::Action &action) const {
+    if (!unchanged_action_ids_.contains(action.preamble().id())) {
+      return nullptr;
+    }
+    return gutil::FindOrNull(info_.actions_by_id(), action.preamble().id());
+  }
+
+  // Returns the IR definition of `table`, if it and its actions are
+  // unchanged, or nullptr. The definition includes the previous direct counter
+  // and meter of the table, which may have changed since.
+  const IrTableDefinition *FindUnchanged(
+      const p4::config::v1::Table &table) const {
+    const uint32_t id = table.preamble().id();
+    const auto it = tables_by_id_.find(id);
+    if (it == tables_by_id_.end() || !Equal(*it->second, table)) {
+      return nullptr;
+    }
+    for (const auto &action_ref : table.action_refs()) {
+      if (!unchanged_action_ids_.contains(action_ref.id())) return nullptr;
     }
+    return gutil::FindOrNull(info_.tables_by_id(), id);
+  }
+
+ private:
+  const IrP4Info &info_;
+  absl::flat_hash_map<uint32_t, const p4::config::v1::Action *> actions_by_id_;
+  absl::flat_hash_map<uint32_t, const p4::config::v1::Table *> tables_by_id_;
+  absl::flat_hash_set<uint32_t> unchanged_action_ids_;
+};
+
+// Translates `p4_info` to IR. If `previous` is not null, the IR definitions of
+// unchanged actions and tables are copied from it instead. Actions and tables
+// are translated in parallel on the threads of `pool`, if it is not null, but
+// added in order, so that errors are the same as when translating in order.
+StatusOr<IrP4Info> TranslateP4Info(const p4::config::v1::P4Info &p4_info,
+                                   const PreviousIrP4Info *previous,
+                                   gutil::ThreadPool *pool) {
+  IrP4Info info;
+  const P4TypeInfo &type_info = p4_info.type_info();
+
+  // Translate all action definitions to IR.
+  const auto &actions = p4_info.actions();
+  std::vector<const IrActionDefinition *> unchanged_actions(actions.size());
+  std::vector<StatusOr<IrActionDefinition>> new_ir_actions(actions.size());
+  gutil::ParallelFor(pool, actions.size(), [&](int i) {
+    if (previous != nullptr) {
+      unchanged_actions[i] = previous->FindUnchanged(actions[i]);
+    }
+    if (unchanged_actions[i] == nullptr) {
+      new_ir_actions[i] = CreateIrActionDefinition(actions[i], type_info);
+    }
+  });
+  for (int i = 0; i < actions.size(); ++i) {
+    const auto &action = actions[i];
+    if (unchanged_actions[i] == nullptr) {
+      RETURN_IF_ERROR(new_ir_actions[i].status());
+    }
+    IrActionDefinition ir_action = unchanged_actions[i] != nullptr
+                                       ? *unchanged_actions[i]
+                                       : *std::move(new_ir_actions[i]);
+    RETURN_IF_ERROR(gutil::InsertIfUnique(
+        info.mutable_actions_by_id(), action.preamble().id(), ir_action,
+        absl::StrCat("Found several actions with the same ID: ",
+                     action.preamble().id())));
+    RETURN_IF_ERROR(gutil::InsertIfUnique(
+        info.mutable_actions_by_name(), action.preamble().alias(),
+        std::move(ir_action),
+        absl::StrCat("Found several actions with the same name: ",
+                     action.preamble().name())));
+  }
 
-    ir_table_definition.set_size(table.size());
+  // Translate all table definitions to IR.
+  const auto &tables = p4_info.tables();
+  std::vector<const IrTableDefinition *> unchanged_tables(tables.size());
+  std::vector<StatusOr<IrTableDefinition>> new_ir_tables(tables.size());
+  gutil::ParallelFor(pool, tables.size(), [&](int i) {
+    if (previous != nullptr) {
+      unchanged_tables[i] = previous->FindUnchanged(tables[i]);
+    }
+    if (unchanged_tables[i] == nullptr) {
+      new_ir_tables[i] = CreateIrTableDefinition(tables[i], info, type_info);
+    }
+  });
+  for (int i = 0; i < tables.size(); ++i) {
+    const auto &table = tables[i];
+    if (unchanged_tables[i] == nullptr) {
+      RETURN_IF_ERROR(new_ir_tables[i].status());
+    }
+    IrTableDefinition ir_table_definition =
+        unchanged_tables[i] != nullptr ? *unchanged_tables[i]
+                                       : *std::move(new_ir_tables[i]);
     RETURN_IF_ERROR(gutil::InsertIfUnique(
-        info.mutable_tables_by_id(), table_id, ir_table_definition,
+        info.mutable_tables_by_id(), table.preamble().id(),
+        ir_table_definition,
         absl::StrCat("Found several tables with the same ID ",
                      table.preamble().id())));
     RETURN_IF_ERROR(gutil::InsertIfUnique(
         info.mutable_tables_by_name(), table.preamble().alias(),
-        ir_table_definition,
+        std::move(ir_table_definition),
         absl::StrCat("Found several tables with the same name \"",
                      table.preamble().alias(), "\"")));
   }
 
+  // Reused table definitions still have their previous counters and meters,
+  // which are added again below if the tables still have them.
+  if (previous != nullptr) {
+    for (auto &[id, table] : *info.mutable_tables_by_id()) {
+      table.clear_counter();
+      table.clear_meter();
+    }
+    for (auto &[name, table] : *info.mutable_tables_by_name()) {
+      table.clear_counter();
+      table.clear_meter();
+    }
+  }
+
   // Validate and translate the packet-io metadata
   for (const auto &metadata : p4_info.controller_packet_metadata()) {
     const std::string &kind = metadata.preamble().name();
@@ -351,7 +514,8 @@ StatusOr<IrP4Info> CreateIrP4Info(const p4::config::v1::P4Info &p4_info) {
   // Counters.
   for (const auto &counter : p4_info.direct_counters()) {
     const auto table_id = counter.direct_table_id();
-    RETURN_IF_ERROR(gutil::FindOrStatus(info.tables_by_id(), table_id).status())
+    RETURN_IF_ERROR(
+        gutil::FindPtrOrStatus(info.tables_by_id(), table_id).status())
         << "Missing table " << table_id << " for counter with ID "
         << counter.preamble().id();
     IrCounter ir_counter;
@@ -367,7 +531,8 @@ StatusOr<IrP4Info> CreateIrP4Info(const p4::config::v1::P4Info &p4_info) {
   // Meters.
   for (const auto &meter : p4_info.direct_meters()) {
     const auto table_id = meter.direct_table_id();
-    RETURN_IF_ERROR(gutil::FindOrStatus(info.tables_by_id(), table_id).status())
+    RETURN_IF_ERROR(
+        gutil::FindPtrOrStatus(info.tables_by_id(), table_id).status())
         << "Missing table " << table_id << " for meter with ID "
         << meter.preamble().id();
     IrMeter ir_meter;
@@ -383,14 +548,184 @@ StatusOr<IrP4Info> CreateIrP4Info(const p4::config::v1::P4Info &p4_info) {
   return info;
 }
 
+// Sets `changes` to the names of the definitions that were added, removed or
+// modified from `previous` to `current`.
+template <typename T>
+void DiffDefinitions(const google::protobuf::Map<std::string, T> &previous,
+                     const google::protobuf::Map<std::string, T> &current,
+                     IrP4InfoEntityChanges *changes) {
+  *changes = IrP4InfoEntityChanges();
+  for (const auto &[name, definition] : Ordered(current)) {
+    const T *previous_definition = gutil::FindOrNull(previous, name);
+    if (previous_definition == nullptr) {
+      changes->added.push_back(name);
+    } else if (!Equal(*previous_definition, definition)) {
+      changes->modified.push_back(name);
+    }
+  }
+  for (const auto &[name, definition] : Ordered(previous)) {
+    if (!current.contains(name)) changes->removed.push_back(name);
+  }
+}
+
+}  // namespace
+
+StatusOr<IrP4Info> CreateIrP4Info(const p4::config::v1::P4Info &p4_info,
+                                  gutil::ThreadPool *pool) {
+  return TranslateP4Info(p4_info, /*previous=*/nullptr, pool);
+}
+
+StatusOr<CompiledIrP4Info> CreateCompiledIrP4Info(
+    const p4::config::v1::P4Info &p4_info, gutil::ThreadPool *pool) {
+  ASSIGN_OR_RETURN(IrP4Info info, CreateIrP4Info(p4_info, pool));
+  return CompiledIrP4Info(std::move(info));
+}
+
+StatusOr<IrP4Info> UpdateIrP4Info(const IrP4Info &previous_info,
+                                  const p4::config::v1::P4Info &previous_p4info,
+                                  const p4::config::v1::P4Info &p4_info,
+                                  IrP4InfoChanges *changes) {
+  const PreviousIrP4Info previous(previous_info, previous_p4info, p4_info);
+  ASSIGN_OR_RETURN(IrP4Info info,
+                   TranslateP4Info(p4_info, &previous, /*pool=*/nullptr));
+  if (changes != nullptr) {
+    DiffDefinitions(previous_info.tables_by_name(), info.tables_by_name(),
+                    &changes->tables);
+    DiffDefinitions(previous_info.actions_by_name(), info.actions_by_name(),
+                    &changes->actions);
+    DiffDefinitions(previous_info.packet_in_metadata_by_name(),
+                    info.packet_in_metadata_by_name(),
+                    &changes->packet_in_metadata);
+    DiffDefinitions(previous_info.packet_out_metadata_by_name(),
+                    info.packet_out_metadata_by_name(),
+                    &changes->packet_out_metadata);
+  }
+  return info;
+}
+
+namespace {
+
+// The IrP4Infos of the most recently used P4Infos, for GetCachedIrP4Info.
+//
+// P4Infos are looked up by a fingerprint that is cheap to compute (see
+// P4InfoFingerprint). Only if an entry has the same fingerprint, the P4Info is
+// serialized to confirm that it is equal to the P4Info of the entry.
+class IrP4InfoCache {
+ public:
+  // The maximum number of IrP4Infos in the cache.
+  static constexpr int kCapacity = 16;
+
+  // Returns the IrP4Info of `p4_info` with the given fingerprint, or nullptr if
+  // it is not cached.
+  StatusOr<std::shared_ptr<const IrP4Info>> Find(
+      const p4::config::v1::P4Info &p4_info, size_t fingerprint) {
+    {
+      absl::MutexLock lock(&mutex_);
+      if (absl::c_none_of(entries_, [&](const Entry &entry) {
+            return entry.fingerprint == fingerprint;
+          })) {
+        return nullptr;
+      }
+    }
+    // Reused across calls, since P4Infos are serialized on every cache hit.
+    static thread_local std::string *const p4info_bytes = new std::string();
+    if (!SerializeDeterministically(p4_info, p4info_bytes)) {
+      return gutil::InternalErrorBuilder() << "Failed to serialize P4Info";
+    }
+    absl::MutexLock lock(&mutex_);
+    return FindLocked(*p4info_bytes, fingerprint);
+  }
+
+  // Adds the IrP4Info of `p4_info` with the given fingerprint, unless another
+  // thread added it in the meantime, and returns the cached IrP4Info.
+  StatusOr<std::shared_ptr<const IrP4Info>> Insert(
+      const p4::config::v1::P4Info &p4_info, size_t fingerprint,
+      IrP4Info info) {
+    std::string p4info_bytes;
+    if (!SerializeDeterministically(p4_info, &p4info_bytes)) {
+      return gutil::InternalErrorBuilder() << "Failed to serialize P4Info";
+    }
+    absl::MutexLock lock(&mutex_);
+    if (auto cached = FindLocked(p4info_bytes, fingerprint)) return cached;
+    entries_.push_front({std::move(p4info_bytes), fingerprint,
+                         std::make_shared<const IrP4Info>(std::move(info))});
+    if (entries_.size() > kCapacity) entries_.pop_back();
+    return entries_.front().info;
+  }
+
+ private:
+  struct Entry {
+    std::string p4info_bytes;
+    size_t fingerprint;
+    std::shared_ptr<const IrP4Info> info;
+  };
+
+  std::shared_ptr<const IrP4Info> FindLocked(const std::string &p4info_bytes,
+                                             size_t fingerprint)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->fingerprint == fingerprint && it->p4info_bytes == p4info_bytes) {
+        // Marks the entry as the most recently used one.
+        entries_.splice(entries_.begin(), entries_, it);
+        return it->info;
+      }
+    }
+    return nullptr;
+  }
+
+  absl::Mutex mutex_;
+  // Ordered from the most to the least recently used entry.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Returns a fingerprint of `p4_info` based on its size, package and the ids
+// and names of its tables and actions. Equal P4Infos have equal fingerprints.
+// Unlike a hash of the serialized P4Info, it does not copy the P4Info.
+size_t P4InfoFingerprint(const p4::config::v1::P4Info &p4_info) {
+  size_t fingerprint =
+      absl::Hash<std::tuple<size_t, absl::string_view, absl::string_view>>()(
+          {p4_info.ByteSizeLong(), p4_info.pkg_info().name(),
+           p4_info.pkg_info().version()});
+  auto add = [&fingerprint](const p4::config::v1::Preamble &preamble) {
+    fingerprint =
+        absl::Hash<std::tuple<size_t, uint32_t, absl::string_view>>()(
+            {fingerprint, preamble.id(), preamble.name()});
+  };
+  for (const auto &table : p4_info.tables()) add(table.preamble());
+  for (const auto &action : p4_info.actions()) add(action.preamble());
+  return fingerprint;
+}
+
+}  // namespace
+
+StatusOr<std::shared_ptr<const IrP4Info>> GetCachedIrP4Info(
+    const p4::config::v1::P4Info &p4_info) {
+  static auto *const cache = new IrP4InfoCache();
+
+  const size_t fingerprint = P4InfoFingerprint(p4_info);
+  ASSIGN_OR_RETURN(std::shared_ptr<const IrP4Info> cached,
+                   cache->Find(p4_info, fingerprint));
+  if (cached != nullptr) return cached;
+
+  // Created without holding the lock, so that threads using other P4Infos are
+  // not blocked in the meantime.
+  ASSIGN_OR_RETURN(IrP4Info info, CreateIrP4Info(p4_info));
+  return cache->Insert(p4_info, fingerprint, std::move(info));
+}
+
 namespace {
 
-// Verifies the contents of the PI representation and translates to the IR
-// message
-StatusOr<IrMatch> PiMatchFieldToIr(
-    const IrP4Info &info, const IrMatchFieldDefinition &ir_match_definition,
-    const p4::v1::FieldMatch &pi_match) {
-  IrMatch match_entry;
+// Verifies the contents of the PI representation and translates it to the IR
+// message `match_entry`.
+//
+// The PI to IR translation functions below are templated on the PI message
+// type, which is either the p4::v1 message or the view of a serialized p4::v1
+// message with the same accessors (see internal/pi_wire_format.h).
+template <typename PiFieldMatch>
+absl::Status PiMatchFieldToIr(const IrP4Info &info,
+                              const IrMatchFieldDefinition &ir_match_definition,
+                              const PiFieldMatch &pi_match,
+                              IrMatch *match_entry) {
   const MatchField &match_field = ir_match_definition.match_field();
   uint32_t bitwidth = match_field.bitwidth();
 
@@ -401,9 +736,9 @@ StatusOr<IrMatch> PiMatchFieldToIr(
                << "Expected exact match type in PI";
       }
 
-      match_entry.set_name(match_field.name());
+      match_entry->set_name(match_field.name());
       ASSIGN_OR_RETURN(
-          *match_entry.mutable_exact(),
+          *match_entry->mutable_exact(),
           ArbitraryByteStringToIrValue(ir_match_definition.format(), bitwidth,
                                        pi_match.exact().value()));
       break;
@@ -425,7 +760,7 @@ StatusOr<IrMatch> PiMatchFieldToIr(
                << "A wild-card LPM match (i.e., prefix length of 0) must be "
                   "represented by omitting the match altogether";
       }
-      match_entry.set_name(match_field.name());
+      match_entry->set_name(match_field.name());
       ASSIGN_OR_RETURN(const auto mask, PrefixLenToMask(prefix_len, bitwidth));
       ASSIGN_OR_RETURN(const auto value, ArbitraryToNormalizedByteString(
                                              pi_match.lpm().value(), bitwidth));
@@ -435,8 +770,8 @@ StatusOr<IrMatch> PiMatchFieldToIr(
                << "LPM value has masked bits that are set. Value: \""
                << absl::CEscape(value) << "\" Prefix Length: " << prefix_len;
       }
-      match_entry.mutable_lpm()->set_prefix_length(prefix_len);
-      ASSIGN_OR_RETURN(*match_entry.mutable_lpm()->mutable_value(),
+      match_entry->mutable_lpm()->set_prefix_length(prefix_len);
+      ASSIGN_OR_RETURN(*match_entry->mutable_lpm()->mutable_value(),
                        ArbitraryByteStringToIrValue(
                            ir_match_definition.format(), bitwidth, value));
       break;
@@ -459,17 +794,17 @@ StatusOr<IrMatch> PiMatchFieldToIr(
                << "A wild-card ternary match (i.e., mask of 0) must be "
                   "represented by omitting the match altogether";
       }
-      match_entry.set_name(match_field.name());
+      match_entry->set_name(match_field.name());
       ASSIGN_OR_RETURN(const auto intersection, Intersection(value, mask));
       if (value != intersection) {
         return InvalidArgumentErrorBuilder()
                << "Ternary value has masked bits that are set.\nValue: "
                << absl::CEscape(value) << " Mask: " << absl::CEscape(mask);
       }
-      ASSIGN_OR_RETURN(*match_entry.mutable_ternary()->mutable_value(),
+      ASSIGN_OR_RETURN(*match_entry->mutable_ternary()->mutable_value(),
                        ArbitraryByteStringToIrValue(
                            ir_match_definition.format(), bitwidth, value));
-      ASSIGN_OR_RETURN(*match_entry.mutable_ternary()->mutable_mask(),
+      ASSIGN_OR_RETURN(*match_entry->mutable_ternary()->mutable_mask(),
                        ArbitraryByteStringToIrValue(
                            ir_match_definition.format(), bitwidth, mask));
       break;
@@ -480,9 +815,9 @@ StatusOr<IrMatch> PiMatchFieldToIr(
                << "Expected optional match type in PI";
       }
 
-      match_entry.set_name(match_field.name());
+      match_entry->set_name(match_field.name());
       ASSIGN_OR_RETURN(
-          *match_entry.mutable_optional()->mutable_value(),
+          *match_entry->mutable_optional()->mutable_value(),
           ArbitraryByteStringToIrValue(ir_match_definition.format(), bitwidth,
                                        pi_match.optional().value()));
       break;
@@ -491,17 +826,17 @@ StatusOr<IrMatch> PiMatchFieldToIr(
       return InvalidArgumentErrorBuilder()
              << "Unsupported match type \""
              << MatchField_MatchType_Name(match_field.match_type())
-             << "\" in \"" << match_entry.name() << "\"";
+             << "\" in \"" << match_entry->name() << "\"";
   }
-  return match_entry;
+  return absl::OkStatus();
 }
 
-// Verifies the contents of the IR representation and translates to the PI
-// message
-StatusOr<p4::v1::FieldMatch> IrMatchFieldToPi(
-    const IrP4Info &info, const IrMatchFieldDefinition &ir_match_definition,
-    const IrMatch &ir_match) {
-  p4::v1::FieldMatch match_entry;
+// Verifies the contents of the IR representation and translates it to the PI
+// message `match_entry`.
+absl::Status IrMatchFieldToPi(const IrP4Info &info,
+                              const IrMatchFieldDefinition &ir_match_definition,
+                              const IrMatch &ir_match,
+                              p4::v1::FieldMatch *match_entry) {
   const MatchField &match_field = ir_match_definition.match_field();
   uint32_t bitwidth = match_field.bitwidth();
 
@@ -512,14 +847,14 @@ StatusOr<p4::v1::FieldMatch> IrMatchFieldToPi(
                << "Expected exact match type in IR table entry";
       }
 
-      match_entry.set_field_id(match_field.id());
+      match_entry->set_field_id(match_field.id());
       RETURN_IF_ERROR(ValidateIrValueFormat(ir_match.exact(),
                                             ir_match_definition.format()));
       ASSIGN_OR_RETURN(
           const auto &value,
           IrValueToNormalizedByteString(
               ir_match.exact(), ir_match_definition.match_field().bitwidth()));
-      match_entry.mutable_exact()->set_value(
+      match_entry->mutable_exact()->set_value(
           NormalizedToCanonicalByteString(value));
       break;
     }
@@ -547,7 +882,7 @@ StatusOr<p4::v1::FieldMatch> IrMatchFieldToPi(
                << "A wild-card LPM match (i.e., prefix length of 0) must be "
                   "represented by omitting the match altogether";
       }
-      match_entry.set_field_id(match_field.id());
+      match_entry->set_field_id(match_field.id());
       ASSIGN_OR_RETURN(const auto mask, PrefixLenToMask(prefix_len, bitwidth));
       ASSIGN_OR_RETURN(const auto intersection, Intersection(value, mask));
       if (value != intersection) {
@@ -556,8 +891,8 @@ StatusOr<p4::v1::FieldMatch> IrMatchFieldToPi(
                << ir_match.lpm().value().DebugString()
                << "Prefix Length: " << prefix_len;
       }
-      match_entry.mutable_lpm()->set_prefix_len(prefix_len);
-      match_entry.mutable_lpm()->set_value(
+      match_entry->mutable_lpm()->set_prefix_len(prefix_len);
+      match_entry->mutable_lpm()->set_value(
           NormalizedToCanonicalByteString(value));
       break;
     }
@@ -584,7 +919,7 @@ StatusOr<p4::v1::FieldMatch> IrMatchFieldToPi(
                << "A wild-card ternary match (i.e., mask of 0) must be "
                   "represented by omitting the match altogether";
       }
-      match_entry.set_field_id(match_field.id());
+      match_entry->set_field_id(match_field.id());
       ASSIGN_OR_RETURN(const auto intersection, Intersection(value, mask));
       if (value != intersection) {
         return InvalidArgumentErrorBuilder()
@@ -592,9 +927,9 @@ StatusOr<p4::v1::FieldMatch> IrMatchFieldToPi(
                << ir_match.ternary().value().DebugString()
                << "Mask : " << ir_match.ternary().mask().DebugString();
       }
-      match_entry.mutable_ternary()->set_value(
+      match_entry->mutable_ternary()->set_value(
           NormalizedToCanonicalByteString(value));
-      match_entry.mutable_ternary()->set_mask(
+      match_entry->mutable_ternary()->set_mask(
           NormalizedToCanonicalByteString(mask));
       break;
     }
@@ -604,14 +939,14 @@ StatusOr<p4::v1::FieldMatch> IrMatchFieldToPi(
                << "Expected optional match type in IR table entry";
       }
 
-      match_entry.set_field_id(match_field.id());
+      match_entry->set_field_id(match_field.id());
       RETURN_IF_ERROR(ValidateIrValueFormat(ir_match.optional().value(),
                                             ir_match_definition.format()));
       ASSIGN_OR_RETURN(const auto &value,
                        IrValueToNormalizedByteString(
                            ir_match.optional().value(),
                            ir_match_definition.match_field().bitwidth()));
-      match_entry.mutable_optional()->set_value(
+      match_entry->mutable_optional()->set_value(
           NormalizedToCanonicalByteString(value));
       break;
     }
@@ -619,41 +954,124 @@ StatusOr<p4::v1::FieldMatch> IrMatchFieldToPi(
       return InvalidArgumentErrorBuilder()
              << "Unsupported match type \""
              << MatchField_MatchType_Name(match_field.match_type()) << "\" in "
-             << "match field with id " << match_entry.field_id();
+             << "match field with id " << match_entry->field_id();
   }
-  return match_entry;
+  return absl::OkStatus();
 }
 
-// Translates the action invocation from its PI form to IR.
-StatusOr<IrActionInvocation> PiActionToIr(
-    const IrP4Info &info, const p4::v1::Action &pi_action,
-    const google::protobuf::RepeatedPtrField<IrActionReference>
-        &valid_actions) {
-  IrActionInvocation action_entry;
+// Lookups into an IrActionDefinition, with the same interface as
+// CompiledIrAction so that the translation code below can be used with both.
+class ProtoIrAction {
+ public:
+  explicit ProtoIrAction(const IrActionDefinition &definition)
+      : definition_(&definition) {}
+
+  const IrActionDefinition &definition() const { return *definition_; }
+  int num_params() const { return definition_->params_by_id().size(); }
+  const IrActionDefinition::IrActionParamDefinition *FindParamById(
+      uint32_t id) const {
+    return gutil::FindOrNull(definition_->params_by_id(), id);
+  }
+  const IrActionDefinition::IrActionParamDefinition *FindParamByName(
+      const std::string &name) const {
+    return gutil::FindOrNull(definition_->params_by_name(), name);
+  }
+
+ private:
+  const IrActionDefinition *definition_;
+};
+
+// Lookups into an IrTableDefinition, with the same interface as
+// CompiledIrTable so that the translation code below can be used with both.
+class ProtoIrTable {
+ public:
+  explicit ProtoIrTable(const IrTableDefinition &definition)
+      : definition_(definition) {}
+
+  const IrTableDefinition &definition() const { return definition_; }
+  const IrMatchFieldDefinition *FindMatchFieldById(uint32_t id) const {
+    return gutil::FindOrNull(definition_.match_fields_by_id(), id);
+  }
+  const IrMatchFieldDefinition *FindMatchFieldByName(
+      const std::string &name) const {
+    return gutil::FindOrNull(definition_.match_fields_by_name(), name);
+  }
+  absl::optional<ProtoIrAction> FindEntryActionById(uint32_t id) const {
+    for (const auto &action : definition_.entry_actions()) {
+      if (action.action().preamble().id() == id) {
+        return ProtoIrAction(action.action());
+      }
+    }
+    return absl::nullopt;
+  }
+  absl::optional<ProtoIrAction> FindEntryActionByName(
+      const std::string &name) const {
+    for (const auto &action : definition_.entry_actions()) {
+      if (action.action().preamble().alias() == name) {
+        return ProtoIrAction(action.action());
+      }
+    }
+    return absl::nullopt;
+  }
+  int num_mandatory_matches() const {
+    return GetNumMandatoryMatches(definition_);
+  }
+  bool requires_priority() const { return RequiresPriority(definition_); }
+
+ private:
+  const IrTableDefinition &definition_;
+};
+
+// Returns the result of a lookup that returns a pointer or an optional, or the
+// same error as gutil::FindPtrOrStatus if nothing was found.
+template <typename T>
+StatusOr<T> FoundOrStatus(T result) {
+  if (!result) return absl::NotFoundError("Key not found");
+  return result;
+}
+
+// Calls `translate` with `info`, or with a CompiledIrP4Info of `info` if
+// translating `num_entries` table entries with it amortizes the cost of
+// compiling, which is linear in the number of tables and actions. Lookups in
+// an IrP4Info scan the actions of a table and count its mandatory matches on
+// every entry.
+template <typename Translate>
+auto WithBestInfo(const IrP4Info &info, int num_entries, Translate translate) {
+  if (num_entries <= info.tables_by_id_size() + info.actions_by_id_size()) {
+    return translate(info);
+  }
+  // Does not take ownership of `info`, which outlives the compiled form.
+  const CompiledIrP4Info compiled(std::shared_ptr<const IrP4Info>(
+      std::shared_ptr<const IrP4Info>(), &info));
+  return translate(compiled);
+}
+
+// Translates the action invocation from its PI form to IR. Only actions that
+// can be used in entries of `table` are accepted.
+template <typename Table, typename PiAction>
+absl::Status PiActionToIr(const IrP4Info &info, const Table &table,
+                          const PiAction &pi_action,
+                          IrActionInvocation *action_entry) {
   uint32_t action_id = pi_action.action_id();
 
-  ASSIGN_OR_RETURN(
-      const auto &ir_action_definition,
-      gutil::FindOrStatus(info.actions_by_id(), action_id),
-      _ << "Action ID " << action_id << " does not exist in P4Info");
-
-  if (absl::c_find_if(valid_actions,
-                      [action_id](const IrActionReference &action) {
-                        return action.action().preamble().id() == action_id;
-                      }) == valid_actions.end()) {
+  const auto ir_action = table.FindEntryActionById(action_id);
+  if (!ir_action) {
+    RETURN_IF_ERROR(
+        gutil::FindPtrOrStatus(info.actions_by_id(), action_id).status())
+        << "Action ID " << action_id << " does not exist in P4Info";
     return InvalidArgumentErrorBuilder()
            << "Action ID " << action_id
            << " is not a valid action for this table";
   }
 
-  int action_params_size = ir_action_definition.params_by_id().size();
+  int action_params_size = ir_action->num_params();
   if (action_params_size != pi_action.params().size()) {
     return InvalidArgumentErrorBuilder()
            << "Expected " << action_params_size << " parameters, but got "
            << pi_action.params().size() << " instead in action with ID "
            << action_id;
   }
-  action_entry.set_name(ir_action_definition.preamble().alias());
+  action_entry->set_name(ir_action->definition().preamble().alias());
   absl::flat_hash_set<uint32_t> used_params;
   for (const auto &param : pi_action.params()) {
     RETURN_IF_ERROR(gutil::InsertIfUnique(
@@ -661,44 +1079,40 @@ StatusOr<IrActionInvocation> PiActionToIr(
         absl::StrCat("Duplicate param field found with ID ",
                      param.param_id())));
 
-    ASSIGN_OR_RETURN(const auto &ir_param_definition,
-                     gutil::FindOrStatus(ir_action_definition.params_by_id(),
-                                         param.param_id()),
+    ASSIGN_OR_RETURN(const auto *ir_param_definition,
+                     FoundOrStatus(ir_action->FindParamById(param.param_id())),
                      _ << "Unable to find param ID " << param.param_id()
                        << " in action with ID " << action_id);
-    IrActionInvocation::IrActionParam *param_entry = action_entry.add_params();
-    param_entry->set_name(ir_param_definition.param().name());
+    IrActionInvocation::IrActionParam *param_entry = action_entry->add_params();
+    param_entry->set_name(ir_param_definition->param().name());
     ASSIGN_OR_RETURN(
         *param_entry->mutable_value(),
-        ArbitraryByteStringToIrValue(ir_param_definition.format(),
-                                     ir_param_definition.param().bitwidth(),
+        ArbitraryByteStringToIrValue(ir_param_definition->format(),
+                                     ir_param_definition->param().bitwidth(),
                                      param.value()));
   }
-  return action_entry;
+  return absl::OkStatus();
 }
 
-// Translates the action invocation from its IR form to PI.
-StatusOr<p4::v1::Action> IrActionInvocationToPi(
-    const IrP4Info &info, const IrActionInvocation &ir_table_action,
-    const google::protobuf::RepeatedPtrField<IrActionReference>
-        &valid_actions) {
+// Translates the action invocation from its IR form to PI. Only actions that
+// can be used in entries of `table` are accepted.
+template <typename Table>
+absl::Status IrActionInvocationToPi(const IrP4Info &info, const Table &table,
+                                    const IrActionInvocation &ir_table_action,
+                                    p4::v1::Action *action) {
   const std::string &action_name = ir_table_action.name();
 
-  ASSIGN_OR_RETURN(
-      const auto &ir_action_definition,
-      gutil::FindOrStatus(info.actions_by_name(), action_name),
-      _ << "Action \"" << action_name << "\" does not exist in P4Info");
-
-  if (absl::c_find_if(
-          valid_actions, [action_name](const IrActionReference &action) {
-            return action.action().preamble().alias() == action_name;
-          }) == valid_actions.end()) {
+  const auto ir_action = table.FindEntryActionByName(action_name);
+  if (!ir_action) {
+    RETURN_IF_ERROR(
+        gutil::FindPtrOrStatus(info.actions_by_name(), action_name).status())
+        << "Action \"" << action_name << "\" does not exist in P4Info";
     return InvalidArgumentErrorBuilder()
            << "Action \"" << action_name
            << "\" is not a valid action for this table";
   }
 
-  int action_params_size = ir_action_definition.params_by_name().size();
+  int action_params_size = ir_action->num_params();
   if (action_params_size != ir_table_action.params().size()) {
     return InvalidArgumentErrorBuilder()
            << "Expected " << action_params_size << " parameters, but got "
@@ -706,8 +1120,7 @@ StatusOr<p4::v1::Action> IrActionInvocationToPi(
            << action_name << "\"";
   }
 
-  p4::v1::Action action;
-  action.set_action_id(ir_action_definition.preamble().id());
+  action->set_action_id(ir_action->definition().preamble().id());
   absl::flat_hash_set<std::string> used_params;
   for (const auto &param : ir_table_action.params()) {
     RETURN_IF_ERROR(gutil::InsertIfUnique(
@@ -715,35 +1128,32 @@ StatusOr<p4::v1::Action> IrActionInvocationToPi(
         absl::StrCat("Duplicate param field found with name \"", param.name(),
                      "\"")));
 
-    ASSIGN_OR_RETURN(const auto &ir_param_definition,
-                     gutil::FindOrStatus(ir_action_definition.params_by_name(),
-                                         param.name()),
+    ASSIGN_OR_RETURN(const auto *ir_param_definition,
+                     FoundOrStatus(ir_action->FindParamByName(param.name())),
                      _ << "Unable to find param \"" << param.name()
                        << "\" in action \"" << action_name << "\"");
-    p4::v1::Action_Param *param_entry = action.add_params();
-    param_entry->set_param_id(ir_param_definition.param().id());
+    p4::v1::Action_Param *param_entry = action->add_params();
+    param_entry->set_param_id(ir_param_definition->param().id());
     RETURN_IF_ERROR(
-        ValidateIrValueFormat(param.value(), ir_param_definition.format()));
+        ValidateIrValueFormat(param.value(), ir_param_definition->format()));
     ASSIGN_OR_RETURN(
         const auto &value,
         IrValueToNormalizedByteString(param.value(),
-                                      ir_param_definition.param().bitwidth()));
+                                      ir_param_definition->param().bitwidth()));
     param_entry->set_value(NormalizedToCanonicalByteString(value));
   }
-  return action;
+  return absl::OkStatus();
 }
 
 // Translates the action set from its PI form to IR.
-StatusOr<IrActionSet> PiActionSetToIr(
-    const IrP4Info &info, const p4::v1::ActionProfileActionSet &pi_action_set,
-    const google::protobuf::RepeatedPtrField<IrActionReference>
-        &valid_actions) {
-  IrActionSet ir_action_set;
+template <typename Table, typename PiActionSet>
+absl::Status PiActionSetToIr(const IrP4Info &info, const Table &table,
+                             const PiActionSet &pi_action_set,
+                             IrActionSet *ir_action_set) {
   for (const auto &pi_profile_action : pi_action_set.action_profile_actions()) {
-    auto *ir_action = ir_action_set.add_actions();
-    ASSIGN_OR_RETURN(
-        *ir_action->mutable_action(),
-        PiActionToIr(info, pi_profile_action.action(), valid_actions));
+    auto *ir_action = ir_action_set->add_actions();
+    RETURN_IF_ERROR(PiActionToIr(info, table, pi_profile_action.action(),
+                                 ir_action->mutable_action()));
 
     // A action set weight that is not positive does not make sense on a switch.
     if (pi_profile_action.weight() < 1) {
@@ -753,20 +1163,18 @@ StatusOr<IrActionSet> PiActionSetToIr(
     }
     ir_action->set_weight(pi_profile_action.weight());
   }
-  return ir_action_set;
+  return absl::OkStatus();
 }
 
 // Translates the action set from its IR form to PI.
-StatusOr<p4::v1::ActionProfileActionSet> IrActionSetToPi(
-    const IrP4Info &info, const IrActionSet &ir_action_set,
-    const google::protobuf::RepeatedPtrField<IrActionReference>
-        &valid_actions) {
-  p4::v1::ActionProfileActionSet pi;
+template <typename Table>
+absl::Status IrActionSetToPi(const IrP4Info &info, const Table &table,
+                             const IrActionSet &ir_action_set,
+                             p4::v1::ActionProfileActionSet *pi) {
   for (const auto &ir_action : ir_action_set.actions()) {
-    auto *pi_action = pi.add_action_profile_actions();
-    ASSIGN_OR_RETURN(
-        *pi_action->mutable_action(),
-        IrActionInvocationToPi(info, ir_action.action(), valid_actions));
+    auto *pi_action = pi->add_action_profile_actions();
+    RETURN_IF_ERROR(IrActionInvocationToPi(info, table, ir_action.action(),
+                                           pi_action->mutable_action()));
     if (ir_action.weight() < 1) {
       return InvalidArgumentErrorBuilder()
              << "Expected positive action set weight, but got "
@@ -774,7 +1182,7 @@ StatusOr<p4::v1::ActionProfileActionSet> IrActionSetToPi(
     }
     pi_action->set_weight(ir_action.weight());
   }
-  return pi;
+  return absl::OkStatus();
 }
 
 // Generic helper that works for both packet-in and packet-out. For both, I is
@@ -787,11 +1195,12 @@ StatusOr<O> PiPacketIoToIr(const IrP4Info &info, const std::string &kind,
   result.set_payload(packet.payload());
   absl::flat_hash_set<uint32_t> used_metadata_ids;
 
-  google::protobuf::Map<uint32_t, IrPacketIoMetadataDefinition> metadata_by_id;
+  const google::protobuf::Map<uint32_t, IrPacketIoMetadataDefinition>
+      *metadata_by_id;
   if (kind == "packet-in") {
-    metadata_by_id = info.packet_in_metadata_by_id();
+    metadata_by_id = &info.packet_in_metadata_by_id();
   } else if (kind == "packet-out") {
-    metadata_by_id = info.packet_out_metadata_by_id();
+    metadata_by_id = &info.packet_out_metadata_by_id();
   } else {
     return InvalidArgumentErrorBuilder() << "Invalid PacketIo type " << kind;
   }
@@ -802,21 +1211,20 @@ StatusOr<O> PiPacketIoToIr(const IrP4Info &info, const std::string &kind,
         used_metadata_ids, id,
         absl::StrCat("Duplicate \"", kind, "\" metadata found with ID ", id)));
 
-    ASSIGN_OR_RETURN(const auto &metadata_definition,
-                     gutil::FindOrStatus(metadata_by_id, id),
+    ASSIGN_OR_RETURN(const auto *metadata_definition,
+                     gutil::FindPtrOrStatus(*metadata_by_id, id),
                      _ << kind << " metadata with ID " << id << " not defined");
 
-    IrPacketMetadata ir_metadata;
-    ir_metadata.set_name(metadata_definition.metadata().name());
+    IrPacketMetadata *ir_metadata = result.add_metadata();
+    ir_metadata->set_name(metadata_definition->metadata().name());
     ASSIGN_OR_RETURN(
-        *ir_metadata.mutable_value(),
-        ArbitraryByteStringToIrValue(metadata_definition.format(),
-                                     metadata_definition.metadata().bitwidth(),
+        *ir_metadata->mutable_value(),
+        ArbitraryByteStringToIrValue(metadata_definition->format(),
+                                     metadata_definition->metadata().bitwidth(),
                                      metadata.value()));
-    *result.add_metadata() = ir_metadata;
   }
   // Check for missing metadata
-  for (const auto &item : metadata_by_id) {
+  for (const auto &item : *metadata_by_id) {
     const auto &id = item.first;
     const auto &meta = item.second;
     if (!used_metadata_ids.contains(id)) {
@@ -835,12 +1243,12 @@ StatusOr<I> IrPacketIoToPi(const IrP4Info &info, const std::string &kind,
   I result;
   result.set_payload(packet.payload());
   absl::flat_hash_set<std::string> used_metadata_names;
-  google::protobuf::Map<std::string, IrPacketIoMetadataDefinition>
-      metadata_by_name;
+  const google::protobuf::Map<std::string, IrPacketIoMetadataDefinition>
+      *metadata_by_name;
   if (kind == "packet-in") {
-    metadata_by_name = info.packet_in_metadata_by_name();
+    metadata_by_name = &info.packet_in_metadata_by_name();
   } else if (kind == "packet-out") {
-    metadata_by_name = info.packet_out_metadata_by_name();
+    metadata_by_name = &info.packet_out_metadata_by_name();
   } else {
     return InvalidArgumentErrorBuilder() << "Invalid PacketIo type " << kind;
   }
@@ -852,23 +1260,22 @@ StatusOr<I> IrPacketIoToPi(const IrP4Info &info, const std::string &kind,
         absl::StrCat("Duplicate \"", kind, "\" metadata found with name \"",
                      name, "\"")));
 
-    ASSIGN_OR_RETURN(const auto &metadata_definition,
-                     gutil::FindOrStatus(metadata_by_name, name),
+    ASSIGN_OR_RETURN(const auto *metadata_definition,
+                     gutil::FindPtrOrStatus(*metadata_by_name, name),
                      _ << "\"" << kind << "\" metadata with name \"" << name
                        << "\" not defined");
-    p4::v1::PacketMetadata pi_metadata;
-    pi_metadata.set_metadata_id(metadata_definition.metadata().id());
+    p4::v1::PacketMetadata *pi_metadata = result.add_metadata();
+    pi_metadata->set_metadata_id(metadata_definition->metadata().id());
     RETURN_IF_ERROR(
-        ValidateIrValueFormat(metadata.value(), metadata_definition.format()));
+        ValidateIrValueFormat(metadata.value(), metadata_definition->format()));
     ASSIGN_OR_RETURN(
         auto value,
         IrValueToNormalizedByteString(
-            metadata.value(), metadata_definition.metadata().bitwidth()));
-    pi_metadata.set_value(NormalizedToCanonicalByteString(value));
-    *result.add_metadata() = pi_metadata;
+            metadata.value(), metadata_definition->metadata().bitwidth()));
+    pi_metadata->set_value(NormalizedToCanonicalByteString(value));
   }
   // Check for missing metadata
-  for (const auto &item : metadata_by_name) {
+  for (const auto &item : *metadata_by_name) {
     const auto &name = item.first;
     const auto &meta = item.second;
     if (!used_metadata_names.contains(name)) {
@@ -881,16 +1288,11 @@ StatusOr<I> IrPacketIoToPi(const IrP4Info &info, const std::string &kind,
   return result;
 }
 
-}  // namespace
-
-StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
-                                        const p4::v1::TableEntry &pi) {
-  IrTableEntry ir;
-  ASSIGN_OR_RETURN(
-      const auto &table,
-      gutil::FindOrStatus(info.tables_by_id(), pi.table_id()),
-      _ << "Table ID " << pi.table_id() << " does not exist in P4Info");
-  ir.set_table_name(table.preamble().alias());
+// Translates a PI table entry of `table` to IR.
+template <typename Table, typename PiTableEntry>
+absl::Status PiTableEntryToIr(const IrP4Info &info, const Table &table,
+                              const PiTableEntry &pi, IrTableEntry *ir) {
+  ir->set_table_name(table.definition().preamble().alias());
 
   // Validate and translate the matches
   absl::flat_hash_set<uint32_t> used_field_ids;
@@ -902,20 +1304,19 @@ StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
                      pi_match.field_id())));
 
     ASSIGN_OR_RETURN(
-        const auto &match,
-        gutil::FindOrStatus(table.match_fields_by_id(), pi_match.field_id()),
+        const auto *match,
+        FoundOrStatus(table.FindMatchFieldById(pi_match.field_id())),
         _ << "Match Field " << pi_match.field_id()
-          << " does not exist in table \"" << ir.table_name() << "\"");
-    ASSIGN_OR_RETURN(const auto &match_entry,
-                     PiMatchFieldToIr(info, match, pi_match));
-    *ir.add_matches() = match_entry;
+          << " does not exist in table \"" << ir->table_name() << "\"");
+    RETURN_IF_ERROR(
+        PiMatchFieldToIr(info, *match, pi_match, ir->add_matches()));
 
-    if (match.match_field().match_type() == MatchField::EXACT) {
+    if (match->match_field().match_type() == MatchField::EXACT) {
       ++mandatory_matches;
     }
   }
 
-  int expected_mandatory_matches = GetNumMandatoryMatches(table);
+  int expected_mandatory_matches = table.num_mandatory_matches();
   if (mandatory_matches != expected_mandatory_matches) {
     return InvalidArgumentErrorBuilder()
            << "Expected " << expected_mandatory_matches
@@ -923,7 +1324,7 @@ StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
            << " instead";
   }
 
-  if (RequiresPriority(table)) {
+  if (table.requires_priority()) {
     if (pi.priority() <= 0) {
       return InvalidArgumentErrorBuilder()
              << "Table entries with ternary or optional matches require a "
@@ -931,7 +1332,7 @@ StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
                 "priority. Got "
              << pi.priority() << " instead";
     } else {
-      ir.set_priority(pi.priority());
+      ir->set_priority(pi.priority());
     }
   } else if (pi.priority() != 0) {
     return InvalidArgumentErrorBuilder() << "Table entries with no ternary or "
@@ -947,28 +1348,26 @@ StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
   }
   switch (pi.action().type_case()) {
     case p4::v1::TableAction::kAction: {
-      if (table.uses_oneshot()) {
+      if (table.definition().uses_oneshot()) {
         return InvalidArgumentErrorBuilder()
-               << "Table \"" << ir.table_name()
+               << "Table \"" << ir->table_name()
                << "\" requires an action set since it uses onseshot. Got "
                   "action instead";
       }
-      ASSIGN_OR_RETURN(
-          *ir.mutable_action(),
-          PiActionToIr(info, pi.action().action(), table.entry_actions()));
+      RETURN_IF_ERROR(PiActionToIr(info, table, pi.action().action(),
+                                   ir->mutable_action()));
       break;
     }
     case p4::v1::TableAction::kActionProfileActionSet: {
-      if (!table.uses_oneshot()) {
+      if (!table.definition().uses_oneshot()) {
         return InvalidArgumentErrorBuilder()
-               << "Table \"" << ir.table_name()
+               << "Table \"" << ir->table_name()
                << "\" requires an action since it does not use onseshot. Got "
                   "action set instead";
       }
-      ASSIGN_OR_RETURN(
-          *ir.mutable_action_set(),
-          PiActionSetToIr(info, pi.action().action_profile_action_set(),
-                          table.entry_actions()));
+      RETURN_IF_ERROR(
+          PiActionSetToIr(info, table, pi.action().action_profile_action_set(),
+                          ir->mutable_action_set()));
       break;
     }
     default: {
@@ -977,17 +1376,14 @@ StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
     }
   }
 
-  return ir;
+  return absl::OkStatus();
 }
 
-StatusOr<p4::v1::TableEntry> IrTableEntryToPi(const IrP4Info &info,
-                                              const IrTableEntry &ir) {
-  p4::v1::TableEntry pi;
-  ASSIGN_OR_RETURN(
-      const auto &table,
-      gutil::FindOrStatus(info.tables_by_name(), ir.table_name()),
-      _ << "Table name \"" << ir.table_name() << "\" does not exist in P4Info");
-  pi.set_table_id(table.preamble().id());
+// Translates an IR table entry of `table` to PI.
+template <typename Table>
+absl::Status IrTableEntryToPi(const IrP4Info &info, const Table &table,
+                              const IrTableEntry &ir, p4::v1::TableEntry *pi) {
+  pi->set_table_id(table.definition().preamble().id());
 
   // Validate and translate the matches
   absl::flat_hash_set<std::string> used_field_names;
@@ -999,20 +1395,18 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(const IrP4Info &info,
                      ir_match.name(), "\"")));
 
     ASSIGN_OR_RETURN(
-        const auto &match,
-        gutil::FindOrStatus(table.match_fields_by_name(), ir_match.name()),
+        const auto *match,
+        FoundOrStatus(table.FindMatchFieldByName(ir_match.name())),
         _ << "Match Field \"" << ir_match.name()
           << "\" does not exist in table \"" << ir.table_name() << "\"");
-    ASSIGN_OR_RETURN(const auto &match_entry,
-                     IrMatchFieldToPi(info, match, ir_match));
-    *pi.add_match() = match_entry;
+    RETURN_IF_ERROR(IrMatchFieldToPi(info, *match, ir_match, pi->add_match()));
 
-    if (match.match_field().match_type() == MatchField::EXACT) {
+    if (match->match_field().match_type() == MatchField::EXACT) {
       ++mandatory_matches;
     }
   }
 
-  int expected_mandatory_matches = GetNumMandatoryMatches(table);
+  int expected_mandatory_matches = table.num_mandatory_matches();
   if (mandatory_matches != expected_mandatory_matches) {
     return InvalidArgumentErrorBuilder()
            << "Expected " << expected_mandatory_matches
@@ -1020,7 +1414,7 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(const IrP4Info &info,
            << " instead";
   }
 
-  if (RequiresPriority(table)) {
+  if (table.requires_priority()) {
     if (ir.priority() <= 0) {
       return InvalidArgumentErrorBuilder()
              << "Table entries with ternary or optional matches require a "
@@ -1028,7 +1422,7 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(const IrP4Info &info,
                 "priority. Got "
              << ir.priority() << " instead";
     } else {
-      pi.set_priority(ir.priority());
+      pi->set_priority(ir.priority());
     }
   } else if (ir.priority() != 0) {
     return InvalidArgumentErrorBuilder() << "Table entries with no ternary or "
@@ -1040,27 +1434,26 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(const IrP4Info &info,
   // Validate and translate the action.
   switch (ir.type_case()) {
     case IrTableEntry::kAction: {
-      if (table.uses_oneshot()) {
+      if (table.definition().uses_oneshot()) {
         return InvalidArgumentErrorBuilder()
                << "Table \"" << ir.table_name()
                << "\" requires an action set since it uses onseshot. Got "
                   "action instead";
       }
-      ASSIGN_OR_RETURN(
-          *pi.mutable_action()->mutable_action(),
-          IrActionInvocationToPi(info, ir.action(), table.entry_actions()));
+      RETURN_IF_ERROR(IrActionInvocationToPi(
+          info, table, ir.action(), pi->mutable_action()->mutable_action()));
       break;
     }
     case IrTableEntry::kActionSet: {
-      if (!table.uses_oneshot()) {
+      if (!table.definition().uses_oneshot()) {
         return InvalidArgumentErrorBuilder()
                << "Table \"" << ir.table_name()
                << "\" requires an action since it does not use onseshot. Got "
                   "action set instead";
       }
-      ASSIGN_OR_RETURN(
-          *pi.mutable_action()->mutable_action_profile_action_set(),
-          IrActionSetToPi(info, ir.action_set(), table.entry_actions()));
+      RETURN_IF_ERROR(IrActionSetToPi(
+          info, table, ir.action_set(),
+          pi->mutable_action()->mutable_action_profile_action_set()));
       break;
     }
     default: {
@@ -1069,6 +1462,87 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(const IrP4Info &info,
              << "\"";
     }
   }
+  return absl::OkStatus();
+}
+
+// Translates a PI table entry of any table in `info` to IR.
+template <typename PiTableEntry>
+absl::Status PiTableEntryToIr(const IrP4Info &info, const PiTableEntry &pi,
+                              IrTableEntry *ir) {
+  ASSIGN_OR_RETURN(
+      const auto *table,
+      gutil::FindPtrOrStatus(info.tables_by_id(), pi.table_id()),
+      _ << "Table ID " << pi.table_id() << " does not exist in P4Info");
+  ir->Clear();
+  return PiTableEntryToIr(info, ProtoIrTable(*table), pi, ir);
+}
+
+template <typename PiTableEntry>
+absl::Status PiTableEntryToIr(const CompiledIrP4Info &info,
+                              const PiTableEntry &pi, IrTableEntry *ir) {
+  ASSIGN_OR_RETURN(
+      const auto *table, FoundOrStatus(info.FindTableById(pi.table_id())),
+      _ << "Table ID " << pi.table_id() << " does not exist in P4Info");
+  ir->Clear();
+  return PiTableEntryToIr(info.info(), *table, pi, ir);
+}
+
+}  // namespace
+
+absl::Status PiTableEntryToIr(const IrP4Info &info,
+                              const p4::v1::TableEntry &pi, IrTableEntry *ir) {
+  return PiTableEntryToIr<p4::v1::TableEntry>(info, pi, ir);
+}
+
+absl::Status PiTableEntryToIr(const CompiledIrP4Info &info,
+                              const p4::v1::TableEntry &pi, IrTableEntry *ir) {
+  return PiTableEntryToIr<p4::v1::TableEntry>(info, pi, ir);
+}
+
+absl::Status IrTableEntryToPi(const IrP4Info &info, const IrTableEntry &ir,
+                              p4::v1::TableEntry *pi) {
+  ASSIGN_OR_RETURN(
+      const auto *table,
+      gutil::FindPtrOrStatus(info.tables_by_name(), ir.table_name()),
+      _ << "Table name \"" << ir.table_name() << "\" does not exist in P4Info");
+  pi->Clear();
+  return IrTableEntryToPi(info, ProtoIrTable(*table), ir, pi);
+}
+
+absl::Status IrTableEntryToPi(const CompiledIrP4Info &info,
+                              const IrTableEntry &ir, p4::v1::TableEntry *pi) {
+  ASSIGN_OR_RETURN(
+      const auto *table, FoundOrStatus(info.FindTableByName(ir.table_name())),
+      _ << "Table name \"" << ir.table_name() << "\" does not exist in P4Info");
+  pi->Clear();
+  return IrTableEntryToPi(info.info(), *table, ir, pi);
+}
+
+StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
+                                        const p4::v1::TableEntry &pi) {
+  IrTableEntry ir;
+  RETURN_IF_ERROR(PiTableEntryToIr(info, pi, &ir));
+  return ir;
+}
+
+StatusOr<IrTableEntry> PiTableEntryToIr(const CompiledIrP4Info &info,
+                                        const p4::v1::TableEntry &pi) {
+  IrTableEntry ir;
+  RETURN_IF_ERROR(PiTableEntryToIr(info, pi, &ir));
+  return ir;
+}
+
+StatusOr<p4::v1::TableEntry> IrTableEntryToPi(const IrP4Info &info,
+                                              const IrTableEntry &ir) {
+  p4::v1::TableEntry pi;
+  RETURN_IF_ERROR(IrTableEntryToPi(info, ir, &pi));
+  return pi;
+}
+
+StatusOr<p4::v1::TableEntry> IrTableEntryToPi(const CompiledIrP4Info &info,
+                                              const IrTableEntry &ir) {
+  p4::v1::TableEntry pi;
+  RETURN_IF_ERROR(IrTableEntryToPi(info, ir, &pi));
   return pi;
 }
 
@@ -1156,33 +1630,32 @@ StatusOr<p4::v1::ReadRequest> IrReadRequestToPi(
   return result;
 }
 
-StatusOr<IrReadResponse> PiReadResponseToIr(
-    const IrP4Info &info, const p4::v1::ReadResponse &read_response) {
-  IrReadResponse result;
-  for (const auto &entity : read_response.entities()) {
-    if (!entity.has_table_entry()) {
-      return UnimplementedErrorBuilder()
-             << "Only table entries are supported in ReadResponse";
-    }
-    ASSIGN_OR_RETURN(*result.add_table_entries(),
-                     PiTableEntryToIr(info, entity.table_entry()));
+namespace {
+
+template <typename Info, typename PiEntity>
+absl::Status PiEntityToIr(const Info &info, const PiEntity &entity,
+                          IrTableEntry *ir) {
+  if (!entity.has_table_entry()) {
+    return UnimplementedErrorBuilder()
+           << "Only table entries are supported in ReadResponse";
   }
-  return result;
+  return PiTableEntryToIr(info, entity.table_entry(), ir);
 }
 
-StatusOr<p4::v1::ReadResponse> IrReadResponseToPi(
-    const IrP4Info &info, const IrReadResponse &read_response) {
-  p4::v1::ReadResponse result;
-  for (const auto &entity : read_response.table_entries()) {
-    ASSIGN_OR_RETURN(*result.add_entities()->mutable_table_entry(),
-                     IrTableEntryToPi(info, entity));
+template <typename Info, typename PiReadResponse>
+absl::Status PiReadResponseToIr(const Info &info,
+                                const PiReadResponse &read_response,
+                                IrReadResponse *result) {
+  result->Clear();
+  for (const auto &entity : read_response.entities()) {
+    RETURN_IF_ERROR(PiEntityToIr(info, entity, result->add_table_entries()));
   }
-  return result;
+  return absl::OkStatus();
 }
 
-StatusOr<IrUpdate> PiUpdateToIr(const IrP4Info &info,
-                                const p4::v1::Update &update) {
-  IrUpdate ir_update;
+template <typename Info, typename PiUpdate>
+absl::Status PiUpdateToIr(const Info &info, const PiUpdate &update,
+                          IrUpdate *ir_update) {
   if (!update.entity().has_table_entry()) {
     return UnimplementedErrorBuilder()
            << "Only table entries are supported in Update";
@@ -1190,33 +1663,16 @@ StatusOr<IrUpdate> PiUpdateToIr(const IrP4Info &info,
   if (update.type() == p4::v1::Update_Type_UNSPECIFIED) {
     return InvalidArgumentErrorBuilder() << "Update type should be specified";
   }
-  ir_update.set_type(update.type());
-  ASSIGN_OR_RETURN(*ir_update.mutable_table_entry(),
-                   PiTableEntryToIr(info, update.entity().table_entry()));
-  return ir_update;
+  ir_update->Clear();
+  ir_update->set_type(update.type());
+  return PiTableEntryToIr(info, update.entity().table_entry(),
+                          ir_update->mutable_table_entry());
 }
 
-StatusOr<p4::v1::Update> IrUpdateToPi(const IrP4Info &info,
-                                      const IrUpdate &update) {
-  p4::v1::Update pi_update;
-
-  if (!p4::v1::Update_Type_IsValid(update.type())) {
-    return InvalidArgumentErrorBuilder()
-           << "Invalid type value: " << update.type();
-  }
-  if (update.type() == p4::v1::Update_Type_UNSPECIFIED) {
-    return InvalidArgumentErrorBuilder() << "Update type should be specified";
-  }
-  pi_update.set_type(update.type());
-  ASSIGN_OR_RETURN(*pi_update.mutable_entity()->mutable_table_entry(),
-                   IrTableEntryToPi(info, update.table_entry()));
-  return pi_update;
-}
-
-StatusOr<IrWriteRequest> PiWriteRequestToIr(
-    const IrP4Info &info, const p4::v1::WriteRequest &write_request) {
-  IrWriteRequest ir_write_request;
-
+template <typename Info, typename PiWriteRequest>
+absl::Status PiWriteRequestToIr(const Info &info,
+                                const PiWriteRequest &write_request,
+                                IrWriteRequest *ir_write_request) {
   if (write_request.role_id() != 0) {
     return InvalidArgumentErrorBuilder()
            << "Only the default role is supported, but got role ID "
@@ -1229,38 +1685,352 @@ StatusOr<IrWriteRequest> PiWriteRequestToIr(
            << "Only CONTINUE_ON_ERROR is supported for atomicity";
   }
 
-  ir_write_request.set_device_id(write_request.device_id());
+  ir_write_request->Clear();
+  ir_write_request->set_device_id(write_request.device_id());
   if (write_request.election_id().high() > 0 ||
       write_request.election_id().low() > 0) {
-    *ir_write_request.mutable_election_id() = write_request.election_id();
+    ir_write_request->mutable_election_id()->set_high(
+        write_request.election_id().high());
+    ir_write_request->mutable_election_id()->set_low(
+        write_request.election_id().low());
   }
 
   for (const auto &update : write_request.updates()) {
-    ASSIGN_OR_RETURN(*ir_write_request.add_updates(),
-                     PiUpdateToIr(info, update));
+    RETURN_IF_ERROR(
+        PiUpdateToIr(info, update, ir_write_request->add_updates()));
   }
-  return ir_write_request;
+  return absl::OkStatus();
 }
 
-StatusOr<p4::v1::WriteRequest> IrWriteRequestToPi(
-    const IrP4Info &info, const IrWriteRequest &ir_write_request) {
-  p4::v1::WriteRequest pi_write_request;
+template <typename Info>
+absl::Status IrReadResponseToPi(const Info &info,
+                                const IrReadResponse &read_response,
+                                p4::v1::ReadResponse *result) {
+  result->Clear();
+  for (const auto &entity : read_response.table_entries()) {
+    RETURN_IF_ERROR(IrTableEntryToPi(
+        info, entity, result->add_entities()->mutable_table_entry()));
+  }
+  return absl::OkStatus();
+}
 
-  pi_write_request.set_role_id(0);
-  pi_write_request.set_atomicity(
+template <typename Info>
+absl::Status IrUpdateToPi(const Info &info, const IrUpdate &update,
+                          p4::v1::Update *pi_update) {
+  if (!p4::v1::Update_Type_IsValid(update.type())) {
+    return InvalidArgumentErrorBuilder()
+           << "Invalid type value: " << update.type();
+  }
+  if (update.type() == p4::v1::Update_Type_UNSPECIFIED) {
+    return InvalidArgumentErrorBuilder() << "Update type should be specified";
+  }
+  pi_update->Clear();
+  pi_update->set_type(update.type());
+  return IrTableEntryToPi(info, update.table_entry(),
+                          pi_update->mutable_entity()->mutable_table_entry());
+}
+
+template <typename Info>
+absl::Status IrWriteRequestToPi(const Info &info,
+                                const IrWriteRequest &ir_write_request,
+                                p4::v1::WriteRequest *pi_write_request) {
+  pi_write_request->Clear();
+  pi_write_request->set_role_id(0);
+  pi_write_request->set_atomicity(
       p4::v1::WriteRequest_Atomicity_CONTINUE_ON_ERROR);
-  pi_write_request.set_device_id(ir_write_request.device_id());
+  pi_write_request->set_device_id(ir_write_request.device_id());
   if (ir_write_request.election_id().high() > 0 ||
       ir_write_request.election_id().low() > 0) {
-    *pi_write_request.mutable_election_id() = ir_write_request.election_id();
+    *pi_write_request->mutable_election_id() = ir_write_request.election_id();
   }
 
   for (const auto &update : ir_write_request.updates()) {
-    ASSIGN_OR_RETURN(*pi_write_request.add_updates(),
-                     IrUpdateToPi(info, update));
+    RETURN_IF_ERROR(
+        IrUpdateToPi(info, update, pi_write_request->add_updates()));
   }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status PiReadResponseToIr(const IrP4Info &info,
+                                const p4::v1::ReadResponse &read_response,
+                                IrReadResponse *result) {
+  return WithBestInfo(
+      info, read_response.entities_size(), [&](const auto &info) {
+        return PiReadResponseToIr<std::decay_t<decltype(info)>,
+                                  p4::v1::ReadResponse>(info, read_response,
+                                                        result);
+      });
+}
+
+absl::Status IrReadResponseToPi(const IrP4Info &info,
+                                const IrReadResponse &read_response,
+                                p4::v1::ReadResponse *result) {
+  return WithBestInfo(
+      info, read_response.table_entries_size(), [&](const auto &info) {
+        return IrReadResponseToPi<std::decay_t<decltype(info)>>(
+            info, read_response, result);
+      });
+}
+
+absl::Status PiUpdateToIr(const IrP4Info &info, const p4::v1::Update &update,
+                          IrUpdate *ir_update) {
+  return PiUpdateToIr<IrP4Info, p4::v1::Update>(info, update, ir_update);
+}
+
+absl::Status IrUpdateToPi(const IrP4Info &info, const IrUpdate &update,
+                          p4::v1::Update *pi_update) {
+  return IrUpdateToPi<IrP4Info>(info, update, pi_update);
+}
+
+absl::Status PiWriteRequestToIr(const IrP4Info &info,
+                                const p4::v1::WriteRequest &write_request,
+                                IrWriteRequest *ir_write_request) {
+  return WithBestInfo(
+      info, write_request.updates_size(), [&](const auto &info) {
+        return PiWriteRequestToIr<std::decay_t<decltype(info)>,
+                                  p4::v1::WriteRequest>(info, write_request,
+                                                        ir_write_request);
+      });
+}
+
+absl::Status IrWriteRequestToPi(const IrP4Info &info,
+                                const IrWriteRequest &ir_write_request,
+                                p4::v1::WriteRequest *pi_write_request) {
+  return WithBestInfo(
+      info, ir_write_request.updates_size(), [&](const auto &info) {
+        return IrWriteRequestToPi<std::decay_t<decltype(info)>>(
+            info, ir_write_request, pi_write_request);
+      });
+}
+
+StatusOr<IrReadResponse> PiReadResponseToIr(
+    const IrP4Info &info, const p4::v1::ReadResponse &read_response) {
+  IrReadResponse result;
+  RETURN_IF_ERROR(PiReadResponseToIr(info, read_response, &result));
+  return result;
+}
+
+StatusOr<p4::v1::ReadResponse> IrReadResponseToPi(
+    const IrP4Info &info, const IrReadResponse &read_response) {
+  p4::v1::ReadResponse result;
+  RETURN_IF_ERROR(IrReadResponseToPi(info, read_response, &result));
+  return result;
+}
+
+StatusOr<IrUpdate> PiUpdateToIr(const IrP4Info &info,
+                                const p4::v1::Update &update) {
+  IrUpdate ir_update;
+  RETURN_IF_ERROR(PiUpdateToIr(info, update, &ir_update));
+  return ir_update;
+}
+
+StatusOr<p4::v1::Update> IrUpdateToPi(const IrP4Info &info,
+                                      const IrUpdate &update) {
+  p4::v1::Update pi_update;
+  RETURN_IF_ERROR(IrUpdateToPi(info, update, &pi_update));
+  return pi_update;
+}
+
+StatusOr<IrWriteRequest> PiWriteRequestToIr(
+    const IrP4Info &info, const p4::v1::WriteRequest &write_request) {
+  IrWriteRequest ir_write_request;
+  RETURN_IF_ERROR(PiWriteRequestToIr(info, write_request, &ir_write_request));
+  return ir_write_request;
+}
+
+StatusOr<p4::v1::WriteRequest> IrWriteRequestToPi(
+    const IrP4Info &info, const IrWriteRequest &ir_write_request) {
+  p4::v1::WriteRequest pi_write_request;
+  RETURN_IF_ERROR(
+      IrWriteRequestToPi(info, ir_write_request, &pi_write_request));
   return pi_write_request;
 }
+
+namespace {
+
+// Translates every element of `inputs` using `translate`, in parallel on
+// `pool`. `translate` is called with `info` or its compiled form (see
+// WithBestInfo), an input, and the output to translate it into.
+template <typename Output, typename Inputs, typename Translate>
+std::vector<StatusOr<Output>> TranslateAll(const IrP4Info &info,
+                                           const Inputs &inputs,
+                                           gutil::ThreadPool *pool,
+                                           Translate translate) {
+  std::vector<StatusOr<Output>> outputs(inputs.size());
+  WithBestInfo(info, inputs.size(), [&](const auto &info) {
+    gutil::ParallelFor(pool, inputs.size(), [&](int i) {
+      Output output;
+      const absl::Status status = translate(info, inputs[i], &output);
+      if (status.ok()) {
+        outputs[i] = std::move(output);
+      } else {
+        outputs[i] = status;
+      }
+    });
+    return absl::OkStatus();
+  });
+  return outputs;
+}
+
+}  // namespace
+
+std::vector<StatusOr<IrTableEntry>> PiTableEntriesToIr(
+    const IrP4Info &info, absl::Span<const p4::v1::TableEntry> pi,
+    gutil::ThreadPool *pool) {
+  return TranslateAll<IrTableEntry>(
+      info, pi, pool,
+      [](const auto &info, const auto &entry, IrTableEntry *out) {
+        return PiTableEntryToIr(info, entry, out);
+      });
+}
+
+std::vector<StatusOr<IrTableEntry>> PiTableEntriesToIr(
+    const IrP4Info &info,
+    const google::protobuf::RepeatedPtrField<p4::v1::TableEntry> &pi,
+    gutil::ThreadPool *pool) {
+  return TranslateAll<IrTableEntry>(
+      info, pi, pool,
+      [](const auto &info, const auto &entry, IrTableEntry *out) {
+        return PiTableEntryToIr(info, entry, out);
+      });
+}
+
+std::vector<StatusOr<p4::v1::TableEntry>> IrTableEntriesToPi(
+    const IrP4Info &info, absl::Span<const IrTableEntry> ir,
+    gutil::ThreadPool *pool) {
+  return TranslateAll<p4::v1::TableEntry>(
+      info, ir, pool,
+      [](const auto &info, const auto &entry, p4::v1::TableEntry *out) {
+        return IrTableEntryToPi(info, entry, out);
+      });
+}
+
+std::vector<StatusOr<p4::v1::TableEntry>> IrTableEntriesToPi(
+    const IrP4Info &info,
+    const google::protobuf::RepeatedPtrField<IrTableEntry> &ir,
+    gutil::ThreadPool *pool) {
+  return TranslateAll<p4::v1::TableEntry>(
+      info, ir, pool,
+      [](const auto &info, const auto &entry, p4::v1::TableEntry *out) {
+        return IrTableEntryToPi(info, entry, out);
+      });
+}
+
+std::vector<StatusOr<IrTableEntry>> PiEntitiesToIr(
+    const IrP4Info &info,
+    const google::protobuf::RepeatedPtrField<p4::v1::Entity> &entities,
+    gutil::ThreadPool *pool) {
+  return TranslateAll<IrTableEntry>(
+      info, entities, pool,
+      [](const auto &info, const auto &entity, IrTableEntry *out) {
+        return PiEntityToIr(info, entity, out);
+      });
+}
+
+std::vector<StatusOr<IrUpdate>> PiUpdatesToIr(
+    const IrP4Info &info, absl::Span<const p4::v1::Update> updates,
+    gutil::ThreadPool *pool) {
+  return TranslateAll<IrUpdate>(
+      info, updates, pool,
+      [](const auto &info, const auto &update, IrUpdate *out) {
+        return PiUpdateToIr(info, update, out);
+      });
+}
+
+std::vector<StatusOr<IrUpdate>> PiUpdatesToIr(
+    const IrP4Info &info,
+    const google::protobuf::RepeatedPtrField<p4::v1::Update> &updates,
+    gutil::ThreadPool *pool) {
+  return TranslateAll<IrUpdate>(
+      info, updates, pool,
+      [](const auto &info, const auto &update, IrUpdate *out) {
+        return PiUpdateToIr(info, update, out);
+      });
+}
+
+std::vector<StatusOr<p4::v1::Update>> IrUpdatesToPi(
+    const IrP4Info &info, absl::Span<const IrUpdate> updates,
+    gutil::ThreadPool *pool) {
+  return TranslateAll<p4::v1::Update>(
+      info, updates, pool,
+      [](const auto &info, const auto &update, p4::v1::Update *out) {
+        return IrUpdateToPi(info, update, out);
+      });
+}
+
+std::vector<StatusOr<p4::v1::Update>> IrUpdatesToPi(
+    const IrP4Info &info,
+    const google::protobuf::RepeatedPtrField<IrUpdate> &updates,
+    gutil::ThreadPool *pool) {
+  return TranslateAll<p4::v1::Update>(
+      info, updates, pool,
+      [](const auto &info, const auto &update, p4::v1::Update *out) {
+        return IrUpdateToPi(info, update, out);
+      });
+}
+
+absl::Status SerializedPiWriteRequestToIr(const IrP4Info &info,
+                                          absl::string_view write_request,
+                                          IrWriteRequest *ir) {
+  PiWriteRequestView view;
+  RETURN_IF_ERROR(view.Parse(write_request));
+  return PiWriteRequestToIr(info, view, ir);
+}
+
+absl::Status SerializedPiWriteRequestToIr(const CompiledIrP4Info &info,
+                                          absl::string_view write_request,
+                                          IrWriteRequest *ir) {
+  PiWriteRequestView view;
+  RETURN_IF_ERROR(view.Parse(write_request));
+  return PiWriteRequestToIr(info, view, ir);
+}
+
+absl::Status SerializedPiReadResponseToIr(const IrP4Info &info,
+                                          absl::string_view read_response,
+                                          IrReadResponse *ir) {
+  PiReadResponseView view;
+  RETURN_IF_ERROR(view.Parse(read_response));
+  return PiReadResponseToIr(info, view, ir);
+}
+
+absl::Status SerializedPiReadResponseToIr(const CompiledIrP4Info &info,
+                                          absl::string_view read_response,
+                                          IrReadResponse *ir) {
+  PiReadResponseView view;
+  RETURN_IF_ERROR(view.Parse(read_response));
+  return PiReadResponseToIr(info, view, ir);
+}
+
+StatusOr<IrWriteRequest> SerializedPiWriteRequestToIr(
+    const IrP4Info &info, absl::string_view write_request) {
+  IrWriteRequest ir;
+  RETURN_IF_ERROR(SerializedPiWriteRequestToIr(info, write_request, &ir));
+  return ir;
+}
+
+StatusOr<IrWriteRequest> SerializedPiWriteRequestToIr(
+    const CompiledIrP4Info &info, absl::string_view write_request) {
+  IrWriteRequest ir;
+  RETURN_IF_ERROR(SerializedPiWriteRequestToIr(info, write_request, &ir));
+  return ir;
+}
+
+StatusOr<IrReadResponse> SerializedPiReadResponseToIr(
+    const IrP4Info &info, absl::string_view read_response) {
+  IrReadResponse ir;
+  RETURN_IF_ERROR(SerializedPiReadResponseToIr(info, read_response, &ir));
+  return ir;
+}
+
+StatusOr<IrReadResponse> SerializedPiReadResponseToIr(
+    const CompiledIrP4Info &info, absl::string_view read_response) {
+  IrReadResponse ir;
+  RETURN_IF_ERROR(SerializedPiReadResponseToIr(info, read_response, &ir));
+  return ir;
+}
+
 // Formats a grpc status about write request into a readible string.
 std::string WriteRequestGrpcStatusToString(const grpc::Status &status) {
   std::string readable_status = absl::StrCat(
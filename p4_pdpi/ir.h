@@ -17,20 +17,89 @@
 // P4 intermediate representation definitions for use in conversion to and from
 // Program-Independent to either Program-Dependent or App-DB formats
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "google/protobuf/repeated_field.h"
 #include "grpcpp/grpcpp.h"
 #include "gutil/status.h"
+#include "gutil/thread_pool.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
 #include "p4_pdpi/ir.pb.h"
 
 namespace pdpi {
 
-// Creates IrP4Info and validates that the p4_info has no errors.
-absl::StatusOr<IrP4Info> CreateIrP4Info(const p4::config::v1::P4Info& p4_info);
+// Creates IrP4Info and validates that the p4_info has no errors. Actions and
+// tables are translated in parallel on the threads of `pool` and the calling
+// thread, or only on the calling thread if `pool` is nullptr. The result and
+// errors do not depend on `pool`.
+absl::StatusOr<IrP4Info> CreateIrP4Info(const p4::config::v1::P4Info& p4_info,
+                                        gutil::ThreadPool* pool = nullptr);
+
+// Same as CreateIrP4Info, but returns the IrP4Info in its compiled form, for
+// use with the CompiledIrP4Info overloads of the translation functions.
+absl::StatusOr<CompiledIrP4Info> CreateCompiledIrP4Info(
+    const p4::config::v1::P4Info& p4_info, gutil::ThreadPool* pool = nullptr);
+
+// Same as CreateIrP4Info, but the IrP4Info is shared by all callers that pass
+// the same P4Info, and only created on the first call for each of the 16 most
+// recently used P4Infos. Thread-safe.
+//
+// Each call that finds a cached IrP4Info still serializes `p4_info` to compare
+// it with the cached P4Info. When translating many entries with the same
+// P4Info, get the IrP4Info once and pass it to the IrP4Info-based functions
+// instead of passing the P4Info each time.
+absl::StatusOr<std::shared_ptr<const IrP4Info>> GetCachedIrP4Info(
+    const p4::config::v1::P4Info& p4_info);
+
+// Names of the definitions of one kind (e.g. tables) that differ between two
+// IrP4Infos, each in alphabetical order.
+struct IrP4InfoEntityChanges {
+  std::vector<std::string> added;
+  std::vector<std::string> removed;
+  std::vector<std::string> modified;
+
+  bool empty() const {
+    return added.empty() && removed.empty() && modified.empty();
+  }
+};
+
+// The differences between two IrP4Infos. A table is modified if any part of
+// its definition changed, including the definitions of its actions.
+struct IrP4InfoChanges {
+  IrP4InfoEntityChanges tables;
+  IrP4InfoEntityChanges actions;
+  IrP4InfoEntityChanges packet_in_metadata;
+  IrP4InfoEntityChanges packet_out_metadata;
+
+  bool empty() const {
+    return tables.empty() && actions.empty() && packet_in_metadata.empty() &&
+           packet_out_metadata.empty();
+  }
+};
+
+// Same as CreateIrP4Info, but copies the IR definitions from `previous_info`,
+// which must have been created from `previous_p4info`, instead of translating
+// them again for:
+// - actions whose P4Info definition is unchanged in `p4_info`, and
+// - tables whose P4Info definition and actions are all unchanged.
+// Only the translation of these definitions (e.g. parsing their annotations)
+// is skipped. All actions and tables are still compared with their previous
+// definitions and copied, and packet IO metadata, counters and meters are
+// always translated. Nothing is reused if the type info changed. If `changes`
+// is not null, it is set to the differences between `previous_info` and the
+// result, e.g. to invalidate only the affected entries of caches.
+absl::StatusOr<IrP4Info> UpdateIrP4Info(
+    const IrP4Info& previous_info,
+    const p4::config::v1::P4Info& previous_p4info,
+    const p4::config::v1::P4Info& p4_info, IrP4InfoChanges* changes = nullptr);
 
 // Converts a PI table entry to the IR table entry.
 absl::StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info& info,
@@ -40,6 +109,16 @@ absl::StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info& info,
 absl::StatusOr<p4::v1::TableEntry> IrTableEntryToPi(const IrP4Info& info,
                                                     const IrTableEntry& ir);
 
+// Same as above, but using a CompiledIrP4Info for the lookups. Prefer these
+// when translating many entries with the same P4Info: the IrP4Info overloads
+// scan the actions and match fields of the entry's table. Functions that
+// translate many entries at once (e.g. PiWriteRequestToIr, PiTableEntriesToIr)
+// compile the IrP4Info themselves when the number of entries amortizes it.
+absl::StatusOr<IrTableEntry> PiTableEntryToIr(const CompiledIrP4Info& info,
+                                              const p4::v1::TableEntry& pi);
+absl::StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
+    const CompiledIrP4Info& info, const IrTableEntry& ir);
+
 // Returns the IR of a packet-io packet.
 absl::StatusOr<IrPacketIn> PiPacketInToIr(const IrP4Info& info,
                                           const p4::v1::PacketIn& packet);
@@ -81,6 +160,102 @@ absl::StatusOr<IrWriteRequest> PiWriteRequestToIr(
 absl::StatusOr<p4::v1::WriteRequest> IrWriteRequestToPi(
     const IrP4Info& info, const IrWriteRequest& write_request);
 
+// Output-parameter variants of the conversion functions above. The output is
+// cleared and then built in place, so it may be allocated on a
+// google::protobuf::Arena (e.g. to share one arena across a batch of
+// conversions), in which case all sub-messages are allocated on the same
+// arena. The contents of the output are unspecified if an error is returned.
+absl::Status PiTableEntryToIr(const IrP4Info& info,
+                              const p4::v1::TableEntry& pi, IrTableEntry* ir);
+absl::Status IrTableEntryToPi(const IrP4Info& info, const IrTableEntry& ir,
+                              p4::v1::TableEntry* pi);
+absl::Status PiTableEntryToIr(const CompiledIrP4Info& info,
+                              const p4::v1::TableEntry& pi, IrTableEntry* ir);
+absl::Status IrTableEntryToPi(const CompiledIrP4Info& info,
+                              const IrTableEntry& ir, p4::v1::TableEntry* pi);
+absl::Status PiReadResponseToIr(const IrP4Info& info,
+                                const p4::v1::ReadResponse& read_response,
+                                IrReadResponse* ir);
+absl::Status IrReadResponseToPi(const IrP4Info& info,
+                                const IrReadResponse& read_response,
+                                p4::v1::ReadResponse* pi);
+absl::Status PiUpdateToIr(const IrP4Info& info, const p4::v1::Update& update,
+                          IrUpdate* ir);
+absl::Status IrUpdateToPi(const IrP4Info& info, const IrUpdate& update,
+                          p4::v1::Update* pi);
+absl::Status PiWriteRequestToIr(const IrP4Info& info,
+                                const p4::v1::WriteRequest& write_request,
+                                IrWriteRequest* ir);
+absl::Status IrWriteRequestToPi(const IrP4Info& info,
+                                const IrWriteRequest& write_request,
+                                p4::v1::WriteRequest* pi);
+
+// Batch conversion functions for table entries, read response entities and
+// write request updates. Unlike the RPC-level conversion functions above, they
+// do not stop at the first invalid input: the i-th element of the result is
+// the translation of the i-th input, or the reason it could not be translated.
+// Inputs are translated in parallel on the threads of `pool` and the calling
+// thread, or only on the calling thread if `pool` is nullptr.
+std::vector<absl::StatusOr<IrTableEntry>> PiTableEntriesToIr(
+    const IrP4Info& info, absl::Span<const p4::v1::TableEntry> pi,
+    gutil::ThreadPool* pool = nullptr);
+std::vector<absl::StatusOr<IrTableEntry>> PiTableEntriesToIr(
+    const IrP4Info& info,
+    const google::protobuf::RepeatedPtrField<p4::v1::TableEntry>& pi,
+    gutil::ThreadPool* pool = nullptr);
+std::vector<absl::StatusOr<p4::v1::TableEntry>> IrTableEntriesToPi(
+    const IrP4Info& info, absl::Span<const IrTableEntry> ir,
+    gutil::ThreadPool* pool = nullptr);
+std::vector<absl::StatusOr<p4::v1::TableEntry>> IrTableEntriesToPi(
+    const IrP4Info& info,
+    const google::protobuf::RepeatedPtrField<IrTableEntry>& ir,
+    gutil::ThreadPool* pool = nullptr);
+std::vector<absl::StatusOr<IrTableEntry>> PiEntitiesToIr(
+    const IrP4Info& info,
+    const google::protobuf::RepeatedPtrField<p4::v1::Entity>& entities,
+    gutil::ThreadPool* pool = nullptr);
+std::vector<absl::StatusOr<IrUpdate>> PiUpdatesToIr(
+    const IrP4Info& info, absl::Span<const p4::v1::Update> updates,
+    gutil::ThreadPool* pool = nullptr);
+std::vector<absl::StatusOr<IrUpdate>> PiUpdatesToIr(
+    const IrP4Info& info,
+    const google::protobuf::RepeatedPtrField<p4::v1::Update>& updates,
+    gutil::ThreadPool* pool = nullptr);
+std::vector<absl::StatusOr<p4::v1::Update>> IrUpdatesToPi(
+    const IrP4Info& info, absl::Span<const IrUpdate> updates,
+    gutil::ThreadPool* pool = nullptr);
+std::vector<absl::StatusOr<p4::v1::Update>> IrUpdatesToPi(
+    const IrP4Info& info,
+    const google::protobuf::RepeatedPtrField<IrUpdate>& updates,
+    gutil::ThreadPool* pool = nullptr);
+
+// Same as PiWriteRequestToIr and PiReadResponseToIr, but for the serialized
+// p4::v1 message, e.g. as received over the wire. The message is translated
+// directly from its wire format, which is faster than parsing it into a p4::v1
+// message first. The result is the same as translating the parsed message,
+// except that the bytes of fields that are not translated (e.g. counter data)
+// are not validated. Returns InvalidArgument if the message is malformed.
+absl::StatusOr<IrWriteRequest> SerializedPiWriteRequestToIr(
+    const IrP4Info& info, absl::string_view write_request);
+absl::StatusOr<IrWriteRequest> SerializedPiWriteRequestToIr(
+    const CompiledIrP4Info& info, absl::string_view write_request);
+absl::StatusOr<IrReadResponse> SerializedPiReadResponseToIr(
+    const IrP4Info& info, absl::string_view read_response);
+absl::StatusOr<IrReadResponse> SerializedPiReadResponseToIr(
+    const CompiledIrP4Info& info, absl::string_view read_response);
+absl::Status SerializedPiWriteRequestToIr(const IrP4Info& info,
+                                          absl::string_view write_request,
+                                          IrWriteRequest* ir);
+absl::Status SerializedPiWriteRequestToIr(const CompiledIrP4Info& info,
+                                          absl::string_view write_request,
+                                          IrWriteRequest* ir);
+absl::Status SerializedPiReadResponseToIr(const IrP4Info& info,
+                                          absl::string_view read_response,
+                                          IrReadResponse* ir);
+absl::Status SerializedPiReadResponseToIr(const CompiledIrP4Info& info,
+                                          absl::string_view read_response,
+                                          IrReadResponse* ir);
+
 // Formats a grpc status about write request into a readible string.
 std::string WriteRequestGrpcStatusToString(const grpc::Status& grpc_status);
 
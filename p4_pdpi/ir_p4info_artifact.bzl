@@ -0,0 +1,43 @@
+# Copyright 2020 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Rule for precompiling the IrP4Info of a p4info file."""
+
+def ir_p4info_artifact(
+        name,
+        src,
+        out,
+        visibility = None):
+    """Generates the IrP4Info artifact of a p4info file.
+
+    The artifact can be loaded with ReadIrP4InfoArtifact (see
+    p4_pdpi/ir_p4info_artifact.h) instead of parsing the p4info file and
+    creating its IrP4Info at runtime.
+    """
+    gen = "//p4_pdpi:ir_p4info_artifact_gen"
+    p4info = ":" + src
+    native.genrule(
+        name = name,
+        outs = [out],
+        cmd = """
+            $(location {gen})\\
+                --p4info $(location {p4info})\\
+                > $(OUTS)
+        """.format(
+            gen = gen,
+            p4info = p4info,
+        ),
+        srcs = [p4info],
+        tools = [gen],
+        visibility = visibility,
+    )
@@ -0,0 +1,201 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/ir_p4info_artifact.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+#include "gutil/status.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+namespace {
+
+constexpr absl::string_view kMagic = "PDPIIRP4";
+
+// Offsets of the header fields.
+constexpr int kVersionOffset = 8;
+constexpr int kHeaderSizeOffset = 12;
+constexpr int kP4InfoChecksumOffset = 16;
+constexpr int kIrP4InfoSizeOffset = 24;
+constexpr int kIrP4InfoChecksumOffset = 32;
+constexpr int kHeaderSize = 40;
+
+// Returns the 64 bit FNV-1a hash of `bytes`.
+uint64_t Fnv1a64(absl::string_view bytes) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const char c : bytes) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+// Serializes `message`, always in the same way for equal messages.
+absl::StatusOr<std::string> SerializeDeterministically(
+    const google::protobuf::Message& message) {
+  std::string bytes;
+  {
+    google::protobuf::io::StringOutputStream stream(&bytes);
+    google::protobuf::io::CodedOutputStream coded_stream(&stream);
+    coded_stream.SetSerializationDeterministic(true);
+    if (!message.SerializeToCodedStream(&coded_stream)) {
+      return gutil::InternalErrorBuilder()
+             << "Failed to serialize " << message.GetTypeName();
+    }
+  }
+  return bytes;
+}
+
+template <typename T>
+void AppendLittleEndian(T value, std::string* bytes) {
+  for (int i = 0; i < sizeof(T); ++i) {
+    bytes->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+template <typename T>
+T ReadLittleEndian(absl::string_view bytes, int offset) {
+  T value = 0;
+  for (int i = 0; i < sizeof(T); ++i) {
+    value |= static_cast<T>(static_cast<uint8_t>(bytes[offset + i]))
+             << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+absl::StatusOr<uint64_t> P4InfoChecksum(const p4::config::v1::P4Info& p4_info) {
+  ASSIGN_OR_RETURN(const std::string bytes,
+                   SerializeDeterministically(p4_info));
+  return Fnv1a64(bytes);
+}
+
+absl::StatusOr<std::string> CreateIrP4InfoArtifact(
+    const p4::config::v1::P4Info& p4_info) {
+  ASSIGN_OR_RETURN(const IrP4Info info, CreateIrP4Info(p4_info));
+  ASSIGN_OR_RETURN(const uint64_t p4info_checksum, P4InfoChecksum(p4_info));
+  ASSIGN_OR_RETURN(const std::string info_bytes,
+                   SerializeDeterministically(info));
+
+  std::string artifact(kMagic);
+  AppendLittleEndian<uint32_t>(kIrP4InfoArtifactVersion, &artifact);
+  AppendLittleEndian<uint32_t>(kHeaderSize, &artifact);
+  AppendLittleEndian<uint64_t>(p4info_checksum, &artifact);
+  AppendLittleEndian<uint64_t>(info_bytes.size(), &artifact);
+  AppendLittleEndian<uint64_t>(Fnv1a64(info_bytes), &artifact);
+  artifact.append(info_bytes);
+  return artifact;
+}
+
+absl::StatusOr<IrP4Info> ParseIrP4InfoArtifact(
+    absl::string_view artifact, const p4::config::v1::P4Info* p4_info) {
+  if (artifact.size() < kHeaderSize ||
+      artifact.substr(0, kMagic.size()) != kMagic) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Not an IrP4Info artifact: missing header";
+  }
+  const uint32_t version = ReadLittleEndian<uint32_t>(artifact, kVersionOffset);
+  if (version != kIrP4InfoArtifactVersion) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "IrP4Info artifact has layout version " << version
+           << ", but only version " << kIrP4InfoArtifactVersion
+           << " is supported";
+  }
+  const uint32_t header_size =
+      ReadLittleEndian<uint32_t>(artifact, kHeaderSizeOffset);
+  const uint64_t info_size =
+      ReadLittleEndian<uint64_t>(artifact, kIrP4InfoSizeOffset);
+  if (header_size != kHeaderSize ||
+      artifact.size() != header_size + info_size) {
+    return gutil::DataLossErrorBuilder()
+           << "IrP4Info artifact has " << artifact.size()
+           << " bytes, but its header expects " << header_size << " + "
+           << info_size;
+  }
+  const absl::string_view info_bytes = artifact.substr(header_size);
+  if (Fnv1a64(info_bytes) !=
+      ReadLittleEndian<uint64_t>(artifact, kIrP4InfoChecksumOffset)) {
+    return gutil::DataLossErrorBuilder()
+           << "IrP4Info artifact does not match its checksum";
+  }
+  if (p4_info != nullptr) {
+    ASSIGN_OR_RETURN(const uint64_t p4info_checksum, P4InfoChecksum(*p4_info));
+    if (p4info_checksum !=
+        ReadLittleEndian<uint64_t>(artifact, kP4InfoChecksumOffset)) {
+      return gutil::FailedPreconditionErrorBuilder()
+             << "IrP4Info artifact was not created from the given P4Info";
+    }
+  }
+
+  IrP4Info info;
+  if (!info.ParseFromArray(info_bytes.data(), info_bytes.size())) {
+    return gutil::DataLossErrorBuilder()
+           << "Failed to parse the IrP4Info of the artifact";
+  }
+  return info;
+}
+
+absl::StatusOr<IrP4Info> ReadIrP4InfoArtifact(
+    const std::string& filename, const p4::config::v1::P4Info* p4_info) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Error opening the file " << filename;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Error reading the size of the file " << filename;
+  }
+  const size_t size = file_stat.st_size;
+  if (size == 0) {
+    close(fd);
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Invalid IrP4Info artifact " << filename << ": file is empty";
+  }
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping remains valid after the file is closed.
+  close(fd);
+  if (data == MAP_FAILED) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Error mapping the file " << filename;
+  }
+  absl::StatusOr<IrP4Info> info = ParseIrP4InfoArtifact(
+      absl::string_view(static_cast<const char*>(data), size), p4_info);
+  munmap(data, size);
+  if (!info.ok()) {
+    return gutil::StatusBuilder(info.status()).SetPrepend()
+           << "Invalid IrP4Info artifact " << filename << ": ";
+  }
+  return info;
+}
+
+}  // namespace pdpi
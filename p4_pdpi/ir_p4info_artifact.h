@@ -0,0 +1,80 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef P4_PDPI_IR_P4INFO_ARTIFACT_H
+#define P4_PDPI_IR_P4INFO_ARTIFACT_H
+// Precompiled IrP4Info artifacts, which let processes skip parsing the P4Info
+// text format and running CreateIrP4Info at startup. Artifacts are generated
+// at build time with the `ir_p4info_artifact` rule (see
+// ir_p4info_artifact.bzl).
+//
+// An artifact is a fixed-size header followed by the IrP4Info in protobuf
+// binary format. All header fields are little endian:
+//
+//   offset  size  field
+//        0     8  magic "PDPIIRP4"
+//        8     4  layout version (kIrP4InfoArtifactVersion)
+//       12     4  header size in bytes
+//       16     8  checksum of the P4Info the IrP4Info was created from
+//       24     8  size of the IrP4Info in bytes
+//       32     8  checksum of the IrP4Info bytes
+//
+// Checksums are 64 bit FNV-1a hashes of deterministic protobuf serializations.
+// Deterministic serialization is only guaranteed to be the same within one
+// build of one process: a different protobuf version may serialize the same
+// message to other bytes, and hence give another checksum. The IrP4Info
+// checksum is computed over the bytes stored in the artifact, so it is not
+// affected. The P4Info checksum, however, is computed again from the P4Info
+// passed to ParseIrP4InfoArtifact. After a protobuf upgrade, regenerate the
+// artifacts, or artifacts created from the same P4Info may be rejected.
+
+#include <stdint.h>
+
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+// The version of the artifact layout. Artifacts of other versions are
+// rejected.
+constexpr uint32_t kIrP4InfoArtifactVersion = 1;
+
+// Returns the checksum of `p4_info` that is recorded in the artifacts created
+// from it.
+absl::StatusOr<uint64_t> P4InfoChecksum(const p4::config::v1::P4Info& p4_info);
+
+// Creates the IrP4Info of `p4_info` and returns it as an artifact.
+absl::StatusOr<std::string> CreateIrP4InfoArtifact(
+    const p4::config::v1::P4Info& p4_info);
+
+// Returns the IrP4Info of the given artifact after verifying its layout and
+// checksum. If `p4_info` is not null, also verifies that the artifact was
+// created from it, by comparing P4Info checksums (see above).
+absl::StatusOr<IrP4Info> ParseIrP4InfoArtifact(
+    absl::string_view artifact,
+    const p4::config::v1::P4Info* p4_info = nullptr);
+
+// Same as ParseIrP4InfoArtifact, but for the artifact in the given file, which
+// is memory-mapped rather than read.
+absl::StatusOr<IrP4Info> ReadIrP4InfoArtifact(
+    const std::string& filename,
+    const p4::config::v1::P4Info* p4_info = nullptr);
+
+}  // namespace pdpi
+
+#endif  // P4_PDPI_IR_P4INFO_ARTIFACT_H
@@ -0,0 +1,65 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Given a P4Info file, writes the corresponding IrP4Info artifact (see
+// ir_p4info_artifact.h) to stdout.
+
+#include <iostream>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_join.h"
+#include "gutil/proto.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir_p4info_artifact.h"
+
+ABSL_FLAG(std::string, p4info, "", "p4info file (required)");
+
+constexpr char kUsage[] = "--p4info=<file>";
+
+using ::p4::config::v1::P4Info;
+
+int main(int argc, char** argv) {
+  absl::SetProgramUsageMessage(
+      absl::StrJoin({"usage:", (const char*)argv[0], kUsage}, " "));
+  absl::ParseCommandLine(argc, argv);
+
+  // Get p4info file name.
+  const std::string p4info_filename = absl::GetFlag(FLAGS_p4info);
+  if (p4info_filename.empty()) {
+    std::cerr << "Missing argument: --p4info=<file>" << std::endl;
+    return 1;
+  }
+
+  // Parse p4info file.
+  P4Info p4info;
+  absl::Status status = gutil::ReadProtoFromFile(p4info_filename, &p4info);
+  if (!status.ok()) {
+    std::cerr << status << std::endl;
+    return 1;
+  }
+
+  absl::StatusOr<std::string> artifact = pdpi::CreateIrP4InfoArtifact(p4info);
+  if (!artifact.ok()) {
+    std::cerr << "Failed to create IrP4Info artifact: " << artifact.status()
+              << std::endl;
+    return 1;
+  }
+  std::cout.write(artifact->data(), artifact->size());
+  return std::cout.good() ? 0 : 1;
+}
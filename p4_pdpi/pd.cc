@@ -16,18 +16,24 @@
 
 #include <stdint.h>
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/base/attributes.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/map.h"
 #include "google/protobuf/message.h"
 #include "google/rpc/code.pb.h"
 #include "google/rpc/status.pb.h"
 #include "gutil/collections.h"
-#include "gutil/proto.h"
 #include "gutil/status.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/v1/p4runtime.pb.h"
@@ -39,7 +45,10 @@
 
 namespace pdpi {
 
+using ::google::protobuf::Descriptor;
+using ::google::protobuf::DescriptorPool;
 using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::OneofDescriptor;
 using ::gutil::InvalidArgumentErrorBuilder;
 using ::gutil::UnimplementedErrorBuilder;
 using ::p4::config::v1::MatchField;
@@ -49,251 +58,429 @@ namespace {
 constexpr char kPdProtoAndP4InfoOutOfSync[] =
     "The PD proto and P4Info file are out of sync";
 
-absl::StatusOr<const google::protobuf::FieldDescriptor *> GetFieldDescriptor(
-    const google::protobuf::Message &parent_message,
-    const std::string &fieldname) {
-  auto *parent_descriptor = parent_message.GetDescriptor();
-  auto *field_descriptor = parent_descriptor->FindFieldByName(fieldname);
-  if (field_descriptor == nullptr) {
+// The fields of a PD message type. They are resolved once per type, so that
+// converting PD messages neither looks up fields in descriptors, nor converts
+// between P4 names and protobuf field names.
+struct PdMessageFields {
+  struct Field {
+    const FieldDescriptor *descriptor = nullptr;
+    // The fields of the message type of a message field, nullptr otherwise.
+    const PdMessageFields *message = nullptr;
+    // Whether the field is the PD field of a P4 table, and if so, the P4 name
+    // of the table.
+    bool is_table = false;
+    std::string p4_table_name;
+  };
+
+  const Descriptor *descriptor = nullptr;
+  // The i-th element belongs to `descriptor->field(i)`.
+  std::vector<Field> fields;
+  absl::flat_hash_map<std::string, const Field *> fields_by_name;
+  absl::flat_hash_map<std::string, const OneofDescriptor *> oneofs_by_name;
+  // The PD fields of P4 tables and actions, by P4 name.
+  absl::flat_hash_map<std::string, const Field *> tables_by_p4_name;
+  absl::flat_hash_map<std::string, const Field *> actions_by_p4_name;
+
+  // Returns the field with the given descriptor, which must be a (non
+  // extension) field of this message type.
+  const Field &field(const FieldDescriptor *field_descriptor) const {
+    return fields[field_descriptor->index()];
+  }
+};
+
+using PdMessageFieldsByDescriptor =
+    absl::flat_hash_map<const Descriptor *, std::unique_ptr<PdMessageFields>>;
+
+// Resolves the fields of `descriptor` and of all message types used by it,
+// unless they are in `cache` already.
+const PdMessageFields &ResolvePdMessageFields(
+    const Descriptor *descriptor, PdMessageFieldsByDescriptor &cache) {
+  std::unique_ptr<PdMessageFields> &cached = cache[descriptor];
+  if (cached != nullptr) return *cached;
+  cached = absl::make_unique<PdMessageFields>();
+  // Resolving message fields below inserts into the cache, which invalidates
+  // `cached`, but not the fields it points to.
+  PdMessageFields &result = *cached;
+  result.descriptor = descriptor;
+  result.fields.resize(descriptor->field_count());
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    PdMessageFields::Field &field = result.fields[i];
+    field.descriptor = descriptor->field(i);
+    const std::string &name = field.descriptor->name();
+    if (field.descriptor->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      field.message =
+          &ResolvePdMessageFields(field.descriptor->message_type(), cache);
+    }
+    result.fields_by_name[name] = &field;
+    absl::StatusOr<std::string> p4_table_name =
+        ProtobufFieldNameToP4Name(name, kP4Table);
+    if (p4_table_name.ok()) {
+      field.is_table = true;
+      field.p4_table_name = *p4_table_name;
+      result.tables_by_p4_name[*p4_table_name] = &field;
+    }
+    absl::StatusOr<std::string> p4_action_name =
+        ProtobufFieldNameToP4Name(name, kP4Action);
+    if (p4_action_name.ok()) {
+      result.actions_by_p4_name[*p4_action_name] = &field;
+    }
+  }
+  for (int i = 0; i < descriptor->oneof_decl_count(); ++i) {
+    const OneofDescriptor *oneof = descriptor->oneof_decl(i);
+    result.oneofs_by_name[oneof->name()] = oneof;
+  }
+  return result;
+}
+
+ABSL_CONST_INIT absl::Mutex pd_message_fields_mutex(absl::kConstInit);
+
+// The fields of a PD message type, as returned by GetPdMessageFields. Owns
+// them if they are not cached.
+class PdMessageFieldsRef {
+ public:
+  explicit PdMessageFieldsRef(const PdMessageFields &cached)
+      : fields_(&cached) {}
+  PdMessageFieldsRef(std::unique_ptr<PdMessageFieldsByDescriptor> uncached,
+                     const PdMessageFields &fields)
+      : uncached_(std::move(uncached)), fields_(&fields) {}
+
+  operator const PdMessageFields &() const { return *fields_; }  // NOLINT
+
+ private:
+  std::unique_ptr<PdMessageFieldsByDescriptor> uncached_;
+  const PdMessageFields *fields_;
+};
+
+// Returns the fields of the given PD message type. The fields of generated
+// messages are cached for the lifetime of the process. Other descriptors (e.g.
+// of dynamic messages) may be destroyed and their addresses reused, so their
+// fields are resolved on every call instead.
+PdMessageFieldsRef GetPdMessageFields(const Descriptor *descriptor) {
+  if (descriptor->file()->pool() != DescriptorPool::generated_pool()) {
+    auto uncached = absl::make_unique<PdMessageFieldsByDescriptor>();
+    const PdMessageFields &fields =
+        ResolvePdMessageFields(descriptor, *uncached);
+    return PdMessageFieldsRef(std::move(uncached), fields);
+  }
+  static auto *const cache = new PdMessageFieldsByDescriptor();
+  {
+    absl::ReaderMutexLock lock(&pd_message_fields_mutex);
+    auto it = cache->find(descriptor);
+    if (it != cache->end()) return PdMessageFieldsRef(*it->second);
+  }
+  absl::MutexLock lock(&pd_message_fields_mutex);
+  return PdMessageFieldsRef(ResolvePdMessageFields(descriptor, *cache));
+}
+
+absl::StatusOr<const PdMessageFields::Field *> GetField(
+    const PdMessageFields &fields, absl::string_view fieldname) {
+  auto it = fields.fields_by_name.find(fieldname);
+  if (it == fields.fields_by_name.end()) {
     return gutil::InvalidArgumentErrorBuilder()
            << "Field " << fieldname << " missing in "
-           << parent_message.GetTypeName();
+           << fields.descriptor->full_name();
   }
-  return field_descriptor;
+  return it->second;
 }
 
-absl::StatusOr<google::protobuf::Message *> GetMutableMessage(
-    google::protobuf::Message *parent_message, const std::string &fieldname) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(*parent_message, fieldname));
+// Returns the PD field of the P4 table with the given name.
+absl::StatusOr<const PdMessageFields::Field *> GetTableField(
+    const PdMessageFields &fields, const std::string &p4_table_name) {
+  auto it = fields.tables_by_p4_name.find(p4_table_name);
+  if (it != fields.tables_by_p4_name.end()) return it->second;
+  ASSIGN_OR_RETURN(const std::string pd_table_name,
+                   P4NameToProtobufFieldName(p4_table_name, kP4Table));
+  return GetField(fields, pd_table_name);
+}
+
+// Returns the PD field of the P4 action with the given name.
+absl::StatusOr<const PdMessageFields::Field *> GetActionField(
+    const PdMessageFields &fields, const std::string &p4_action_name) {
+  auto it = fields.actions_by_p4_name.find(p4_action_name);
+  if (it != fields.actions_by_p4_name.end()) return it->second;
+  ASSIGN_OR_RETURN(const std::string pd_action_name,
+                   P4NameToProtobufFieldName(p4_action_name, kP4Action));
+  return GetField(fields, pd_action_name);
+}
+
+// Returns the field that is set in the oneof with the given name.
+absl::StatusOr<const PdMessageFields::Field *> GetOneofField(
+    const PdMessageFields &fields, const google::protobuf::Message &message,
+    const std::string &oneof_name) {
+  auto it = fields.oneofs_by_name.find(oneof_name);
+  if (it == fields.oneofs_by_name.end()) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Oneof " << oneof_name << " missing in "
+           << fields.descriptor->full_name();
+  }
+  const FieldDescriptor *field_descriptor =
+      message.GetReflection()->GetOneofFieldDescriptor(message, it->second);
   if (field_descriptor == nullptr) {
+    return gutil::NotFoundErrorBuilder()
+           << "Oneof field \"" << oneof_name << "\" is not set";
+  }
+  return &fields.field(field_descriptor);
+}
+
+absl::Status ValidateFieldDescriptorType(const FieldDescriptor *descriptor,
+                                         FieldDescriptor::Type expected_type) {
+  if (expected_type != descriptor->type()) {
     return gutil::InvalidArgumentErrorBuilder()
-           << "Field " << fieldname << " missing in "
-           << parent_message->GetTypeName() << ". "
-           << kPdProtoAndP4InfoOutOfSync;
+           << "Expected field \"" << descriptor->name() << "\" to be of type \""
+           << FieldDescriptor::TypeName(expected_type) << "\", but got \""
+           << FieldDescriptor::TypeName(descriptor->type()) << "\" instead";
   }
+  return absl::OkStatus();
+}
 
+absl::StatusOr<google::protobuf::Message *> GetMutableMessage(
+    google::protobuf::Message *parent_message,
+    const PdMessageFields::Field &field) {
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field.descriptor,
+                                              FieldDescriptor::TYPE_MESSAGE));
   return parent_message->GetReflection()->MutableMessage(parent_message,
-                                                         field_descriptor);
+                                                         field.descriptor);
+}
+
+// Returns the message field with the given name, and stores the fields of its
+// type in `message_fields`.
+absl::StatusOr<google::protobuf::Message *> GetMutableMessage(
+    const PdMessageFields &fields, google::protobuf::Message *parent_message,
+    absl::string_view fieldname, const PdMessageFields **message_fields) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  *message_fields = field->message;
+  return GetMutableMessage(parent_message, *field);
 }
 
 absl::StatusOr<const google::protobuf::Message *> GetMessageField(
     const google::protobuf::Message &parent_message,
-    const std::string &fieldname) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(parent_message, fieldname));
-  if (field_descriptor == nullptr) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "Field " << fieldname << " missing in "
-           << parent_message.GetTypeName() << ". "
-           << kPdProtoAndP4InfoOutOfSync;
-  }
-
+    const PdMessageFields::Field &field) {
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field.descriptor,
+                                              FieldDescriptor::TYPE_MESSAGE));
   return &parent_message.GetReflection()->GetMessage(parent_message,
-                                                     field_descriptor);
+                                                     field.descriptor);
+}
+
+// Returns the message field with the given name, and stores the fields of its
+// type in `message_fields`.
+absl::StatusOr<const google::protobuf::Message *> GetMessageField(
+    const PdMessageFields &fields,
+    const google::protobuf::Message &parent_message,
+    absl::string_view fieldname, const PdMessageFields **message_fields) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  *message_fields = field->message;
+  return GetMessageField(parent_message, *field);
 }
 
 absl::StatusOr<const google::protobuf::Message *> GetRepeatedMessage(
+    const PdMessageFields &fields,
     const google::protobuf::Message &parent_message,
-    const std::string &fieldname, int index) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(parent_message, fieldname));
-  if (field_descriptor == nullptr) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "Field " << fieldname << " missing in "
-           << parent_message.GetTypeName() << ". "
-           << kPdProtoAndP4InfoOutOfSync;
-  }
+    absl::string_view fieldname, int index) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
+                                              FieldDescriptor::TYPE_MESSAGE));
   int repeated_field_length = parent_message.GetReflection()->FieldSize(
-      parent_message, field_descriptor);
-  if (parent_message.GetReflection()->FieldSize(parent_message,
-                                                field_descriptor) < index) {
+      parent_message, field->descriptor);
+  if (repeated_field_length < index) {
     return gutil::OutOfRangeErrorBuilder()
            << "Index out of repeated field's bound. field's length: "
            << repeated_field_length << "index: " << index;
   }
   return &parent_message.GetReflection()->GetRepeatedMessage(
-      parent_message, field_descriptor, index);
+      parent_message, field->descriptor, index);
 }
 
 absl::StatusOr<google::protobuf::Message *> AddRepeatedMutableMessage(
-    google::protobuf::Message *parent_message, const std::string &fieldname) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(*parent_message, fieldname));
-  if (field_descriptor == nullptr) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "Field " << fieldname << " missing in "
-           << parent_message->GetTypeName() << ". "
-           << kPdProtoAndP4InfoOutOfSync;
-  }
+    google::protobuf::Message *parent_message,
+    const PdMessageFields::Field &field) {
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field.descriptor,
+                                              FieldDescriptor::TYPE_MESSAGE));
   return parent_message->GetReflection()->AddMessage(parent_message,
-                                                     field_descriptor);
-}
-
-absl::Status ValidateFieldDescriptorType(const FieldDescriptor *descriptor,
-                                         FieldDescriptor::Type expected_type) {
-  if (expected_type != descriptor->type()) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "Expected field \"" << descriptor->name() << "\" to be of type \""
-           << FieldDescriptor::TypeName(expected_type) << "\", but got \""
-           << FieldDescriptor::TypeName(descriptor->type()) << "\" instead";
-  }
-  return absl::OkStatus();
+                                                     field.descriptor);
 }
 
-absl::StatusOr<bool> GetBoolField(const google::protobuf::Message &message,
-                                  const std::string &fieldname) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(message, fieldname));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+absl::StatusOr<bool> GetBoolField(const PdMessageFields &fields,
+                                  const google::protobuf::Message &message,
+                                  absl::string_view fieldname) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_BOOL));
-  return message.GetReflection()->GetBool(message, field_descriptor);
+  return message.GetReflection()->GetBool(message, field->descriptor);
 }
 
-absl::StatusOr<int32_t> GetInt32Field(const google::protobuf::Message &message,
-                                      const std::string &fieldname) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(message, fieldname));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+absl::StatusOr<int32_t> GetInt32Field(const PdMessageFields &fields,
+                                      const google::protobuf::Message &message,
+                                      absl::string_view fieldname) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_INT32));
-  return message.GetReflection()->GetInt32(message, field_descriptor);
+  return message.GetReflection()->GetInt32(message, field->descriptor);
 }
 
-absl::StatusOr<int64_t> GetInt64Field(const google::protobuf::Message &message,
-                                      const std::string &fieldname) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(message, fieldname));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+absl::StatusOr<int64_t> GetInt64Field(const PdMessageFields &fields,
+                                      const google::protobuf::Message &message,
+                                      absl::string_view fieldname) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_INT64));
-  return message.GetReflection()->GetInt64(message, field_descriptor);
+  return message.GetReflection()->GetInt64(message, field->descriptor);
 }
 
 absl::StatusOr<uint64_t> GetUint64Field(
-    const google::protobuf::Message &message, const std::string &fieldname) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(message, fieldname));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+    const PdMessageFields &fields, const google::protobuf::Message &message,
+    absl::string_view fieldname) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_UINT64));
-  return message.GetReflection()->GetUInt64(message, field_descriptor);
+  return message.GetReflection()->GetUInt64(message, field->descriptor);
 }
 
 absl::StatusOr<std::string> GetStringField(
-    const google::protobuf::Message &message, const std::string &fieldname) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(message, fieldname));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+    const google::protobuf::Message &message,
+    const PdMessageFields::Field &field) {
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field.descriptor,
                                               FieldDescriptor::TYPE_STRING));
-  return message.GetReflection()->GetString(message, field_descriptor);
+  return message.GetReflection()->GetString(message, field.descriptor);
+}
+
+absl::StatusOr<std::string> GetStringField(
+    const PdMessageFields &fields, const google::protobuf::Message &message,
+    absl::string_view fieldname) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  return GetStringField(message, *field);
 }
 
-absl::Status SetBoolField(google::protobuf::Message *message,
-                          const std::string &fieldname, bool value) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(*message, fieldname));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+absl::Status SetBoolField(const PdMessageFields &fields,
+                          google::protobuf::Message *message,
+                          absl::string_view fieldname, bool value) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_BOOL));
-  message->GetReflection()->SetBool(message, field_descriptor, value);
+  message->GetReflection()->SetBool(message, field->descriptor, value);
   return absl::OkStatus();
 }
 
-absl::Status SetInt32Field(google::protobuf::Message *message,
-                           const std::string &fieldname, int32_t value) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(*message, fieldname));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+absl::Status SetInt32Field(const PdMessageFields &fields,
+                           google::protobuf::Message *message,
+                           absl::string_view fieldname, int32_t value) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_INT32));
-  message->GetReflection()->SetInt32(message, field_descriptor, value);
+  message->GetReflection()->SetInt32(message, field->descriptor, value);
   return absl::OkStatus();
 }
 
-absl::Status SetInt64Field(google::protobuf::Message *message,
-                           const std::string &fieldname, int64_t value) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(*message, fieldname));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+absl::Status SetInt64Field(const PdMessageFields &fields,
+                           google::protobuf::Message *message,
+                           absl::string_view fieldname, int64_t value) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_INT64));
-  message->GetReflection()->SetInt64(message, field_descriptor, value);
+  message->GetReflection()->SetInt64(message, field->descriptor, value);
   return absl::OkStatus();
 }
 
-absl::Status SetUint64Field(google::protobuf::Message *message,
-                            const std::string &fieldname, uint64_t value) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(*message, fieldname));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+absl::Status SetUint64Field(const PdMessageFields &fields,
+                            google::protobuf::Message *message,
+                            absl::string_view fieldname, uint64_t value) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_UINT64));
-  message->GetReflection()->SetUInt64(message, field_descriptor, value);
+  message->GetReflection()->SetUInt64(message, field->descriptor, value);
   return absl::OkStatus();
 }
 
-absl::Status SetStringField(google::protobuf::Message *message,
-                            const std::string &fieldname, std::string value) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(*message, fieldname));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+absl::Status SetStringField(const PdMessageFields &fields,
+                            google::protobuf::Message *message,
+                            absl::string_view fieldname, std::string value) {
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, fieldname));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_STRING));
-  message->GetReflection()->SetString(message, field_descriptor, value);
+  message->GetReflection()->SetString(message, field->descriptor,
+                                      std::move(value));
   return absl::OkStatus();
 }
 
-std::vector<std::string> GetAllFieldNames(
-    const google::protobuf::Message &message) {
-  std::vector<const FieldDescriptor *> fields;
-  message.GetReflection()->ListFields(message, &fields);
-  std::vector<std::string> field_names;
-  field_names.reserve(fields.size());
-  for (const auto *field : fields) {
-    field_names.push_back(field->name());
-  }
-  return field_names;
-}
-}  // namespace
-
-absl::StatusOr<int> GetEnumField(const google::protobuf::Message &message,
+absl::StatusOr<int> GetEnumField(const PdMessageFields &fields,
+                                 const google::protobuf::Message &message,
                                  const std::string &field_name) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(message, field_name));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, field_name));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_ENUM));
   int enum_value =
-      message.GetReflection()->GetEnumValue(message, field_descriptor);
-  if (field_descriptor->enum_type()->FindValueByNumber(enum_value) == nullptr) {
+      message.GetReflection()->GetEnumValue(message, field->descriptor);
+  if (field->descriptor->enum_type()->FindValueByNumber(enum_value) ==
+      nullptr) {
     return gutil::InvalidArgumentErrorBuilder()
            << "Enum value within " << field_name << " is : " << enum_value;
   }
   return enum_value;
 }
-absl::Status SetEnumField(google::protobuf::Message *message,
+
+absl::Status SetEnumField(const PdMessageFields &fields,
+                          google::protobuf::Message *message,
                           const std::string &enum_field_name, int enum_value) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(*message, enum_field_name));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+  ASSIGN_OR_RETURN(const auto *field, GetField(fields, enum_field_name));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(field->descriptor,
                                               FieldDescriptor::TYPE_ENUM));
-  if (field_descriptor->enum_type()->FindValueByNumber(enum_value) == nullptr) {
+  if (field->descriptor->enum_type()->FindValueByNumber(enum_value) ==
+      nullptr) {
     return gutil::InvalidArgumentErrorBuilder()
            << "enum_value: " << enum_value << " is not a valid enum value ";
   }
-  message->GetReflection()->SetEnumValue(message, field_descriptor, enum_value);
+  message->GetReflection()->SetEnumValue(message, field->descriptor,
+                                         enum_value);
   return absl::OkStatus();
 }
 
-absl::Status PiTableEntryToPd(const p4::config::v1::P4Info &p4_info,
+// Returns the fields of `message` that are set.
+std::vector<const FieldDescriptor *> GetAllFields(
+    const google::protobuf::Message &message) {
+  std::vector<const FieldDescriptor *> fields;
+  message.GetReflection()->ListFields(message, &fields);
+  return fields;
+}
+}  // namespace
+
+absl::StatusOr<int> GetEnumField(const google::protobuf::Message &message,
+                                 const std::string &field_name) {
+  return GetEnumField(GetPdMessageFields(message.GetDescriptor()), message,
+                      field_name);
+}
+absl::Status SetEnumField(google::protobuf::Message *message,
+                          const std::string &enum_field_name, int enum_value) {
+  return SetEnumField(GetPdMessageFields(message->GetDescriptor()), message,
+                      enum_field_name, enum_value);
+}
+
+absl::Status PiTableEntryToPd(const IrP4Info &info,
                               const p4::v1::TableEntry &pi,
                               google::protobuf::Message *pd) {
-  ASSIGN_OR_RETURN(const auto info, CreateIrP4Info(p4_info));
   ASSIGN_OR_RETURN(const auto ir_entry, PiTableEntryToIr(info, pi));
   RETURN_IF_ERROR(IrTableEntryToPd(info, ir_entry, pd));
   return absl::OkStatus();
 }
 
 absl::StatusOr<p4::v1::TableEntry> PdTableEntryToPi(
-    const p4::config::v1::P4Info &p4_info,
-    const google::protobuf::Message &pd) {
-  ASSIGN_OR_RETURN(const auto info, CreateIrP4Info(p4_info));
+    const IrP4Info &info, const google::protobuf::Message &pd) {
   ASSIGN_OR_RETURN(const auto ir_entry, PdTableEntryToIr(info, pd));
   return IrTableEntryToPi(info, ir_entry);
 }
 
+absl::Status PiTableEntryToPd(const p4::config::v1::P4Info &p4_info,
+                              const p4::v1::TableEntry &pi,
+                              google::protobuf::Message *pd) {
+  ASSIGN_OR_RETURN(const auto info, GetCachedIrP4Info(p4_info));
+  return PiTableEntryToPd(*info, pi, pd);
+}
+
+absl::StatusOr<p4::v1::TableEntry> PdTableEntryToPi(
+    const p4::config::v1::P4Info &p4_info,
+    const google::protobuf::Message &pd) {
+  ASSIGN_OR_RETURN(const auto info, GetCachedIrP4Info(p4_info));
+  return PdTableEntryToPi(*info, pd);
+}
+
 absl::Status PiPacketInToPd(const IrP4Info &info,
                             const p4::v1::PacketIn &pi_packet,
                             google::protobuf::Message *pd_packet) {
@@ -336,36 +523,52 @@ absl::StatusOr<grpc::Status> PdWriteRpcStatusToGrpcStatus(
   return IrWriteRpcStatusToGrpcStatus(ir_write_rpc_status);
 }
 
+// Overloads of the table entry conversions for PD messages whose fields were
+// resolved already, which are used for the table entries of requests and
+// responses.
+static absl::Status IrTableEntryToPd(const IrP4Info &ir_p4info,
+                                     const IrTableEntry &ir,
+                                     const PdMessageFields &pd_fields,
+                                     google::protobuf::Message *pd);
+static absl::Status PdTableEntryToIr(const IrP4Info &ir_p4info,
+                                     const google::protobuf::Message &pd,
+                                     const PdMessageFields &pd_fields,
+                                     IrTableEntry *ir);
+
 absl::Status IrReadRequestToPd(const IrP4Info &info, const IrReadRequest &ir,
                                google::protobuf::Message *pd) {
+  const PdMessageFieldsRef fields = GetPdMessageFields(pd->GetDescriptor());
   if (ir.device_id() == 0) {
     return UnimplementedErrorBuilder() << "Device ID missing";
   }
-  RETURN_IF_ERROR(SetUint64Field(pd, "device_id", ir.device_id()));
+  RETURN_IF_ERROR(SetUint64Field(fields, pd, "device_id", ir.device_id()));
   if (ir.read_counter_data()) {
     RETURN_IF_ERROR(
-        SetBoolField(pd, "read_counter_data", ir.read_counter_data()));
+        SetBoolField(fields, pd, "read_counter_data", ir.read_counter_data()));
   }
   if (ir.read_meter_configs()) {
-    RETURN_IF_ERROR(
-        SetBoolField(pd, "read_meter_configs", ir.read_meter_configs()));
+    RETURN_IF_ERROR(SetBoolField(fields, pd, "read_meter_configs",
+                                 ir.read_meter_configs()));
   }
   return absl::OkStatus();
 }
 
 absl::StatusOr<IrReadRequest> PdReadRequestToIr(
     const IrP4Info &info, const google::protobuf::Message &read_request) {
+  const PdMessageFieldsRef fields =
+      GetPdMessageFields(read_request.GetDescriptor());
   IrReadRequest result;
-  ASSIGN_OR_RETURN(auto device_id, GetUint64Field(read_request, "device_id"));
+  ASSIGN_OR_RETURN(auto device_id,
+                   GetUint64Field(fields, read_request, "device_id"));
   if (device_id == 0) {
     return InvalidArgumentErrorBuilder() << "Device ID missing";
   }
   result.set_device_id(device_id);
   ASSIGN_OR_RETURN(auto read_counter_data,
-                   GetBoolField(read_request, "read_counter_data"));
+                   GetBoolField(fields, read_request, "read_counter_data"));
   result.set_read_counter_data(read_counter_data);
   ASSIGN_OR_RETURN(auto read_meter_configs,
-                   GetBoolField(read_request, "read_meter_configs"));
+                   GetBoolField(fields, read_request, "read_meter_configs"));
   result.set_read_meter_configs(read_meter_configs);
 
   return result;
@@ -373,118 +576,185 @@ absl::StatusOr<IrReadRequest> PdReadRequestToIr(
 
 absl::Status IrReadResponseToPd(const IrP4Info &info, const IrReadResponse &ir,
                                 google::protobuf::Message *read_response) {
+  const PdMessageFieldsRef fields =
+      GetPdMessageFields(read_response->GetDescriptor());
   for (const auto &ir_table_entry : ir.table_entries()) {
-    ASSIGN_OR_RETURN(const auto *table_entries_descriptor,
-                     GetFieldDescriptor(*read_response, "table_entries"));
-    RETURN_IF_ERROR(
-        IrTableEntryToPd(info, ir_table_entry,
-                         read_response->GetReflection()->AddMessage(
-                             read_response, table_entries_descriptor)));
+    ASSIGN_OR_RETURN(const auto *table_entries_field,
+                     GetField(fields, "table_entries"));
+    ASSIGN_OR_RETURN(
+        auto *pd_table_entry,
+        AddRepeatedMutableMessage(read_response, *table_entries_field));
+    RETURN_IF_ERROR(IrTableEntryToPd(info, ir_table_entry,
+                                     *table_entries_field->message,
+                                     pd_table_entry));
   }
   return absl::OkStatus();
 }
 
-absl::StatusOr<IrReadResponse> PdReadResponseToIr(
-    const IrP4Info &info, const google::protobuf::Message &read_response) {
-  IrReadResponse ir_response;
-  ASSIGN_OR_RETURN(const auto table_entries_descriptor,
-                   GetFieldDescriptor(read_response, "table_entries"));
+absl::Status PdReadResponseToIr(const IrP4Info &info,
+                                const google::protobuf::Message &read_response,
+                                IrReadResponse *ir_response) {
+  ir_response->Clear();
+  const PdMessageFieldsRef fields =
+      GetPdMessageFields(read_response.GetDescriptor());
+  ASSIGN_OR_RETURN(const auto *table_entries_field,
+                   GetField(fields, "table_entries"));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(table_entries_field->descriptor,
+                                              FieldDescriptor::TYPE_MESSAGE));
+  const auto *table_entries_descriptor = table_entries_field->descriptor;
   for (auto i = 0; i < read_response.GetReflection()->FieldSize(
                            read_response, table_entries_descriptor);
        ++i) {
-    ASSIGN_OR_RETURN(
-        *ir_response.add_table_entries(),
+    RETURN_IF_ERROR(
         PdTableEntryToIr(info,
                          read_response.GetReflection()->GetRepeatedMessage(
-                             read_response, table_entries_descriptor, i)));
+                             read_response, table_entries_descriptor, i),
+                         *table_entries_field->message,
+                         ir_response->add_table_entries()));
   }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<IrReadResponse> PdReadResponseToIr(
+    const IrP4Info &info, const google::protobuf::Message &read_response) {
+  IrReadResponse ir_response;
+  RETURN_IF_ERROR(PdReadResponseToIr(info, read_response, &ir_response));
   return ir_response;
 }
 
-absl::Status IrUpdateToPd(const IrP4Info &info, const IrUpdate &ir,
-                          google::protobuf::Message *update) {
-  ASSIGN_OR_RETURN(const auto *type_descriptor,
-                   GetFieldDescriptor(*update, "type"));
-  RETURN_IF_ERROR(
-      ValidateFieldDescriptorType(type_descriptor, FieldDescriptor::TYPE_ENUM));
-  update->GetReflection()->SetEnumValue(update, type_descriptor, ir.type());
+static absl::Status IrUpdateToPd(const IrP4Info &info, const IrUpdate &ir,
+                                 const PdMessageFields &fields,
+                                 google::protobuf::Message *update) {
+  ASSIGN_OR_RETURN(const auto *type_field, GetField(fields, "type"));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(type_field->descriptor,
+                                              FieldDescriptor::TYPE_ENUM));
+  update->GetReflection()->SetEnumValue(update, type_field->descriptor,
+                                        ir.type());
 
-  ASSIGN_OR_RETURN(auto *pd_table_entry,
-                   GetMutableMessage(update, "table_entry"));
-  RETURN_IF_ERROR(IrTableEntryToPd(info, ir.table_entry(), pd_table_entry));
+  const PdMessageFields *table_entry_fields;
+  ASSIGN_OR_RETURN(
+      auto *pd_table_entry,
+      GetMutableMessage(fields, update, "table_entry", &table_entry_fields));
+  RETURN_IF_ERROR(IrTableEntryToPd(info, ir.table_entry(),
+                                   *table_entry_fields, pd_table_entry));
   return absl::OkStatus();
 }
 
-absl::StatusOr<IrUpdate> PdUpdateToIr(const IrP4Info &info,
-                                      const google::protobuf::Message &update) {
-  IrUpdate ir_update;
-  ASSIGN_OR_RETURN(const auto *type_descriptor,
-                   GetFieldDescriptor(update, "type"));
+absl::Status IrUpdateToPd(const IrP4Info &info, const IrUpdate &ir,
+                          google::protobuf::Message *update) {
+  return IrUpdateToPd(info, ir, GetPdMessageFields(update->GetDescriptor()),
+                      update);
+}
+
+static absl::Status PdUpdateToIr(const IrP4Info &info,
+                                 const google::protobuf::Message &update,
+                                 const PdMessageFields &fields,
+                                 IrUpdate *ir_update) {
+  ir_update->Clear();
+  ASSIGN_OR_RETURN(const auto *type_field, GetField(fields, "type"));
   const auto &type_value =
-      update.GetReflection()->GetEnumValue(update, type_descriptor);
+      update.GetReflection()->GetEnumValue(update, type_field->descriptor);
 
   if (!p4::v1::Update_Type_IsValid(type_value)) {
     return InvalidArgumentErrorBuilder()
            << "Invalid value for type: " << type_value;
   }
-  ir_update.set_type((p4::v1::Update_Type)type_value);
+  ir_update->set_type((p4::v1::Update_Type)type_value);
 
-  ASSIGN_OR_RETURN(const auto *table_entry,
-                   GetMessageField(update, "table_entry"));
-  ASSIGN_OR_RETURN(*ir_update.mutable_table_entry(),
-                   PdTableEntryToIr(info, *table_entry));
+  const PdMessageFields *table_entry_fields;
+  ASSIGN_OR_RETURN(
+      const auto *table_entry,
+      GetMessageField(fields, update, "table_entry", &table_entry_fields));
+  return PdTableEntryToIr(info, *table_entry, *table_entry_fields,
+                          ir_update->mutable_table_entry());
+}
+
+absl::Status PdUpdateToIr(const IrP4Info &info,
+                          const google::protobuf::Message &update,
+                          IrUpdate *ir_update) {
+  return PdUpdateToIr(info, update, GetPdMessageFields(update.GetDescriptor()),
+                      ir_update);
+}
+
+absl::StatusOr<IrUpdate> PdUpdateToIr(const IrP4Info &info,
+                                      const google::protobuf::Message &update) {
+  IrUpdate ir_update;
+  RETURN_IF_ERROR(PdUpdateToIr(info, update, &ir_update));
   return ir_update;
 }
 
 absl::Status IrWriteRequestToPd(const IrP4Info &info, const IrWriteRequest &ir,
                                 google::protobuf::Message *write_request) {
-  RETURN_IF_ERROR(SetUint64Field(write_request, "device_id", ir.device_id()));
+  const PdMessageFieldsRef fields =
+      GetPdMessageFields(write_request->GetDescriptor());
+  RETURN_IF_ERROR(
+      SetUint64Field(fields, write_request, "device_id", ir.device_id()));
   if (ir.election_id().high() > 0 || ir.election_id().low() > 0) {
+    const PdMessageFields *election_id_fields;
     ASSIGN_OR_RETURN(auto *election_id,
-                     GetMutableMessage(write_request, "election_id"));
-    RETURN_IF_ERROR(
-        SetUint64Field(election_id, "high", ir.election_id().high()));
-    RETURN_IF_ERROR(SetUint64Field(election_id, "low", ir.election_id().low()));
+                     GetMutableMessage(fields, write_request, "election_id",
+                                       &election_id_fields));
+    RETURN_IF_ERROR(SetUint64Field(*election_id_fields, election_id, "high",
+                                   ir.election_id().high()));
+    RETURN_IF_ERROR(SetUint64Field(*election_id_fields, election_id, "low",
+                                   ir.election_id().low()));
   }
 
-  ASSIGN_OR_RETURN(const auto updates_descriptor,
-                   GetFieldDescriptor(*write_request, "updates"));
+  ASSIGN_OR_RETURN(const auto *updates_field, GetField(fields, "updates"));
   for (const auto &ir_update : ir.updates()) {
-    RETURN_IF_ERROR(IrUpdateToPd(info, ir_update,
-                                 write_request->GetReflection()->AddMessage(
-                                     write_request, updates_descriptor)));
+    ASSIGN_OR_RETURN(auto *pd_update,
+                     AddRepeatedMutableMessage(write_request, *updates_field));
+    RETURN_IF_ERROR(
+        IrUpdateToPd(info, ir_update, *updates_field->message, pd_update));
   }
   return absl::OkStatus();
 }
 
-absl::StatusOr<IrWriteRequest> PdWriteRequestToIr(
-    const IrP4Info &info, const google::protobuf::Message &write_request) {
-  IrWriteRequest ir_write_request;
+absl::Status PdWriteRequestToIr(const IrP4Info &info,
+                                const google::protobuf::Message &write_request,
+                                IrWriteRequest *ir_write_request) {
+  ir_write_request->Clear();
+  const PdMessageFieldsRef fields =
+      GetPdMessageFields(write_request.GetDescriptor());
   ASSIGN_OR_RETURN(const auto &device_id,
-                   GetUint64Field(write_request, "device_id"));
-  ir_write_request.set_device_id(device_id);
+                   GetUint64Field(fields, write_request, "device_id"));
+  ir_write_request->set_device_id(device_id);
 
+  const PdMessageFields *election_id_fields;
   ASSIGN_OR_RETURN(const auto *election_id,
-                   GetMessageField(write_request, "election_id"));
-  ASSIGN_OR_RETURN(const auto &high, GetUint64Field(*election_id, "high"));
-  ASSIGN_OR_RETURN(const auto &low, GetUint64Field(*election_id, "low"));
+                   GetMessageField(fields, write_request, "election_id",
+                                   &election_id_fields));
+  ASSIGN_OR_RETURN(const auto &high,
+                   GetUint64Field(*election_id_fields, *election_id, "high"));
+  ASSIGN_OR_RETURN(const auto &low,
+                   GetUint64Field(*election_id_fields, *election_id, "low"));
   if (high > 0 || low > 0) {
-    auto *ir_election_id = ir_write_request.mutable_election_id();
+    auto *ir_election_id = ir_write_request->mutable_election_id();
     ir_election_id->set_high(high);
     ir_election_id->set_low(low);
   }
 
-  ASSIGN_OR_RETURN(const auto updates_descriptor,
-                   GetFieldDescriptor(write_request, "updates"));
+  ASSIGN_OR_RETURN(const auto *updates_field, GetField(fields, "updates"));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(updates_field->descriptor,
+                                              FieldDescriptor::TYPE_MESSAGE));
+  const auto *updates_descriptor = updates_field->descriptor;
   for (auto i = 0; i < write_request.GetReflection()->FieldSize(
                            write_request, updates_descriptor);
        ++i) {
-    ASSIGN_OR_RETURN(
-        *ir_write_request.add_updates(),
-        PdUpdateToIr(info, write_request.GetReflection()->GetRepeatedMessage(
-                               write_request, updates_descriptor, i)));
+    RETURN_IF_ERROR(
+        PdUpdateToIr(info,
+                     write_request.GetReflection()->GetRepeatedMessage(
+                         write_request, updates_descriptor, i),
+                     *updates_field->message, ir_write_request->add_updates()));
   }
 
+  return absl::OkStatus();
+}
+
+absl::StatusOr<IrWriteRequest> PdWriteRequestToIr(
+    const IrP4Info &info, const google::protobuf::Message &write_request) {
+  IrWriteRequest ir_write_request;
+  RETURN_IF_ERROR(PdWriteRequestToIr(info, write_request, &ir_write_request));
   return ir_write_request;
 }
 
@@ -492,61 +762,71 @@ absl::StatusOr<IrWriteRequest> PdWriteRequestToIr(
 // of the PD table entry.
 static absl::Status IrMatchEntryToPd(const IrTableDefinition &ir_table_info,
                                      const IrTableEntry &ir_table_entry,
+                                     const PdMessageFields &match_fields,
                                      google::protobuf::Message *pd_match) {
   for (const auto &ir_match : ir_table_entry.matches()) {
-    ASSIGN_OR_RETURN(const auto &ir_match_info,
-                     gutil::FindOrStatus(ir_table_info.match_fields_by_name(),
-                                         ir_match.name()),
-                     _ << "P4Info for table \""
-                       << ir_table_info.preamble().name()
-                       << "\" does not contain match with name \""
-                       << ir_match.name() << "\"");
-    switch (ir_match_info.match_field().match_type()) {
+    ASSIGN_OR_RETURN(
+        const auto *ir_match_info,
+        gutil::FindPtrOrStatus(ir_table_info.match_fields_by_name(),
+                               ir_match.name()),
+        _ << "P4Info for table \"" << ir_table_info.preamble().name()
+          << "\" does not contain match with name \"" << ir_match.name()
+          << "\"");
+    const PdMessageFields *fields;
+    switch (ir_match_info->match_field().match_type()) {
       case MatchField::EXACT: {
-        ASSIGN_OR_RETURN(
-            const auto pd_value,
-            IrValueToFormattedString(ir_match.exact(), ir_match_info.format()));
-        RETURN_IF_ERROR(SetStringField(pd_match, ir_match.name(), pd_value));
+        ASSIGN_OR_RETURN(auto pd_value,
+                         IrValueToFormattedString(ir_match.exact(),
+                                                  ir_match_info->format()));
+        RETURN_IF_ERROR(SetStringField(match_fields, pd_match, ir_match.name(),
+                                       std::move(pd_value)));
         break;
       }
       case MatchField::LPM: {
         ASSIGN_OR_RETURN(auto *pd_lpm,
-                         GetMutableMessage(pd_match, ir_match.name()));
-        ASSIGN_OR_RETURN(const auto pd_value,
+                         GetMutableMessage(match_fields, pd_match,
+                                           ir_match.name(), &fields));
+        ASSIGN_OR_RETURN(auto pd_value,
                          IrValueToFormattedString(ir_match.lpm().value(),
-                                                  ir_match_info.format()));
-        RETURN_IF_ERROR(SetStringField(pd_lpm, "value", pd_value));
-        RETURN_IF_ERROR(SetInt32Field(pd_lpm, "prefix_length",
+                                                  ir_match_info->format()));
+        RETURN_IF_ERROR(
+            SetStringField(*fields, pd_lpm, "value", std::move(pd_value)));
+        RETURN_IF_ERROR(SetInt32Field(*fields, pd_lpm, "prefix_length",
                                       ir_match.lpm().prefix_length()));
         break;
       }
       case MatchField::TERNARY: {
         ASSIGN_OR_RETURN(auto *pd_ternary,
-                         GetMutableMessage(pd_match, ir_match.name()));
-        ASSIGN_OR_RETURN(const auto pd_value,
+                         GetMutableMessage(match_fields, pd_match,
+                                           ir_match.name(), &fields));
+        ASSIGN_OR_RETURN(auto pd_value,
                          IrValueToFormattedString(ir_match.ternary().value(),
-                                                  ir_match_info.format()));
-        RETURN_IF_ERROR(SetStringField(pd_ternary, "value", pd_value));
-        ASSIGN_OR_RETURN(const auto pd_mask,
+                                                  ir_match_info->format()));
+        RETURN_IF_ERROR(
+            SetStringField(*fields, pd_ternary, "value", std::move(pd_value)));
+        ASSIGN_OR_RETURN(auto pd_mask,
                          IrValueToFormattedString(ir_match.ternary().mask(),
-                                                  ir_match_info.format()));
-        RETURN_IF_ERROR(SetStringField(pd_ternary, "mask", pd_mask));
+                                                  ir_match_info->format()));
+        RETURN_IF_ERROR(
+            SetStringField(*fields, pd_ternary, "mask", std::move(pd_mask)));
         break;
       }
       case MatchField::OPTIONAL: {
         ASSIGN_OR_RETURN(auto *pd_optional,
-                         GetMutableMessage(pd_match, ir_match.name()));
-        ASSIGN_OR_RETURN(const auto pd_value,
+                         GetMutableMessage(match_fields, pd_match,
+                                           ir_match.name(), &fields));
+        ASSIGN_OR_RETURN(auto pd_value,
                          IrValueToFormattedString(ir_match.optional().value(),
-                                                  ir_match_info.format()));
-        RETURN_IF_ERROR(SetStringField(pd_optional, "value", pd_value));
+                                                  ir_match_info->format()));
+        RETURN_IF_ERROR(
+            SetStringField(*fields, pd_optional, "value", std::move(pd_value)));
         break;
       }
       default:
         return gutil::InvalidArgumentErrorBuilder()
                << "Unsupported match type \""
                << MatchField_MatchType_Name(
-                      ir_match_info.match_field().match_type())
+                      ir_match_info->match_field().match_type())
                << "\" in \"" << ir_match.name() << "\"";
     }
   }
@@ -557,40 +837,42 @@ static absl::Status IrMatchEntryToPd(const IrTableDefinition &ir_table_info,
 // of ir_table_entry.
 static absl::Status PdMatchEntryToIr(const IrTableDefinition &ir_table_info,
                                      const google::protobuf::Message &pd_match,
+                                     const PdMessageFields &match_fields,
                                      IrTableEntry *ir_table_entry) {
-  for (const auto &pd_match_name : GetAllFieldNames(pd_match)) {
+  for (const auto *pd_match_field : GetAllFields(pd_match)) {
+    const PdMessageFields::Field &field = match_fields.field(pd_match_field);
+    const std::string &pd_match_name = pd_match_field->name();
     auto *ir_match = ir_table_entry->add_matches();
     ir_match->set_name(pd_match_name);
     ASSIGN_OR_RETURN(
-        const auto &ir_match_info,
-        gutil::FindOrStatus(ir_table_info.match_fields_by_name(),
-                            pd_match_name),
+        const auto *ir_match_info,
+        gutil::FindPtrOrStatus(ir_table_info.match_fields_by_name(),
+                               pd_match_name),
         _ << "P4Info for table \"" << ir_table_info.preamble().name()
           << "\" does not contain match with name \"" << pd_match_name << "\"");
-    switch (ir_match_info.match_field().match_type()) {
+    switch (ir_match_info->match_field().match_type()) {
       case MatchField::EXACT: {
-        ASSIGN_OR_RETURN(const auto &pd_value,
-                         GetStringField(pd_match, pd_match_name));
+        ASSIGN_OR_RETURN(const auto &pd_value, GetStringField(pd_match, field));
         ASSIGN_OR_RETURN(
             *ir_match->mutable_exact(),
-            FormattedStringToIrValue(pd_value, ir_match_info.format()));
+            FormattedStringToIrValue(pd_value, ir_match_info->format()));
         break;
       }
       case MatchField::LPM: {
         auto *ir_lpm = ir_match->mutable_lpm();
-        ASSIGN_OR_RETURN(const auto *pd_lpm,
-                         GetMessageField(pd_match, pd_match_name));
+        ASSIGN_OR_RETURN(const auto *pd_lpm, GetMessageField(pd_match, field));
 
         ASSIGN_OR_RETURN(const auto &pd_value,
-                         GetStringField(*pd_lpm, "value"));
+                         GetStringField(*field.message, *pd_lpm, "value"));
         ASSIGN_OR_RETURN(
             *ir_lpm->mutable_value(),
-            FormattedStringToIrValue(pd_value, ir_match_info.format()));
+            FormattedStringToIrValue(pd_value, ir_match_info->format()));
 
-        ASSIGN_OR_RETURN(const auto &pd_prefix_len,
-                         GetInt32Field(*pd_lpm, "prefix_length"));
+        ASSIGN_OR_RETURN(
+            const auto &pd_prefix_len,
+            GetInt32Field(*field.message, *pd_lpm, "prefix_length"));
         if (pd_prefix_len < 0 ||
-            pd_prefix_len > ir_match_info.match_field().bitwidth()) {
+            pd_prefix_len > ir_match_info->match_field().bitwidth()) {
           return InvalidArgumentErrorBuilder()
                  << "Prefix length (" << pd_prefix_len << ") for match field \""
                  << ir_match->name() << "\" is out of bounds";
@@ -601,38 +883,38 @@ static absl::Status PdMatchEntryToIr(const IrTableDefinition &ir_table_info,
       case MatchField::TERNARY: {
         auto *ir_ternary = ir_match->mutable_ternary();
         ASSIGN_OR_RETURN(const auto *pd_ternary,
-                         GetMessageField(pd_match, pd_match_name));
+                         GetMessageField(pd_match, field));
 
         ASSIGN_OR_RETURN(const auto &pd_value,
-                         GetStringField(*pd_ternary, "value"));
+                         GetStringField(*field.message, *pd_ternary, "value"));
         ASSIGN_OR_RETURN(
             *ir_ternary->mutable_value(),
-            FormattedStringToIrValue(pd_value, ir_match_info.format()));
+            FormattedStringToIrValue(pd_value, ir_match_info->format()));
 
         ASSIGN_OR_RETURN(const auto &pd_mask,
-                         GetStringField(*pd_ternary, "mask"));
+                         GetStringField(*field.message, *pd_ternary, "mask"));
         ASSIGN_OR_RETURN(
             *ir_ternary->mutable_mask(),
-            FormattedStringToIrValue(pd_mask, ir_match_info.format()));
+            FormattedStringToIrValue(pd_mask, ir_match_info->format()));
         break;
       }
       case MatchField::OPTIONAL: {
         auto *ir_optional = ir_match->mutable_optional();
         ASSIGN_OR_RETURN(const auto *pd_optional,
-                         GetMessageField(pd_match, pd_match_name));
+                         GetMessageField(pd_match, field));
 
         ASSIGN_OR_RETURN(const auto &pd_value,
-                         GetStringField(*pd_optional, "value"));
+                         GetStringField(*field.message, *pd_optional, "value"));
         ASSIGN_OR_RETURN(
             *ir_optional->mutable_value(),
-            FormattedStringToIrValue(pd_value, ir_match_info.format()));
+            FormattedStringToIrValue(pd_value, ir_match_info->format()));
         break;
       }
       default:
         return gutil::InvalidArgumentErrorBuilder()
                << "Unsupported match type \""
                << MatchField_MatchType_Name(
-                      ir_match_info.match_field().match_type())
+                      ir_match_info->match_field().match_type())
                << "\" in \"" << pd_match_name << "\"";
     }
   }
@@ -643,120 +925,151 @@ static absl::Status PdMatchEntryToIr(const IrTableDefinition &ir_table_info,
 // message.
 static absl::Status IrActionInvocationToPd(
     const IrP4Info &ir_p4info, const IrActionInvocation &ir_action,
+    const PdMessageFields &parent_fields,
     google::protobuf::Message *parent_message) {
   ASSIGN_OR_RETURN(
-      const auto &ir_action_info,
-      gutil::FindOrStatus(ir_p4info.actions_by_name(), ir_action.name()),
+      const auto *ir_action_info,
+      gutil::FindPtrOrStatus(ir_p4info.actions_by_name(), ir_action.name()),
       _ << "P4Info does not contain action with name \"" << ir_action.name()
         << "\"");
-  ASSIGN_OR_RETURN(const auto &pd_action_name,
-                   P4NameToProtobufFieldName(ir_action.name(), kP4Action));
+  ASSIGN_OR_RETURN(const auto *pd_action_field,
+                   GetActionField(parent_fields, ir_action.name()));
   ASSIGN_OR_RETURN(auto *pd_action,
-                   GetMutableMessage(parent_message, pd_action_name));
+                   GetMutableMessage(parent_message, *pd_action_field));
   for (const auto &ir_param : ir_action.params()) {
     ASSIGN_OR_RETURN(
-        const auto &param_info,
-        gutil::FindOrStatus(ir_action_info.params_by_name(), ir_param.name()));
+        const auto *param_info,
+        gutil::FindPtrOrStatus(ir_action_info->params_by_name(),
+                               ir_param.name()),
+        _ << "P4Info for action \"" << ir_action.name()
+          << "\" does not contain parameter with name \"" << ir_param.name()
+          << "\"");
     ASSIGN_OR_RETURN(
-        const auto &pd_value,
-        IrValueToFormattedString(ir_param.value(), param_info.format()));
-    RETURN_IF_ERROR(SetStringField(pd_action, ir_param.name(), pd_value));
+        auto pd_value,
+        IrValueToFormattedString(ir_param.value(), param_info->format()));
+    RETURN_IF_ERROR(SetStringField(*pd_action_field->message, pd_action,
+                                   ir_param.name(), std::move(pd_value)));
   }
   return absl::OkStatus();
 }
 
-// Converts a PD action invocation to its IR form and returns it.
-static absl::StatusOr<IrActionInvocation> PdActionInvocationToIr(
+// Converts a PD action invocation to its IR form and stores it in `ir_action`.
+static absl::Status PdActionInvocationToIr(
     const IrP4Info &ir_p4info, const std::string &action_name,
-    const google::protobuf::Message &pd_action) {
+    const google::protobuf::Message &pd_action,
+    const PdMessageFields &action_fields, IrActionInvocation *ir_action) {
   ASSIGN_OR_RETURN(
-      const auto &ir_action_info,
-      gutil::FindOrStatus(ir_p4info.actions_by_name(), action_name),
+      const auto *ir_action_info,
+      gutil::FindPtrOrStatus(ir_p4info.actions_by_name(), action_name),
       _ << "P4Info does not contain action with name \"" << action_name
         << "\"");
-  IrActionInvocation ir_action;
-  ir_action.set_name(action_name);
-  for (const auto &pd_arg_name : GetAllFieldNames(pd_action)) {
+  ir_action->set_name(action_name);
+  for (const auto *pd_arg_field : GetAllFields(pd_action)) {
+    const std::string &pd_arg_name = pd_arg_field->name();
     ASSIGN_OR_RETURN(
-        const auto &param_info,
-        gutil::FindOrStatus(ir_action_info.params_by_name(), pd_arg_name));
-    ASSIGN_OR_RETURN(const auto &pd_arg,
-                     GetStringField(pd_action, pd_arg_name));
-    auto *ir_param = ir_action.add_params();
+        const auto *param_info,
+        gutil::FindPtrOrStatus(ir_action_info->params_by_name(), pd_arg_name));
+    ASSIGN_OR_RETURN(
+        const auto &pd_arg,
+        GetStringField(pd_action, action_fields.field(pd_arg_field)));
+    auto *ir_param = ir_action->add_params();
     ir_param->set_name(pd_arg_name);
     ASSIGN_OR_RETURN(*ir_param->mutable_value(),
-                     FormattedStringToIrValue(pd_arg, param_info.format()));
+                     FormattedStringToIrValue(pd_arg, param_info->format()));
   }
-  return ir_action;
+  return absl::OkStatus();
 }
 
 // Converts an IR action set to its PD form and stores it in the
 // PD table entry.
 static absl::Status IrActionSetToPd(const IrP4Info &ir_p4info,
                                     const IrTableEntry &ir_table_entry,
+                                    const PdMessageFields &table_fields,
                                     google::protobuf::Message *pd_table) {
-  ASSIGN_OR_RETURN(const auto *pd_action_set_descriptor,
-                   GetFieldDescriptor(*pd_table, "actions"));
+  ASSIGN_OR_RETURN(const auto *pd_action_set_field,
+                   GetField(table_fields, "actions"));
+  const PdMessageFields *action_set_fields = pd_action_set_field->message;
   for (const auto &ir_action_set_invocation :
        ir_table_entry.action_set().actions()) {
-    auto *pd_action_set = pd_table->GetReflection()->AddMessage(
-        pd_table, pd_action_set_descriptor);
-    RETURN_IF_ERROR(IrActionInvocationToPd(
-        ir_p4info, ir_action_set_invocation.action(), pd_action_set));
-    RETURN_IF_ERROR(SetInt32Field(pd_action_set, "weight",
+    ASSIGN_OR_RETURN(
+        auto *pd_action_set,
+        AddRepeatedMutableMessage(pd_table, *pd_action_set_field));
+    RETURN_IF_ERROR(IrActionInvocationToPd(ir_p4info,
+                                           ir_action_set_invocation.action(),
+                                           *action_set_fields, pd_action_set));
+    RETURN_IF_ERROR(SetInt32Field(*action_set_fields, pd_action_set, "weight",
                                   ir_action_set_invocation.weight()));
   }
   return absl::OkStatus();
 }
 
-// Converts a PD action set to its IR form and stores it in the
-// ir_table_entry.
-static absl::StatusOr<IrActionSetInvocation> PdActionSetToIr(
-    const IrP4Info &ir_p4info, const google::protobuf::Message &pd_action_set) {
-  IrActionSetInvocation ir_action_set_invocation;
-  for (const auto &pd_field_name : GetAllFieldNames(pd_action_set)) {
+// Converts a PD action set to its IR form and stores it in
+// `ir_action_set_invocation`.
+static absl::Status PdActionSetToIr(
+    const IrP4Info &ir_p4info, const google::protobuf::Message &pd_action_set,
+    const PdMessageFields &action_set_fields,
+    IrActionSetInvocation *ir_action_set_invocation) {
+  for (const auto *pd_field : GetAllFields(pd_action_set)) {
+    const std::string &pd_field_name = pd_field->name();
     if (pd_field_name == "weight") {
-      ASSIGN_OR_RETURN(const auto &pd_weight,
-                       GetInt32Field(pd_action_set, "weight"));
-      ir_action_set_invocation.set_weight(pd_weight);
+      ASSIGN_OR_RETURN(
+          const auto &pd_weight,
+          GetInt32Field(action_set_fields, pd_action_set, "weight"));
+      ir_action_set_invocation->set_weight(pd_weight);
     } else {
+      const PdMessageFields::Field &field = action_set_fields.field(pd_field);
       ASSIGN_OR_RETURN(const auto *pd_action,
-                       GetMessageField(pd_action_set, pd_field_name));
-      ASSIGN_OR_RETURN(
-          *ir_action_set_invocation.mutable_action(),
-          PdActionInvocationToIr(ir_p4info, pd_field_name, *pd_action));
+                       GetMessageField(pd_action_set, field));
+      RETURN_IF_ERROR(PdActionInvocationToIr(
+          ir_p4info, pd_field_name, *pd_action, *field.message,
+          ir_action_set_invocation->mutable_action()));
     }
   }
-  return ir_action_set_invocation;
+  return absl::OkStatus();
 }
 
-absl::Status IrTableEntryToPd(const IrP4Info &ir_p4info, const IrTableEntry &ir,
-                              google::protobuf::Message *pd) {
+static absl::Status IrTableEntryToPd(const IrP4Info &ir_p4info,
+                                     const IrTableEntry &ir,
+                                     const PdMessageFields &pd_fields,
+                                     google::protobuf::Message *pd) {
   ASSIGN_OR_RETURN(
-      const auto &ir_table_info,
-      gutil::FindOrStatus(ir_p4info.tables_by_name(), ir.table_name()),
-      _ << "Table \"" << ir.table_name() << "\" does not exist in P4Info."
+      const auto *ir_table_info,
+      gutil::FindPtrOrStatus(ir_p4info.tables_by_name(), ir.table_name()),
+      _ << "Table \"" << ir.table_name() << "\" does not exist in P4Info. "
         << kPdProtoAndP4InfoOutOfSync);
-  ASSIGN_OR_RETURN(const auto pd_table_name,
-                   P4NameToProtobufFieldName(ir.table_name(), kP4Table));
-  ASSIGN_OR_RETURN(auto *pd_table, GetMutableMessage(pd, pd_table_name));
+  ASSIGN_OR_RETURN(const auto *pd_table_field,
+                   GetTableField(pd_fields, ir.table_name()));
+  ASSIGN_OR_RETURN(auto *pd_table, GetMutableMessage(pd, *pd_table_field));
+  const PdMessageFields &table_fields = *pd_table_field->message;
 
-  ASSIGN_OR_RETURN(auto *pd_match, GetMutableMessage(pd_table, "match"));
-  RETURN_IF_ERROR(IrMatchEntryToPd(ir_table_info, ir, pd_match));
+  const PdMessageFields *match_fields;
+  ASSIGN_OR_RETURN(
+      auto *pd_match,
+      GetMutableMessage(table_fields, pd_table, "match", &match_fields));
+  RETURN_IF_ERROR(
+      IrMatchEntryToPd(*ir_table_info, ir, *match_fields, pd_match));
 
   if (ir.priority() != 0) {
-    RETURN_IF_ERROR(SetInt32Field(pd_table, "priority", ir.priority()));
+    RETURN_IF_ERROR(
+        SetInt32Field(table_fields, pd_table, "priority", ir.priority()));
   }
 
-  if (ir_table_info.uses_oneshot()) {
-    RETURN_IF_ERROR(IrActionSetToPd(ir_p4info, ir, pd_table));
+  if (ir_table_info->uses_oneshot()) {
+    RETURN_IF_ERROR(IrActionSetToPd(ir_p4info, ir, table_fields, pd_table));
   } else {
-    ASSIGN_OR_RETURN(auto *pd_action, GetMutableMessage(pd_table, "action"));
-    RETURN_IF_ERROR(IrActionInvocationToPd(ir_p4info, ir.action(), pd_action));
+    const PdMessageFields *action_fields;
+    ASSIGN_OR_RETURN(
+        auto *pd_action,
+        GetMutableMessage(table_fields, pd_table, "action", &action_fields));
+    RETURN_IF_ERROR(IrActionInvocationToPd(ir_p4info, ir.action(),
+                                           *action_fields, pd_action));
   }
 
-  if (ir_table_info.has_meter()) {
-    ASSIGN_OR_RETURN(auto *config, GetMutableMessage(pd_table, "meter_config"));
+  if (ir_table_info->has_meter()) {
+    const PdMessageFields *config_fields;
+    ASSIGN_OR_RETURN(auto *config,
+                     GetMutableMessage(table_fields, pd_table, "meter_config",
+                                       &config_fields));
     const auto &ir_meter_config = ir.meter_config();
     if (ir_meter_config.cir() != ir_meter_config.pir()) {
       return InvalidArgumentErrorBuilder()
@@ -769,160 +1082,212 @@ absl::Status IrTableEntryToPd(const IrP4Info &ir_p4info, const IrTableEntry &ir,
              << ir_meter_config.cburst() << ", PBurst as "
              << ir_meter_config.pburst();
     }
-    switch (ir_table_info.meter().unit()) {
+    switch (ir_table_info->meter().unit()) {
       case p4::config::v1::MeterSpec_Unit_BYTES: {
-        RETURN_IF_ERROR(
-            SetInt64Field(config, "bytes_per_second", ir_meter_config.cir()));
-        RETURN_IF_ERROR(
-            SetInt64Field(config, "burst_bytes", ir_meter_config.cburst()));
+        RETURN_IF_ERROR(SetInt64Field(*config_fields, config,
+                                      "bytes_per_second",
+                                      ir_meter_config.cir()));
+        RETURN_IF_ERROR(SetInt64Field(*config_fields, config, "burst_bytes",
+                                      ir_meter_config.cburst()));
         break;
       }
       case p4::config::v1::MeterSpec_Unit_PACKETS: {
-        RETURN_IF_ERROR(
-            SetInt64Field(config, "packets_per_second", ir_meter_config.cir()));
-        RETURN_IF_ERROR(
-            SetInt64Field(config, "burst_packets", ir_meter_config.cburst()));
+        RETURN_IF_ERROR(SetInt64Field(*config_fields, config,
+                                      "packets_per_second",
+                                      ir_meter_config.cir()));
+        RETURN_IF_ERROR(SetInt64Field(*config_fields, config, "burst_packets",
+                                      ir_meter_config.cburst()));
         break;
       }
       default:
         return InvalidArgumentErrorBuilder()
-               << "Invalid meter unit: " << ir_table_info.meter().unit();
+               << "Invalid meter unit: " << ir_table_info->meter().unit();
     }
   }
 
-  if (ir_table_info.has_counter()) {
-    switch (ir_table_info.counter().unit()) {
+  if (ir_table_info->has_counter()) {
+    switch (ir_table_info->counter().unit()) {
       case p4::config::v1::CounterSpec_Unit_BYTES: {
-        RETURN_IF_ERROR(SetInt64Field(pd_table, "byte_counter",
+        RETURN_IF_ERROR(SetInt64Field(table_fields, pd_table, "byte_counter",
                                       ir.counter_data().byte_count()));
         break;
       }
       case p4::config::v1::CounterSpec_Unit_PACKETS: {
-        RETURN_IF_ERROR(SetInt64Field(pd_table, "packet_counter",
+        RETURN_IF_ERROR(SetInt64Field(table_fields, pd_table, "packet_counter",
                                       ir.counter_data().packet_count()));
         break;
       }
       case p4::config::v1::CounterSpec_Unit_BOTH: {
-        RETURN_IF_ERROR(SetInt64Field(pd_table, "byte_counter",
+        RETURN_IF_ERROR(SetInt64Field(table_fields, pd_table, "byte_counter",
                                       ir.counter_data().byte_count()));
-        RETURN_IF_ERROR(SetInt64Field(pd_table, "packet_counter",
+        RETURN_IF_ERROR(SetInt64Field(table_fields, pd_table, "packet_counter",
                                       ir.counter_data().packet_count()));
         break;
       }
       default:
         return InvalidArgumentErrorBuilder()
-               << "Invalid counter unit: " << ir_table_info.meter().unit();
+               << "Invalid counter unit: " << ir_table_info->meter().unit();
     }
   }
 
   return absl::OkStatus();
 }
 
-absl::StatusOr<IrTableEntry> PdTableEntryToIr(
-    const IrP4Info &ir_p4info, const google::protobuf::Message &pd) {
-  IrTableEntry ir;
-  ASSIGN_OR_RETURN(const std::string &pd_table_field_name,
-                   gutil::GetOneOfFieldName(pd, "entry"));
-  ASSIGN_OR_RETURN(const std::string &p4_table_name,
-                   ProtobufFieldNameToP4Name(pd_table_field_name, kP4Table));
+absl::Status IrTableEntryToPd(const IrP4Info &ir_p4info, const IrTableEntry &ir,
+                              google::protobuf::Message *pd) {
+  return IrTableEntryToPd(ir_p4info, ir,
+                          GetPdMessageFields(pd->GetDescriptor()), pd);
+}
+
+static absl::Status PdTableEntryToIr(const IrP4Info &ir_p4info,
+                                     const google::protobuf::Message &pd,
+                                     const PdMessageFields &pd_fields,
+                                     IrTableEntry *ir) {
+  ir->Clear();
+  ASSIGN_OR_RETURN(const auto *pd_table_field,
+                   GetOneofField(pd_fields, pd, "entry"));
+  if (!pd_table_field->is_table) {
+    return ProtobufFieldNameToP4Name(pd_table_field->descriptor->name(),
+                                     kP4Table)
+        .status();
+  }
+  const std::string &p4_table_name = pd_table_field->p4_table_name;
   ASSIGN_OR_RETURN(
-      const auto &ir_table_info,
-      gutil::FindOrStatus(ir_p4info.tables_by_name(), p4_table_name),
-      _ << "Table \"" << p4_table_name << "\" does not exist in P4Info."
+      const auto *ir_table_info,
+      gutil::FindPtrOrStatus(ir_p4info.tables_by_name(), p4_table_name),
+      _ << "Table \"" << p4_table_name << "\" does not exist in P4Info. "
         << kPdProtoAndP4InfoOutOfSync);
-  ir.set_table_name(p4_table_name);
+  ir->set_table_name(p4_table_name);
 
-  ASSIGN_OR_RETURN(const auto *pd_table,
-                   GetMessageField(pd, pd_table_field_name));
+  ASSIGN_OR_RETURN(const auto *pd_table, GetMessageField(pd, *pd_table_field));
+  const PdMessageFields &table_fields = *pd_table_field->message;
 
-  ASSIGN_OR_RETURN(const auto *pd_match, GetMessageField(*pd_table, "match"));
-  RETURN_IF_ERROR(PdMatchEntryToIr(ir_table_info, *pd_match, &ir));
+  const PdMessageFields *match_fields;
+  ASSIGN_OR_RETURN(
+      const auto *pd_match,
+      GetMessageField(table_fields, *pd_table, "match", &match_fields));
+  RETURN_IF_ERROR(
+      PdMatchEntryToIr(*ir_table_info, *pd_match, *match_fields, ir));
 
-  const auto &status_or_priority = GetInt32Field(*pd_table, "priority");
+  const auto &status_or_priority =
+      GetInt32Field(table_fields, *pd_table, "priority");
   if (status_or_priority.ok()) {
-    ir.set_priority(status_or_priority.value());
+    ir->set_priority(status_or_priority.value());
   }
 
-  if (ir_table_info.uses_oneshot()) {
-    ASSIGN_OR_RETURN(const auto *pd_action_set,
-                     GetFieldDescriptor(*pd_table, "actions"));
-    auto *action_set = ir.mutable_action_set();
+  if (ir_table_info->uses_oneshot()) {
+    ASSIGN_OR_RETURN(const auto *pd_action_set_field,
+                     GetField(table_fields, "actions"));
+    RETURN_IF_ERROR(ValidateFieldDescriptorType(
+        pd_action_set_field->descriptor, FieldDescriptor::TYPE_MESSAGE));
+    const auto *pd_action_set = pd_action_set_field->descriptor;
+    auto *action_set = ir->mutable_action_set();
     for (auto i = 0;
          i < pd_table->GetReflection()->FieldSize(*pd_table, pd_action_set);
          ++i) {
-      ASSIGN_OR_RETURN(
-          *action_set->add_actions(),
+      RETURN_IF_ERROR(
           PdActionSetToIr(ir_p4info,
                           pd_table->GetReflection()->GetRepeatedMessage(
-                              *pd_table, pd_action_set, i)));
+                              *pd_table, pd_action_set, i),
+                          *pd_action_set_field->message,
+                          action_set->add_actions()));
     }
   } else {
-    ASSIGN_OR_RETURN(const auto *pd_action,
-                     GetMessageField(*pd_table, "action"));
-    for (const auto &action_name : GetAllFieldNames(*pd_action)) {
+    const PdMessageFields *action_fields;
+    ASSIGN_OR_RETURN(
+        const auto *pd_action,
+        GetMessageField(table_fields, *pd_table, "action", &action_fields));
+    for (const auto *pd_action_field : GetAllFields(*pd_action)) {
+      const PdMessageFields::Field &field =
+          action_fields->field(pd_action_field);
       ASSIGN_OR_RETURN(const auto *pd_action_invocation,
-                       GetMessageField(*pd_action, action_name));
-      ASSIGN_OR_RETURN(*ir.mutable_action(),
-                       PdActionInvocationToIr(ir_p4info, action_name,
-                                              *pd_action_invocation));
+                       GetMessageField(*pd_action, field));
+      RETURN_IF_ERROR(PdActionInvocationToIr(
+          ir_p4info, pd_action_field->name(), *pd_action_invocation,
+          *field.message, ir->mutable_action()));
     }
   }
 
-  if (ir_table_info.has_meter()) {
+  if (ir_table_info->has_meter()) {
+    const PdMessageFields *config_fields;
     ASSIGN_OR_RETURN(const auto *config,
-                     GetMessageField(*pd_table, "meter_config"));
+                     GetMessageField(table_fields, *pd_table, "meter_config",
+                                     &config_fields));
     int64_t value;
     int64_t burst_value;
-    switch (ir_table_info.meter().unit()) {
+    switch (ir_table_info->meter().unit()) {
       case p4::config::v1::MeterSpec_Unit_BYTES: {
-        ASSIGN_OR_RETURN(value, GetInt64Field(*config, "bytes_per_second"));
-        ASSIGN_OR_RETURN(burst_value, GetInt64Field(*config, "burst_bytes"));
+        ASSIGN_OR_RETURN(
+            value, GetInt64Field(*config_fields, *config, "bytes_per_second"));
+        ASSIGN_OR_RETURN(burst_value,
+                         GetInt64Field(*config_fields, *config, "burst_bytes"));
         break;
       }
       case p4::config::v1::MeterSpec_Unit_PACKETS: {
-        ASSIGN_OR_RETURN(value, GetInt64Field(*config, "packets_per_second"));
-        ASSIGN_OR_RETURN(burst_value, GetInt64Field(*config, "burst_packets"));
+        ASSIGN_OR_RETURN(value, GetInt64Field(*config_fields, *config,
+                                              "packets_per_second"));
+        ASSIGN_OR_RETURN(
+            burst_value,
+            GetInt64Field(*config_fields, *config, "burst_packets"));
         break;
       }
       default:
         return InvalidArgumentErrorBuilder()
-               << "Invalid meter unit: " << ir_table_info.meter().unit();
+               << "Invalid meter unit: " << ir_table_info->meter().unit();
     }
-    auto ir_meter_config = ir.mutable_meter_config();
+    auto ir_meter_config = ir->mutable_meter_config();
     ir_meter_config->set_cir(value);
     ir_meter_config->set_pir(value);
     ir_meter_config->set_cburst(burst_value);
     ir_meter_config->set_pburst(burst_value);
   }
 
-  if (ir_table_info.has_counter()) {
-    switch (ir_table_info.counter().unit()) {
+  if (ir_table_info->has_counter()) {
+    switch (ir_table_info->counter().unit()) {
       case p4::config::v1::CounterSpec_Unit_BYTES: {
-        ASSIGN_OR_RETURN(const auto &pd_byte_counter,
-                         GetInt64Field(*pd_table, "byte_counter"));
-        ir.mutable_counter_data()->set_byte_count(pd_byte_counter);
+        ASSIGN_OR_RETURN(
+            const auto &pd_byte_counter,
+            GetInt64Field(table_fields, *pd_table, "byte_counter"));
+        ir->mutable_counter_data()->set_byte_count(pd_byte_counter);
         break;
       }
       case p4::config::v1::CounterSpec_Unit_PACKETS: {
-        ASSIGN_OR_RETURN(const auto &pd_packet_counter,
-                         GetInt64Field(*pd_table, "packet_counter"));
-        ir.mutable_counter_data()->set_packet_count(pd_packet_counter);
+        ASSIGN_OR_RETURN(
+            const auto &pd_packet_counter,
+            GetInt64Field(table_fields, *pd_table, "packet_counter"));
+        ir->mutable_counter_data()->set_packet_count(pd_packet_counter);
         break;
       }
       case p4::config::v1::CounterSpec_Unit_BOTH: {
-        ASSIGN_OR_RETURN(const auto &pd_byte_counter,
-                         GetInt64Field(*pd_table, "byte_counter"));
-        ir.mutable_counter_data()->set_byte_count(pd_byte_counter);
-        ASSIGN_OR_RETURN(const auto &pd_packet_counter,
-                         GetInt64Field(*pd_table, "packet_counter"));
-        ir.mutable_counter_data()->set_packet_count(pd_packet_counter);
+        ASSIGN_OR_RETURN(
+            const auto &pd_byte_counter,
+            GetInt64Field(table_fields, *pd_table, "byte_counter"));
+        ir->mutable_counter_data()->set_byte_count(pd_byte_counter);
+        ASSIGN_OR_RETURN(
+            const auto &pd_packet_counter,
+            GetInt64Field(table_fields, *pd_table, "packet_counter"));
+        ir->mutable_counter_data()->set_packet_count(pd_packet_counter);
         break;
       }
       default:
         return InvalidArgumentErrorBuilder()
-               << "Invalid counter unit: " << ir_table_info.meter().unit();
+               << "Invalid counter unit: " << ir_table_info->meter().unit();
     }
   }
+  return absl::OkStatus();
+}
+
+absl::Status PdTableEntryToIr(const IrP4Info &ir_p4info,
+                              const google::protobuf::Message &pd,
+                              IrTableEntry *ir) {
+  return PdTableEntryToIr(ir_p4info, pd, GetPdMessageFields(pd.GetDescriptor()),
+                          ir);
+}
+
+absl::StatusOr<IrTableEntry> PdTableEntryToIr(
+    const IrP4Info &ir_p4info, const google::protobuf::Message &pd) {
+  IrTableEntry ir;
+  RETURN_IF_ERROR(PdTableEntryToIr(ir_p4info, pd, &ir));
   return ir;
 }
 
@@ -932,29 +1297,32 @@ template <typename T>
 absl::StatusOr<T> PdPacketIoToIr(const IrP4Info &info, const std::string &kind,
                                  const google::protobuf::Message &packet) {
   T result;
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(packet, "payload"));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+  const PdMessageFieldsRef fields = GetPdMessageFields(packet.GetDescriptor());
+  ASSIGN_OR_RETURN(const auto *payload_field, GetField(fields, "payload"));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(payload_field->descriptor,
                                               FieldDescriptor::TYPE_BYTES));
   const auto &pd_payload =
-      packet.GetReflection()->GetString(packet, field_descriptor);
+      packet.GetReflection()->GetString(packet, payload_field->descriptor);
   result.set_payload(pd_payload);
 
-  google::protobuf::Map<std::string, IrPacketIoMetadataDefinition>
-      metadata_by_name;
+  const google::protobuf::Map<std::string, IrPacketIoMetadataDefinition>
+      *metadata_by_name;
   if (kind == "packet-in") {
-    metadata_by_name = info.packet_in_metadata_by_name();
+    metadata_by_name = &info.packet_in_metadata_by_name();
   } else if (kind == "packet-out") {
-    metadata_by_name = info.packet_out_metadata_by_name();
+    metadata_by_name = &info.packet_out_metadata_by_name();
   } else {
     return InvalidArgumentErrorBuilder() << "Invalid PacketIo type " << kind;
   }
 
-  ASSIGN_OR_RETURN(const auto &pd_metadata,
-                   GetMessageField(packet, "metadata"));
-  for (const auto &entry : Ordered(metadata_by_name)) {
-    ASSIGN_OR_RETURN(const auto &pd_entry,
-                     GetStringField(*pd_metadata, entry.first));
+  const PdMessageFields *metadata_fields;
+  ASSIGN_OR_RETURN(
+      const auto &pd_metadata,
+      GetMessageField(fields, packet, "metadata", &metadata_fields));
+  for (const auto &entry : Ordered(*metadata_by_name)) {
+    ASSIGN_OR_RETURN(
+        const auto &pd_entry,
+        GetStringField(*metadata_fields, *pd_metadata, entry.first));
     auto *ir_metadata = result.add_metadata();
     ir_metadata->set_name(entry.first);
     ASSIGN_OR_RETURN(*ir_metadata->mutable_value(),
@@ -968,19 +1336,20 @@ template <typename T>
 absl::Status IrPacketIoToPd(const IrP4Info &info, const std::string &kind,
                             const T &packet,
                             google::protobuf::Message *pd_packet) {
-  ASSIGN_OR_RETURN(auto *field_descriptor,
-                   GetFieldDescriptor(*pd_packet, "payload"));
-  RETURN_IF_ERROR(ValidateFieldDescriptorType(field_descriptor,
+  const PdMessageFieldsRef fields =
+      GetPdMessageFields(pd_packet->GetDescriptor());
+  ASSIGN_OR_RETURN(const auto *payload_field, GetField(fields, "payload"));
+  RETURN_IF_ERROR(ValidateFieldDescriptorType(payload_field->descriptor,
                                               FieldDescriptor::TYPE_BYTES));
-  pd_packet->GetReflection()->SetString(pd_packet, field_descriptor,
+  pd_packet->GetReflection()->SetString(pd_packet, payload_field->descriptor,
                                         packet.payload());
 
-  google::protobuf::Map<std::string, IrPacketIoMetadataDefinition>
-      metadata_by_name;
+  const google::protobuf::Map<std::string, IrPacketIoMetadataDefinition>
+      *metadata_by_name;
   if (kind == "packet-in") {
-    metadata_by_name = info.packet_in_metadata_by_name();
+    metadata_by_name = &info.packet_in_metadata_by_name();
   } else if (kind == "packet-out") {
-    metadata_by_name = info.packet_out_metadata_by_name();
+    metadata_by_name = &info.packet_out_metadata_by_name();
   } else {
     return InvalidArgumentErrorBuilder() << "Invalid PacketIo type " << kind;
   }
@@ -988,16 +1357,19 @@ absl::Status IrPacketIoToPd(const IrP4Info &info, const std::string &kind,
   for (const auto &metadata : packet.metadata()) {
     const std::string &name = metadata.name();
 
-    ASSIGN_OR_RETURN(const auto &metadata_definition,
-                     gutil::FindOrStatus(metadata_by_name, name),
+    ASSIGN_OR_RETURN(const auto *metadata_definition,
+                     gutil::FindPtrOrStatus(*metadata_by_name, name),
                      _ << "\"" << kind << "\" metadata with name \"" << name
                        << "\" not defined");
-    ASSIGN_OR_RETURN(const auto &raw_value,
+    ASSIGN_OR_RETURN(auto raw_value,
                      IrValueToFormattedString(metadata.value(),
-                                              metadata_definition.format()));
-    ASSIGN_OR_RETURN(auto *pd_metadata,
-                     GetMutableMessage(pd_packet, "metadata"));
-    RETURN_IF_ERROR(SetStringField(pd_metadata, name, raw_value));
+                                              metadata_definition->format()));
+    const PdMessageFields *metadata_fields;
+    ASSIGN_OR_RETURN(
+        auto *pd_metadata,
+        GetMutableMessage(fields, pd_packet, "metadata", &metadata_fields));
+    RETURN_IF_ERROR(SetStringField(*metadata_fields, pd_metadata, name,
+                                   std::move(raw_value)));
   }
   return absl::OkStatus();
 }
@@ -1021,44 +1393,53 @@ absl::Status IrPacketOutToPd(const IrP4Info &info, const IrPacketOut &packet,
 }
 
 static absl::Status IrUpdateStatusToPd(
-    const IrUpdateStatus &ir_update_status,
+    const IrUpdateStatus &ir_update_status, const PdMessageFields &fields,
     google::protobuf::Message *pd_update_status) {
   RETURN_IF_ERROR(
-      SetEnumField(pd_update_status, "code", ir_update_status.code()));
-  RETURN_IF_ERROR(
-      SetStringField(pd_update_status, "message", ir_update_status.message()));
+      SetEnumField(fields, pd_update_status, "code", ir_update_status.code()));
+  RETURN_IF_ERROR(SetStringField(fields, pd_update_status, "message",
+                                 ir_update_status.message()));
   return absl::OkStatus();
 }
 
 static absl::Status IrWriteResponseToPd(
-    const IrWriteResponse &ir_write_response,
+    const IrWriteResponse &ir_write_response, const PdMessageFields &fields,
     google::protobuf::Message *pd_rpc_response) {
   // Iterates through each ir update status and add message to pd via
   // AddRepeatedMutableMessage
   for (const IrUpdateStatus &ir_update_status : ir_write_response.statuses()) {
-    ASSIGN_OR_RETURN(auto *pd_update_status,
-                     AddRepeatedMutableMessage(pd_rpc_response, "statuses"));
-    RETURN_IF_ERROR(IrUpdateStatusToPd(ir_update_status, pd_update_status));
+    ASSIGN_OR_RETURN(const auto *statuses_field, GetField(fields, "statuses"));
+    ASSIGN_OR_RETURN(
+        auto *pd_update_status,
+        AddRepeatedMutableMessage(pd_rpc_response, *statuses_field));
+    RETURN_IF_ERROR(IrUpdateStatusToPd(
+        ir_update_status, *statuses_field->message, pd_update_status));
   }
   return absl::OkStatus();
 }
 
 absl::Status IrWriteRpcStatusToPd(const IrWriteRpcStatus &ir_write_status,
                                   google::protobuf::Message *pd) {
+  const PdMessageFieldsRef fields = GetPdMessageFields(pd->GetDescriptor());
   switch (ir_write_status.status_case()) {
     case IrWriteRpcStatus::kRpcResponse: {
+      const PdMessageFields *rpc_response_fields;
       ASSIGN_OR_RETURN(auto *pd_rpc_response,
-                       GetMutableMessage(pd, "rpc_response"));
+                       GetMutableMessage(fields, pd, "rpc_response",
+                                         &rpc_response_fields));
       return IrWriteResponseToPd(ir_write_status.rpc_response(),
-                                 pd_rpc_response);
+                                 *rpc_response_fields, pd_rpc_response);
     }
     case IrWriteRpcStatus::kRpcWideError: {
+      const PdMessageFields *rpc_wide_error_fields;
       ASSIGN_OR_RETURN(auto *pd_rpc_wide_error,
-                       GetMutableMessage(pd, "rpc_wide_error"));
-      RETURN_IF_ERROR(SetInt32Field(pd_rpc_wide_error, "code",
+                       GetMutableMessage(fields, pd, "rpc_wide_error",
+                                         &rpc_wide_error_fields));
+      RETURN_IF_ERROR(SetInt32Field(*rpc_wide_error_fields, pd_rpc_wide_error,
+                                    "code",
                                     ir_write_status.rpc_wide_error().code()));
       RETURN_IF_ERROR(
-          SetStringField(pd_rpc_wide_error, "message",
+          SetStringField(*rpc_wide_error_fields, pd_rpc_wide_error, "message",
                          ir_write_status.rpc_wide_error().message()));
       break;
     }
@@ -1069,32 +1450,37 @@ absl::Status IrWriteRpcStatusToPd(const IrWriteRpcStatus &ir_write_status,
 }
 
 static absl::StatusOr<IrUpdateStatus> PdUpdateStatusToIr(
-    const google::protobuf::Message &pd) {
+    const google::protobuf::Message &pd, const PdMessageFields &fields) {
   IrUpdateStatus ir_update_status;
-  ASSIGN_OR_RETURN(int google_rpc_code, GetEnumField(pd, "code"));
+  ASSIGN_OR_RETURN(int google_rpc_code, GetEnumField(fields, pd, "code"));
   ASSIGN_OR_RETURN(std::string update_status_message,
-                   GetStringField(pd, "message"));
+                   GetStringField(fields, pd, "message"));
   ir_update_status.set_code(static_cast<google::rpc::Code>(google_rpc_code));
   ir_update_status.set_message(update_status_message);
   return ir_update_status;
 }
 
 static absl::StatusOr<IrWriteResponse> PdWriteResponseToIr(
-    const google::protobuf::Message &pd) {
+    const google::protobuf::Message &pd, const PdMessageFields &fields) {
   IrWriteResponse ir_write_response;
-  ASSIGN_OR_RETURN(const auto *status_message,
-                   GetMessageField(pd, "rpc_response"));
-  ASSIGN_OR_RETURN(const auto *repeated_update_status_field_descriptor,
-                   GetFieldDescriptor(*status_message, "statuses"));
-  for (int i = 0;
-       i < status_message->GetReflection()->FieldSize(
-               *status_message, repeated_update_status_field_descriptor);
+  const PdMessageFields *status_message_fields;
+  ASSIGN_OR_RETURN(
+      const auto *status_message,
+      GetMessageField(fields, pd, "rpc_response", &status_message_fields));
+  ASSIGN_OR_RETURN(const auto *repeated_update_status_field,
+                   GetField(*status_message_fields, "statuses"));
+  for (int i = 0; i < status_message->GetReflection()->FieldSize(
+                          *status_message,
+                          repeated_update_status_field->descriptor);
        i++) {
     // Extract out the Pd::UpdateStatus and pass to PdUpdateStatusToIr
     ASSIGN_OR_RETURN(const auto *pd_update_status,
-                     GetRepeatedMessage(*status_message, "statuses", i));
-    ASSIGN_OR_RETURN(const auto ir_update_status,
-                     PdUpdateStatusToIr(*pd_update_status));
+                     GetRepeatedMessage(*status_message_fields,
+                                        *status_message, "statuses", i));
+    ASSIGN_OR_RETURN(
+        const auto ir_update_status,
+        PdUpdateStatusToIr(*pd_update_status,
+                           *repeated_update_status_field->message));
     *ir_write_response.add_statuses() = ir_update_status;
   }
   return ir_write_response;
@@ -1103,19 +1489,25 @@ static absl::StatusOr<IrWriteResponse> PdWriteResponseToIr(
 absl::StatusOr<IrWriteRpcStatus> PdWriteRpcStatusToIr(
     const google::protobuf::Message &pd) {
   IrWriteRpcStatus ir_write_rpc_status;
-  ASSIGN_OR_RETURN(std::string status_oneof_name,
-                   gutil::GetOneOfFieldName(pd, "status"));
+  const PdMessageFieldsRef fields = GetPdMessageFields(pd.GetDescriptor());
+  ASSIGN_OR_RETURN(const auto *status_oneof_field,
+                   GetOneofField(fields, pd, "status"));
+  const std::string &status_oneof_name = status_oneof_field->descriptor->name();
   // status_message is of type WriteResponse with field name rpc_response
   if (status_oneof_name == "rpc_response") {
     ASSIGN_OR_RETURN(*ir_write_rpc_status.mutable_rpc_response(),
-                     PdWriteResponseToIr(pd));
+                     PdWriteResponseToIr(pd, fields));
   } else if (status_oneof_name == "rpc_wide_error") {
+    const PdMessageFields *rpc_wide_error_fields;
     ASSIGN_OR_RETURN(const auto *rpc_wide_error_message,
-                     GetMessageField(pd, "rpc_wide_error"));
+                     GetMessageField(fields, pd, "rpc_wide_error",
+                                     &rpc_wide_error_fields));
     ASSIGN_OR_RETURN(int32_t status_code,
-                     GetInt32Field(*rpc_wide_error_message, "code"));
+                     GetInt32Field(*rpc_wide_error_fields,
+                                   *rpc_wide_error_message, "code"));
     ASSIGN_OR_RETURN(std::string status_message,
-                     GetStringField(*rpc_wide_error_message, "message"));
+                     GetStringField(*rpc_wide_error_fields,
+                                    *rpc_wide_error_message, "message"));
     auto *rpc_wide_error = ir_write_rpc_status.mutable_rpc_wide_error();
     rpc_wide_error->set_code(status_code);
     rpc_wide_error->set_message(status_message);
@@ -31,10 +31,22 @@ namespace pdpi {
 // This file contains functions that translate from and to PD.
 // Since the exact form of PD is not known until run time, we need to pass in
 // a generic google::protobuf::Message and use GetReflection() to access the PD
-// proto.
+// proto. For table entries and packets, p4_pd_proto can additionally generate
+// equivalent conversions that are specialized for the PD proto of a program
+// and do not use reflection (see `cc_conversions` in pdgen.bzl).
 
 // -- Conversions to and from PI -----------------------------------------------
 
+absl::Status PiTableEntryToPd(const IrP4Info &info,
+                              const p4::v1::TableEntry &pi,
+                              google::protobuf::Message *pd);
+
+absl::StatusOr<p4::v1::TableEntry> PdTableEntryToPi(
+    const IrP4Info &info, const google::protobuf::Message &pd);
+
+// Same as above, using the IrP4Info of `p4_info`, which is only created on the
+// first call with a given P4Info (see GetCachedIrP4Info). When converting many
+// entries, prefer the overloads above.
 absl::Status PiTableEntryToPd(const p4::config::v1::P4Info &p4_info,
                               const p4::v1::TableEntry &pi,
                               google::protobuf::Message *pd);
@@ -76,20 +88,34 @@ absl::Status IrReadResponseToPd(const IrP4Info &info, const IrReadResponse &ir,
                                 google::protobuf::Message *read_response);
 absl::StatusOr<IrReadResponse> PdReadResponseToIr(
     const IrP4Info &info, const google::protobuf::Message &read_response);
+absl::Status PdReadResponseToIr(const IrP4Info &info,
+                                const google::protobuf::Message &read_response,
+                                IrReadResponse *ir);
 
 absl::Status IrUpdateToPd(const IrP4Info &info, const IrUpdate &ir,
                           google::protobuf::Message *update);
 absl::StatusOr<IrUpdate> PdUpdateToIr(const IrP4Info &info,
                                       const google::protobuf::Message &update);
+absl::Status PdUpdateToIr(const IrP4Info &info,
+                          const google::protobuf::Message &update,
+                          IrUpdate *ir);
 
 absl::Status IrWriteRequestToPd(const IrP4Info &info, const IrWriteRequest &ir,
                                 google::protobuf::Message *write_request);
 absl::StatusOr<IrWriteRequest> PdWriteRequestToIr(
     const IrP4Info &info, const google::protobuf::Message &write_request);
+absl::Status PdWriteRequestToIr(const IrP4Info &info,
+                                const google::protobuf::Message &write_request,
+                                IrWriteRequest *ir);
 
 // Converts a PD table entry to the IR table entry.
 absl::StatusOr<IrTableEntry> PdTableEntryToIr(
     const IrP4Info &ir_p4info, const google::protobuf::Message &pd);
+// Same as above, but overwrites `ir`, which may be allocated on an arena. The
+// contents of `ir` are unspecified if an error is returned.
+absl::Status PdTableEntryToIr(const IrP4Info &ir_p4info,
+                              const google::protobuf::Message &pd,
+                              IrTableEntry *ir);
 
 // Converts an IR table entry to the PD table entry.
 absl::Status IrTableEntryToPd(const IrP4Info &ir_p4info, const IrTableEntry &ir,
@@ -13,8 +13,22 @@
 # limitations under the License.
 """Rule for invoking the PD generator."""
 
-def p4_pd_proto(name, src, out, package, format = True, visibility = None):
-    """Generates PD proto from p4info file."""
+def p4_pd_proto(
+        name,
+        src,
+        out,
+        package,
+        format = True,
+        cc_conversions = None,
+        cc_proto = None,
+        visibility = None):
+    """Generates PD proto from p4info file.
+
+    If `cc_conversions` is given, also generates a cc_library of that name with
+    conversions between the PD proto and IR that do not use reflection (see
+    IrP4InfoToPdConversionsHeader in pdgenlib.h). It is built on `cc_proto`,
+    the cc_proto_library of the PD proto.
+    """
     pdgen = "//p4_pdpi:pdgen"
     p4info = ":" + src
     tools = [pdgen]
@@ -37,3 +51,53 @@ def p4_pd_proto(name, src, out, package, format = True, visibility = None):
         tools = tools,
         visibility = visibility,
     )
+
+    if cc_conversions == None:
+        return
+    if cc_proto == None:
+        fail("cc_proto is required for cc_conversions")
+
+    package_path = native.package_name()
+    if package_path:
+        package_path += "/"
+    pd_proto_header = package_path + out[:-len(".proto")] + ".pb.h"
+    cc_header = package_path + cc_conversions + ".h"
+    for output, extension in [("cc_header", ".h"), ("cc_source", ".cc")]:
+        native.genrule(
+            name = cc_conversions + "_" + output,
+            outs = [cc_conversions + extension],
+            cmd = """
+                $(location {pdgen})\\
+                    --p4info $(location {p4info})\\
+                    --package "{package}"\\
+                    --output {output}\\
+                    --pd_proto_header "{pd_proto_header}"\\
+                    --cc_header "{cc_header}"\\
+                    > $(OUTS)
+            """.format(
+                p4info = p4info,
+                package = package,
+                pdgen = pdgen,
+                output = output,
+                pd_proto_header = pd_proto_header,
+                cc_header = cc_header,
+            ),
+            srcs = [p4info],
+            tools = tools,
+            visibility = visibility,
+        )
+
+    native.cc_library(
+        name = cc_conversions,
+        srcs = [cc_conversions + ".cc"],
+        hdrs = [cc_conversions + ".h"],
+        visibility = visibility,
+        deps = [
+            cc_proto,
+            "//gutil:status",
+            "//p4_pdpi:ir_cc_proto",
+            "@com_google_absl//absl/status",
+            "@com_google_absl//absl/status:statusor",
+            "@com_google_absl//absl/strings",
+        ],
+    )
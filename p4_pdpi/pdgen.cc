@@ -12,7 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-// Given a P4Info file, generates the corresponding PD proto.
+// Given a P4Info file, generates the corresponding PD proto, or the header or
+// source of the C++ library of conversions between the PD proto and IR.
 
 #include <iostream>
 #include <string>
@@ -33,8 +34,19 @@
 
 ABSL_FLAG(std::string, p4info, "", "p4info file (required)");
 ABSL_FLAG(std::string, package, "", "protobuf package name (required)");
+ABSL_FLAG(std::string, output, "proto",
+          "what to generate: proto, cc_header or cc_source");
+ABSL_FLAG(std::string, pd_proto_header, "",
+          "include path of the C++ header of the PD proto (required for "
+          "cc_header and cc_source)");
+ABSL_FLAG(std::string, cc_header, "",
+          "include path of the generated C++ header (required for cc_header "
+          "and cc_source)");
 
-constexpr char kUsage[] = "--p4info=<file> --package=<package>";
+constexpr char kUsage[] =
+    "--p4info=<file> --package=<package> [--output=proto] | "
+    "--output=<cc_header|cc_source> --pd_proto_header=<file> "
+    "--cc_header=<file>";
 
 using ::p4::config::v1::P4Info;
 
@@ -74,15 +86,35 @@ int main(int argc, char** argv) {
   }
   pdpi::IrP4Info info = status_or_info.value();
 
-  // Output PD proto.
-  absl::StatusOr<std::string> status_or_pdproto =
-      pdpi::IrP4InfoToPdProto(info, package);
-  if (!status_or_pdproto.ok()) {
-    std::cerr << "Failed to generate PD proto: " << status_or_pdproto.status()
-              << std::endl;
+  // Output PD proto or C++ conversions.
+  const std::string output = absl::GetFlag(FLAGS_output);
+  absl::StatusOr<std::string> status_or_output;
+  if (output == "proto") {
+    status_or_output = pdpi::IrP4InfoToPdProto(info, package);
+  } else if (output == "cc_header" || output == "cc_source") {
+    const std::string pd_proto_header = absl::GetFlag(FLAGS_pd_proto_header);
+    const std::string cc_header = absl::GetFlag(FLAGS_cc_header);
+    if (pd_proto_header.empty() || cc_header.empty()) {
+      std::cerr << "Missing argument: --pd_proto_header=<file> or "
+                << "--cc_header=<file>" << std::endl;
+      return 1;
+    }
+    status_or_output =
+        output == "cc_header"
+            ? pdpi::IrP4InfoToPdConversionsHeader(info, package,
+                                                  pd_proto_header, cc_header)
+            : pdpi::IrP4InfoToPdConversionsSource(info, package,
+                                                  pd_proto_header, cc_header);
+  } else {
+    std::cerr << "Invalid argument: --output=" << output << std::endl;
+    return 1;
+  }
+  if (!status_or_output.ok()) {
+    std::cerr << "Failed to generate " << output << ": "
+              << status_or_output.status() << std::endl;
     return 1;
   }
-  std::cout << status_or_pdproto.value() << std::endl;
+  std::cout << status_or_output.value() << std::endl;
 
   return 0;
 }
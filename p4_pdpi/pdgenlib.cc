@@ -24,6 +24,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/escaping.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
@@ -67,6 +68,88 @@ std::string GetFormatComment(Format format, int32_t bitwidth) {
   return absl::StrCat("Format::", Format_Name(format), bitwidth_str);
 }
 
+// Returns the match fields of the given table, sorted by ID.
+std::vector<IrMatchFieldDefinition> SortedMatchFields(
+    const IrTableDefinition& table) {
+  std::vector<IrMatchFieldDefinition> match_fields;
+  for (const auto& [id, match] : Ordered(table.match_fields_by_id())) {
+    match_fields.push_back(match);
+  }
+  std::sort(match_fields.begin(), match_fields.end(),
+            [](const IrMatchFieldDefinition& a,
+               const IrMatchFieldDefinition& b) -> bool {
+              return a.match_field().id() < b.match_field().id();
+            });
+  return match_fields;
+}
+
+// Returns the entry actions of the given table, sorted by ID.
+std::vector<IrActionReference> SortedEntryActions(
+    const IrTableDefinition& table) {
+  std::vector<IrActionReference> entry_actions;
+  for (const auto& action : table.entry_actions()) {
+    entry_actions.push_back(action);
+  }
+  std::sort(entry_actions.begin(), entry_actions.end(),
+            [](const IrActionReference& a, const IrActionReference& b) -> bool {
+              return a.action().preamble().id() < b.action().preamble().id();
+            });
+  return entry_actions;
+}
+
+// Returns the parameters of the given action, sorted by ID.
+std::vector<IrActionDefinition::IrActionParamDefinition> SortedParams(
+    const IrActionDefinition& action) {
+  std::vector<IrActionDefinition::IrActionParamDefinition> params;
+  for (const auto& [id, param] : Ordered(action.params_by_id())) {
+    params.push_back(param);
+  }
+  std::sort(params.begin(), params.end(),
+            [](const IrActionDefinition::IrActionParamDefinition& a,
+               const IrActionDefinition::IrActionParamDefinition& b) -> bool {
+              return a.param().id() < b.param().id();
+            });
+  return params;
+}
+
+// Returns the tables of the given P4 info, sorted by ID.
+std::vector<IrTableDefinition> SortedTables(const IrP4Info& info) {
+  std::vector<IrTableDefinition> tables;
+  for (const auto& [id, table] : Ordered(info.tables_by_id())) {
+    tables.push_back(table);
+  }
+  std::sort(tables.begin(), tables.end(),
+            [](const IrTableDefinition& a, const IrTableDefinition& b) {
+              return a.preamble().id() < b.preamble().id();
+            });
+  return tables;
+}
+
+// Returns the actions of the given P4 info, sorted by ID.
+std::vector<IrActionDefinition> SortedActions(const IrP4Info& info) {
+  std::vector<IrActionDefinition> actions;
+  for (const auto& [id, action] : Ordered(info.actions_by_id())) {
+    actions.push_back(action);
+  }
+  std::sort(actions.begin(), actions.end(),
+            [](const IrActionDefinition& a, const IrActionDefinition& b) {
+              return a.preamble().id() < b.preamble().id();
+            });
+  return actions;
+}
+
+// Returns true if entries of the given table have a priority.
+bool HasPriority(const IrTableDefinition& table) {
+  for (const auto& [id, match] : Ordered(table.match_fields_by_id())) {
+    const auto& kind = match.match_field().match_type();
+    if (kind == MatchField::TERNARY || kind == MatchField::OPTIONAL ||
+        kind == MatchField::RANGE) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // Returns the proto field for a match.
 StatusOr<std::string> GetMatchFieldDeclaration(
     const IrMatchFieldDefinition& match) {
@@ -109,16 +192,7 @@ StatusOr<std::string> GetTableMatchMessage(const IrTableDefinition& table) {
   std::string result = "";
 
   absl::StrAppend(&result, "  message Match {\n");
-  std::vector<IrMatchFieldDefinition> match_fields;
-  for (const auto& [id, match] : Ordered(table.match_fields_by_id())) {
-    match_fields.push_back(match);
-  }
-  std::sort(match_fields.begin(), match_fields.end(),
-            [](const IrMatchFieldDefinition& a,
-               const IrMatchFieldDefinition& b) -> bool {
-              return a.match_field().id() < b.match_field().id();
-            });
-  for (const auto& match : match_fields) {
+  for (const auto& match : SortedMatchFields(table)) {
     ASSIGN_OR_RETURN(const auto& match_pd, GetMatchFieldDeclaration(match));
     absl::StrAppend(&result, "    ", match_pd, "\n");
   }
@@ -132,14 +206,8 @@ StatusOr<std::string> GetTableActionMessage(const IrTableDefinition& table) {
   std::string result;
 
   absl::StrAppend(&result, "  message Action {\n");
-  std::vector<IrActionReference> entry_actions;
-  for (const auto& action : table.entry_actions()) {
-    entry_actions.push_back(action);
-  }
-  std::sort(entry_actions.begin(), entry_actions.end(),
-            [](const IrActionReference& a, const IrActionReference& b) -> bool {
-              return a.action().preamble().id() < b.action().preamble().id();
-            });
+  const std::vector<IrActionReference> entry_actions =
+      SortedEntryActions(table);
   if (entry_actions.size() > 1) {
     absl::StrAppend(&result, "  oneof action {\n");
   }
@@ -226,15 +294,7 @@ StatusOr<std::string> GetTableMessage(const IrTableDefinition& table) {
   }
 
   // Priority (if applicable).
-  bool has_priority = false;
-  for (const auto& [id, match] : Ordered(table.match_fields_by_id())) {
-    const auto& kind = match.match_field().match_type();
-    if (kind == MatchField::TERNARY || kind == MatchField::OPTIONAL ||
-        kind == MatchField::RANGE) {
-      has_priority = true;
-    }
-  }
-  if (has_priority) {
+  if (HasPriority(table)) {
     absl::StrAppend(&result, "  int32 priority = 3;\n");
   }
 
@@ -285,19 +345,8 @@ StatusOr<std::string> GetActionMessage(const IrActionDefinition& action) {
                    P4NameToProtobufMessageName(name, kP4Action));
   absl::StrAppend(&result, "message ", message_name, " {\n");
 
-  // Sort parameters by ID
-  std::vector<IrActionDefinition::IrActionParamDefinition> params;
-  for (const auto& [id, param] : Ordered(action.params_by_id())) {
-    params.push_back(param);
-  }
-  std::sort(params.begin(), params.end(),
-            [](const IrActionDefinition::IrActionParamDefinition& a,
-               const IrActionDefinition::IrActionParamDefinition& b) -> bool {
-              return a.param().id() < b.param().id();
-            });
-
   // Field for every param.
-  for (const auto& param : params) {
+  for (const auto& param : SortedParams(action)) {
     ASSIGN_OR_RETURN(
         const std::string param_name,
         P4NameToProtobufFieldName(param.param().name(), kP4Parameter));
@@ -400,25 +449,8 @@ message Optional {
 }
 )");
 
-  // Sort tables by ID.
-  std::vector<IrTableDefinition> tables;
-  for (const auto& [id, table] : Ordered(info.tables_by_id())) {
-    tables.push_back(table);
-  }
-  std::sort(tables.begin(), tables.end(),
-            [](const IrTableDefinition& a, const IrTableDefinition& b) {
-              return a.preamble().id() < b.preamble().id();
-            });
-
-  // Sort actions by ID.
-  std::vector<IrActionDefinition> actions;
-  for (const auto& [id, action] : Ordered(info.actions_by_id())) {
-    actions.push_back(action);
-  }
-  std::sort(actions.begin(), actions.end(),
-            [](const IrActionDefinition& a, const IrActionDefinition& b) {
-              return a.preamble().id() < b.preamble().id();
-            });
+  const std::vector<IrTableDefinition> tables = SortedTables(info);
+  const std::vector<IrActionDefinition> actions = SortedActions(info);
 
   // Table messages.
   absl::StrAppend(&result, HeaderComment("Tables"), "\n");
@@ -536,4 +568,730 @@ message ReadResponse {
   return result;
 }
 
+
+namespace {
+
+// The header comment of generated C++ files.
+constexpr char kGeneratedCcComment[] =
+    R"(// P4 PD conversions
+
+// NOTE: This file is automatically created from the P4 program, do not modify manually.
+)";
+
+// Returns the given string as a C++ string literal.
+std::string CcStringLiteral(absl::string_view s) {
+  return absl::StrCat("\"", absl::CEscape(s), "\"");
+}
+
+// Returns the C++ namespace of the given protobuf package, e.g. "a::b" for
+// "a.b".
+std::string CcNamespace(const std::string& package) {
+  return absl::StrJoin(absl::StrSplit(package, '.'), "::");
+}
+
+// Returns the include guard of the given header file.
+std::string IncludeGuard(absl::string_view header) {
+  std::string guard;
+  for (char c : header) {
+    guard.push_back(absl::ascii_isalnum(c) ? absl::ascii_toupper(c) : '_');
+  }
+  return absl::StrCat(guard, "_");
+}
+
+// C++ keywords, which protoc appends an underscore to when they are used as
+// field names.
+constexpr absl::string_view kCcKeywords[] = {
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor",
+    "bool", "break", "case", "catch", "char", "class", "compl", "const",
+    "constexpr", "const_cast", "continue", "decltype", "default", "delete",
+    "do", "double", "dynamic_cast", "else", "enum", "explicit", "export",
+    "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int",
+    "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+    "nullptr", "operator", "or", "or_eq", "private", "protected", "public",
+    "register", "reinterpret_cast", "return", "short", "signed", "sizeof",
+    "static", "static_assert", "static_cast", "struct", "switch", "template",
+    "this", "thread_local", "throw", "true", "try", "typedef", "typeid",
+    "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+    "wchar_t", "while", "xor", "xor_eq",
+};
+
+// Returns the name of the C++ accessors that protoc generates for the PD proto
+// field of the given P4 entity, e.g. "noaction" for the action "NoAction".
+StatusOr<std::string> CcAccessorName(absl::string_view p4_name,
+                                     P4EntityKind entity_kind) {
+  ASSIGN_OR_RETURN(std::string name,
+                   P4NameToProtobufFieldName(p4_name, entity_kind));
+  absl::AsciiStrToLower(&name);
+  for (absl::string_view keyword : kCcKeywords) {
+    if (name == keyword) return absl::StrCat(name, "_");
+  }
+  return name;
+}
+
+// Returns the name of the constant that protoc generates in C++ for the given
+// member of a oneof, e.g. "kIpv6TableEntry" for "ipv6_table_entry".
+std::string OneofCaseName(absl::string_view field_name) {
+  std::string result = "k";
+  bool capitalize_next = true;
+  for (char c : field_name) {
+    if (absl::ascii_islower(c)) {
+      result.push_back(capitalize_next ? absl::ascii_toupper(c) : c);
+      capitalize_next = false;
+    } else if (absl::ascii_isupper(c)) {
+      result.push_back(c);
+      capitalize_next = false;
+    } else if (absl::ascii_isdigit(c)) {
+      result.push_back(c);
+      capitalize_next = true;
+    } else {
+      capitalize_next = true;
+    }
+  }
+  return result;
+}
+
+// Returns the field of IrValue that holds values of the given format. Since
+// PD values are formatted strings, this is all there is to converting them.
+StatusOr<std::string> IrValueFieldName(Format format) {
+  switch (format) {
+    case Format::MAC:
+      return "mac";
+    case Format::IPV4:
+      return "ipv4";
+    case Format::IPV6:
+      return "ipv6";
+    case Format::STRING:
+      return "str";
+    case Format::HEX_STRING:
+      return "hex_str";
+    default:
+      return InvalidArgumentErrorBuilder()
+             << "Unexpected format: " << Format_Name(format);
+  }
+}
+
+// The reflective conversions in pd.cc look names up with
+// gutil::FindPtrOrStatus, whose error message is followed by the context of the
+// lookup. The generated conversions start their lookup errors with the same
+// message, so that both report the same status.
+constexpr char kKeyNotFound[] = "Key not found; ";
+
+// Returns a C++ statement returning an error of the given code, whose message
+// is `prefix`, followed by the value of the C++ expression `value`, followed
+// by `suffix`.
+std::string ReturnError(absl::string_view code, absl::string_view prefix,
+                        absl::string_view value, absl::string_view suffix) {
+  return absl::StrCat("return gutil::", code, "ErrorBuilder() << ",
+                      CcStringLiteral(prefix), " << ", value, " << ",
+                      CcStringLiteral(suffix), ";");
+}
+
+// Returns the functions converting the PD message of the given action to IR
+// and back.
+StatusOr<std::string> GetActionConversions(const IrActionDefinition& action) {
+  const std::string& name = action.preamble().alias();
+  ASSIGN_OR_RETURN(const std::string message_name,
+                   P4NameToProtobufMessageName(name, kP4Action));
+  const auto params = SortedParams(action);
+  std::string result;
+
+  absl::StrAppend(&result, "void ", message_name, "ToIr(const ", message_name,
+                  "& pd_action, ::pdpi::IrActionInvocation* ir_action) {\n");
+  absl::StrAppend(&result, "  ir_action->set_name(", CcStringLiteral(name),
+                  ");\n");
+  for (const auto& param : params) {
+    const std::string& param_name = param.param().name();
+    ASSIGN_OR_RETURN(const std::string field_name,
+                     CcAccessorName(param_name, kP4Parameter));
+    ASSIGN_OR_RETURN(const std::string value_field,
+                     IrValueFieldName(param.format()));
+    absl::StrAppend(
+        &result, "  if (!pd_action.", field_name, "().empty()) {\n",
+        "    auto* ir_param = ir_action->add_params();\n",
+        "    ir_param->set_name(", CcStringLiteral(param_name), ");\n",
+        "    ir_param->mutable_value()->set_", value_field, "(pd_action.",
+        field_name, "());\n", "  }\n");
+  }
+  absl::StrAppend(&result, "}\n\n");
+
+  absl::StrAppend(&result, "absl::Status IrTo", message_name,
+                  "(const ::pdpi::IrActionInvocation& ir_action, ",
+                  message_name, "* pd_action) {\n");
+  absl::StrAppend(&result,
+                  "  for (const auto& ir_param : ir_action.params()) {\n",
+                  "    const std::string& name = ir_param.name();\n");
+  for (const auto& param : params) {
+    const std::string& param_name = param.param().name();
+    ASSIGN_OR_RETURN(const std::string field_name,
+                     CcAccessorName(param_name, kP4Parameter));
+    ASSIGN_OR_RETURN(const std::string value_field,
+                     IrValueFieldName(param.format()));
+    absl::StrAppend(&result, "    if (name == ", CcStringLiteral(param_name),
+                    ") {\n", "      pd_action->set_", field_name,
+                    "(ir_param.value().", value_field, "());\n",
+                    "      continue;\n", "    }\n");
+  }
+  absl::StrAppend(
+      &result, "    ",
+      ReturnError("NotFound",
+                  absl::StrCat(kKeyNotFound, "P4Info for action \"", name,
+                               "\" does not contain parameter with name \""),
+                  "name", "\""),
+      "\n", "  }\n", "  return absl::OkStatus();\n", "}\n");
+  return result;
+}
+
+// Returns code converting the PD action `pd_action` of the given table to the
+// IR action invocation `ir_action`, which is only evaluated if an action is
+// set.
+StatusOr<std::string> GetPdActionToIr(const IrTableDefinition& table,
+                                      const std::string& table_message_name,
+                                      absl::string_view indent,
+                                      absl::string_view ir_action) {
+  const auto entry_actions = SortedEntryActions(table);
+  std::string result;
+  if (entry_actions.size() > 1) {
+    absl::StrAppend(&result, indent, "switch (pd_action.action_case()) {\n");
+  }
+  for (const auto& action : entry_actions) {
+    const std::string& name = action.action().preamble().alias();
+    ASSIGN_OR_RETURN(const std::string message_name,
+                     P4NameToProtobufMessageName(name, kP4Action));
+    ASSIGN_OR_RETURN(const std::string proto_field_name,
+                     P4NameToProtobufFieldName(name, kP4Action));
+    ASSIGN_OR_RETURN(const std::string field_name,
+                     CcAccessorName(name, kP4Action));
+    const std::string conversion =
+        absl::StrCat(message_name, "ToIr(pd_action.", field_name, "(), ",
+                     ir_action, ");\n");
+    if (entry_actions.size() > 1) {
+      absl::StrAppend(&result, indent, "  case ", table_message_name,
+                      "::Action::", OneofCaseName(proto_field_name), ":\n",
+                      indent, "    ", conversion, indent, "    break;\n");
+    } else {
+      absl::StrAppend(&result, indent, "if (pd_action.has_", field_name,
+                      "()) {\n", indent, "  ", conversion, indent, "}\n");
+    }
+  }
+  if (entry_actions.size() > 1) {
+    absl::StrAppend(&result, indent, "  default:\n", indent, "    break;\n",
+                    indent, "}\n");
+  }
+  return result;
+}
+
+// Returns the functions converting the PD message of the given table to IR and
+// back.
+StatusOr<std::string> GetTableConversions(const IrTableDefinition& table) {
+  const std::string& name = table.preamble().alias();
+  ASSIGN_OR_RETURN(const std::string message_name,
+                   P4NameToProtobufMessageName(name, kP4Table));
+  const auto match_fields = SortedMatchFields(table);
+  std::string result;
+
+  // PD to IR.
+  absl::StrAppend(&result, "absl::Status ", message_name, "ToIr(const ",
+                  message_name, "& pd_table, ::pdpi::IrTableEntry* ir) {\n");
+  absl::StrAppend(&result, "  ir->set_table_name(", CcStringLiteral(name),
+                  ");\n", "  const auto& pd_match = pd_table.match();\n");
+  for (const auto& match : match_fields) {
+    const std::string& match_name = match.match_field().name();
+    ASSIGN_OR_RETURN(const std::string field_name,
+                     CcAccessorName(match_name, kP4MatchField));
+    ASSIGN_OR_RETURN(const std::string value_field,
+                     IrValueFieldName(match.format()));
+    const std::string add_match = absl::StrCat(
+        "    auto* ir_match = ir->add_matches();\n",
+        "    ir_match->set_name(", CcStringLiteral(match_name), ");\n");
+    switch (match.match_field().match_type()) {
+      case MatchField::EXACT:
+        absl::StrAppend(&result, "  if (!pd_match.", field_name,
+                        "().empty()) {\n", add_match,
+                        "    ir_match->mutable_exact()->set_", value_field,
+                        "(pd_match.", field_name, "());\n", "  }\n");
+        break;
+      case MatchField::LPM:
+        absl::StrAppend(
+            &result, "  if (pd_match.has_", field_name, "()) {\n",
+            "    const int32_t prefix_length = pd_match.", field_name,
+            "().prefix_length();\n", "    if (prefix_length < 0 || ",
+            "prefix_length > ", match.match_field().bitwidth(), ") {\n",
+            "      ",
+            ReturnError("InvalidArgument", "Prefix length (", "prefix_length",
+                        absl::StrCat(") for match field \"", match_name,
+                                     "\" is out of bounds")),
+            "\n", "    }\n", add_match,
+            "    auto* ir_lpm = ir_match->mutable_lpm();\n",
+            "    ir_lpm->mutable_value()->set_", value_field, "(pd_match.",
+            field_name, "().value());\n",
+            "    ir_lpm->set_prefix_length(prefix_length);\n", "  }\n");
+        break;
+      case MatchField::TERNARY:
+        absl::StrAppend(
+            &result, "  if (pd_match.has_", field_name, "()) {\n", add_match,
+            "    auto* ir_ternary = ir_match->mutable_ternary();\n",
+            "    ir_ternary->mutable_value()->set_", value_field, "(pd_match.",
+            field_name, "().value());\n",
+            "    ir_ternary->mutable_mask()->set_", value_field, "(pd_match.",
+            field_name, "().mask());\n", "  }\n");
+        break;
+      case MatchField::OPTIONAL:
+        absl::StrAppend(
+            &result, "  if (pd_match.has_", field_name, "()) {\n", add_match,
+            "    ir_match->mutable_optional()->mutable_value()->set_",
+            value_field, "(pd_match.", field_name, "().value());\n", "  }\n");
+        break;
+      default:
+        return InvalidArgumentErrorBuilder()
+               << "Invalid match kind: " << match.DebugString();
+    }
+  }
+  if (HasPriority(table)) {
+    absl::StrAppend(&result, "  ir->set_priority(pd_table.priority());\n");
+  }
+  if (table.uses_oneshot()) {
+    ASSIGN_OR_RETURN(
+        const std::string pd_action_to_ir,
+        GetPdActionToIr(table, message_name, "    ",
+                        "ir_action_set_invocation->mutable_action()"));
+    absl::StrAppend(
+        &result, "  auto* ir_action_set = ir->mutable_action_set();\n",
+        "  for (const auto& pd_action : pd_table.actions()) {\n",
+        "    auto* ir_action_set_invocation = ir_action_set->add_actions();\n",
+        pd_action_to_ir,
+        "    ir_action_set_invocation->set_weight(pd_action.weight());\n",
+        "  }\n");
+  } else {
+    ASSIGN_OR_RETURN(
+        const std::string pd_action_to_ir,
+        GetPdActionToIr(table, message_name, "  ", "ir->mutable_action()"));
+    absl::StrAppend(&result, "  const auto& pd_action = pd_table.action();\n",
+                    pd_action_to_ir);
+  }
+  std::string rate_field;
+  std::string burst_field;
+  if (table.has_meter()) {
+    switch (table.meter().unit()) {
+      case p4::config::v1::MeterSpec::BYTES:
+        rate_field = "bytes_per_second";
+        burst_field = "burst_bytes";
+        break;
+      case p4::config::v1::MeterSpec::PACKETS:
+        rate_field = "packets_per_second";
+        burst_field = "burst_packets";
+        break;
+      default:
+        return InvalidArgumentErrorBuilder()
+               << "Unsupported meter: " << table.meter().DebugString();
+    }
+    absl::StrAppend(
+        &result, "  const auto& pd_meter_config = pd_table.meter_config();\n",
+        "  auto* ir_meter_config = ir->mutable_meter_config();\n",
+        "  ir_meter_config->set_cir(pd_meter_config.", rate_field, "());\n",
+        "  ir_meter_config->set_pir(pd_meter_config.", rate_field, "());\n",
+        "  ir_meter_config->set_cburst(pd_meter_config.", burst_field,
+        "());\n", "  ir_meter_config->set_pburst(pd_meter_config.",
+        burst_field, "());\n");
+  }
+  bool has_byte_counter = false;
+  bool has_packet_counter = false;
+  if (table.has_counter()) {
+    switch (table.counter().unit()) {
+      case p4::config::v1::CounterSpec::BYTES:
+        has_byte_counter = true;
+        break;
+      case p4::config::v1::CounterSpec::PACKETS:
+        has_packet_counter = true;
+        break;
+      case p4::config::v1::CounterSpec::BOTH:
+        has_byte_counter = true;
+        has_packet_counter = true;
+        break;
+      default:
+        return InvalidArgumentErrorBuilder()
+               << "Unsupported counter: " << table.counter().DebugString();
+    }
+  }
+  if (has_byte_counter) {
+    absl::StrAppend(&result,
+                    "  ir->mutable_counter_data()->set_byte_count("
+                    "pd_table.byte_counter());\n");
+  }
+  if (has_packet_counter) {
+    absl::StrAppend(&result,
+                    "  ir->mutable_counter_data()->set_packet_count("
+                    "pd_table.packet_counter());\n");
+  }
+  absl::StrAppend(&result, "  return absl::OkStatus();\n", "}\n\n");
+
+  // IR to PD, starting with the action, which is shared by action sets.
+  absl::StrAppend(&result, "absl::Status IrTo", message_name,
+                  "Action(const ::pdpi::IrActionInvocation& ir_action, ",
+                  message_name, "::Action* pd_action) {\n",
+                  "  const std::string& name = ir_action.name();\n");
+  for (const auto& action : SortedEntryActions(table)) {
+    const std::string& action_name = action.action().preamble().alias();
+    ASSIGN_OR_RETURN(const std::string action_message_name,
+                     P4NameToProtobufMessageName(action_name, kP4Action));
+    ASSIGN_OR_RETURN(const std::string field_name,
+                     CcAccessorName(action_name, kP4Action));
+    absl::StrAppend(&result, "  if (name == ", CcStringLiteral(action_name),
+                    ") {\n", "    return IrTo", action_message_name,
+                    "(ir_action, pd_action->mutable_", field_name, "());\n",
+                    "  }\n");
+  }
+  absl::StrAppend(&result, "  return UnknownActionError(name, ",
+                  CcStringLiteral(name), ");\n", "}\n\n");
+
+  absl::StrAppend(&result, "absl::Status IrTo", message_name,
+                  "(const ::pdpi::IrTableEntry& ir, ", message_name,
+                  "* pd_table) {\n",
+                  "  auto* pd_match = pd_table->mutable_match();\n",
+                  "  for (const auto& ir_match : ir.matches()) {\n",
+                  "    const std::string& name = ir_match.name();\n");
+  for (const auto& match : match_fields) {
+    const std::string& match_name = match.match_field().name();
+    ASSIGN_OR_RETURN(const std::string field_name,
+                     CcAccessorName(match_name, kP4MatchField));
+    ASSIGN_OR_RETURN(const std::string value_field,
+                     IrValueFieldName(match.format()));
+    absl::StrAppend(&result, "    if (name == ", CcStringLiteral(match_name),
+                    ") {\n");
+    switch (match.match_field().match_type()) {
+      case MatchField::EXACT:
+        absl::StrAppend(&result, "      pd_match->set_", field_name,
+                        "(ir_match.exact().", value_field, "());\n");
+        break;
+      case MatchField::LPM:
+        absl::StrAppend(
+            &result, "      auto* pd_lpm = pd_match->mutable_", field_name,
+            "();\n", "      pd_lpm->set_value(ir_match.lpm().value().",
+            value_field, "());\n",
+            "      pd_lpm->set_prefix_length("
+            "ir_match.lpm().prefix_length());\n");
+        break;
+      case MatchField::TERNARY:
+        absl::StrAppend(
+            &result, "      auto* pd_ternary = pd_match->mutable_", field_name,
+            "();\n", "      pd_ternary->set_value(ir_match.ternary().value().",
+            value_field, "());\n",
+            "      pd_ternary->set_mask(ir_match.ternary().mask().",
+            value_field, "());\n");
+        break;
+      case MatchField::OPTIONAL:
+        absl::StrAppend(&result, "      pd_match->mutable_", field_name,
+                        "()->set_value(ir_match.optional().value().",
+                        value_field, "());\n");
+        break;
+      default:
+        return InvalidArgumentErrorBuilder()
+               << "Invalid match kind: " << match.DebugString();
+    }
+    absl::StrAppend(&result, "      continue;\n", "    }\n");
+  }
+  absl::StrAppend(
+      &result, "    ",
+      ReturnError("NotFound",
+                  absl::StrCat(kKeyNotFound, "P4Info for table \"",
+                               table.preamble().name(),
+                               "\" does not contain match with name \""),
+                  "name", "\""),
+      "\n", "  }\n");
+  if (HasPriority(table)) {
+    absl::StrAppend(&result, "  pd_table->set_priority(ir.priority());\n");
+  } else {
+    absl::StrAppend(
+        &result, "  if (ir.priority() != 0) {\n", "    ",
+        ReturnError("InvalidArgument", "Priority (", "ir.priority()",
+                    absl::StrCat(") given for table \"", name,
+                                 "\", which has no priority")),
+        "\n", "  }\n");
+  }
+  if (table.uses_oneshot()) {
+    absl::StrAppend(
+        &result,
+        "  for (const auto& ir_action_set_invocation : "
+        "ir.action_set().actions()) {\n",
+        "    auto* pd_action = pd_table->add_actions();\n",
+        "    RETURN_IF_ERROR(IrTo", message_name,
+        "Action(ir_action_set_invocation.action(), pd_action));\n",
+        "    pd_action->set_weight(ir_action_set_invocation.weight());\n",
+        "  }\n");
+  } else {
+    absl::StrAppend(&result, "  RETURN_IF_ERROR(IrTo", message_name,
+                    "Action(ir.action(), pd_table->mutable_action()));\n");
+  }
+  if (table.has_meter()) {
+    absl::StrAppend(
+        &result, "  const auto& ir_meter_config = ir.meter_config();\n",
+        "  if (ir_meter_config.cir() != ir_meter_config.pir()) {\n",
+        "    return gutil::InvalidArgumentErrorBuilder()\n",
+        "           << \"CIR and PIR values should be equal. Got CIR as \"\n",
+        "           << ir_meter_config.cir() << \", PIR as \" << "
+        "ir_meter_config.pir();\n",
+        "  }\n",
+        "  if (ir_meter_config.cburst() != ir_meter_config.pburst()) {\n",
+        "    return gutil::InvalidArgumentErrorBuilder()\n",
+        "           << \"CBurst and PBurst values should be equal. Got CBurst "
+        "as \"\n",
+        "           << ir_meter_config.cburst() << \", PBurst as \" << "
+        "ir_meter_config.pburst();\n",
+        "  }\n",
+        "  auto* pd_meter_config = pd_table->mutable_meter_config();\n",
+        "  pd_meter_config->set_", rate_field, "(ir_meter_config.cir());\n",
+        "  pd_meter_config->set_", burst_field,
+        "(ir_meter_config.cburst());\n");
+  }
+  if (has_byte_counter) {
+    absl::StrAppend(
+        &result,
+        "  pd_table->set_byte_counter(ir.counter_data().byte_count());\n");
+  }
+  if (has_packet_counter) {
+    absl::StrAppend(
+        &result,
+        "  pd_table->set_packet_counter(ir.counter_data().packet_count());\n");
+  }
+  absl::StrAppend(&result, "  return absl::OkStatus();\n", "}\n");
+  return result;
+}
+
+// Returns the functions converting the PD packet-in or packet-out message to
+// IR and back. `kind` is one of "packet-in", "packet-out".
+StatusOr<std::string> GetPacketIoConversions(
+    const std::string& kind, const std::string& message_name,
+    const google::protobuf::Map<std::string, IrPacketIoMetadataDefinition>&
+        metadata_by_name) {
+  std::string result;
+  absl::StrAppend(&result, "absl::StatusOr<::pdpi::Ir", message_name, "> Pd",
+                  message_name, "ToIr(const ", message_name, "& packet) {\n",
+                  "  ::pdpi::Ir", message_name, " result;\n",
+                  "  result.set_payload(packet.payload());\n");
+  for (const auto& [name, meta] : Ordered(metadata_by_name)) {
+    ASSIGN_OR_RETURN(
+        const std::string field_name,
+        CcAccessorName(meta.metadata().name(), kP4MetaField));
+    ASSIGN_OR_RETURN(const std::string value_field,
+                     IrValueFieldName(meta.format()));
+    absl::StrAppend(&result, "  {\n",
+                    "    auto* ir_metadata = result.add_metadata();\n",
+                    "    ir_metadata->set_name(", CcStringLiteral(name),
+                    ");\n", "    ir_metadata->mutable_value()->set_",
+                    value_field, "(packet.metadata().", field_name, "());\n",
+                    "  }\n");
+  }
+  absl::StrAppend(&result, "  return result;\n", "}\n\n");
+
+  absl::StrAppend(&result, "absl::Status Ir", message_name,
+                  "ToPd(const ::pdpi::Ir", message_name, "& packet, ",
+                  message_name, "* pd_packet) {\n",
+                  "  pd_packet->set_payload(packet.payload());\n",
+                  "  for (const auto& metadata : packet.metadata()) {\n",
+                  "    const std::string& name = metadata.name();\n");
+  for (const auto& [name, meta] : Ordered(metadata_by_name)) {
+    ASSIGN_OR_RETURN(
+        const std::string field_name,
+        CcAccessorName(meta.metadata().name(), kP4MetaField));
+    ASSIGN_OR_RETURN(const std::string value_field,
+                     IrValueFieldName(meta.format()));
+    absl::StrAppend(&result, "    if (name == ", CcStringLiteral(name),
+                    ") {\n", "      pd_packet->mutable_metadata()->set_",
+                    field_name, "(metadata.value().", value_field, "());\n",
+                    "      continue;\n", "    }\n");
+  }
+  absl::StrAppend(
+      &result, "    ",
+      ReturnError("NotFound",
+                  absl::StrCat(kKeyNotFound, "\"", kind,
+                               "\" metadata with name \""),
+                  "name",
+                  "\" not defined"),
+      "\n", "  }\n", "  return absl::OkStatus();\n", "}\n");
+  return result;
+}
+
+}  // namespace
+
+StatusOr<std::string> IrP4InfoToPdConversionsHeader(
+    const IrP4Info& info, const std::string& package,
+    const std::string& pd_proto_header, const std::string& header) {
+  const std::string guard = IncludeGuard(header);
+  std::string result = kGeneratedCcComment;
+  absl::StrAppend(&result, R"(
+#ifndef )", guard, R"(
+#define )", guard, R"(
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "p4_pdpi/ir.pb.h"
+#include ")", pd_proto_header, R"("
+
+namespace )", CcNamespace(package), R"( {
+
+// Conversions between the PD messages of this P4 program and IR. They behave
+// like the functions of the same name in p4_pdpi/pd.h, given the P4Info that
+// the PD proto was generated from, but access the PD messages through their
+// generated accessors instead of reflection, and are specialized for the
+// P4Info at compile time, so they do not need an IrP4Info.
+
+// Converts a PD table entry to the IR table entry. Overwrites `ir`, whose
+// contents are unspecified if an error is returned.
+absl::Status PdTableEntryToIr(const TableEntry& pd, ::pdpi::IrTableEntry* ir);
+// Same as above, but returns the IR table entry.
+absl::StatusOr<::pdpi::IrTableEntry> PdTableEntryToIr(const TableEntry& pd);
+// Converts an IR table entry to the PD table entry.
+absl::Status IrTableEntryToPd(const ::pdpi::IrTableEntry& ir, TableEntry* pd);
+
+// Converts between PD and IR packets.
+absl::StatusOr<::pdpi::IrPacketIn> PdPacketInToIr(const PacketIn& packet);
+absl::Status IrPacketInToPd(const ::pdpi::IrPacketIn& packet,
+                            PacketIn* pd_packet);
+absl::StatusOr<::pdpi::IrPacketOut> PdPacketOutToIr(const PacketOut& packet);
+absl::Status IrPacketOutToPd(const ::pdpi::IrPacketOut& packet,
+                             PacketOut* pd_packet);
+
+}  // namespace )", CcNamespace(package), R"(
+
+#endif  // )", guard, "\n");
+  return result;
+}
+
+StatusOr<std::string> IrP4InfoToPdConversionsSource(
+    const IrP4Info& info, const std::string& package,
+    const std::string& pd_proto_header, const std::string& header) {
+  std::string result = kGeneratedCcComment;
+  absl::StrAppend(&result, R"(
+#include ")", header, R"("
+
+#include <stdint.h>
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "gutil/status.h"
+#include "p4_pdpi/ir.pb.h"
+#include ")", pd_proto_header, R"("
+
+namespace )", CcNamespace(package), R"( {
+namespace {
+)");
+  const std::vector<IrActionDefinition> actions = SortedActions(info);
+
+  // Actions.
+  absl::StrAppend(&result, HeaderComment("Actions"), "\n");
+  absl::StrAppend(&result,
+                  "// Returns true if the given name is the name of an "
+                  "action.\n",
+                  "bool IsAction(absl::string_view name) {\n");
+  for (const auto& action : actions) {
+    absl::StrAppend(&result, "  if (name == ",
+                    CcStringLiteral(action.preamble().alias()),
+                    ") return true;\n");
+  }
+  absl::StrAppend(&result, "  return false;\n", "}\n\n");
+  absl::StrAppend(
+      &result,
+      "// Returns the error for an action that is not an entry action of the "
+      "given\n// table.\n",
+      "absl::Status UnknownActionError(const std::string& action_name,\n",
+      "                                absl::string_view table_name) {\n",
+      "  if (IsAction(action_name)) {\n",
+      "    return gutil::InvalidArgumentErrorBuilder()\n",
+      "           << \"Action \\\"\" << action_name\n",
+      "           << \"\\\" is not an entry action of table \\\"\" << "
+      "table_name << \"\\\"\";\n",
+      "  }\n", "  return gutil::NotFoundErrorBuilder()\n",
+      "         << \"", kKeyNotFound,
+      "P4Info does not contain action with name \\\"\"\n",
+      "         << action_name\n",
+      "         << \"\\\"\";\n", "}\n");
+  // Only entry actions are converted, all others cannot occur in PD.
+  const std::vector<IrTableDefinition> tables = SortedTables(info);
+  absl::flat_hash_set<std::string> entry_actions;
+  for (const auto& table : tables) {
+    for (const auto& action : table.entry_actions()) {
+      entry_actions.insert(action.action().preamble().alias());
+    }
+  }
+  for (const auto& action : actions) {
+    if (!entry_actions.contains(action.preamble().alias())) continue;
+    ASSIGN_OR_RETURN(const auto action_conversions,
+                     GetActionConversions(action));
+    absl::StrAppend(&result, "\n", action_conversions);
+  }
+
+  // Tables.
+  absl::StrAppend(&result, HeaderComment("Tables"));
+  for (const auto& table : tables) {
+    ASSIGN_OR_RETURN(const auto table_conversions, GetTableConversions(table));
+    absl::StrAppend(&result, "\n", table_conversions);
+  }
+  absl::StrAppend(&result, "\n}  // namespace\n");
+
+  // Overall table entry.
+  absl::StrAppend(&result, HeaderComment("All tables"), "\n");
+  absl::StrAppend(&result,
+                  "absl::Status PdTableEntryToIr(const TableEntry& pd, "
+                  "::pdpi::IrTableEntry* ir) {\n",
+                  "  ir->Clear();\n", "  switch (pd.entry_case()) {\n");
+  for (const auto& table : tables) {
+    const auto& name = table.preamble().alias();
+    ASSIGN_OR_RETURN(const std::string message_name,
+                     P4NameToProtobufMessageName(name, kP4Table));
+    ASSIGN_OR_RETURN(const std::string proto_field_name,
+                     P4NameToProtobufFieldName(name, kP4Table));
+    ASSIGN_OR_RETURN(const std::string field_name,
+                     CcAccessorName(name, kP4Table));
+    absl::StrAppend(&result, "    case TableEntry::",
+                    OneofCaseName(proto_field_name),
+                    ":\n", "      return ", message_name, "ToIr(pd.",
+                    field_name, "(), ir);\n");
+  }
+  absl::StrAppend(&result, "    default:\n",
+                  "      return gutil::NotFoundErrorBuilder()\n",
+                  "             << \"Oneof field \\\"entry\\\" is not set\";\n",
+                  "  }\n", "}\n\n");
+  absl::StrAppend(&result,
+                  "absl::StatusOr<::pdpi::IrTableEntry> PdTableEntryToIr("
+                  "const TableEntry& pd) {\n",
+                  "  ::pdpi::IrTableEntry ir;\n",
+                  "  RETURN_IF_ERROR(PdTableEntryToIr(pd, &ir));\n",
+                  "  return ir;\n", "}\n\n");
+  absl::StrAppend(&result,
+                  "absl::Status IrTableEntryToPd(const ::pdpi::IrTableEntry& "
+                  "ir, TableEntry* pd) {\n",
+                  "  const std::string& name = ir.table_name();\n");
+  for (const auto& table : tables) {
+    const auto& name = table.preamble().alias();
+    ASSIGN_OR_RETURN(const std::string message_name,
+                     P4NameToProtobufMessageName(name, kP4Table));
+    ASSIGN_OR_RETURN(const std::string field_name,
+                     CcAccessorName(name, kP4Table));
+    absl::StrAppend(&result, "  if (name == ", CcStringLiteral(name), ") {\n",
+                    "    return IrTo", message_name, "(ir, pd->mutable_",
+                    field_name, "());\n", "  }\n");
+  }
+  absl::StrAppend(
+      &result, "  ",
+      ReturnError("NotFound", absl::StrCat(kKeyNotFound, "Table \""), "name",
+                  "\" does not exist in P4Info. The PD proto and P4Info file "
+                  "are out of sync"),
+      "\n", "}\n");
+
+  // Packet IO.
+  absl::StrAppend(&result, HeaderComment("Packet-IO"), "\n");
+  ASSIGN_OR_RETURN(const auto packet_in_conversions,
+                   GetPacketIoConversions("packet-in", "PacketIn",
+                                          info.packet_in_metadata_by_name()));
+  ASSIGN_OR_RETURN(const auto packet_out_conversions,
+                   GetPacketIoConversions("packet-out", "PacketOut",
+                                          info.packet_out_metadata_by_name()));
+  absl::StrAppend(&result, packet_in_conversions, "\n", packet_out_conversions);
+
+  absl::StrAppend(&result, "\n}  // namespace ", CcNamespace(package), "\n");
+  return result;
+}
+
 }  // namespace pdpi
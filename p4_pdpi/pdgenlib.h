@@ -28,6 +28,18 @@ namespace pdpi {
 absl::StatusOr<std::string> IrP4InfoToPdProto(const IrP4Info& info,
                                               const std::string& package);
 
+// Returns the header and source of a C++ library of conversions between IR and
+// the PD proto of the given P4 info, which access the PD messages directly
+// instead of through reflection. `package` is the package of the PD proto, and
+// `pd_proto_header` the path of its C++ header, which the library includes. The
+// source includes the header as `header`.
+absl::StatusOr<std::string> IrP4InfoToPdConversionsHeader(
+    const IrP4Info& info, const std::string& package,
+    const std::string& pd_proto_header, const std::string& header);
+absl::StatusOr<std::string> IrP4InfoToPdConversionsSource(
+    const IrP4Info& info, const std::string& package,
+    const std::string& pd_proto_header, const std::string& header);
+
 }  // namespace pdpi
 
 #endif  // P4_PDPI_PD_H_
@@ -0,0 +1,338 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/reconciliation.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "google/protobuf/util/message_differencer.h"
+#include "gutil/status.h"
+#include "gutil/thread_pool.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
+#include "p4_pdpi/connection_management.h"
+#include "p4_pdpi/entity_management.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/sequencing.h"
+#include "p4_pdpi/table_entry_key.h"
+#include "p4_pdpi/utils/ir.h"
+
+namespace pdpi {
+
+using ::google::protobuf::util::MessageDifferencer;
+using ::p4::v1::Action;
+using ::p4::v1::ActionProfileActionSet;
+using ::p4::v1::TableAction;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+
+namespace {
+
+// Number of partitions per thread, to balance the load when partitions have
+// different sizes.
+constexpr int kPartitionsPerThread = 4;
+
+// Returns true if the actions are equal up to the order of their params and
+// leading zeros in param values.
+bool SameAction(const Action& left, const Action& right) {
+  if (left.action_id() != right.action_id() ||
+      left.params_size() != right.params_size()) {
+    return false;
+  }
+  // Actions have few params, so a quadratic search is fastest.
+  for (const Action::Param& left_param : left.params()) {
+    auto right_param =
+        absl::c_find_if(right.params(), [&](const Action::Param& param) {
+          return param.param_id() == left_param.param_id();
+        });
+    if (right_param == right.params().end() ||
+        NormalizedToCanonicalByteStringView(left_param.value()) !=
+            NormalizedToCanonicalByteStringView(right_param->value())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if the action sets are equal up to the order of their actions.
+bool SameActionSet(const ActionProfileActionSet& left,
+                   const ActionProfileActionSet& right) {
+  if (left.action_profile_actions_size() !=
+      right.action_profile_actions_size()) {
+    return false;
+  }
+  // Action sets are small, so matching up actions in quadratic time is fine.
+  std::vector<bool> matched(right.action_profile_actions_size(), false);
+  for (const auto& left_action : left.action_profile_actions()) {
+    bool found = false;
+    for (int i = 0; i < right.action_profile_actions_size() && !found; ++i) {
+      const auto& right_action = right.action_profile_actions(i);
+      if (!matched[i] && left_action.weight() == right_action.weight() &&
+          left_action.watch_port() == right_action.watch_port() &&
+          left_action.watch() == right_action.watch() &&
+          SameAction(left_action.action(), right_action.action())) {
+        matched[i] = found = true;
+      }
+    }
+    if (!found) return false;
+  }
+  return true;
+}
+
+bool SameTableAction(const TableAction& left, const TableAction& right) {
+  if (left.type_case() != right.type_case()) return false;
+  switch (left.type_case()) {
+    case TableAction::kAction:
+      return SameAction(left.action(), right.action());
+    case TableAction::kActionProfileMemberId:
+      return left.action_profile_member_id() ==
+             right.action_profile_member_id();
+    case TableAction::kActionProfileGroupId:
+      return left.action_profile_group_id() == right.action_profile_group_id();
+    case TableAction::kActionProfileActionSet:
+      return SameActionSet(left.action_profile_action_set(),
+                           right.action_profile_action_set());
+    case TableAction::TYPE_NOT_SET:
+      return true;
+  }
+  return false;
+}
+
+// Returns true if entries with the same key need no MODIFY to turn one into the
+// other. Counter data is maintained by the switch, so it is ignored.
+bool SameNonKeyFields(const TableEntry& left, const TableEntry& right) {
+  return left.controller_metadata() == right.controller_metadata() &&
+         left.metadata() == right.metadata() &&
+         left.idle_timeout_ns() == right.idle_timeout_ns() &&
+         left.is_default_action() == right.is_default_action() &&
+         SameTableAction(left.action(), right.action()) &&
+         MessageDifferencer::Equals(left.meter_config(), right.meter_config());
+}
+
+// The keys of entries, and the partitions the entries belong to.
+struct PartitionedKeys {
+  std::vector<TableEntryKey> keys;
+  // The indices of the entries in each partition, in increasing order.
+  std::vector<std::vector<int>> partitions;
+};
+
+// Computes the keys of `entries` in parallel, and partitions the entries by
+// key hash into `num_partitions` partitions.
+absl::StatusOr<PartitionedKeys> PartitionByKey(
+    const CompiledIrP4Info& info, absl::Span<const TableEntry> entries,
+    int num_partitions, gutil::ThreadPool* pool) {
+  std::vector<absl::StatusOr<TableEntryKey>> keys(entries.size());
+  std::vector<int> partition(entries.size());
+  gutil::ParallelFor(pool, entries.size(), [&](int i) {
+    keys[i] = PiTableEntryKey(info, entries[i]);
+    if (!keys[i].ok()) return;
+    // The partition is chosen by the high bits of the hash, since hash maps
+    // use the low bits, which would otherwise be the same for all keys of a
+    // partition.
+    const uint64_t hash = absl::Hash<TableEntryKey>()(*keys[i]);
+    partition[i] = ((hash >> 32) * num_partitions) >> 32;
+  });
+
+  PartitionedKeys result;
+  result.keys.reserve(entries.size());
+  result.partitions.resize(num_partitions);
+  for (int i = 0; i < entries.size(); ++i) {
+    RETURN_IF_ERROR(keys[i].status()).SetPrepend()
+        << "Entry at index " << i << " has no key: ";
+    result.keys.push_back(*std::move(keys[i]));
+    result.partitions[partition[i]].push_back(i);
+  }
+  return result;
+}
+
+// What happens to an entry.
+enum class Outcome : char { kUnchanged, kInsert, kModify, kDelete };
+
+// Diffs the desired and installed entries of one partition, and stores the
+// outcome of each of them. Entries in different partitions have different
+// keys, so partitions can be diffed independently.
+absl::Status DiffPartition(absl::Span<const TableEntry> desired,
+                           const PartitionedKeys& desired_keys,
+                           absl::Span<const TableEntry> installed,
+                           const PartitionedKeys& installed_keys, int partition,
+                           absl::Span<Outcome> desired_outcomes,
+                           absl::Span<Outcome> installed_outcomes) {
+  struct KeyHash {
+    size_t operator()(const TableEntryKey* key) const {
+      return absl::Hash<TableEntryKey>()(*key);
+    }
+  };
+  struct KeyEq {
+    bool operator()(const TableEntryKey* left,
+                    const TableEntryKey* right) const {
+      return *left == *right;
+    }
+  };
+  // The indices of the installed and desired entry with a key, or -1 if there
+  // is none.
+  struct Indices {
+    int installed = -1;
+    int desired = -1;
+  };
+  absl::flat_hash_map<const TableEntryKey*, Indices, KeyHash, KeyEq>
+      indices_by_key;
+  indices_by_key.reserve(installed_keys.partitions[partition].size());
+
+  for (int i : installed_keys.partitions[partition]) {
+    Indices& indices = indices_by_key[&installed_keys.keys[i]];
+    if (indices.installed != -1) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Installed entry at index " << i
+             << " has the same key as the installed entry at index "
+             << indices.installed << ".";
+    }
+    indices.installed = i;
+    installed_outcomes[i] = Outcome::kDelete;
+  }
+  for (int i : desired_keys.partitions[partition]) {
+    Indices& indices = indices_by_key[&desired_keys.keys[i]];
+    if (indices.desired != -1) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Desired entry at index " << i
+             << " has the same key as the desired entry at index "
+             << indices.desired << ".";
+    }
+    indices.desired = i;
+    if (indices.installed == -1) {
+      desired_outcomes[i] = Outcome::kInsert;
+      continue;
+    }
+    installed_outcomes[indices.installed] = Outcome::kUnchanged;
+    if (!SameNonKeyFields(desired[i], installed[indices.installed])) {
+      desired_outcomes[i] = Outcome::kModify;
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Returns updates of the given type for the `entries` with the given
+// `outcome`, in the order of `entries`. The updates are filled in parallel.
+std::vector<Update> MakeUpdates(absl::Span<const TableEntry> entries,
+                                absl::Span<const Outcome> outcomes,
+                                Outcome outcome, Update::Type type,
+                                gutil::ThreadPool* pool) {
+  std::vector<int> indices;
+  for (int i = 0; i < entries.size(); ++i) {
+    if (outcomes[i] == outcome) indices.push_back(i);
+  }
+  std::vector<Update> updates(indices.size());
+  gutil::ParallelFor(pool, indices.size(), [&](int i) {
+    updates[i].set_type(type);
+    *updates[i].mutable_entity()->mutable_table_entry() = entries[indices[i]];
+  });
+  return updates;
+}
+
+}  // namespace
+
+absl::StatusOr<TableEntryDiff> DiffTableEntries(
+    const CompiledIrP4Info& info, absl::Span<const TableEntry> desired,
+    absl::Span<const TableEntry> installed, gutil::ThreadPool* pool) {
+  const int num_partitions =
+      pool == nullptr ? 1 : kPartitionsPerThread * (pool->num_threads() + 1);
+  ASSIGN_OR_RETURN(
+      const PartitionedKeys desired_keys,
+      PartitionByKey(info, desired, num_partitions, pool),
+      _.SetPrepend() << "Invalid desired entries: ");
+  ASSIGN_OR_RETURN(
+      const PartitionedKeys installed_keys,
+      PartitionByKey(info, installed, num_partitions, pool),
+      _.SetPrepend() << "Invalid installed entries: ");
+
+  std::vector<Outcome> desired_outcomes(desired.size(), Outcome::kUnchanged);
+  std::vector<Outcome> installed_outcomes(installed.size(),
+                                          Outcome::kUnchanged);
+  std::vector<absl::Status> statuses(num_partitions);
+  gutil::ParallelFor(pool, num_partitions, [&](int partition) {
+    statuses[partition] = DiffPartition(
+        desired, desired_keys, installed, installed_keys, partition,
+        absl::MakeSpan(desired_outcomes), absl::MakeSpan(installed_outcomes));
+  });
+  for (const absl::Status& partition_status : statuses) {
+    RETURN_IF_ERROR(partition_status);
+  }
+
+  TableEntryDiff diff;
+  diff.inserts = MakeUpdates(desired, desired_outcomes, Outcome::kInsert,
+                             Update::INSERT, pool);
+  diff.modifies = MakeUpdates(desired, desired_outcomes, Outcome::kModify,
+                              Update::MODIFY, pool);
+  diff.deletes = MakeUpdates(installed, installed_outcomes, Outcome::kDelete,
+                             Update::DELETE, pool);
+  return diff;
+}
+
+absl::StatusOr<TableEntryDiff> DiffTableEntries(
+    const CompiledIrP4Info& info, absl::Span<const IrTableEntry> desired,
+    absl::Span<const TableEntry> installed, gutil::ThreadPool* pool) {
+  std::vector<absl::StatusOr<TableEntry>> translated(desired.size());
+  gutil::ParallelFor(pool, desired.size(), [&](int i) {
+    translated[i] = IrTableEntryToPi(info, desired[i]);
+  });
+  std::vector<TableEntry> pi_desired;
+  pi_desired.reserve(translated.size());
+  for (int i = 0; i < translated.size(); ++i) {
+    RETURN_IF_ERROR(translated[i].status()).SetPrepend()
+        << "Desired entry at index " << i << " cannot be translated to PI: ";
+    pi_desired.push_back(*std::move(translated[i]));
+  }
+  return DiffTableEntries(info, pi_desired, installed, pool);
+}
+
+absl::Status ReconcileTableEntries(P4RuntimeSession* session,
+                                   const CompiledIrP4Info& info,
+                                   absl::Span<const TableEntry> desired,
+                                   const WriteBatchOptions& options,
+                                   gutil::ThreadPool* pool) {
+  ASSIGN_OR_RETURN(const P4InfoReferences references,
+                   P4InfoReferences::Create(info.info()));
+  ASSIGN_OR_RETURN(std::vector<TableEntry> installed,
+                   ReadPiTableEntries(session));
+  ASSIGN_OR_RETURN(TableEntryDiff diff,
+                   DiffTableEntries(info, desired, installed, pool));
+  RETURN_IF_ERROR(
+      SendPiUpdatesInSequence(session, references, diff.inserts, options))
+          .SetPrepend()
+      << "Failed to insert entries: ";
+  RETURN_IF_ERROR(
+      SendPiUpdatesInSequence(session, references, diff.modifies, options))
+          .SetPrepend()
+      << "Failed to modify entries: ";
+  RETURN_IF_ERROR(
+      SendPiUpdatesInSequence(session, references, diff.deletes, options))
+          .SetPrepend()
+      << "Failed to delete entries: ";
+  return absl::OkStatus();
+}
+
+}  // namespace pdpi
@@ -0,0 +1,90 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_P4_PDPI_RECONCILIATION_H_
+#define GOOGLE_P4_PDPI_RECONCILIATION_H_
+
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "gutil/thread_pool.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
+#include "p4_pdpi/connection_management.h"
+#include "p4_pdpi/entity_management.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+// The PI (program independent) updates that turn the table entries installed
+// on a switch into the desired ones. Entries are matched up by their
+// TableEntryKey, so the diff is minimal: every desired entry that is installed
+// unchanged needs no update.
+//
+// Desired entries may refer to other desired entries (e.g. a route to its
+// nexthop), and installed entries to other installed entries. To never break
+// such a reference, apply the inserts first, then the modifies, then the
+// deletes, each only after the switch applied all updates of the previous
+// kind (see ReconcileTableEntries).
+struct TableEntryDiff {
+  // INSERTs of the desired entries that are not installed, in the order of
+  // the desired entries.
+  std::vector<p4::v1::Update> inserts;
+  // MODIFYs to the desired entries that are installed with a different action,
+  // meter config or metadata, in the order of the desired entries.
+  std::vector<p4::v1::Update> modifies;
+  // DELETEs of the installed entries that are not desired, in the order of the
+  // installed entries.
+  std::vector<p4::v1::Update> deletes;
+};
+
+// Returns the diff from the `installed` entries (e.g. as returned by
+// ReadPiTableEntries) to the `desired` ones. Counter data is ignored, since it
+// is maintained by the switch. Returns InvalidArgument if the key of an entry
+// cannot be computed (see PiTableEntryKey), or if two desired or two installed
+// entries have the same key.
+//
+// Entries are hash-partitioned by key, and the partitions are diffed in
+// parallel on the threads of `pool` and the calling thread, or only on the
+// calling thread if `pool` is nullptr. Takes expected linear time in the
+// number of entries. Takes the compiled form of the IrP4Info, so that callers
+// that diff repeatedly (e.g. on every reconciliation) compile it only once.
+absl::StatusOr<TableEntryDiff> DiffTableEntries(
+    const CompiledIrP4Info& info, absl::Span<const p4::v1::TableEntry> desired,
+    absl::Span<const p4::v1::TableEntry> installed,
+    gutil::ThreadPool* pool = nullptr);
+// Same as above, but for desired IR entries, which are translated to PI
+// first. Returns an error if a desired entry cannot be translated.
+absl::StatusOr<TableEntryDiff> DiffTableEntries(
+    const CompiledIrP4Info& info, absl::Span<const IrTableEntry> desired,
+    absl::Span<const p4::v1::TableEntry> installed,
+    gutil::ThreadPool* pool = nullptr);
+
+// Makes the table entries on the switch equal to the `desired` ones, by
+// reading the installed entries and sending the updates of their
+// DiffTableEntries, kind by kind in the order described at TableEntryDiff.
+// The updates of one kind are sent with SendPiUpdatesInSequence, so references
+// between them (see sequencing.h) are respected as well. Returns an error if
+// any update failed, without sending the updates of the remaining kinds.
+absl::Status ReconcileTableEntries(
+    P4RuntimeSession* session, const CompiledIrP4Info& info,
+    absl::Span<const p4::v1::TableEntry> desired,
+    const WriteBatchOptions& options = WriteBatchOptions(),
+    gutil::ThreadPool* pool = nullptr);
+
+}  // namespace pdpi
+
+#endif  // GOOGLE_P4_PDPI_RECONCILIATION_H_
@@ -0,0 +1,510 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/sequencing.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "google/protobuf/repeated_field.h"
+#include "gutil/status.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/utils/annotation_parser.h"
+#include "p4_pdpi/utils/ir.h"
+
+namespace pdpi {
+
+using ::p4::config::v1::MatchField;
+using ::p4::v1::Action;
+using ::p4::v1::FieldMatch;
+using ::p4::v1::TableAction;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+
+namespace sequencing_internal {
+
+// The match fields of a table that identify the entry a reference refers to.
+struct ReferredFields {
+  uint32_t table_id;
+  // In increasing order.
+  std::vector<uint32_t> match_field_ids;
+};
+
+// Match fields of a table or params of an action that together refer to an
+// entry.
+struct Reference {
+  // Index into References::referred_fields.
+  int referred_fields;
+  // The IDs of the referring match fields or params, in the order of the
+  // match fields they refer to.
+  std::vector<uint32_t> referring_ids;
+};
+
+// The references declared in a P4Info.
+struct References {
+  std::vector<ReferredFields> referred_fields;
+  // Indices into `referred_fields`, by table ID.
+  absl::flat_hash_map<uint32_t, std::vector<int>> referred_fields_by_table;
+  // The references of the match fields of tables, by table ID.
+  absl::flat_hash_map<uint32_t, std::vector<Reference>> references_by_table;
+  // The references of the params of actions, by action ID.
+  absl::flat_hash_map<uint32_t, std::vector<Reference>> references_by_action;
+  // The IDs of the tables that the entries of a table may refer to, in
+  // increasing order, by table ID.
+  absl::flat_hash_map<uint32_t, std::vector<uint32_t>> referred_tables_by_table;
+};
+
+}  // namespace sequencing_internal
+
+namespace {
+
+using ::pdpi::sequencing_internal::Reference;
+using ::pdpi::sequencing_internal::ReferredFields;
+using ::pdpi::sequencing_internal::References;
+
+// A @refers_to(<table alias>, <match field name>) annotation.
+struct RefersTo {
+  std::string table;
+  std::string match_field;
+};
+
+absl::StatusOr<RefersTo> ParseRefersTo(std::string body) {
+  std::vector<absl::string_view> args = absl::StrSplit(body, ',');
+  if (args.size() != 2) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Expected @refers_to(<table alias>, <match field name>), but got "
+              "@refers_to("
+           << body << ").";
+  }
+  return RefersTo{std::string(absl::StripAsciiWhitespace(args[0])),
+                  std::string(absl::StripAsciiWhitespace(args[1]))};
+}
+
+// Returns the @refers_to annotations among `annotations`.
+absl::StatusOr<std::vector<RefersTo>> GetRefersTo(
+    const google::protobuf::RepeatedPtrField<std::string>& annotations) {
+  auto refers_to = GetAllParsedAnnotations<RefersTo>("refers_to", annotations,
+                                                     ParseRefersTo);
+  if (absl::IsNotFound(refers_to.status())) return std::vector<RefersTo>();
+  return refers_to;
+}
+
+// Pairs of the IDs and annotations of the match fields of a table or the params
+// of an action.
+using Annotations = google::protobuf::RepeatedPtrField<std::string>;
+using AnnotationsById = std::vector<std::pair<uint32_t, const Annotations*>>;
+
+// Builds References from the @refers_to annotations of match fields and params.
+class ReferencesBuilder {
+ public:
+  explicit ReferencesBuilder(const IrP4Info& info) : info_(info) {}
+
+  // Returns the references of the match fields or params of one table or
+  // action, and adds the fields they refer to. `context` describes the match
+  // fields or params in error messages.
+  absl::StatusOr<std::vector<Reference>> MakeReferences(
+      absl::string_view context, const AnnotationsById& annotations_by_id) {
+    // Pairs of the referred-to match field ID and the referring ID, by the
+    // referred-to table ID.
+    std::map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> by_table;
+    for (const auto& [id, annotations] : annotations_by_id) {
+      ASSIGN_OR_RETURN(std::vector<RefersTo> refers_to,
+                       GetRefersTo(*annotations),
+                       _.SetPrepend() << context << " " << id << ": ");
+      for (const RefersTo& annotation : refers_to) {
+        auto table = info_.tables_by_name().find(annotation.table);
+        if (table == info_.tables_by_name().end()) {
+          return gutil::InvalidArgumentErrorBuilder()
+                 << context << " " << id << " refers to unknown table '"
+                 << annotation.table << "'.";
+        }
+        auto match_field =
+            table->second.match_fields_by_name().find(annotation.match_field);
+        if (match_field == table->second.match_fields_by_name().end()) {
+          return gutil::InvalidArgumentErrorBuilder()
+                 << context << " " << id << " refers to unknown match field '"
+                 << annotation.match_field << "' of table '"
+                 << annotation.table << "'.";
+        }
+        const MatchField& definition = match_field->second.match_field();
+        if (definition.match_type() != MatchField::EXACT &&
+            definition.match_type() != MatchField::OPTIONAL) {
+          return gutil::InvalidArgumentErrorBuilder()
+                 << context << " " << id << " refers to match field '"
+                 << annotation.match_field << "' of table '"
+                 << annotation.table
+                 << "', which is neither an exact nor an optional match.";
+        }
+        by_table[table->second.preamble().id()].push_back(
+            {definition.id(), id});
+      }
+    }
+
+    std::vector<Reference> references;
+    for (auto& [table_id, fields] : by_table) {
+      absl::c_sort(fields);
+      const bool distinct_fields =
+          absl::c_adjacent_find(fields, [](const auto& left,
+                                           const auto& right) {
+            return left.first == right.first;
+          }) == fields.end();
+      if (distinct_fields) {
+        // The fields refer to a single entry together.
+        Reference& reference = references.emplace_back();
+        std::vector<uint32_t> match_field_ids;
+        for (const auto& [match_field_id, referring_id] : fields) {
+          match_field_ids.push_back(match_field_id);
+          reference.referring_ids.push_back(referring_id);
+        }
+        reference.referred_fields =
+            GetReferredFields(table_id, std::move(match_field_ids));
+      } else {
+        // Several fields refer to the same match field (e.g. an ingress and an
+        // egress port), so each of them refers to an entry on its own.
+        for (const auto& [match_field_id, referring_id] : fields) {
+          references.push_back(
+              {GetReferredFields(table_id, {match_field_id}), {referring_id}});
+        }
+      }
+    }
+    return references;
+  }
+
+  References& references() { return references_; }
+
+ private:
+  // Returns the index of the given referred fields, adding them if needed.
+  int GetReferredFields(uint32_t table_id,
+                        std::vector<uint32_t> match_field_ids) {
+    auto [it, inserted] = indices_.try_emplace(
+        std::make_pair(table_id, match_field_ids),
+        references_.referred_fields.size());
+    if (inserted) {
+      references_.referred_fields_by_table[table_id].push_back(it->second);
+      references_.referred_fields.push_back(
+          {table_id, std::move(match_field_ids)});
+    }
+    return it->second;
+  }
+
+  const IrP4Info& info_;
+  References references_;
+  std::map<std::pair<uint32_t, std::vector<uint32_t>>, int> indices_;
+};
+
+// Adds the IDs of the tables that the references with the given `id` in
+// `references_by_id` refer to.
+void AddReferredTables(
+    const References& references,
+    const absl::flat_hash_map<uint32_t, std::vector<Reference>>&
+        references_by_id,
+    uint32_t id, std::set<uint32_t>& referred_tables) {
+  auto it = references_by_id.find(id);
+  if (it == references_by_id.end()) return;
+  for (const Reference& reference : it->second) {
+    referred_tables.insert(
+        references.referred_fields[reference.referred_fields].table_id);
+  }
+}
+
+absl::StatusOr<References> GetReferences(const IrP4Info& info) {
+  ReferencesBuilder builder(info);
+  for (const auto& [table_id, table] : info.tables_by_id()) {
+    AnnotationsById annotations_by_id;
+    for (const auto& [match_field_id, match_field] :
+         table.match_fields_by_id()) {
+      annotations_by_id.push_back(
+          {match_field_id, &match_field.match_field().annotations()});
+    }
+    ASSIGN_OR_RETURN(
+        std::vector<Reference> references,
+        builder.MakeReferences(
+            absl::StrCat("Match field of table '", table.preamble().alias(),
+                         "' with ID"),
+            annotations_by_id));
+    if (!references.empty()) {
+      builder.references().references_by_table[table_id] =
+          std::move(references);
+    }
+  }
+  for (const auto& [action_id, action] : info.actions_by_id()) {
+    AnnotationsById annotations_by_id;
+    for (const auto& [param_id, param] : action.params_by_id()) {
+      annotations_by_id.push_back({param_id, &param.param().annotations()});
+    }
+    ASSIGN_OR_RETURN(
+        std::vector<Reference> references,
+        builder.MakeReferences(
+            absl::StrCat("Param of action '", action.preamble().alias(),
+                         "' with ID"),
+            annotations_by_id));
+    if (!references.empty()) {
+      builder.references().references_by_action[action_id] =
+          std::move(references);
+    }
+  }
+  References& references = builder.references();
+  for (const auto& [table_id, table] : info.tables_by_id()) {
+    std::set<uint32_t> referred_tables;
+    AddReferredTables(references, references.references_by_table, table_id,
+                      referred_tables);
+    for (const IrActionReference& action : table.entry_actions()) {
+      AddReferredTables(references, references.references_by_action,
+                        action.action().preamble().id(), referred_tables);
+    }
+    if (!referred_tables.empty()) {
+      references.referred_tables_by_table[table_id].assign(
+          referred_tables.begin(), referred_tables.end());
+    }
+  }
+  return std::move(references);
+}
+
+// Appends `value` to the encoded key of a referred-to entry. Values are length
+// prefixed, so that keys of different values differ.
+void AppendValue(absl::string_view value, std::string* key) {
+  value = NormalizedToCanonicalByteStringView(value);
+  const uint32_t size = value.size();
+  key->append(reinterpret_cast<const char*>(&size), sizeof(size));
+  key->append(value.data(), value.size());
+}
+
+// Returns the encoded key by which a referred-to entry is found, i.e. the
+// index of its referred fields followed by their values, or an empty string if
+// a value is missing. `find_value` returns the value of a field by ID, or
+// nullptr if there is none.
+template <typename FindValue>
+std::string ReferenceKey(int referred_fields, absl::Span<const uint32_t> ids,
+                         const FindValue& find_value) {
+  std::string key(reinterpret_cast<const char*>(&referred_fields),
+                  sizeof(referred_fields));
+  for (uint32_t id : ids) {
+    const std::string* value = find_value(id);
+    if (value == nullptr) return "";
+    AppendValue(*value, &key);
+  }
+  return key;
+}
+
+// Returns the value of an exact or optional match, or nullptr if `entry` has
+// no such match on the given field.
+const std::string* FindMatchValue(const TableEntry& entry, uint32_t field_id) {
+  for (const FieldMatch& match : entry.match()) {
+    if (match.field_id() != field_id) continue;
+    if (match.has_exact()) return &match.exact().value();
+    if (match.has_optional()) return &match.optional().value();
+    return nullptr;
+  }
+  return nullptr;
+}
+
+const std::string* FindParamValue(const Action& action, uint32_t param_id) {
+  for (const Action::Param& param : action.params()) {
+    if (param.param_id() == param_id) return &param.value();
+  }
+  return nullptr;
+}
+
+// Appends the keys of the entries that `action` refers to.
+void AppendActionReferenceKeys(const References& references,
+                               const Action& action,
+                               std::vector<std::string>* keys) {
+  auto it = references.references_by_action.find(action.action_id());
+  if (it == references.references_by_action.end()) return;
+  for (const Reference& reference : it->second) {
+    std::string key = ReferenceKey(
+        reference.referred_fields, reference.referring_ids,
+        [&](uint32_t id) { return FindParamValue(action, id); });
+    if (!key.empty()) keys->push_back(std::move(key));
+  }
+}
+
+// Returns the keys of the entries that `entry` refers to with its match fields
+// and actions.
+std::vector<std::string> ReferenceKeys(const References& references,
+                                       const TableEntry& entry) {
+  std::vector<std::string> keys;
+  auto it = references.references_by_table.find(entry.table_id());
+  if (it != references.references_by_table.end()) {
+    for (const Reference& reference : it->second) {
+      std::string key = ReferenceKey(
+          reference.referred_fields, reference.referring_ids,
+          [&](uint32_t id) { return FindMatchValue(entry, id); });
+      if (!key.empty()) keys.push_back(std::move(key));
+    }
+  }
+  const TableAction& action = entry.action();
+  if (action.has_action()) {
+    AppendActionReferenceKeys(references, action.action(), &keys);
+  } else if (action.has_action_profile_action_set()) {
+    for (const auto& profile_action :
+         action.action_profile_action_set().action_profile_actions()) {
+      AppendActionReferenceKeys(references, profile_action.action(), &keys);
+    }
+  }
+  return keys;
+}
+
+// Returns the keys by which references can refer to `entry`.
+std::vector<std::string> ReferredKeys(const References& references,
+                                      const TableEntry& entry) {
+  std::vector<std::string> keys;
+  auto it = references.referred_fields_by_table.find(entry.table_id());
+  if (it == references.referred_fields_by_table.end()) return keys;
+  for (int referred_fields : it->second) {
+    std::string key = ReferenceKey(
+        referred_fields,
+        references.referred_fields[referred_fields].match_field_ids,
+        [&](uint32_t id) { return FindMatchValue(entry, id); });
+    if (!key.empty()) keys.push_back(std::move(key));
+  }
+  return keys;
+}
+
+bool IsDelete(const Update& update) { return update.type() == Update::DELETE; }
+
+}  // namespace
+
+absl::StatusOr<P4InfoReferences> P4InfoReferences::Create(
+    const IrP4Info& info) {
+  ASSIGN_OR_RETURN(References references, GetReferences(info));
+  return P4InfoReferences(
+      std::make_shared<const References>(std::move(references)));
+}
+
+std::vector<uint32_t> P4InfoReferences::ReferredTableIds(
+    uint32_t table_id) const {
+  auto it = references_->referred_tables_by_table.find(table_id);
+  if (it == references_->referred_tables_by_table.end()) return {};
+  return it->second;
+}
+
+absl::StatusOr<std::vector<std::vector<int>>> SequencePiUpdatesInBatches(
+    const P4InfoReferences& p4info_references,
+    absl::Span<const Update> updates) {
+  const References& references = p4info_references.references();
+  for (int i = 0; i < updates.size(); ++i) {
+    if (updates[i].type() == Update::UNSPECIFIED) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Update at index " << i << " has no type.";
+    }
+  }
+
+  // The INSERTs and DELETEs of the entries with a referred key, by key.
+  absl::flat_hash_map<std::string, absl::InlinedVector<int, 1>> inserts;
+  absl::flat_hash_map<std::string, absl::InlinedVector<int, 1>> deletes;
+  for (int i = 0; i < updates.size(); ++i) {
+    if (updates[i].type() == Update::MODIFY) continue;
+    auto& updates_by_key = IsDelete(updates[i]) ? deletes : inserts;
+    for (std::string& key :
+         ReferredKeys(references, updates[i].entity().table_entry())) {
+      updates_by_key[std::move(key)].push_back(i);
+    }
+  }
+
+  // An edge from update i to update j means that i must be applied before j.
+  std::vector<std::vector<int>> successors(updates.size());
+  std::vector<int> num_predecessors(updates.size(), 0);
+  for (int i = 0; i < updates.size(); ++i) {
+    const auto& updates_by_key = IsDelete(updates[i]) ? deletes : inserts;
+    for (const std::string& key :
+         ReferenceKeys(references, updates[i].entity().table_entry())) {
+      auto it = updates_by_key.find(key);
+      if (it == updates_by_key.end()) continue;
+      for (int j : it->second) {
+        if (i == j) continue;
+        // Referred-to entries are inserted before and deleted after the entries
+        // that refer to them.
+        if (IsDelete(updates[i])) {
+          successors[i].push_back(j);
+          ++num_predecessors[j];
+        } else {
+          successors[j].push_back(i);
+          ++num_predecessors[i];
+        }
+      }
+    }
+  }
+
+  // Assigns each update the length of the longest path to it (Kahn's
+  // algorithm), which is the earliest batch it can be in.
+  std::vector<int> levels(updates.size(), 0);
+  std::deque<int> ready;
+  for (int i = 0; i < updates.size(); ++i) {
+    if (num_predecessors[i] == 0) ready.push_back(i);
+  }
+  int num_sequenced = 0;
+  int num_insert_levels = 0;
+  while (!ready.empty()) {
+    const int i = ready.front();
+    ready.pop_front();
+    ++num_sequenced;
+    if (!IsDelete(updates[i])) {
+      num_insert_levels = std::max(num_insert_levels, levels[i] + 1);
+    }
+    for (int j : successors[i]) {
+      levels[j] = std::max(levels[j], levels[i] + 1);
+      if (--num_predecessors[j] == 0) ready.push_back(j);
+    }
+  }
+  if (num_sequenced < updates.size()) {
+    const int i = absl::c_find_if(num_predecessors,
+                                  [](int num) { return num > 0; }) -
+                  num_predecessors.begin();
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Cannot sequence updates whose entries refer to each other in a "
+              "cycle, e.g. update at index "
+           << i << ": " << updates[i].ShortDebugString();
+  }
+
+  std::vector<std::vector<int>> batches;
+  for (int i = 0; i < updates.size(); ++i) {
+    // DELETEs come after all INSERTs and MODIFYs.
+    const int batch =
+        IsDelete(updates[i]) ? num_insert_levels + levels[i] : levels[i];
+    if (batch >= batches.size()) batches.resize(batch + 1);
+    batches[batch].push_back(i);
+  }
+  return batches;
+}
+
+absl::StatusOr<std::vector<std::vector<int>>> SequencePiUpdatesInBatches(
+    const IrP4Info& info, absl::Span<const Update> updates) {
+  ASSIGN_OR_RETURN(const P4InfoReferences references,
+                   P4InfoReferences::Create(info));
+  return SequencePiUpdatesInBatches(references, updates);
+}
+
+}  // namespace pdpi
@@ -0,0 +1,96 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_P4_PDPI_SEQUENCING_H_
+#define GOOGLE_P4_PDPI_SEQUENCING_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+// Table entries may refer to entries of other tables, e.g. a nexthop to its
+// router interface and neighbor. Such references are declared in the P4Info by
+// annotating a match field or action param with
+//   @refers_to(<table alias>, <match field name>)
+// which means that its value is the value of the given exact or optional match
+// field of an entry in the given table. A match field or param may refer to
+// several tables, and when several match fields or params of a table or action
+// refer to the same table, they refer to a single entry of that table together
+// (e.g. to a neighbor by router interface and neighbor ID).
+//
+// A switch rejects entries that refer to entries that are not installed, and
+// deletions of entries that are referred to. This library orders updates such
+// that neither happens.
+
+namespace sequencing_internal {
+struct References;
+}  // namespace sequencing_internal
+
+// The references declared by the @refers_to annotations of a P4Info. Creating
+// them parses the annotations of all match fields and action params, so
+// callers that sequence updates repeatedly should create them once per P4Info.
+// Cheap to copy.
+class P4InfoReferences {
+ public:
+  // Returns InvalidArgument if a @refers_to annotation in `info` is malformed.
+  static absl::StatusOr<P4InfoReferences> Create(const IrP4Info& info);
+
+  // Returns the IDs of the tables that entries of the table with the given ID
+  // may refer to, in increasing order. May include `table_id` itself.
+  std::vector<uint32_t> ReferredTableIds(uint32_t table_id) const;
+
+  const sequencing_internal::References& references() const {
+    return *references_;
+  }
+
+ private:
+  explicit P4InfoReferences(
+      std::shared_ptr<const sequencing_internal::References> references)
+      : references_(std::move(references)) {}
+
+  std::shared_ptr<const sequencing_internal::References> references_;
+};
+
+// Returns the indices of `updates` in batches, such that sending the batches
+// one after the other, each only after the switch applied the previous one,
+// never inserts or modifies an entry before the entries it refers to are
+// inserted, and never deletes an entry before the entries that refer to it are
+// deleted. All INSERTs and MODIFYs come before all DELETEs. Every update is in
+// the earliest batch possible, so the updates of a batch can be sent in
+// parallel (e.g. with SendPiUpdates). Within a batch, indices are increasing.
+//
+// Only references between the given updates are considered, and only INSERTs
+// and DELETEs are referred to. Returns InvalidArgument if the inserted or the
+// deleted entries refer to each other in a cycle. Takes expected linear time
+// in the number of updates and references.
+absl::StatusOr<std::vector<std::vector<int>>> SequencePiUpdatesInBatches(
+    const P4InfoReferences& references,
+    absl::Span<const p4::v1::Update> updates);
+// Same as above, but creates the P4InfoReferences of `info` on every call.
+absl::StatusOr<std::vector<std::vector<int>>> SequencePiUpdatesInBatches(
+    const IrP4Info& info, absl::Span<const p4::v1::Update> updates);
+
+}  // namespace pdpi
+
+#endif  // GOOGLE_P4_PDPI_SEQUENCING_H_
@@ -0,0 +1,122 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/session_pool.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "grpcpp/channel.h"
+#include "gutil/status.h"
+#include "gutil/thread_pool.h"
+#include "p4/v1/p4runtime.grpc.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/connection_management.h"
+#include "p4_pdpi/entity_management.h"
+
+namespace pdpi {
+
+using ::p4::v1::TableEntry;
+
+P4RuntimeSessionPool::P4RuntimeSessionPool(
+    absl::Span<const P4RuntimeDevice> devices, int max_threads)
+    : devices_(devices.begin(), devices.end()),
+      sessions_(devices.size()),
+      // The calling thread takes part in all operations, so one thread less
+      // is enough to work on all devices at once.
+      thread_pool_(std::max(
+          0, std::min(static_cast<int>(devices.size()), max_threads) - 1)) {}
+
+std::unique_ptr<P4RuntimeSessionPool> P4RuntimeSessionPool::Create(
+    absl::Span<const P4RuntimeDevice> devices,
+    const std::shared_ptr<grpc::ChannelCredentials>& credentials,
+    absl::uint128 election_id, int max_threads) {
+  // Using `new` to access a private constructor.
+  auto pool =
+      absl::WrapUnique(new P4RuntimeSessionPool(devices, max_threads));
+
+  absl::flat_hash_map<std::string, std::shared_ptr<grpc::Channel>>
+      channel_by_address;
+  for (const P4RuntimeDevice& device : devices) {
+    auto& channel = channel_by_address[device.address];
+    if (channel == nullptr) {
+      channel = CreateP4RuntimeChannel(device.address, credentials);
+    }
+  }
+
+  // Session::Create blocks until the device replied to the arbitration
+  // request, so all devices are arbitrated concurrently.
+  gutil::ParallelFor(&pool->thread_pool_, devices.size(), [&](int i) {
+    const P4RuntimeDevice& device = devices[i];
+    absl::StatusOr<std::unique_ptr<P4RuntimeSession>> session =
+        P4RuntimeSession::Create(
+            p4::v1::P4Runtime::NewStub(channel_by_address.at(device.address)),
+            device.device_id, election_id);
+    if (!session.ok()) {
+      absl::Status status = gutil::StatusBuilder(session.status()).SetPrepend()
+                            << "Failed to establish session with device "
+                            << device.device_id << " at " << device.address
+                            << ": ";
+      session = status;
+    }
+    pool->sessions_[i] = std::move(session);
+  });
+  return pool;
+}
+
+absl::StatusOr<P4RuntimeSession*> P4RuntimeSessionPool::session(int i) const {
+  if (!sessions_[i].ok()) return sessions_[i].status();
+  return sessions_[i]->get();
+}
+
+std::vector<absl::Status> P4RuntimeSessionPool::ForEachSession(
+    const std::function<absl::Status(P4RuntimeSession*)>& fn) {
+  std::vector<absl::Status> results(size());
+  gutil::ParallelFor(&thread_pool_, size(), [&](int i) {
+    absl::StatusOr<P4RuntimeSession*> session = this->session(i);
+    results[i] = session.ok() ? fn(*session) : session.status();
+  });
+  return results;
+}
+
+std::vector<absl::Status> P4RuntimeSessionPool::InstallPiTableEntries(
+    absl::Span<const TableEntry> pi_entries, const WriteBatchOptions& options) {
+  return ForEachSession([&](P4RuntimeSession* session) {
+    return pdpi::InstallPiTableEntries(session, pi_entries, options);
+  });
+}
+
+std::vector<absl::StatusOr<std::vector<TableEntry>>>
+P4RuntimeSessionPool::ReadPiTableEntries() {
+  std::vector<absl::StatusOr<std::vector<TableEntry>>> results(size());
+  gutil::ParallelFor(&thread_pool_, size(), [&](int i) {
+    absl::StatusOr<P4RuntimeSession*> session = this->session(i);
+    if (session.ok()) {
+      results[i] = pdpi::ReadPiTableEntries(*session);
+    } else {
+      results[i] = session.status();
+    }
+  });
+  return results;
+}
+
+}  // namespace pdpi
@@ -0,0 +1,98 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_P4_PDPI_SESSION_POOL_H_
+#define GOOGLE_P4_PDPI_SESSION_POOL_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "grpcpp/security/credentials.h"
+#include "gutil/thread_pool.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/connection_management.h"
+#include "p4_pdpi/entity_management.h"
+
+namespace pdpi {
+
+// Identifies a P4Runtime device.
+struct P4RuntimeDevice {
+  // The address of the P4Runtime server of the device.
+  std::string address;
+  uint32_t device_id;
+};
+
+// Sessions with many devices, which are established and used concurrently.
+// The results of all operations are per device, in the order in which the
+// devices were given to Create.
+class P4RuntimeSessionPool {
+ public:
+  // Establishes sessions with all `devices` concurrently, using up to
+  // `max_threads` threads. Devices with the same address share a gRPC channel.
+  // Failing to connect to a device does not affect the other devices; see
+  // `session`.
+  static std::unique_ptr<P4RuntimeSessionPool> Create(
+      absl::Span<const P4RuntimeDevice> devices,
+      const std::shared_ptr<grpc::ChannelCredentials>& credentials,
+      absl::uint128 election_id = TimeBasedElectionId(),
+      int max_threads = 64);
+
+  // Disable copy semantics.
+  P4RuntimeSessionPool(const P4RuntimeSessionPool&) = delete;
+  P4RuntimeSessionPool& operator=(const P4RuntimeSessionPool&) = delete;
+
+  // Returns the number of devices.
+  int size() const { return devices_.size(); }
+  // Returns the i-th device.
+  const P4RuntimeDevice& device(int i) const { return devices_[i]; }
+  // Returns the session with the i-th device, or the reason why it could not
+  // be established.
+  absl::StatusOr<P4RuntimeSession*> session(int i) const;
+
+  // Calls `fn` on the sessions with all devices concurrently and returns its
+  // results. Devices without a session get the reason why it could not be
+  // established instead.
+  std::vector<absl::Status> ForEachSession(
+      const std::function<absl::Status(P4RuntimeSession*)>& fn);
+
+  // Installs the given PI (program independent) table entries on all devices.
+  std::vector<absl::Status> InstallPiTableEntries(
+      absl::Span<const p4::v1::TableEntry> pi_entries,
+      const WriteBatchOptions& options = WriteBatchOptions());
+
+  // Reads the PI (program independent) table entries of all devices.
+  std::vector<absl::StatusOr<std::vector<p4::v1::TableEntry>>>
+  ReadPiTableEntries();
+
+ private:
+  P4RuntimeSessionPool(absl::Span<const P4RuntimeDevice> devices,
+                       int max_threads);
+
+  std::vector<P4RuntimeDevice> devices_;
+  // The i-th element is the session with the i-th device.
+  std::vector<absl::StatusOr<std::unique_ptr<P4RuntimeSession>>> sessions_;
+  gutil::ThreadPool thread_pool_;
+};
+
+}  // namespace pdpi
+
+#endif  // GOOGLE_P4_PDPI_SESSION_POOL_H_
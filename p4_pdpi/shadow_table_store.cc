@@ -0,0 +1,200 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/shadow_table_store.h"
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "google/protobuf/util/message_differencer.h"
+#include "google/rpc/code.pb.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/table_entry_key.h"
+
+namespace pdpi {
+
+using ::google::protobuf::util::MessageDifferencer;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+
+const TableEntry* ShadowTableStore::Lookup(const TableEntry& entry) const {
+  auto table = tables_.find(entry.table_id());
+  if (table == tables_.end()) return nullptr;
+  absl::StatusOr<TableEntryKey> key = PiTableEntryKey(info_, entry);
+  if (!key.ok()) return nullptr;
+  auto it = table->second.find(*key);
+  if (it == table->second.end()) return nullptr;
+  return &it->second;
+}
+
+absl::Status ShadowTableStore::Insert(TableEntry entry) {
+  ASSIGN_OR_RETURN(TableEntryKey key, PiTableEntryKey(info_, entry));
+  Table& table = tables_[entry.table_id()];
+  if (!table.try_emplace(std::move(key), std::move(entry)).second) {
+    return gutil::AlreadyExistsErrorBuilder()
+           << "Table entry is already installed.";
+  }
+  ++size_;
+  return absl::OkStatus();
+}
+
+absl::Status ShadowTableStore::Modify(TableEntry entry) {
+  ASSIGN_OR_RETURN(TableEntryKey key, PiTableEntryKey(info_, entry));
+  auto table = tables_.find(entry.table_id());
+  if (table != tables_.end()) {
+    auto it = table->second.find(key);
+    if (it != table->second.end()) {
+      it->second = std::move(entry);
+      return absl::OkStatus();
+    }
+  }
+  return gutil::NotFoundErrorBuilder() << "Table entry is not installed.";
+}
+
+absl::Status ShadowTableStore::Delete(const TableEntry& entry) {
+  ASSIGN_OR_RETURN(TableEntryKey key, PiTableEntryKey(info_, entry));
+  auto table = tables_.find(entry.table_id());
+  if (table == tables_.end() || table->second.erase(key) == 0) {
+    return gutil::NotFoundErrorBuilder() << "Table entry is not installed.";
+  }
+  --size_;
+  return absl::OkStatus();
+}
+
+absl::Status ShadowTableStore::Apply(const Update& update) {
+  if (!update.entity().has_table_entry()) return absl::OkStatus();
+  const TableEntry& entry = update.entity().table_entry();
+  switch (update.type()) {
+    case Update::INSERT:
+      return Insert(entry);
+    case Update::MODIFY:
+      return Modify(entry);
+    case Update::DELETE:
+      return Delete(entry);
+    default:
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Invalid update type: " << Update::Type_Name(update.type());
+  }
+}
+
+absl::Status ShadowTableStore::ApplyWriteResponse(
+    absl::Span<const Update> updates, const IrWriteResponse& response) {
+  if (response.statuses_size() != updates.size()) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Write response has " << response.statuses_size()
+           << " statuses, but " << updates.size() << " updates were sent.";
+  }
+  absl::Status out_of_sync;
+  for (int i = 0; i < updates.size(); ++i) {
+    if (response.statuses(i).code() != google::rpc::OK) continue;
+    const Update& update = updates[i];
+    absl::Status status = Apply(update);
+    if (status.ok()) continue;
+    // Make the shadow match the switch again. Failed DELETEs need no repair,
+    // since the entry is not installed either way, and neither do entries
+    // without a key, which the switch should not have accepted.
+    if (update.type() == Update::INSERT || update.type() == Update::MODIFY) {
+      const TableEntry& entry = update.entity().table_entry();
+      absl::StatusOr<TableEntryKey> key = PiTableEntryKey(info_, entry);
+      if (key.ok() && tables_[entry.table_id()]
+                          .insert_or_assign(*std::move(key), entry)
+                          .second) {
+        ++size_;
+      }
+    }
+    if (out_of_sync.ok()) {
+      out_of_sync = gutil::InternalErrorBuilder()
+                    << "Shadow table store is out of sync with the switch, "
+                    << "which accepted update " << i << ": "
+                    << status.message() << " Update: "
+                    << update.ShortDebugString();
+    }
+  }
+  return out_of_sync;
+}
+
+std::vector<Update> ShadowTableStore::RemoveDuplicateInserts(
+    absl::Span<const Update> updates) const {
+  // The entries that the earlier `updates` leave installed, by key, or nullptr
+  // for entries that they delete. Entries of other keys are as in the store.
+  absl::flat_hash_map<TableEntryKey, const TableEntry*> written;
+  std::vector<Update> result;
+  result.reserve(updates.size());
+  for (const Update& update : updates) {
+    if (!update.entity().has_table_entry()) {
+      result.push_back(update);
+      continue;
+    }
+    const TableEntry& entry = update.entity().table_entry();
+    // Invalid entries are kept, for the switch to reject them.
+    absl::StatusOr<TableEntryKey> key = PiTableEntryKey(info_, entry);
+    if (!key.ok()) {
+      result.push_back(update);
+      continue;
+    }
+    const TableEntry* installed = nullptr;
+    if (auto written_it = written.find(*key); written_it != written.end()) {
+      installed = written_it->second;
+    } else if (auto table = tables_.find(entry.table_id());
+               table != tables_.end()) {
+      auto it = table->second.find(*key);
+      if (it != table->second.end()) installed = &it->second;
+    }
+    switch (update.type()) {
+      case Update::INSERT:
+        if (installed != nullptr &&
+            MessageDifferencer::Equals(*installed, entry)) {
+          continue;
+        }
+        // Inserting an entry with the key of another entry fails.
+        if (installed == nullptr) written[*key] = &entry;
+        break;
+      case Update::MODIFY:
+        if (installed != nullptr) written[*key] = &entry;
+        break;
+      case Update::DELETE:
+        written[*key] = nullptr;
+        break;
+      default:
+        break;
+    }
+    result.push_back(update);
+  }
+  return result;
+}
+
+std::vector<TableEntry> ShadowTableStore::GetTableEntries(
+    uint32_t table_id) const {
+  std::vector<TableEntry> entries;
+  auto table = tables_.find(table_id);
+  if (table == tables_.end()) return entries;
+  entries.reserve(table->second.size());
+  for (const auto& [key, entry] : table->second) entries.push_back(entry);
+  return entries;
+}
+
+void ShadowTableStore::Clear() {
+  tables_.clear();
+  size_ = 0;
+}
+
+}  // namespace pdpi
@@ -0,0 +1,111 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_P4_PDPI_SHADOW_TABLE_STORE_H_
+#define GOOGLE_P4_PDPI_SHADOW_TABLE_STORE_H_
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/table_entry_key.h"
+
+namespace pdpi {
+
+// A shadow of the PI (program independent) table entries installed on a
+// switch. It is kept up to date with the updates that the switch accepted
+// (see ApplyWriteResponse), so that callers can tell what is installed without
+// reading the switch.
+//
+// Like on the switch, an entry is identified by its TableEntryKey, so the order
+// of the match fields and leading zeros in bytestrings do not matter. All
+// operations on a single entry take expected constant time. Operations on
+// entries whose key cannot be computed (see PiTableEntryKey) fail, and such
+// entries are never installed.
+class ShadowTableStore {
+ public:
+  // Creates an empty store for entries of the tables in `info`.
+  explicit ShadowTableStore(IrP4Info info) : info_(std::move(info)) {}
+
+  // Returns the installed entry with the same key as `entry`, or nullptr if
+  // there is none.
+  const p4::v1::TableEntry* Lookup(const p4::v1::TableEntry& entry) const;
+  bool Contains(const p4::v1::TableEntry& entry) const {
+    return Lookup(entry) != nullptr;
+  }
+
+  // Adds `entry`. Returns AlreadyExists if an entry with the same key is
+  // installed.
+  absl::Status Insert(p4::v1::TableEntry entry);
+  // Replaces the installed entry with the same key as `entry`. Returns NotFound
+  // if there is none.
+  absl::Status Modify(p4::v1::TableEntry entry);
+  // Removes the installed entry with the same key as `entry`. Returns NotFound
+  // if there is none.
+  absl::Status Delete(const p4::v1::TableEntry& entry);
+
+  // Applies `update` with Insert, Modify or Delete. Updates of entities other
+  // than table entries are ignored.
+  absl::Status Apply(const p4::v1::Update& update);
+
+  // Applies the `updates` whose status in `response` is OK, e.g. the updates
+  // given to and the response returned by SendPiUpdates. Returns
+  // InvalidArgument if `response` does not have one status per update. Updates
+  // that the switch accepted but that cannot be applied (e.g. an INSERT of an
+  // installed entry) mean that the shadow was out of sync with the switch: they
+  // are still applied, such that the shadow matches the switch again, and an
+  // Internal error describing the first of them is returned.
+  absl::Status ApplyWriteResponse(absl::Span<const p4::v1::Update> updates,
+                                  const IrWriteResponse& response);
+
+  // Returns `updates` without the INSERTs of table entries that are already
+  // installed, or that the earlier updates in `updates` install, which the
+  // switch would reject with ALREADY_EXISTS. Only INSERTs of entries that are
+  // equal to the installed entry, including their action, are removed: INSERTs
+  // that conflict with an installed entry of the same key are kept, for the
+  // switch to reject them. Earlier INSERTs, MODIFYs and DELETEs in `updates`
+  // are taken into account, e.g. an INSERT after a DELETE of the same entry is
+  // kept.
+  std::vector<p4::v1::Update> RemoveDuplicateInserts(
+      absl::Span<const p4::v1::Update> updates) const;
+
+  // Returns the installed entries of the table with the given ID, in no
+  // particular order.
+  std::vector<p4::v1::TableEntry> GetTableEntries(uint32_t table_id) const;
+
+  // Returns the number of installed entries.
+  int size() const { return size_; }
+  // Removes all entries, e.g. after the switch was cleared.
+  void Clear();
+
+ private:
+  using Table = absl::flat_hash_map<TableEntryKey, p4::v1::TableEntry>;
+
+  CompiledIrP4Info info_;
+  // Installed entries by table ID and key. Tables without entries may be
+  // missing.
+  absl::flat_hash_map<uint32_t, Table> tables_;
+  int size_ = 0;
+};
+
+}  // namespace pdpi
+
+#endif  // GOOGLE_P4_PDPI_SHADOW_TABLE_STORE_H_
@@ -0,0 +1,342 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/table_entry_key.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "gutil/collections.h"
+#include "gutil/status.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/utils/ir.h"
+
+namespace pdpi {
+
+using ::p4::config::v1::MatchField;
+
+// Encodes the fields of a TableEntryKey.
+class TableEntryKeyBuilder {
+ public:
+  TableEntryKeyBuilder(uint32_t table_id, int32_t priority) {
+    key_.table_id_ = table_id;
+    key_.priority_ = priority;
+  }
+
+  void AppendVarint(uint64_t value) {
+    while (value >= 0x80) {
+      key_.matches_.push_back(static_cast<char>(value | 0x80));
+      value >>= 7;
+    }
+    key_.matches_.push_back(static_cast<char>(value));
+  }
+  void AppendBytes(absl::string_view bytes) {
+    key_.matches_.insert(key_.matches_.end(), bytes.begin(), bytes.end());
+  }
+
+  TableEntryKey Build() && { return std::move(key_); }
+
+ private:
+  TableEntryKey key_;
+};
+
+namespace {
+
+// Lookups with the same interface for IrP4Info and CompiledIrP4Info.
+const IrTableDefinition* FindTableById(const IrP4Info& info, uint32_t id) {
+  return gutil::FindOrNull(info.tables_by_id(), id);
+}
+const CompiledIrTable* FindTableById(const CompiledIrP4Info& info,
+                                     uint32_t id) {
+  return info.FindTableById(id);
+}
+const IrTableDefinition* FindTableByName(const IrP4Info& info,
+                                         const std::string& name) {
+  return gutil::FindOrNull(info.tables_by_name(), name);
+}
+const CompiledIrTable* FindTableByName(const CompiledIrP4Info& info,
+                                       const std::string& name) {
+  return info.FindTableByName(name);
+}
+const IrTableDefinition& Definition(const IrTableDefinition& table) {
+  return table;
+}
+const IrTableDefinition& Definition(const CompiledIrTable& table) {
+  return table.definition();
+}
+const IrMatchFieldDefinition* FindMatchField(const IrTableDefinition& table,
+                                             const p4::v1::FieldMatch& match) {
+  return gutil::FindOrNull(table.match_fields_by_id(), match.field_id());
+}
+const IrMatchFieldDefinition* FindMatchField(const CompiledIrTable& table,
+                                             const p4::v1::FieldMatch& match) {
+  return table.FindMatchFieldById(match.field_id());
+}
+const IrMatchFieldDefinition* FindMatchField(const IrTableDefinition& table,
+                                             const IrMatch& match) {
+  return gutil::FindOrNull(table.match_fields_by_name(), match.name());
+}
+const IrMatchFieldDefinition* FindMatchField(const CompiledIrTable& table,
+                                             const IrMatch& match) {
+  return table.FindMatchFieldByName(match.name());
+}
+
+// A match field of an entry, with its definition.
+template <typename Match>
+struct DefinedMatch {
+  const IrMatchFieldDefinition* definition;
+  const Match* match;
+
+  uint32_t id() const { return definition->match_field().id(); }
+};
+
+// Returns `matches` with their definitions in `table`, in field ID order.
+template <typename Match, typename Table, typename Matches>
+absl::StatusOr<absl::InlinedVector<DefinedMatch<Match>, 16>> SortedMatches(
+    const Table& table, const Matches& matches) {
+  absl::InlinedVector<DefinedMatch<Match>, 16> result;
+  for (const Match& match : matches) {
+    const IrMatchFieldDefinition* definition = FindMatchField(table, match);
+    if (definition == nullptr) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Match field " << match.ShortDebugString()
+             << " does not exist in table \""
+             << Definition(table).preamble().alias() << "\"";
+    }
+    result.push_back({definition, &match});
+  }
+  absl::c_sort(result,
+               [](const DefinedMatch<Match>& left,
+                  const DefinedMatch<Match>& right) {
+                 return left.id() < right.id();
+               });
+  for (int i = 1; i < result.size(); ++i) {
+    if (result[i - 1].id() == result[i].id()) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Duplicate match field \""
+             << result[i].definition->match_field().name() << "\"";
+    }
+  }
+  return result;
+}
+
+// Returns an error unless the match has the match type of its definition, as
+// indicated by `has_expected_type`.
+absl::Status CheckMatchType(const IrMatchFieldDefinition& definition,
+                            bool has_expected_type) {
+  if (has_expected_type) return absl::OkStatus();
+  return gutil::InvalidArgumentErrorBuilder()
+         << "Expected " << MatchField::MatchType_Name(
+                               definition.match_field().match_type())
+         << " match for match field \"" << definition.match_field().name()
+         << "\"";
+}
+
+// Appends the value of the match field with the given definition. String
+// values have no bitwidth, so they are prefixed by their length instead.
+absl::Status AppendPiValue(const IrMatchFieldDefinition& definition,
+                           absl::string_view value,
+                           TableEntryKeyBuilder& builder) {
+  if (definition.format() == Format::STRING) {
+    value = NormalizedToCanonicalByteStringView(value);
+    builder.AppendVarint(value.size());
+    builder.AppendBytes(value);
+    return absl::OkStatus();
+  }
+  const int bitwidth = definition.match_field().bitwidth();
+  if (bitwidth <= InlineByteString::kCapacity * kNumBitsInByte) {
+    InlineByteString normalized;
+    RETURN_IF_ERROR(ArbitraryToNormalizedByteString(value, bitwidth,
+                                                    &normalized));
+    builder.AppendBytes(normalized.view());
+  } else {
+    ASSIGN_OR_RETURN(std::string normalized,
+                     ArbitraryToNormalizedByteString(value, bitwidth));
+    builder.AppendBytes(normalized);
+  }
+  return absl::OkStatus();
+}
+
+// Returns the format case of IR values of the given format.
+IrValue::FormatCase FormatCase(Format format) {
+  switch (format) {
+    case Format::MAC:
+      return IrValue::kMac;
+    case Format::IPV4:
+      return IrValue::kIpv4;
+    case Format::IPV6:
+      return IrValue::kIpv6;
+    case Format::STRING:
+      return IrValue::kStr;
+    case Format::HEX_STRING:
+      return IrValue::kHexStr;
+    default:
+      return IrValue::FORMAT_NOT_SET;
+  }
+}
+
+absl::Status AppendIrValue(const IrMatchFieldDefinition& definition,
+                           const IrValue& value,
+                           TableEntryKeyBuilder& builder) {
+  if (value.format_case() != FormatCase(definition.format())) {
+    // Produces the error message.
+    RETURN_IF_ERROR(ValidateIrValueFormat(value, definition.format()));
+  }
+  if (definition.format() == Format::STRING) {
+    return AppendPiValue(definition, value.str(), builder);
+  }
+  const int bitwidth = definition.match_field().bitwidth();
+  if (bitwidth <= InlineByteString::kCapacity * kNumBitsInByte) {
+    InlineByteString normalized;
+    RETURN_IF_ERROR(IrValueToNormalizedByteString(value, bitwidth,
+                                                  &normalized));
+    builder.AppendBytes(normalized.view());
+  } else {
+    ASSIGN_OR_RETURN(std::string normalized,
+                     IrValueToNormalizedByteString(value, bitwidth));
+    builder.AppendBytes(normalized);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status AppendPiMatch(const IrMatchFieldDefinition& definition,
+                           const p4::v1::FieldMatch& match,
+                           TableEntryKeyBuilder& builder) {
+  builder.AppendVarint(definition.match_field().id());
+  switch (definition.match_field().match_type()) {
+    case MatchField::EXACT:
+      RETURN_IF_ERROR(CheckMatchType(definition, match.has_exact()));
+      return AppendPiValue(definition, match.exact().value(), builder);
+    case MatchField::LPM:
+      RETURN_IF_ERROR(CheckMatchType(definition, match.has_lpm()));
+      RETURN_IF_ERROR(AppendPiValue(definition, match.lpm().value(), builder));
+      builder.AppendVarint(match.lpm().prefix_len());
+      return absl::OkStatus();
+    case MatchField::TERNARY:
+      RETURN_IF_ERROR(CheckMatchType(definition, match.has_ternary()));
+      RETURN_IF_ERROR(
+          AppendPiValue(definition, match.ternary().value(), builder));
+      return AppendPiValue(definition, match.ternary().mask(), builder);
+    case MatchField::OPTIONAL:
+      RETURN_IF_ERROR(CheckMatchType(definition, match.has_optional()));
+      return AppendPiValue(definition, match.optional().value(), builder);
+    default:
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unsupported match type \""
+             << MatchField::MatchType_Name(
+                    definition.match_field().match_type())
+             << "\" in match field \"" << definition.match_field().name()
+             << "\"";
+  }
+}
+
+absl::Status AppendIrMatch(const IrMatchFieldDefinition& definition,
+                           const IrMatch& match,
+                           TableEntryKeyBuilder& builder) {
+  builder.AppendVarint(definition.match_field().id());
+  switch (definition.match_field().match_type()) {
+    case MatchField::EXACT:
+      RETURN_IF_ERROR(CheckMatchType(definition, match.has_exact()));
+      return AppendIrValue(definition, match.exact(), builder);
+    case MatchField::LPM:
+      RETURN_IF_ERROR(CheckMatchType(definition, match.has_lpm()));
+      RETURN_IF_ERROR(AppendIrValue(definition, match.lpm().value(), builder));
+      builder.AppendVarint(match.lpm().prefix_length());
+      return absl::OkStatus();
+    case MatchField::TERNARY:
+      RETURN_IF_ERROR(CheckMatchType(definition, match.has_ternary()));
+      RETURN_IF_ERROR(
+          AppendIrValue(definition, match.ternary().value(), builder));
+      return AppendIrValue(definition, match.ternary().mask(), builder);
+    case MatchField::OPTIONAL:
+      RETURN_IF_ERROR(CheckMatchType(definition, match.has_optional()));
+      return AppendIrValue(definition, match.optional().value(), builder);
+    default:
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unsupported match type \""
+             << MatchField::MatchType_Name(
+                    definition.match_field().match_type())
+             << "\" in match field \"" << definition.match_field().name()
+             << "\"";
+  }
+}
+
+template <typename Info>
+absl::StatusOr<TableEntryKey> PiTableEntryKeyImpl(
+    const Info& info, const p4::v1::TableEntry& pi) {
+  const auto* table = FindTableById(info, pi.table_id());
+  if (table == nullptr) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Table ID " << pi.table_id() << " does not exist in P4Info";
+  }
+  ASSIGN_OR_RETURN(auto matches,
+                   SortedMatches<p4::v1::FieldMatch>(*table, pi.match()));
+  TableEntryKeyBuilder builder(pi.table_id(), pi.priority());
+  for (const auto& match : matches) {
+    RETURN_IF_ERROR(AppendPiMatch(*match.definition, *match.match, builder));
+  }
+  return std::move(builder).Build();
+}
+
+template <typename Info>
+absl::StatusOr<TableEntryKey> IrTableEntryKeyImpl(const Info& info,
+                                                  const IrTableEntry& ir) {
+  const auto* table = FindTableByName(info, ir.table_name());
+  if (table == nullptr) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Table name \"" << ir.table_name()
+           << "\" does not exist in P4Info";
+  }
+  ASSIGN_OR_RETURN(auto matches, SortedMatches<IrMatch>(*table, ir.matches()));
+  TableEntryKeyBuilder builder(Definition(*table).preamble().id(),
+                               ir.priority());
+  for (const auto& match : matches) {
+    RETURN_IF_ERROR(AppendIrMatch(*match.definition, *match.match, builder));
+  }
+  return std::move(builder).Build();
+}
+
+}  // namespace
+
+absl::StatusOr<TableEntryKey> PiTableEntryKey(const IrP4Info& info,
+                                              const p4::v1::TableEntry& pi) {
+  return PiTableEntryKeyImpl(info, pi);
+}
+
+absl::StatusOr<TableEntryKey> PiTableEntryKey(const CompiledIrP4Info& info,
+                                              const p4::v1::TableEntry& pi) {
+  return PiTableEntryKeyImpl(info, pi);
+}
+
+absl::StatusOr<TableEntryKey> IrTableEntryKey(const IrP4Info& info,
+                                              const IrTableEntry& ir) {
+  return IrTableEntryKeyImpl(info, ir);
+}
+
+absl::StatusOr<TableEntryKey> IrTableEntryKey(const CompiledIrP4Info& info,
+                                              const IrTableEntry& ir) {
+  return IrTableEntryKeyImpl(info, ir);
+}
+
+}  // namespace pdpi
@@ -0,0 +1,107 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_P4_PDPI_TABLE_ENTRY_KEY_H_
+#define GOOGLE_P4_PDPI_TABLE_ENTRY_KEY_H_
+
+#include <stdint.h>
+
+#include <tuple>
+#include <utility>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+// The key of a table entry, i.e. its table, match fields and priority, which
+// identify the entry on a switch. Keys of entries that only differ in the
+// order of their match fields or in the representation of their values (e.g.
+// PI bytestrings with leading zeros, or the same entry in PI and IR) are equal.
+//
+// Keys support absl::Hash, and cheap equality and ordering, so they can be used
+// to deduplicate and diff table entries. The match fields are stored in field
+// ID order, each as its ID followed by its normalized values, so a key is a
+// single bytestring that is stored inline for keys of up to kInlineCapacity
+// bytes. Computing such a key does not allocate memory.
+class TableEntryKey {
+ public:
+  static constexpr int kInlineCapacity = 64;
+
+  // The key of an entry without match fields of the table with ID 0.
+  TableEntryKey() = default;
+
+  uint32_t table_id() const { return table_id_; }
+  int32_t priority() const { return priority_; }
+  // The encoded match fields, as described above.
+  absl::string_view matches() const {
+    return absl::string_view(matches_.data(), matches_.size());
+  }
+
+  friend bool operator==(const TableEntryKey& left,
+                         const TableEntryKey& right) {
+    return left.table_id_ == right.table_id_ &&
+           left.priority_ == right.priority_ &&
+           left.matches() == right.matches();
+  }
+  friend bool operator!=(const TableEntryKey& left,
+                         const TableEntryKey& right) {
+    return !(left == right);
+  }
+  // Keys are ordered by table ID, then priority, then encoded match fields.
+  friend bool operator<(const TableEntryKey& left,
+                        const TableEntryKey& right) {
+    return std::make_tuple(left.table_id_, left.priority_, left.matches()) <
+           std::make_tuple(right.table_id_, right.priority_, right.matches());
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const TableEntryKey& key) {
+    return H::combine(std::move(h), key.table_id_, key.priority_,
+                      key.matches());
+  }
+
+ private:
+  friend class TableEntryKeyBuilder;
+
+  uint32_t table_id_ = 0;
+  int32_t priority_ = 0;
+  absl::InlinedVector<char, kInlineCapacity> matches_;
+};
+
+// Returns the key of the given PI (program independent) table entry. Only
+// checks what is needed to compute the key, i.e. that the table and its match
+// fields exist, that every match field is given at most once and with the
+// match type of its definition, and that values fit the bitwidth of their
+// field. Use PiTableEntryToIr to validate entries completely.
+absl::StatusOr<TableEntryKey> PiTableEntryKey(const IrP4Info& info,
+                                              const p4::v1::TableEntry& pi);
+absl::StatusOr<TableEntryKey> PiTableEntryKey(const CompiledIrP4Info& info,
+                                              const p4::v1::TableEntry& pi);
+
+// Returns the key of the given IR table entry, which is equal to the key of its
+// PI translation. Checks the same as PiTableEntryKey, and that values have the
+// format of their field.
+absl::StatusOr<TableEntryKey> IrTableEntryKey(const IrP4Info& info,
+                                              const IrTableEntry& ir);
+absl::StatusOr<TableEntryKey> IrTableEntryKey(const CompiledIrP4Info& info,
+                                              const IrTableEntry& ir);
+
+}  // namespace pdpi
+
+#endif  // GOOGLE_P4_PDPI_TABLE_ENTRY_KEY_H_
@@ -0,0 +1,205 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/compiled_ir_p4info.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+namespace {
+
+using ::p4::config::v1::MatchField;
+using ::p4::config::v1::P4Info;
+
+constexpr char kMainP4InfoFile[] = "p4_pdpi/testing/main-p4info.pb.txt";
+
+// Values to index. Only their addresses matter.
+const int kValues[4] = {};
+
+TEST(IdIndexTest, CompactIdsAreFound) {
+  // Table IDs as assigned by p4c, and match field IDs.
+  for (uint32_t prefix : {0x02000000u, 0u}) {
+    const IdIndex<int> index({{prefix | 1, &kValues[0]},
+                              {prefix | 3, &kValues[1]},
+                              {prefix | 2, &kValues[2]}});
+    EXPECT_EQ(index.Find(prefix | 1), &kValues[0]);
+    EXPECT_EQ(index.Find(prefix | 3), &kValues[1]);
+    EXPECT_EQ(index.Find(prefix | 2), &kValues[2]);
+    // Unknown IDs, within and beyond the indexed range.
+    EXPECT_EQ(index.Find(prefix | 0), nullptr);
+    EXPECT_EQ(index.Find(prefix | 4), nullptr);
+    EXPECT_EQ(index.Find(prefix | 0xffffff), nullptr);
+    // Known IDs with another type prefix.
+    EXPECT_EQ(index.Find(0x01000000 | 1), nullptr);
+    EXPECT_EQ(index.Find(0xff000000 | 3), nullptr);
+  }
+}
+
+TEST(IdIndexTest, SparseIdsAreFound) {
+  // IDs beyond the dense range, e.g. from @id annotations.
+  const IdIndex<int> index({{0x02000001, &kValues[0]},
+                            {0x02fffffe, &kValues[1]},
+                            {0x02123456, &kValues[2]}});
+  EXPECT_EQ(index.Find(0x02000001), &kValues[0]);
+  EXPECT_EQ(index.Find(0x02fffffe), &kValues[1]);
+  EXPECT_EQ(index.Find(0x02123456), &kValues[2]);
+  EXPECT_EQ(index.Find(0x02000002), nullptr);
+  EXPECT_EQ(index.Find(0x02ffffff), nullptr);
+  EXPECT_EQ(index.Find(0x01fffffe), nullptr);
+}
+
+TEST(IdIndexTest, IdsThatOnlyDifferInTheirPrefixAreFound) {
+  const IdIndex<int> index({{0x01000001, &kValues[0]},
+                            {0x02000001, &kValues[1]},
+                            {0x02000002, &kValues[2]}});
+  EXPECT_EQ(index.Find(0x01000001), &kValues[0]);
+  EXPECT_EQ(index.Find(0x02000001), &kValues[1]);
+  EXPECT_EQ(index.Find(0x02000002), &kValues[2]);
+  EXPECT_EQ(index.Find(0x01000002), nullptr);
+  EXPECT_EQ(index.Find(0x03000001), nullptr);
+}
+
+TEST(IdIndexTest, EmptyIndexFindsNothing) {
+  const IdIndex<int> index;
+  EXPECT_EQ(index.Find(0), nullptr);
+  EXPECT_EQ(index.Find(0x02000001), nullptr);
+  const IdIndex<int> from_no_values(
+      std::vector<std::pair<uint32_t, const int*>>{});
+  EXPECT_EQ(from_no_values.Find(0), nullptr);
+}
+
+// Checks that `compiled` finds exactly the definitions of `info`.
+void ExpectIndexes(const IrP4Info& info, const CompiledIrP4Info& compiled) {
+  ASSERT_EQ(&compiled.info(), &info);
+  for (const auto& [id, table] : info.tables_by_id()) {
+    SCOPED_TRACE(table.preamble().alias());
+    const CompiledIrTable* compiled_table = compiled.FindTableById(id);
+    ASSERT_NE(compiled_table, nullptr);
+    EXPECT_EQ(compiled.FindTableByName(table.preamble().alias()),
+              compiled_table);
+    EXPECT_EQ(&compiled_table->definition(), &info.tables_by_id().at(id));
+
+    int num_mandatory_matches = 0;
+    for (const auto& [id, match_field] : table.match_fields_by_id()) {
+      const IrMatchFieldDefinition* compiled_match_field =
+          compiled_table->FindMatchFieldById(id);
+      ASSERT_NE(compiled_match_field, nullptr);
+      EXPECT_EQ(compiled_match_field->match_field().name(),
+                match_field.match_field().name());
+      EXPECT_EQ(compiled_table->FindMatchFieldByName(
+                    match_field.match_field().name()),
+                compiled_match_field);
+      if (match_field.match_field().match_type() == MatchField::EXACT) {
+        ++num_mandatory_matches;
+      }
+    }
+    EXPECT_EQ(compiled_table->num_mandatory_matches(), num_mandatory_matches);
+    EXPECT_EQ(compiled_table->FindMatchFieldById(0), nullptr);
+    EXPECT_EQ(compiled_table->FindMatchFieldByName("unknown"), nullptr);
+
+    for (const auto& action_reference : table.entry_actions()) {
+      const IrActionDefinition& action = action_reference.action();
+      const CompiledIrAction* compiled_action =
+          compiled_table->FindEntryActionById(action.preamble().id());
+      ASSERT_NE(compiled_action, nullptr);
+      EXPECT_EQ(
+          compiled_table->FindEntryActionByName(action.preamble().alias()),
+          compiled_action);
+      EXPECT_EQ(compiled_action->num_params(), action.params_by_id().size());
+      for (const auto& [id, param] : action.params_by_id()) {
+        const auto* compiled_param = compiled_action->FindParamById(id);
+        ASSERT_NE(compiled_param, nullptr);
+        EXPECT_EQ(compiled_param->param().name(), param.param().name());
+        EXPECT_EQ(compiled_action->FindParamByName(param.param().name()),
+                  compiled_param);
+      }
+      EXPECT_EQ(compiled_action->FindParamById(0), nullptr);
+    }
+    // Default-only actions cannot be used in entries.
+    for (const auto& action_reference : table.default_only_actions()) {
+      const IrActionDefinition& action = action_reference.action();
+      EXPECT_EQ(compiled_table->FindEntryActionById(action.preamble().id()),
+                nullptr);
+    }
+  }
+  EXPECT_EQ(compiled.FindTableById(0), nullptr);
+  EXPECT_EQ(compiled.FindTableByName("unknown"), nullptr);
+}
+
+TEST(CompiledIrP4InfoTest, IndexesMainP4Info) {
+  const auto p4info = gutil::ParseProtoFileOrDie<P4Info>(kMainP4InfoFile);
+  ASSERT_OK_AND_ASSIGN(IrP4Info info, CreateIrP4Info(p4info));
+  auto shared_info = std::make_shared<const IrP4Info>(std::move(info));
+  // Sharing the IrP4Info does not copy it.
+  CompiledIrP4Info compiled(shared_info);
+  ExpectIndexes(*shared_info, compiled);
+  // Moving the compiled form keeps its indices valid.
+  const CompiledIrP4Info moved = std::move(compiled);
+  ExpectIndexes(*shared_info, moved);
+}
+
+// A P4Info whose table, match field and param IDs are too sparse to be
+// indexed by dense arrays.
+P4Info SparseP4Info() {
+  return gutil::ParseProtoOrDie<P4Info>(R"pb(
+    tables {
+      preamble { id: 33554433 name: "ingress.t1" alias: "t1" }
+      match_fields { id: 1 name: "f1" bitwidth: 8 match_type: EXACT }
+      match_fields { id: 1000 name: "f2" bitwidth: 8 match_type: TERNARY }
+      action_refs { id: 16777217 annotations: "@proto_id(1)" }
+      size: 1024
+    }
+    tables {
+      preamble { id: 50331647 name: "ingress.t2" alias: "t2" }
+      match_fields { id: 1 name: "f1" bitwidth: 8 match_type: EXACT }
+      action_refs { id: 16777217 annotations: "@proto_id(1)" }
+      size: 1024
+    }
+    actions {
+      preamble { id: 16777217 name: "ingress.a" alias: "a" }
+      params { id: 1 name: "p1" bitwidth: 8 }
+      params { id: 77 name: "p2" bitwidth: 8 }
+    }
+  )pb");
+}
+
+TEST(CompiledIrP4InfoTest, IndexesSparseIds) {
+  ASSERT_OK_AND_ASSIGN(IrP4Info info, CreateIrP4Info(SparseP4Info()));
+  auto shared_info = std::make_shared<const IrP4Info>(std::move(info));
+  ExpectIndexes(*shared_info, CompiledIrP4Info(shared_info));
+}
+
+TEST(CompiledIrP4InfoTest, CreateCompiledIrP4InfoIndexesTheIrP4Info) {
+  ASSERT_OK_AND_ASSIGN(const CompiledIrP4Info compiled,
+                       CreateCompiledIrP4Info(SparseP4Info()));
+  ExpectIndexes(compiled.info(), compiled);
+  EXPECT_THAT(CreateIrP4Info(SparseP4Info()),
+              gutil::IsOkAndHolds(gutil::EqualsProto(compiled.info())));
+}
+
+}  // namespace
+}  // namespace pdpi
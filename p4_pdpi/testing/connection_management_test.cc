@@ -0,0 +1,416 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/connection_management.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "google/rpc/code.pb.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/testing/fake_p4runtime_server.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::p4::v1::PacketIn;
+using ::p4::v1::PacketOut;
+using ::p4::v1::ReadRequest;
+using ::p4::v1::ReadResponse;
+using ::p4::v1::StreamMessageResponse;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+using ::p4::v1::WriteRequest;
+using ::testing::ElementsAre;
+using ::testing::SizeIs;
+
+constexpr uint32_t kDeviceId = 183807201;
+
+TableEntry Entry(int id) {
+  TableEntry entry = gutil::ParseProtoOrDie<TableEntry>(R"pb(
+    table_id: 33554433
+    match { field_id: 1 }
+    action { action { action_id: 16777217 } }
+  )pb");
+  entry.mutable_match(0)->mutable_exact()->set_value(std::string(1, id));
+  return entry;
+}
+
+// Returns a request that inserts the entries with the given IDs.
+WriteRequest InsertRequest(const P4RuntimeSession& session,
+                           const std::vector<int>& ids) {
+  WriteRequest request;
+  request.set_device_id(session.DeviceId());
+  *request.mutable_election_id() = session.ElectionId();
+  for (int id : ids) {
+    Update* update = request.add_updates();
+    update->set_type(Update::INSERT);
+    *update->mutable_entity()->mutable_table_entry() = Entry(id);
+  }
+  return request;
+}
+
+// The status passed to the `done` callback of an asynchronous RPC.
+class DoneStatus {
+ public:
+  std::function<void(const grpc::Status&)> Callback() {
+    return [this](const grpc::Status& status) {
+      status_ = status;
+      done_.Notify();
+    };
+  }
+  // Waits for the callback to be called and returns its status.
+  grpc::Status Wait() {
+    done_.WaitForNotification();
+    return status_;
+  }
+  bool HasBeenCalled() const { return done_.HasBeenNotified(); }
+
+ private:
+  absl::Notification done_;
+  grpc::Status status_;
+};
+
+// A session with a fake P4Runtime server.
+class SessionTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK_AND_ASSIGN(session_,
+                         P4RuntimeSession::Create(fake_.NewStub(), kDeviceId));
+  }
+
+  FakeP4RuntimeServer fake_;
+  std::unique_ptr<P4RuntimeSession> session_;
+};
+
+using AsyncRpcTest = SessionTest;
+
+TEST_F(AsyncRpcTest, WriteCompletes) {
+  DoneStatus done;
+  session_->AsyncWrite(InsertRequest(*session_, {1, 2}), done.Callback());
+  EXPECT_TRUE(done.Wait().ok());
+  EXPECT_THAT(fake_.TableEntries(kDeviceId),
+              ElementsAre(EqualsProto(Entry(1)), EqualsProto(Entry(2))));
+}
+
+TEST_F(AsyncRpcTest, WriteReportsUpdateErrors) {
+  DoneStatus done;
+  session_->AsyncWrite(InsertRequest(*session_, {1, 1}), done.Callback());
+  const grpc::Status status = done.Wait();
+  ASSERT_OK_AND_ASSIGN(IrWriteRpcStatus ir_status,
+                       GrpcStatusToIrWriteRpcStatus(status, 2));
+  EXPECT_THAT(ir_status, EqualsProto(R"pb(
+                rpc_response {
+                  statuses { code: OK }
+                  statuses {
+                    code: ALREADY_EXISTS
+                    message: "Entry already exists."
+                  }
+                }
+              )pb"));
+}
+
+TEST_F(AsyncRpcTest, WriteReportsRpcWideErrors) {
+  fake_.SetWriteHook([](grpc::ServerContext*, const WriteRequest&) {
+    return grpc::Status(grpc::StatusCode::PERMISSION_DENIED,
+                        "Not the primary.");
+  });
+  DoneStatus done;
+  session_->AsyncWrite(InsertRequest(*session_, {1}), done.Callback());
+  const grpc::Status status = done.Wait();
+  EXPECT_EQ(status.error_code(), grpc::StatusCode::PERMISSION_DENIED);
+  EXPECT_EQ(status.error_message(), "Not the primary.");
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), SizeIs(0));
+}
+
+TEST_F(AsyncRpcTest, ReadStreamsResponses) {
+  DoneStatus written;
+  session_->AsyncWrite(InsertRequest(*session_, {1, 2, 3, 4, 5, 6, 7}),
+                       written.Callback());
+  ASSERT_TRUE(written.Wait().ok());
+
+  ReadRequest request;
+  request.set_device_id(kDeviceId);
+  request.add_entities()->mutable_table_entry();
+  std::vector<int> response_sizes;
+  DoneStatus done;
+  session_->AsyncRead(
+      request,
+      [&response_sizes](ReadResponse& response) {
+        response_sizes.push_back(response.entities_size());
+      },
+      done.Callback());
+  EXPECT_TRUE(done.Wait().ok());
+  // The fake sends at most 3 entities per response.
+  EXPECT_THAT(response_sizes, ElementsAre(3, 3, 1));
+}
+
+TEST_F(AsyncRpcTest, SetForwardingPipelineConfigCompletes) {
+  p4::v1::SetForwardingPipelineConfigRequest request;
+  request.set_device_id(kDeviceId);
+  request.set_action(
+      p4::v1::SetForwardingPipelineConfigRequest::VERIFY_AND_COMMIT);
+  DoneStatus done;
+  session_->AsyncSetForwardingPipelineConfig(request, done.Callback());
+  EXPECT_TRUE(done.Wait().ok());
+  EXPECT_THAT(fake_.SetForwardingPipelineConfigRequests(),
+              ElementsAre(EqualsProto(request)));
+}
+
+TEST_F(AsyncRpcTest, ManyRpcsCanBeInFlight) {
+  constexpr int kNumWrites = 50;
+  absl::BlockingCounter done(kNumWrites);
+  absl::Mutex mutex;
+  int num_ok = 0;
+  for (int i = 0; i < kNumWrites; ++i) {
+    session_->AsyncWrite(InsertRequest(*session_, {i}),
+                         [&](const grpc::Status& status) {
+                           if (status.ok()) {
+                             absl::MutexLock lock(&mutex);
+                             ++num_ok;
+                           }
+                           done.DecrementCount();
+                         });
+  }
+  done.Wait();
+  absl::MutexLock lock(&mutex);
+  EXPECT_EQ(num_ok, kNumWrites);
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), SizeIs(kNumWrites));
+}
+
+TEST_F(AsyncRpcTest, DestroyingTheSessionCancelsRpcsInFlight) {
+  absl::Notification write_started;
+  fake_.SetWriteHook(
+      [&write_started](grpc::ServerContext* context, const WriteRequest&) {
+        write_started.Notify();
+        // Only completes once the client cancelled the RPC.
+        const absl::Time deadline = absl::Now() + absl::Seconds(10);
+        while (!context->IsCancelled() && absl::Now() < deadline) {
+          absl::SleepFor(absl::Milliseconds(1));
+        }
+        return grpc::Status(grpc::StatusCode::UNAVAILABLE, "Not cancelled.");
+      });
+  DoneStatus done;
+  session_->AsyncWrite(InsertRequest(*session_, {1}), done.Callback());
+  write_started.WaitForNotification();
+  EXPECT_FALSE(done.HasBeenCalled());
+
+  // Returns only once the callback returned.
+  session_.reset();
+  ASSERT_TRUE(done.HasBeenCalled());
+  EXPECT_EQ(done.Wait().error_code(), grpc::StatusCode::CANCELLED);
+}
+
+TEST_F(AsyncRpcTest, DestroyingTheSessionWithoutRpcsReturns) {
+  // The session never started polling.
+  session_.reset();
+  SUCCEED();
+}
+
+// A P4Info whose packet ins carry an ingress port.
+IrP4Info PacketIoInfo() {
+  return CreateIrP4Info(gutil::ParseProtoOrDie<p4::config::v1::P4Info>(R"pb(
+           controller_packet_metadata {
+             preamble {
+               id: 81826293
+               name: "packet_in"
+               alias: "packet_in"
+               annotations: "@controller_header(\"packet_in\")"
+             }
+             metadata { id: 1 name: "ingress_port" bitwidth: 10 }
+           }
+         )pb"))
+      .value();
+}
+
+PacketIn PiPacketIn(const std::string& payload) {
+  PacketIn packet;
+  packet.set_payload(payload);
+  auto* metadata = packet.add_metadata();
+  metadata->set_metadata_id(1);
+  metadata->set_value("\x01");
+  return packet;
+}
+
+StreamMessageResponse PacketInMessage(const PacketIn& packet) {
+  StreamMessageResponse message;
+  *message.mutable_packet() = packet;
+  return message;
+}
+
+class PacketIoTest : public SessionTest {
+ protected:
+  // Sends `packet` to the session, once it is connected.
+  void SendPacketIn(const PacketIn& packet) {
+    ASSERT_TRUE(fake_.WaitForClients(1, absl::Seconds(10)));
+    ASSERT_EQ(fake_.SendToClients(PacketInMessage(packet)), 1);
+  }
+
+  // Reads `n` packets, waiting for them to arrive. Fails the test if they did
+  // not arrive in time.
+  std::vector<ReceivedPacketIn> ReadPacketIns(int n) {
+    std::vector<ReceivedPacketIn> packets;
+    const absl::Time deadline = absl::Now() + absl::Seconds(10);
+    while (packets.size() < n && absl::Now() < deadline) {
+      ReceivedPacketIn packet;
+      if (session_->TryReadPacketIn(&packet)) {
+        packets.push_back(std::move(packet));
+      } else {
+        absl::SleepFor(absl::Milliseconds(1));
+      }
+    }
+    EXPECT_THAT(packets, SizeIs(n));
+    return packets;
+  }
+};
+
+TEST_F(PacketIoTest, NoPacketInsAreReadBeforePacketIoIsStarted) {
+  ReceivedPacketIn packet;
+  EXPECT_FALSE(session_->TryReadPacketIn(&packet));
+  EXPECT_EQ(session_->DroppedPacketIns(), 0);
+}
+
+TEST_F(PacketIoTest, PacketIoCanOnlyBeStartedOnce) {
+  ASSERT_OK(session_->StartPacketIo());
+  EXPECT_THAT(session_->StartPacketIo(),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_F(PacketIoTest, PacketInsAreReadInOrder) {
+  ASSERT_OK(session_->StartPacketIo());
+  SendPacketIn(PiPacketIn("first"));
+  SendPacketIn(PiPacketIn("second"));
+  const std::vector<ReceivedPacketIn> packets = ReadPacketIns(2);
+  ASSERT_THAT(packets, SizeIs(2));
+  EXPECT_THAT(packets[0].pi, EqualsProto(PiPacketIn("first")));
+  EXPECT_THAT(packets[1].pi, EqualsProto(PiPacketIn("second")));
+  // Without an IrP4Info, packets are not translated.
+  EXPECT_FALSE(packets[0].ir.has_value());
+
+  ReceivedPacketIn packet;
+  EXPECT_FALSE(session_->TryReadPacketIn(&packet));
+}
+
+TEST_F(PacketIoTest, PacketInsAreTranslatedToIr) {
+  const IrP4Info info = PacketIoInfo();
+  PacketIoOptions options;
+  options.ir_p4info = &info;
+  ASSERT_OK(session_->StartPacketIo(options));
+  SendPacketIn(PiPacketIn("payload"));
+  PacketIn unknown_metadata = PiPacketIn("payload");
+  unknown_metadata.mutable_metadata(0)->set_metadata_id(7);
+  SendPacketIn(unknown_metadata);
+
+  const std::vector<ReceivedPacketIn> packets = ReadPacketIns(2);
+  ASSERT_THAT(packets, SizeIs(2));
+  ASSERT_TRUE(packets[0].ir.has_value());
+  EXPECT_THAT(*packets[0].ir, IsOkAndHolds(EqualsProto(R"pb(
+                payload: "payload"
+                metadata {
+                  name: "ingress_port"
+                  value { hex_str: "0x1" }
+                }
+              )pb")));
+  // Packets that cannot be translated are still received.
+  EXPECT_THAT(packets[1].pi, EqualsProto(unknown_metadata));
+  ASSERT_TRUE(packets[1].ir.has_value());
+  EXPECT_FALSE(packets[1].ir->ok());
+}
+
+TEST_F(PacketIoTest, PacketInsAreDroppedWhenTheQueueIsFull) {
+  PacketIoOptions options;
+  options.packet_in_queue_capacity = 2;
+  ASSERT_OK(session_->StartPacketIo(options));
+  for (int i = 0; i < 5; ++i) SendPacketIn(PiPacketIn(absl::StrCat(i)));
+
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (session_->DroppedPacketIns() < 3 && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  EXPECT_EQ(session_->DroppedPacketIns(), 3);
+  // The oldest packets are kept.
+  const std::vector<ReceivedPacketIn> packets = ReadPacketIns(2);
+  ASSERT_THAT(packets, SizeIs(2));
+  EXPECT_EQ(packets[0].pi.payload(), "0");
+  EXPECT_EQ(packets[1].pi.payload(), "1");
+}
+
+TEST_F(PacketIoTest, OtherStreamMessagesArePassedToTheCallback) {
+  absl::Notification received;
+  StreamMessageResponse message;
+  PacketIoOptions options;
+  options.on_stream_message = [&](const StreamMessageResponse& response) {
+    message = response;
+    received.Notify();
+  };
+  ASSERT_OK(session_->StartPacketIo(options));
+  ASSERT_TRUE(fake_.WaitForClients(1, absl::Seconds(10)));
+  StreamMessageResponse error;
+  error.mutable_error()->set_canonical_code(google::rpc::INVALID_ARGUMENT);
+  error.mutable_error()->set_message("Invalid packet out.");
+  ASSERT_EQ(fake_.SendToClients(error), 1);
+
+  ASSERT_TRUE(received.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  EXPECT_THAT(message, EqualsProto(error));
+  ReceivedPacketIn packet;
+  EXPECT_FALSE(session_->TryReadPacketIn(&packet));
+}
+
+TEST_F(PacketIoTest, PacketOutsAreSentInOrder) {
+  // Packet outs do not need packet IO to be started.
+  std::vector<PacketOut> packets(3);
+  for (int i = 0; i < packets.size(); ++i) {
+    packets[i].set_payload(absl::StrCat("packet ", i));
+  }
+  ASSERT_OK(session_->SendPacketOuts(packets));
+  ASSERT_OK(session_->SendPacketOuts({}));
+  ASSERT_TRUE(fake_.WaitForPacketOuts(3, absl::Seconds(10)));
+  EXPECT_THAT(fake_.PacketOuts(),
+              ElementsAre(EqualsProto(packets[0]), EqualsProto(packets[1]),
+                          EqualsProto(packets[2])));
+}
+
+TEST_F(PacketIoTest, DestroyingTheSessionStopsPacketIo) {
+  ASSERT_OK(session_->StartPacketIo());
+  SendPacketIn(PiPacketIn("unread"));
+  // Returns once the stream channel is no longer read.
+  session_.reset();
+  SUCCEED();
+}
+
+}  // namespace
+}  // namespace pdpi
@@ -0,0 +1,404 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/entity_management.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "gmock/gmock.h"
+#include "google/rpc/code.pb.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "gutil/thread_pool.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/connection_management.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/sequencing.h"
+#include "p4_pdpi/testing/fake_p4runtime_server.h"
+#include "p4_pdpi/testing/test_p4info.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::StatusIs;
+using ::p4::config::v1::P4Info;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+using ::p4::v1::WriteRequest;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::SizeIs;
+
+constexpr uint32_t kDeviceId = 183807201;
+
+TableEntry Entry(int id) {
+  TableEntry entry = gutil::ParseProtoOrDie<TableEntry>(R"pb(
+    table_id: 33554433
+    match { field_id: 1 }
+    action { action { action_id: 16777217 } }
+  )pb");
+  entry.mutable_match(0)->mutable_exact()->set_value(std::string(1, id));
+  return entry;
+}
+
+std::vector<TableEntry> Entries(int n) {
+  std::vector<TableEntry> entries;
+  for (int i = 0; i < n; ++i) entries.push_back(Entry(i));
+  return entries;
+}
+
+std::vector<Update> Inserts(int n) {
+  std::vector<Update> updates;
+  for (int i = 0; i < n; ++i) {
+    Update& update = updates.emplace_back();
+    update.set_type(Update::INSERT);
+    *update.mutable_entity()->mutable_table_entry() = Entry(i);
+  }
+  return updates;
+}
+
+WriteBatchOptions Options(int max_updates_per_request,
+                          int max_requests_in_flight = 1) {
+  WriteBatchOptions options;
+  options.max_updates_per_request = max_updates_per_request;
+  options.max_requests_in_flight = max_requests_in_flight;
+  return options;
+}
+
+std::vector<google::rpc::Code> Codes(const IrWriteResponse& response) {
+  std::vector<google::rpc::Code> codes;
+  for (const IrUpdateStatus& status : response.statuses()) {
+    codes.push_back(status.code());
+  }
+  return codes;
+}
+
+class EntityManagementTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK_AND_ASSIGN(session_,
+                         P4RuntimeSession::Create(fake_.NewStub(), kDeviceId));
+  }
+
+  FakeP4RuntimeServer fake_;
+  std::unique_ptr<P4RuntimeSession> session_;
+};
+
+TEST_F(EntityManagementTest, UpdatesAreSentInRequestsOfBoundedSize) {
+  ASSERT_OK_AND_ASSIGN(IrWriteResponse response,
+                       SendPiUpdates(session_.get(), Inserts(5),
+                                     Options(/*max_updates_per_request=*/2)));
+  EXPECT_THAT(Codes(response), ElementsAre(google::rpc::OK, google::rpc::OK,
+                                           google::rpc::OK, google::rpc::OK,
+                                           google::rpc::OK));
+
+  const std::vector<WriteRequest> requests = fake_.WriteRequests();
+  ASSERT_THAT(requests, SizeIs(3));
+  EXPECT_THAT(requests[0].updates(), SizeIs(2));
+  EXPECT_THAT(requests[1].updates(), SizeIs(2));
+  EXPECT_THAT(requests[2].updates(), SizeIs(1));
+  // Updates keep their order across requests.
+  EXPECT_THAT(requests[1].updates(0), EqualsProto(Inserts(5)[2]));
+  for (const WriteRequest& request : requests) {
+    EXPECT_EQ(request.device_id(), kDeviceId);
+    EXPECT_THAT(request.election_id(), EqualsProto(session_->ElectionId()));
+  }
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), SizeIs(5));
+
+  // Without updates, no request is sent.
+  ASSERT_OK_AND_ASSIGN(response, SendPiUpdates(session_.get(), {}));
+  EXPECT_THAT(response.statuses(), SizeIs(0));
+  EXPECT_THAT(fake_.WriteRequests(), SizeIs(3));
+}
+
+TEST_F(EntityManagementTest, InvalidOptionsAreRejected) {
+  EXPECT_THAT(SendPiUpdates(session_.get(), Inserts(1),
+                            Options(/*max_updates_per_request=*/0)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(InstallPiTableEntries(session_.get(), Entries(1),
+                                    Options(/*max_updates_per_request=*/1,
+                                            /*max_requests_in_flight=*/0)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(fake_.WriteRequests(), SizeIs(0));
+}
+
+// Counts the Write RPCs that the fake is handling at the same time.
+class InFlightCounter {
+ public:
+  // Lets every RPC wait until `n` RPCs were in flight at the same time, or
+  // `timeout` passed, so that pipelined RPCs overlap.
+  InFlightCounter(int n, absl::Duration timeout)
+      : wait_for_(n), timeout_(timeout) {}
+
+  grpc::Status OnWrite() {
+    absl::MutexLock lock(&mutex_);
+    ++in_flight_;
+    max_in_flight_ = std::max(max_in_flight_, in_flight_);
+    auto condition = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return max_in_flight_ >= wait_for_;
+    };
+    mutex_.AwaitWithTimeout(absl::Condition(&condition), timeout_);
+    --in_flight_;
+    return grpc::Status::OK;
+  }
+
+  int max_in_flight() {
+    absl::MutexLock lock(&mutex_);
+    return max_in_flight_;
+  }
+
+ private:
+  const int wait_for_;
+  const absl::Duration timeout_;
+  absl::Mutex mutex_;
+  int in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+  int max_in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+TEST_F(EntityManagementTest, RequestsAreSentOneAtATimeByDefault) {
+  InFlightCounter counter(/*n=*/2, absl::Milliseconds(100));
+  fake_.SetWriteHook([&counter](grpc::ServerContext*, const WriteRequest&) {
+    return counter.OnWrite();
+  });
+  ASSERT_OK(InstallPiTableEntries(session_.get(), Entries(3),
+                                  Options(/*max_updates_per_request=*/1)));
+  EXPECT_THAT(fake_.WriteRequests(), SizeIs(3));
+  EXPECT_EQ(counter.max_in_flight(), 1);
+}
+
+TEST_F(EntityManagementTest, RequestsInFlightAreBounded) {
+  InFlightCounter counter(/*n=*/2, absl::Seconds(10));
+  fake_.SetWriteHook([&counter](grpc::ServerContext*, const WriteRequest&) {
+    return counter.OnWrite();
+  });
+  ASSERT_OK(InstallPiTableEntries(
+      session_.get(), Entries(6),
+      Options(/*max_updates_per_request=*/1,
+              /*max_requests_in_flight=*/2)));
+  EXPECT_THAT(fake_.WriteRequests(), SizeIs(6));
+  EXPECT_EQ(counter.max_in_flight(), 2);
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), SizeIs(6));
+}
+
+TEST_F(EntityManagementTest, UpdateErrorsAreReportedInOrderAcrossRequests) {
+  ASSERT_OK(InstallPiTableEntry(session_.get(), Entry(2)));
+  ASSERT_OK_AND_ASSIGN(IrWriteResponse response,
+                       SendPiUpdates(session_.get(), Inserts(5),
+                                     Options(/*max_updates_per_request=*/2)));
+  EXPECT_THAT(Codes(response),
+              ElementsAre(google::rpc::OK, google::rpc::OK,
+                          google::rpc::ALREADY_EXISTS, google::rpc::OK,
+                          google::rpc::OK));
+  EXPECT_EQ(response.statuses(2).message(), "Entry already exists.");
+
+  // Errors are numbered by their entry, not by their position in a request.
+  EXPECT_THAT(
+      RemovePiTableEntries(session_.get(), {Entry(0), Entry(7), Entry(1)},
+                           Options(/*max_updates_per_request=*/2)),
+      StatusIs(absl::StatusCode::kUnknown,
+               "Batch failed, individual results:\n"
+               "#1: OK\n"
+               "#2: NOT_FOUND: Entry does not exist.\n"
+               "#3: OK\n"));
+}
+
+TEST_F(EntityManagementTest, RpcWideErrorStopsSending) {
+  int num_requests = 0;
+  fake_.SetWriteHook(
+      [&num_requests](grpc::ServerContext*, const WriteRequest&) {
+        if (++num_requests == 2) {
+          return grpc::Status(grpc::StatusCode::PERMISSION_DENIED,
+                              "Not the primary.");
+        }
+        return grpc::Status::OK;
+      });
+  ASSERT_OK_AND_ASSIGN(IrWriteResponse response,
+                       SendPiUpdates(session_.get(), Inserts(6),
+                                     Options(/*max_updates_per_request=*/2)));
+  EXPECT_THAT(Codes(response),
+              ElementsAre(google::rpc::OK, google::rpc::OK,
+                          google::rpc::PERMISSION_DENIED,
+                          google::rpc::PERMISSION_DENIED,
+                          google::rpc::ABORTED, google::rpc::ABORTED));
+  EXPECT_EQ(response.statuses(2).message(), "Not the primary.");
+  EXPECT_THAT(response.statuses(4).message(), HasSubstr("Not the primary."));
+  EXPECT_THAT(fake_.WriteRequests(), SizeIs(2));
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), SizeIs(2));
+
+  // Installing reports the RPC-wide error itself.
+  num_requests = 0;
+  EXPECT_THAT(InstallPiTableEntries(session_.get(), Entries(6),
+                                    Options(/*max_updates_per_request=*/2)),
+              StatusIs(absl::StatusCode::kPermissionDenied,
+                       "Not the primary."));
+  EXPECT_THAT(fake_.WriteRequests(), SizeIs(4));
+}
+
+class SendPiUpdatesInSequenceTest : public EntityManagementTest {
+ protected:
+  void SetUp() override {
+    EntityManagementTest::SetUp();
+    // The fake rejects updates that violate a reference, like a switch would.
+    fake_.SetUpdateCheck(ReferenceCheck);
+    ASSERT_OK_AND_ASSIGN(references_,
+                         P4InfoReferences::Create(TestIrP4Info()));
+  }
+
+  absl::optional<P4InfoReferences> references_;
+};
+
+TEST_F(SendPiUpdatesInSequenceTest, BatchesAreSentInOrder) {
+  ASSERT_OK(SendPiUpdatesInSequence(
+      session_.get(), *references_,
+      {MakeUpdate(Update::INSERT, Nexthop(10, 1, 7)),
+       MakeUpdate(Update::INSERT, Neighbor(1, 7)),
+       MakeUpdate(Update::INSERT, Rif(1))}));
+  std::vector<WriteRequest> requests = fake_.WriteRequests();
+  ASSERT_THAT(requests, SizeIs(3));
+  EXPECT_THAT(requests[0].updates(),
+              ElementsAre(EqualsProto(MakeUpdate(Update::INSERT, Rif(1)))));
+  EXPECT_THAT(requests[1].updates(), ElementsAre(EqualsProto(MakeUpdate(
+                                         Update::INSERT, Neighbor(1, 7)))));
+  EXPECT_THAT(requests[2].updates(), ElementsAre(EqualsProto(MakeUpdate(
+                                         Update::INSERT, Nexthop(10, 1, 7)))));
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), SizeIs(3));
+
+  // Deletes are sent in the reverse order.
+  ASSERT_OK(SendPiUpdatesInSequence(
+      session_.get(), *references_,
+      {MakeUpdate(Update::DELETE, Rif(1)),
+       MakeUpdate(Update::DELETE, Neighbor(1, 7)),
+       MakeUpdate(Update::DELETE, Nexthop(10, 1, 7))}));
+  requests = fake_.WriteRequests();
+  ASSERT_THAT(requests, SizeIs(6));
+  EXPECT_EQ(requests[3].updates(0).entity().table_entry().table_id(),
+            kNexthopTableId);
+  EXPECT_EQ(requests[4].updates(0).entity().table_entry().table_id(),
+            kNeighborTableId);
+  EXPECT_EQ(requests[5].updates(0).entity().table_entry().table_id(),
+            kRifTableId);
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), IsEmpty());
+}
+
+TEST_F(SendPiUpdatesInSequenceTest, FailedBatchStopsSending) {
+  ASSERT_OK(InstallPiTableEntry(session_.get(), Rif(1)));
+  EXPECT_THAT(SendPiUpdatesInSequence(
+                  session_.get(), *references_,
+                  {MakeUpdate(Update::INSERT, Rif(1)),
+                   MakeUpdate(Update::INSERT, Neighbor(1, 7)),
+                   MakeUpdate(Update::INSERT, Nexthop(10, 1, 7))}),
+              StatusIs(absl::StatusCode::kUnknown,
+                       HasSubstr("ALREADY_EXISTS")));
+  EXPECT_THAT(fake_.WriteRequests(), SizeIs(2));
+  EXPECT_THAT(fake_.TableEntries(kDeviceId),
+              ElementsAre(EqualsProto(Rif(1))));
+}
+
+TEST_F(SendPiUpdatesInSequenceTest, IrP4InfoOverloadCreatesTheReferences) {
+  ASSERT_OK(SendPiUpdatesInSequence(
+      session_.get(), TestIrP4Info(),
+      {MakeUpdate(Update::INSERT, Neighbor(1, 7)),
+       MakeUpdate(Update::INSERT, Rif(1))}));
+  EXPECT_THAT(fake_.WriteRequests(), SizeIs(2));
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), SizeIs(2));
+}
+
+class ClearTableEntriesTest : public SendPiUpdatesInSequenceTest {
+ protected:
+  void SetUp() override {
+    SendPiUpdatesInSequenceTest::SetUp();
+    ASSERT_OK(InstallPiTableEntries(
+        session_.get(), {Rif(1), Neighbor(1, 7), Nexthop(10, 1, 7),
+                         Route(1, 10), Route(2, 10)}));
+  }
+};
+
+TEST_F(ClearTableEntriesTest, EntriesAreDeletedAfterTheEntriesReferringToThem) {
+  // Deleting the nexthop before the routes fails.
+  EXPECT_THAT(RemovePiTableEntries(session_.get(), {Nexthop(10, 1, 7)}),
+              StatusIs(absl::StatusCode::kUnknown,
+                       HasSubstr("FAILED_PRECONDITION")));
+
+  ASSERT_OK(ClearTableEntries(session_.get(), TestIrP4Info()));
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), IsEmpty());
+}
+
+TEST_F(ClearTableEntriesTest, OnlySelectedTablesAreCleared) {
+  // Entries of tables that are not cleared still refer to the nexthop.
+  std::vector<uint32_t> table_ids = {kNexthopTableId};
+  EXPECT_THAT(
+      ClearTableEntries(session_.get(), TestIrP4Info(), table_ids),
+      StatusIs(absl::StatusCode::kUnknown, HasSubstr("FAILED_PRECONDITION")));
+
+  table_ids = {kNexthopTableId, kRouteTableId};
+  ASSERT_OK(ClearTableEntries(session_.get(), TestIrP4Info(), table_ids));
+  EXPECT_THAT(fake_.TableEntries(kDeviceId),
+              ElementsAre(EqualsProto(Rif(1)), EqualsProto(Neighbor(1, 7))));
+
+  table_ids = {kRifTableId, 1234};
+  EXPECT_THAT(ClearTableEntries(session_.get(), TestIrP4Info(), table_ids),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), SizeIs(2));
+}
+
+TEST_F(ClearTableEntriesTest, TablesAreClearedInParallelInBoundedRequests) {
+  ASSERT_OK(InstallPiTableEntries(
+      session_.get(), {Rif(2), Neighbor(2, 8), Nexthop(11, 2, 8),
+                       WcmpGroup(1, {10, 11}), AclEntry()}));
+  const int num_requests = fake_.WriteRequests().size();
+
+  gutil::ThreadPool pool(4);
+  ASSERT_OK(ClearTableEntries(session_.get(), TestIrP4Info(),
+                              Options(/*max_updates_per_request=*/1), &pool));
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), IsEmpty());
+  const std::vector<WriteRequest> requests = fake_.WriteRequests();
+  EXPECT_THAT(requests, SizeIs(num_requests + 10));
+  for (int i = num_requests; i < requests.size(); ++i) {
+    EXPECT_THAT(requests[i].updates(), SizeIs(1));
+  }
+}
+
+
+TEST_F(ClearTableEntriesTest, TablesReferringToEachOtherAreClearedTogether) {
+  P4Info p4info = TestP4Info();
+  // Lets router interfaces refer to nexthops, which refer to router
+  // interfaces.
+  p4info.mutable_tables(0)->mutable_match_fields(0)->add_annotations(
+      "@refers_to(nexthop_table, nexthop_id)");
+  ASSERT_OK_AND_ASSIGN(const IrP4Info info, CreateIrP4Info(p4info));
+
+  gutil::ThreadPool pool(4);
+  ASSERT_OK(
+      ClearTableEntries(session_.get(), info, WriteBatchOptions(), &pool));
+  EXPECT_THAT(fake_.TableEntries(kDeviceId), IsEmpty());
+}
+
+}  // namespace
+}  // namespace pdpi
@@ -0,0 +1,285 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/testing/fake_p4runtime_server.h"
+
+#include <stdint.h>
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/rpc/code.pb.h"
+#include "grpcpp/security/server_credentials.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.grpc.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+namespace {
+
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+
+// Returns the match key of `entry`: its table, match fields and priority.
+std::string MatchKey(const TableEntry& entry) {
+  TableEntry key;
+  key.set_table_id(entry.table_id());
+  *key.mutable_match() = entry.match();
+  absl::c_sort(*key.mutable_match(), [](const auto& a, const auto& b) {
+    return a.field_id() < b.field_id();
+  });
+  key.set_priority(entry.priority());
+  std::string serialized;
+  google::protobuf::io::StringOutputStream stream(&serialized);
+  google::protobuf::io::CodedOutputStream coded_stream(&stream);
+  coded_stream.SetSerializationDeterministic(true);
+  key.SerializeToCodedStream(&coded_stream);
+  coded_stream.Trim();
+  return serialized;
+}
+
+}  // namespace
+
+FakeP4RuntimeServer::FakeP4RuntimeServer() {
+  int port = 0;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort("localhost:0", grpc::InsecureServerCredentials(),
+                           &port);
+  builder.RegisterService(this);
+  server_ = builder.BuildAndStart();
+  address_ = absl::StrCat("localhost:", port);
+}
+
+FakeP4RuntimeServer::~FakeP4RuntimeServer() {
+  // Cancels all RPCs in flight right away, including stream channels that
+  // clients keep open.
+  server_->Shutdown(std::chrono::system_clock::now());
+  server_->Wait();
+}
+
+std::unique_ptr<p4::v1::P4Runtime::Stub> FakeP4RuntimeServer::NewStub() {
+  return p4::v1::P4Runtime::NewStub(
+      server_->InProcessChannel(grpc::ChannelArguments()));
+}
+
+void FakeP4RuntimeServer::SetWriteHook(WriteHook hook) {
+  absl::MutexLock lock(&mutex_);
+  write_hook_ = std::move(hook);
+}
+
+void FakeP4RuntimeServer::SetUpdateCheck(UpdateCheck check) {
+  absl::MutexLock lock(&mutex_);
+  update_check_ = std::move(check);
+}
+
+std::vector<TableEntry> FakeP4RuntimeServer::TableEntries(
+    uint32_t device_id) const {
+  absl::MutexLock lock(&mutex_);
+  std::vector<TableEntry> result;
+  auto it = entries_by_device_.find(device_id);
+  if (it == entries_by_device_.end()) return result;
+  for (const auto& [key, entry] : it->second) result.push_back(entry);
+  absl::c_stable_sort(result, [](const TableEntry& a, const TableEntry& b) {
+    return a.table_id() < b.table_id();
+  });
+  return result;
+}
+
+std::vector<p4::v1::WriteRequest> FakeP4RuntimeServer::WriteRequests() const {
+  absl::MutexLock lock(&mutex_);
+  return write_requests_;
+}
+
+std::vector<p4::v1::SetForwardingPipelineConfigRequest>
+FakeP4RuntimeServer::SetForwardingPipelineConfigRequests() const {
+  absl::MutexLock lock(&mutex_);
+  return set_forwarding_pipeline_config_requests_;
+}
+
+std::vector<p4::v1::PacketOut> FakeP4RuntimeServer::PacketOuts() const {
+  absl::MutexLock lock(&mutex_);
+  return packet_outs_;
+}
+
+int FakeP4RuntimeServer::SendToClients(
+    const p4::v1::StreamMessageResponse& message) {
+  absl::MutexLock lock(&mutex_);
+  for (Stream* stream : clients_) stream->Write(message);
+  return clients_.size();
+}
+
+bool FakeP4RuntimeServer::WaitForClients(int n, absl::Duration timeout) {
+  absl::MutexLock lock(&mutex_);
+  auto condition = [this, n]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return clients_.size() >= n;
+  };
+  return mutex_.AwaitWithTimeout(absl::Condition(&condition), timeout);
+}
+
+bool FakeP4RuntimeServer::WaitForPacketOuts(int n, absl::Duration timeout) {
+  absl::MutexLock lock(&mutex_);
+  auto condition = [this, n]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return packet_outs_.size() >= n;
+  };
+  return mutex_.AwaitWithTimeout(absl::Condition(&condition), timeout);
+}
+
+absl::Status FakeP4RuntimeServer::Apply(const Update& update,
+                                        EntriesByKey& entries) {
+  if (!update.entity().has_table_entry()) {
+    return gutil::UnimplementedErrorBuilder()
+           << "Only table entries are supported.";
+  }
+  if (update_check_) {
+    std::vector<TableEntry> installed;
+    installed.reserve(entries.size());
+    for (const auto& [key, entry] : entries) installed.push_back(entry);
+    RETURN_IF_ERROR(update_check_(update, installed));
+  }
+  const TableEntry& entry = update.entity().table_entry();
+  const std::string key = MatchKey(entry);
+  auto it = entries.find(key);
+  switch (update.type()) {
+    case Update::INSERT:
+      if (it != entries.end()) {
+        return gutil::AlreadyExistsErrorBuilder() << "Entry already exists.";
+      }
+      entries.emplace(key, entry);
+      return absl::OkStatus();
+    case Update::MODIFY:
+      if (it == entries.end()) {
+        return gutil::NotFoundErrorBuilder() << "Entry does not exist.";
+      }
+      it->second = entry;
+      return absl::OkStatus();
+    case Update::DELETE:
+      if (it == entries.end()) {
+        return gutil::NotFoundErrorBuilder() << "Entry does not exist.";
+      }
+      entries.erase(it);
+      return absl::OkStatus();
+    default:
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Invalid update type " << update.type() << ".";
+  }
+}
+
+grpc::Status FakeP4RuntimeServer::Write(grpc::ServerContext* context,
+                                        const p4::v1::WriteRequest* request,
+                                        p4::v1::WriteResponse* response) {
+  WriteHook hook;
+  {
+    absl::MutexLock lock(&mutex_);
+    write_requests_.push_back(*request);
+    hook = write_hook_;
+  }
+  if (hook) {
+    grpc::Status status = hook(context, *request);
+    if (!status.ok()) return status;
+  }
+
+  IrWriteRpcStatus rpc_status;
+  {
+    absl::MutexLock lock(&mutex_);
+    EntriesByKey& entries = entries_by_device_[request->device_id()];
+    for (const Update& update : request->updates()) {
+      const absl::Status status = Apply(update, entries);
+      IrUpdateStatus* update_status =
+          rpc_status.mutable_rpc_response()->add_statuses();
+      update_status->set_code(static_cast<google::rpc::Code>(status.code()));
+      update_status->set_message(std::string(status.message()));
+    }
+  }
+  absl::StatusOr<grpc::Status> status =
+      IrWriteRpcStatusToGrpcStatus(rpc_status);
+  if (!status.ok()) {
+    return grpc::Status(grpc::StatusCode::INTERNAL,
+                        std::string(status.status().message()));
+  }
+  return *status;
+}
+
+grpc::Status FakeP4RuntimeServer::Read(
+    grpc::ServerContext* context, const p4::v1::ReadRequest* request,
+    grpc::ServerWriter<p4::v1::ReadResponse>* writer) {
+  std::vector<TableEntry> entries = TableEntries(request->device_id());
+  p4::v1::ReadResponse response;
+  for (const TableEntry& entry : entries) {
+    const bool requested =
+        absl::c_any_of(request->entities(), [&](const p4::v1::Entity& entity) {
+          return entity.has_table_entry() &&
+                 (entity.table_entry().table_id() == 0 ||
+                  entity.table_entry().table_id() == entry.table_id());
+        });
+    if (!requested) continue;
+    *response.add_entities()->mutable_table_entry() = entry;
+    if (response.entities_size() == kMaxEntitiesPerReadResponse) {
+      if (!writer->Write(response)) break;
+      response.Clear();
+    }
+  }
+  if (!response.entities().empty()) writer->Write(response);
+  if (context->IsCancelled()) {
+    return grpc::Status(grpc::StatusCode::CANCELLED, "Read was cancelled.");
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeP4RuntimeServer::SetForwardingPipelineConfig(
+    grpc::ServerContext* context,
+    const p4::v1::SetForwardingPipelineConfigRequest* request,
+    p4::v1::SetForwardingPipelineConfigResponse* response) {
+  absl::MutexLock lock(&mutex_);
+  set_forwarding_pipeline_config_requests_.push_back(*request);
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeP4RuntimeServer::StreamChannel(grpc::ServerContext* context,
+                                                Stream* stream) {
+  p4::v1::StreamMessageRequest request;
+  while (stream->Read(&request)) {
+    absl::MutexLock lock(&mutex_);
+    if (request.has_arbitration()) {
+      // Every client becomes the primary.
+      p4::v1::StreamMessageResponse response;
+      *response.mutable_arbitration() = request.arbitration();
+      response.mutable_arbitration()->mutable_status()->set_code(
+          google::rpc::OK);
+      stream->Write(response);
+      clients_.insert(stream);
+    } else if (request.has_packet()) {
+      packet_outs_.push_back(request.packet());
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  clients_.erase(stream);
+  return grpc::Status::OK;
+}
+
+}  // namespace pdpi
@@ -0,0 +1,145 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_P4_PDPI_TESTING_FAKE_P4RUNTIME_SERVER_H_
+#define GOOGLE_P4_PDPI_TESTING_FAKE_P4RUNTIME_SERVER_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "grpcpp/support/sync_stream.h"
+#include "p4/v1/p4runtime.grpc.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+
+namespace pdpi {
+
+// A P4Runtime server for tests of P4Runtime clients, running in the test's
+// process. It keeps the table entries written by clients per device, answers
+// arbitration requests, and records the requests and packets it receives.
+// Tests can delay or fail RPCs and updates with hooks, and send stream
+// messages (e.g. packets) to the connected clients. Thread-safe.
+class FakeP4RuntimeServer final : public p4::v1::P4Runtime::Service {
+ public:
+  // Called on every Write RPC before its updates are applied, e.g. to delay it
+  // until the RPC is cancelled. If it returns an error, the RPC fails with that
+  // RPC-wide error and no update is applied.
+  using WriteHook = std::function<grpc::Status(
+      grpc::ServerContext* context, const p4::v1::WriteRequest& request)>;
+  // Called on every update of a Write RPC with the entries installed on the
+  // device at that time, e.g. to reject deleting entries that others refer
+  // to. If it returns an error, the update fails with it.
+  using UpdateCheck = std::function<absl::Status(
+      const p4::v1::Update& update,
+      absl::Span<const p4::v1::TableEntry> installed)>;
+
+  // The maximum number of entities per response to a Read RPC, so that reads
+  // of few entries are streamed in several responses, too.
+  static constexpr int kMaxEntitiesPerReadResponse = 3;
+
+  // Starts the server, listening on a local port.
+  FakeP4RuntimeServer();
+  // Cancels all RPCs in flight and shuts the server down.
+  ~FakeP4RuntimeServer() override;
+
+  // Returns the address of the server, e.g. for CreateP4RuntimeStub.
+  const std::string& address() const { return address_; }
+  // Returns a stub that is connected to the server in-process.
+  std::unique_ptr<p4::v1::P4Runtime::Stub> NewStub();
+
+  void SetWriteHook(WriteHook hook);
+  void SetUpdateCheck(UpdateCheck check);
+
+  // Returns the entries installed on the given device, ordered by table ID.
+  std::vector<p4::v1::TableEntry> TableEntries(uint32_t device_id) const;
+  // Returns the requests received so far, in the order in which they arrived.
+  std::vector<p4::v1::WriteRequest> WriteRequests() const;
+  std::vector<p4::v1::SetForwardingPipelineConfigRequest>
+  SetForwardingPipelineConfigRequests() const;
+  // Returns the packets sent by clients so far, in the order in which they
+  // arrived.
+  std::vector<p4::v1::PacketOut> PacketOuts() const;
+
+  // Sends `message` on the stream channels of all clients that completed
+  // arbitration, and returns their number.
+  int SendToClients(const p4::v1::StreamMessageResponse& message);
+  // Waits until at least `n` clients completed arbitration and their stream
+  // channels are still open. Returns false if that did not happen in time.
+  bool WaitForClients(int n, absl::Duration timeout);
+  // Waits until at least `n` packets were received. Returns false if that did
+  // not happen in time.
+  bool WaitForPacketOuts(int n, absl::Duration timeout);
+
+  // P4Runtime RPCs.
+  grpc::Status Write(grpc::ServerContext* context,
+                     const p4::v1::WriteRequest* request,
+                     p4::v1::WriteResponse* response) override;
+  grpc::Status Read(grpc::ServerContext* context,
+                    const p4::v1::ReadRequest* request,
+                    grpc::ServerWriter<p4::v1::ReadResponse>* writer) override;
+  grpc::Status SetForwardingPipelineConfig(
+      grpc::ServerContext* context,
+      const p4::v1::SetForwardingPipelineConfigRequest* request,
+      p4::v1::SetForwardingPipelineConfigResponse* response) override;
+  grpc::Status StreamChannel(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<p4::v1::StreamMessageResponse,
+                               p4::v1::StreamMessageRequest>* stream) override;
+
+ private:
+  using Stream = grpc::ServerReaderWriter<p4::v1::StreamMessageResponse,
+                                          p4::v1::StreamMessageRequest>;
+  // The entries of a device, by their match key.
+  using EntriesByKey = std::map<std::string, p4::v1::TableEntry>;
+
+  // Applies `update` to `entries`.
+  absl::Status Apply(const p4::v1::Update& update, EntriesByKey& entries)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable absl::Mutex mutex_;
+  WriteHook write_hook_ ABSL_GUARDED_BY(mutex_);
+  UpdateCheck update_check_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<uint32_t, EntriesByKey> entries_by_device_
+      ABSL_GUARDED_BY(mutex_);
+  std::vector<p4::v1::WriteRequest> write_requests_ ABSL_GUARDED_BY(mutex_);
+  std::vector<p4::v1::SetForwardingPipelineConfigRequest>
+      set_forwarding_pipeline_config_requests_ ABSL_GUARDED_BY(mutex_);
+  std::vector<p4::v1::PacketOut> packet_outs_ ABSL_GUARDED_BY(mutex_);
+  // The stream channels of the clients that completed arbitration. Only
+  // written to while holding `mutex_`.
+  absl::flat_hash_set<Stream*> clients_ ABSL_GUARDED_BY(mutex_);
+
+  std::string address_;
+  // Declared last, so that it is shut down before the state it uses is
+  // destroyed.
+  std::unique_ptr<grpc::Server> server_;
+};
+
+}  // namespace pdpi
+
+#endif  // GOOGLE_P4_PDPI_TESTING_FAKE_P4RUNTIME_SERVER_H_
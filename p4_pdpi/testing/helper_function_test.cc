@@ -12,10 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "gmock/gmock.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor_database.h"
+#include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/message.h"
 #include "google/rpc/code.pb.h"
 #include "gtest/gtest.h"
@@ -91,5 +95,28 @@ TEST(SetEnumValueInProtoByReflectionTest, SetEnumWithInvalidFieldName) {
   ASSERT_FALSE(status_or_enum_code.ok());
 }
 
+// Messages whose descriptors are not in the generated pool (e.g. dynamic
+// messages) can be converted as well, even after their pool was destroyed and
+// another one was created, e.g. at the same address.
+TEST(GetEnumValueInProtoByReflectionTest, GetValueOfDynamicMessage) {
+  const auto pd_update_status =
+      gutil::ParseProtoOrDie<pdpi::UpdateStatus>(kPdUpdatestatus);
+  google::protobuf::DescriptorPoolDatabase database(
+      *google::protobuf::DescriptorPool::generated_pool());
+  for (int i = 0; i < 2; ++i) {
+    google::protobuf::DescriptorPool pool(&database);
+    const google::protobuf::Descriptor* descriptor = pool.FindMessageTypeByName(
+        pdpi::UpdateStatus::descriptor()->full_name());
+    ASSERT_NE(descriptor, nullptr);
+    ASSERT_NE(descriptor, pdpi::UpdateStatus::descriptor());
+    google::protobuf::DynamicMessageFactory factory(&pool);
+    std::unique_ptr<google::protobuf::Message> message(
+        factory.GetPrototype(descriptor)->New());
+    ASSERT_TRUE(message->ParseFromString(pd_update_status.SerializeAsString()));
+    EXPECT_THAT(GetEnumField(*message, "code"),
+                gutil::IsOkAndHolds(google::rpc::UNKNOWN));
+  }
+}
+
 }  // namespace
 }  // namespace pdpi
@@ -12,14 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <functional>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_join.h"
 #include "glog/logging.h"
+#include "google/protobuf/util/message_differencer.h"
 #include "gutil/status.h"
 #include "gutil/testing.h"
+#include "gutil/thread_pool.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
@@ -39,6 +44,69 @@ static void RunP4InfoTest(const std::string& test_name, const P4Info& p4info) {
     std::cout << status_or_info.value().DebugString() << std::endl;
   }
   std::cout << std::endl;
+
+  // Translating in parallel must give the same result.
+  gutil::ThreadPool pool(4);
+  absl::StatusOr<pdpi::IrP4Info> parallel_status_or_info =
+      pdpi::CreateIrP4Info(p4info, &pool);
+  if (parallel_status_or_info.status() != status_or_info.status()) {
+    Fail("Parallel pdpi::CreateIrP4Info() returned a different status");
+  } else if (status_or_info.ok() &&
+             !google::protobuf::util::MessageDifferencer::Equals(
+                 *parallel_status_or_info, *status_or_info)) {
+    Fail("Parallel pdpi::CreateIrP4Info() returned a different result");
+  }
+}
+
+static void PrintChanges(const std::string& kind,
+                         const pdpi::IrP4InfoEntityChanges& changes) {
+  if (changes.empty()) return;
+  std::cout << kind << ":" << std::endl;
+  if (!changes.added.empty()) {
+    std::cout << "  added: " << absl::StrJoin(changes.added, ", ") << std::endl;
+  }
+  if (!changes.removed.empty()) {
+    std::cout << "  removed: " << absl::StrJoin(changes.removed, ", ")
+              << std::endl;
+  }
+  if (!changes.modified.empty()) {
+    std::cout << "  modified: " << absl::StrJoin(changes.modified, ", ")
+              << std::endl;
+  }
+}
+
+// Updates the IrP4Info of `p4info` to the P4Info obtained by applying `mutate`
+// to it, and prints the changes. Fails if the result differs from creating
+// the IrP4Info of the mutated P4Info from scratch.
+static void RunP4InfoUpdateTest(const std::string& test_name,
+                                const P4Info& p4info,
+                                const std::function<void(P4Info&)>& mutate) {
+  std::cout << TestHeader(test_name) << std::endl << std::endl;
+  const pdpi::IrP4Info previous_info = pdpi::CreateIrP4Info(p4info).value();
+  P4Info new_p4info = p4info;
+  mutate(new_p4info);
+  pdpi::IrP4InfoChanges changes;
+  absl::StatusOr<pdpi::IrP4Info> status_or_info =
+      pdpi::UpdateIrP4Info(previous_info, p4info, new_p4info, &changes);
+  absl::StatusOr<pdpi::IrP4Info> expected = pdpi::CreateIrP4Info(new_p4info);
+  std::cout << "pdpi::UpdateIrP4Info() result:" << std::endl;
+  if (!status_or_info.ok()) {
+    std::cout << status_or_info.status() << std::endl;
+    if (status_or_info.status() != expected.status()) {
+      Fail("pdpi::CreateIrP4Info() returned a different status");
+    }
+  } else {
+    if (!expected.ok() || !google::protobuf::util::MessageDifferencer::Equals(
+                              *status_or_info, *expected)) {
+      Fail("pdpi::CreateIrP4Info() returned a different result");
+    }
+    if (changes.empty()) std::cout << "no changes" << std::endl;
+    PrintChanges("tables", changes.tables);
+    PrintChanges("actions", changes.actions);
+    PrintChanges("packet_in metadata", changes.packet_in_metadata);
+    PrintChanges("packet_out metadata", changes.packet_out_metadata);
+  }
+  std::cout << std::endl;
 }
 
 int main(int argc, char** argv) {
@@ -156,5 +224,45 @@ int main(int argc, char** argv) {
 
   RunP4InfoTest("main.p4", p4info);
 
+  RunP4InfoUpdateTest("update to the same P4Info", p4info,
+                      [](P4Info& p4info) {});
+  RunP4InfoUpdateTest("update with a modified action param", p4info,
+                      [](P4Info& p4info) {
+                        p4info.mutable_actions(0)->mutable_params(0)
+                            ->add_annotations("@format(IPV4_ADDRESS)");
+                      });
+  RunP4InfoUpdateTest("update with a removed table", p4info,
+                      [](P4Info& p4info) {
+                        p4info.mutable_tables()->RemoveLast();
+                      });
+  RunP4InfoUpdateTest("update with an added table", p4info,
+                      [](P4Info& p4info) {
+                        p4::config::v1::Table table = p4info.tables(0);
+                        table.mutable_preamble()->set_id(33554999);
+                        table.mutable_preamble()->set_name("ingress.new_table");
+                        table.mutable_preamble()->set_alias("new_table");
+                        *p4info.add_tables() = table;
+                      });
+  RunP4InfoUpdateTest("update with a modified direct counter", p4info,
+                      [](P4Info& p4info) {
+                        p4info.mutable_direct_counters(0)
+                            ->mutable_spec()
+                            ->set_unit(p4::config::v1::CounterSpec::PACKETS);
+                      });
+  RunP4InfoUpdateTest(
+      "update with added packet metadata", p4info, [](P4Info& p4info) {
+        for (auto& metadata : *p4info.mutable_controller_packet_metadata()) {
+          if (metadata.preamble().name() != "packet_in") continue;
+          auto* new_metadata = metadata.add_metadata();
+          new_metadata->set_id(100);
+          new_metadata->set_name("new_metadata");
+          new_metadata->set_bitwidth(8);
+        }
+      });
+  RunP4InfoUpdateTest("update with a duplicate table id", p4info,
+                      [](P4Info& p4info) {
+                        *p4info.add_tables() = p4info.tables(0);
+                      });
+
   return 0;
 }
@@ -0,0 +1,125 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/ir_p4info_artifact.h"
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::StatusIs;
+using ::p4::config::v1::P4Info;
+
+// Generated from main-p4info.pb.txt by the ir_p4info_artifact rule.
+constexpr char kMainArtifactFile[] = "p4_pdpi/testing/main-ir-p4info.bin";
+constexpr char kMainP4InfoFile[] = "p4_pdpi/testing/main-p4info.pb.txt";
+
+// The offsets of the layout version and of the IrP4Info in an artifact.
+constexpr int kVersionOffset = 8;
+constexpr int kIrP4InfoOffset = 40;
+
+P4Info SmallP4Info() {
+  return gutil::ParseProtoOrDie<P4Info>(R"pb(
+    tables {
+      preamble { id: 33554433 name: "ingress.table" alias: "table" }
+      match_fields {
+        id: 1
+        name: "ipv4"
+        annotations: "@format(IPV4_ADDRESS)"
+        bitwidth: 32
+        match_type: EXACT
+      }
+      action_refs { id: 16777217 annotations: "@proto_id(1)" }
+      size: 1024
+    }
+    actions {
+      preamble { id: 16777217 name: "ingress.action" alias: "action" }
+      params { id: 1 name: "port" bitwidth: 9 }
+    }
+  )pb");
+}
+
+TEST(IrP4InfoArtifactTest, ReadsGeneratedArtifact) {
+  const auto p4info = gutil::ParseProtoFileOrDie<P4Info>(kMainP4InfoFile);
+  ASSERT_OK_AND_ASSIGN(const IrP4Info expected, CreateIrP4Info(p4info));
+  EXPECT_THAT(ReadIrP4InfoArtifact(kMainArtifactFile, &p4info),
+              gutil::IsOkAndHolds(EqualsProto(expected)));
+}
+
+TEST(IrP4InfoArtifactTest, RoundTrips) {
+  const P4Info p4info = SmallP4Info();
+  ASSERT_OK_AND_ASSIGN(const IrP4Info expected, CreateIrP4Info(p4info));
+  ASSERT_OK_AND_ASSIGN(const std::string artifact,
+                       CreateIrP4InfoArtifact(p4info));
+  EXPECT_THAT(ParseIrP4InfoArtifact(artifact),
+              gutil::IsOkAndHolds(EqualsProto(expected)));
+  EXPECT_THAT(ParseIrP4InfoArtifact(artifact, &p4info),
+              gutil::IsOkAndHolds(EqualsProto(expected)));
+}
+
+TEST(IrP4InfoArtifactTest, RejectsArtifactOfOtherP4Info) {
+  P4Info p4info = SmallP4Info();
+  ASSERT_OK_AND_ASSIGN(const std::string artifact,
+                       CreateIrP4InfoArtifact(p4info));
+  p4info.mutable_tables(0)->set_size(2048);
+  EXPECT_THAT(ParseIrP4InfoArtifact(artifact, &p4info),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(IrP4InfoArtifactTest, RejectsCorruptedArtifact) {
+  ASSERT_OK_AND_ASSIGN(std::string artifact,
+                       CreateIrP4InfoArtifact(SmallP4Info()));
+  artifact[kIrP4InfoOffset + 10] ^= 0x01;
+  EXPECT_THAT(ParseIrP4InfoArtifact(artifact),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(IrP4InfoArtifactTest, RejectsTruncatedArtifact) {
+  ASSERT_OK_AND_ASSIGN(std::string artifact,
+                       CreateIrP4InfoArtifact(SmallP4Info()));
+  artifact.pop_back();
+  EXPECT_THAT(ParseIrP4InfoArtifact(artifact),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(IrP4InfoArtifactTest, RejectsOtherLayoutVersion) {
+  ASSERT_OK_AND_ASSIGN(std::string artifact,
+                       CreateIrP4InfoArtifact(SmallP4Info()));
+  artifact[kVersionOffset] = kIrP4InfoArtifactVersion + 1;
+  EXPECT_THAT(ParseIrP4InfoArtifact(artifact),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(IrP4InfoArtifactTest, RejectsOtherFiles) {
+  EXPECT_THAT(ParseIrP4InfoArtifact("tables { }"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ReadIrP4InfoArtifact(kMainP4InfoFile),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace pdpi
@@ -0,0 +1,133 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for GetCachedIrP4Info. The cache is shared by all tests, so each test
+// uses P4Infos with its own package names.
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::p4::config::v1::P4Info;
+
+constexpr char kMainP4InfoFile[] = "p4_pdpi/testing/main-p4info.pb.txt";
+
+// Returns the P4Info of main.p4, with the given package name.
+P4Info MainP4Info(const std::string& name) {
+  auto p4info = gutil::ParseProtoFileOrDie<P4Info>(kMainP4InfoFile);
+  p4info.mutable_pkg_info()->set_name(name);
+  return p4info;
+}
+
+TEST(IrP4InfoCacheTest, EqualP4InfosShareTheIrP4Info) {
+  const P4Info p4info = MainP4Info("equal");
+  ASSERT_OK_AND_ASSIGN(auto info, GetCachedIrP4Info(p4info));
+  ASSERT_OK_AND_ASSIGN(const IrP4Info expected, CreateIrP4Info(p4info));
+  EXPECT_THAT(*info, EqualsProto(expected));
+
+  ASSERT_OK_AND_ASSIGN(auto cached, GetCachedIrP4Info(p4info));
+  EXPECT_EQ(cached, info);
+  // A copy is equal, so its IrP4Info is cached as well.
+  const P4Info copy = p4info;
+  ASSERT_OK_AND_ASSIGN(cached, GetCachedIrP4Info(copy));
+  EXPECT_EQ(cached, info);
+}
+
+TEST(IrP4InfoCacheTest, P4InfosWithTheSameFingerprintAreDistinguished) {
+  const P4Info p4info = MainP4Info("same_fingerprint");
+  // Changes neither the size, nor the IDs and names of tables and actions.
+  P4Info modified = p4info;
+  std::string& alias = *modified.mutable_tables(0)->mutable_preamble()
+                            ->mutable_alias();
+  ASSERT_FALSE(alias.empty());
+  alias.back() = alias.back() == 'x' ? 'y' : 'x';
+
+  ASSERT_OK_AND_ASSIGN(auto info, GetCachedIrP4Info(p4info));
+  ASSERT_OK_AND_ASSIGN(auto modified_info, GetCachedIrP4Info(modified));
+  EXPECT_NE(modified_info, info);
+  ASSERT_OK_AND_ASSIGN(const IrP4Info expected, CreateIrP4Info(modified));
+  EXPECT_THAT(*modified_info, EqualsProto(expected));
+}
+
+TEST(IrP4InfoCacheTest, LeastRecentlyUsedIrP4InfoIsEvicted) {
+  std::vector<P4Info> p4infos;
+  for (int i = 0; i <= 16; ++i) {
+    p4infos.push_back(MainP4Info(absl::StrCat("eviction_", i)));
+  }
+  std::vector<std::shared_ptr<const IrP4Info>> infos;
+  for (int i = 0; i < 16; ++i) {
+    ASSERT_OK_AND_ASSIGN(infos.emplace_back(), GetCachedIrP4Info(p4infos[i]));
+  }
+  // All 16 IrP4Infos are cached. Using the first one makes the second one the
+  // least recently used.
+  for (int i = 0; i < 16; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto cached, GetCachedIrP4Info(p4infos[i]));
+    EXPECT_EQ(cached, infos[i]) << "P4Info #" << i;
+  }
+  ASSERT_OK_AND_ASSIGN(auto cached, GetCachedIrP4Info(p4infos[0]));
+  EXPECT_EQ(cached, infos[0]);
+
+  ASSERT_OK(GetCachedIrP4Info(p4infos[16]));
+  ASSERT_OK_AND_ASSIGN(cached, GetCachedIrP4Info(p4infos[0]));
+  EXPECT_EQ(cached, infos[0]);
+  ASSERT_OK_AND_ASSIGN(cached, GetCachedIrP4Info(p4infos[1]));
+  EXPECT_NE(cached, infos[1]);
+  EXPECT_THAT(*cached, EqualsProto(*infos[1]));
+}
+
+TEST(IrP4InfoCacheTest, ConcurrentCallsShareTheIrP4Info) {
+  constexpr int kNumThreads = 8;
+  const std::vector<P4Info> p4infos = {MainP4Info("concurrent_0"),
+                                       MainP4Info("concurrent_1")};
+  std::vector<std::vector<std::shared_ptr<const IrP4Info>>> infos(
+      kNumThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&p4infos, &infos, i] {
+      for (int j = 0; j < 20; ++j) {
+        auto info = GetCachedIrP4Info(p4infos[(i + j) % 2]);
+        infos[i].push_back(info.ok() ? *info : nullptr);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  ASSERT_OK_AND_ASSIGN(auto info_0, GetCachedIrP4Info(p4infos[0]));
+  ASSERT_OK_AND_ASSIGN(auto info_1, GetCachedIrP4Info(p4infos[1]));
+  EXPECT_NE(info_0, info_1);
+  for (int i = 0; i < kNumThreads; ++i) {
+    for (int j = 0; j < 20; ++j) {
+      EXPECT_EQ(infos[i][j], (i + j) % 2 == 0 ? info_0 : info_1)
+          << "Thread " << i << ", call " << j;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace pdpi
@@ -26,6 +26,7 @@
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/pd.h"
 #include "p4_pdpi/testing/main_p4_pd.pb.h"
+#include "p4_pdpi/testing/main_p4_pd_conversions.h"
 #include "p4_pdpi/testing/test_helper.h"
 
 using ::p4::config::v1::P4Info;
@@ -46,6 +47,9 @@ static void RunPdPacketInTest(const pdpi::IrP4Info& info,
       info, absl::StrCat("PacketIn test: ", test_name), pd,
       pdpi::PdPacketInToIr, pdpi::IrPacketInToPd, pdpi::IrPacketInToPi,
       pdpi::PiPacketInToIr, validity);
+  CheckGeneratedPdConversions<pdpi::PacketIn, pdpi::IrPacketIn>(
+      info, pd, pdpi::PdPacketInToIr, pdpi::IrPacketInToPd,
+      pdpi::PdPacketInToIr, pdpi::IrPacketInToPd);
 }
 
 static void RunPiPacketOutTest(const pdpi::IrP4Info& info,
@@ -64,6 +68,9 @@ static void RunPdPacketOutTest(const pdpi::IrP4Info& info,
       info, absl::StrCat("PacketOut test: ", test_name), pd,
       pdpi::PdPacketOutToIr, pdpi::IrPacketOutToPd, pdpi::IrPacketOutToPi,
       pdpi::PiPacketOutToIr, validity);
+  CheckGeneratedPdConversions<pdpi::PacketOut, pdpi::IrPacketOut>(
+      info, pd, pdpi::PdPacketOutToIr, pdpi::IrPacketOutToPd,
+      pdpi::PdPacketOutToIr, pdpi::IrPacketOutToPd);
 }
 
 static void RunPacketInTests(pdpi::IrP4Info info) {
@@ -0,0 +1,189 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/reconciliation.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "gutil/thread_pool.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
+#include "p4_pdpi/connection_management.h"
+#include "p4_pdpi/entity_management.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/testing/fake_p4runtime_server.h"
+#include "p4_pdpi/testing/test_p4info.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::StatusIs;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+using ::p4::v1::WriteRequest;
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+using ::testing::SizeIs;
+using ::testing::UnorderedElementsAre;
+
+constexpr uint32_t kDeviceId = 183807201;
+
+// Matches vectors of updates that equal `expected`.
+::testing::Matcher<std::vector<Update>> UpdatesAre(
+    const std::vector<Update>& expected) {
+  std::vector<::testing::Matcher<const Update&>> matchers;
+  for (const Update& update : expected) matchers.push_back(EqualsProto(update));
+  return ElementsAreArray(matchers);
+}
+
+class ReconciliationTest : public testing::Test {
+ protected:
+  const CompiledIrP4Info info_{TestIrP4Info()};
+};
+
+TEST_F(ReconciliationTest, DiffIsMinimal) {
+  // Same entry as Nexthop(1, 1, 1), up to param order and leading zeros.
+  TableEntry same = Nexthop(1, 1, 1);
+  same.mutable_action()->mutable_action()->mutable_params()->SwapElements(0, 1);
+  same.mutable_action()->mutable_action()->mutable_params(0)->set_value(
+      std::string("\x00\x00\x01", 3));
+  same.mutable_counter_data()->set_packet_count(42);
+
+  const std::vector<TableEntry> installed = {same, Nexthop(2, 1, 1),
+                                             Nexthop(3, 1, 1)};
+  const std::vector<TableEntry> desired = {Nexthop(4, 1, 1), Nexthop(2, 2, 1),
+                                           Nexthop(1, 1, 1), Nexthop(5, 1, 1)};
+  ASSERT_OK_AND_ASSIGN(TableEntryDiff diff,
+                       DiffTableEntries(info_, desired, installed));
+  EXPECT_THAT(diff.inserts,
+              UpdatesAre({MakeUpdate(Update::INSERT, Nexthop(4, 1, 1)),
+                          MakeUpdate(Update::INSERT, Nexthop(5, 1, 1))}));
+  EXPECT_THAT(diff.modifies,
+              UpdatesAre({MakeUpdate(Update::MODIFY, Nexthop(2, 2, 1))}));
+  EXPECT_THAT(diff.deletes,
+              UpdatesAre({MakeUpdate(Update::DELETE, Nexthop(3, 1, 1))}));
+
+  ASSERT_OK_AND_ASSIGN(diff, DiffTableEntries(info_, installed, installed));
+  EXPECT_THAT(diff.inserts, IsEmpty());
+  EXPECT_THAT(diff.modifies, IsEmpty());
+  EXPECT_THAT(diff.deletes, IsEmpty());
+}
+
+TEST_F(ReconciliationTest, ParallelDiffEqualsSerialDiff) {
+  std::vector<TableEntry> installed;
+  std::vector<TableEntry> desired;
+  for (int i = 0; i < 1000; ++i) {
+    if (i % 3 != 0) installed.push_back(Nexthop(i, 1, 1));
+    if (i % 5 != 0) desired.push_back(Nexthop(i, i % 7 == 0 ? 2 : 1, 1));
+  }
+  ASSERT_OK_AND_ASSIGN(const TableEntryDiff serial,
+                       DiffTableEntries(info_, desired, installed));
+  gutil::ThreadPool pool(4);
+  ASSERT_OK_AND_ASSIGN(const TableEntryDiff parallel,
+                       DiffTableEntries(info_, desired, installed, &pool));
+  EXPECT_THAT(parallel.inserts, UpdatesAre(serial.inserts));
+  EXPECT_THAT(parallel.modifies, UpdatesAre(serial.modifies));
+  EXPECT_THAT(parallel.deletes, UpdatesAre(serial.deletes));
+  // Entries i with i % 3 == 0 and i % 5 != 0 are inserted, and so on.
+  EXPECT_EQ(serial.inserts.size(), 267);
+  EXPECT_EQ(serial.modifies.size(), 76);
+  EXPECT_EQ(serial.deletes.size(), 133);
+}
+
+TEST_F(ReconciliationTest, DiffOfIrEntriesEqualsDiffOfPiEntries) {
+  const std::vector<TableEntry> installed = {Nexthop(1, 1, 1),
+                                             Nexthop(2, 1, 1)};
+  std::vector<IrTableEntry> ir_desired;
+  std::vector<TableEntry> desired;
+  for (const TableEntry& entry : {Nexthop(2, 2, 1), Nexthop(3, 1, 1)}) {
+    ASSERT_OK_AND_ASSIGN(ir_desired.emplace_back(),
+                         PiTableEntryToIr(info_, entry));
+    // The canonical PI form of the entry, which the IR entry translates to.
+    ASSERT_OK_AND_ASSIGN(desired.emplace_back(),
+                         IrTableEntryToPi(info_, ir_desired.back()));
+  }
+  ASSERT_OK_AND_ASSIGN(const TableEntryDiff pi_diff,
+                       DiffTableEntries(info_, desired, installed));
+  ASSERT_OK_AND_ASSIGN(const TableEntryDiff ir_diff,
+                       DiffTableEntries(info_, ir_desired, installed));
+  EXPECT_THAT(ir_diff.inserts, UpdatesAre(pi_diff.inserts));
+  EXPECT_THAT(ir_diff.modifies, UpdatesAre(pi_diff.modifies));
+  EXPECT_THAT(ir_diff.deletes, UpdatesAre(pi_diff.deletes));
+}
+
+TEST_F(ReconciliationTest, DiffRejectsInvalidAndDuplicateEntries) {
+  const std::vector<TableEntry> valid = {Nexthop(1, 1, 1), Nexthop(2, 1, 1)};
+  const std::vector<TableEntry> duplicates = {
+      Nexthop(1, 1, 1), Nexthop(2, 1, 1), Nexthop(1, 2, 1)};
+  EXPECT_THAT(DiffTableEntries(info_, duplicates, valid),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(DiffTableEntries(info_, valid, duplicates),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  // Duplicates that are not installed are rejected as well.
+  EXPECT_THAT(DiffTableEntries(info_, duplicates, {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  TableEntry unknown_table = Nexthop(3, 1, 1);
+  unknown_table.set_table_id(1);
+  EXPECT_THAT(DiffTableEntries(info_, {unknown_table}, valid),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(DiffTableEntries(info_, valid, {unknown_table}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(ReconciliationTest, ReconcileSendsInsertsThenModifiesThenDeletes) {
+  FakeP4RuntimeServer fake;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<P4RuntimeSession> session,
+                       P4RuntimeSession::Create(fake.NewStub(), kDeviceId));
+  ASSERT_OK(InstallPiTableEntries(
+      session.get(), {Nexthop(1, 1, 1), Nexthop(2, 1, 1), Nexthop(3, 1, 1)}));
+
+  ASSERT_OK(ReconcileTableEntries(
+      session.get(), info_,
+      {Nexthop(1, 1, 1), Nexthop(2, 2, 1), Nexthop(4, 1, 1)}));
+  EXPECT_THAT(fake.TableEntries(kDeviceId),
+              UnorderedElementsAre(EqualsProto(Nexthop(1, 1, 1)),
+                                   EqualsProto(Nexthop(2, 2, 1)),
+                                   EqualsProto(Nexthop(4, 1, 1))));
+  const std::vector<WriteRequest> requests = fake.WriteRequests();
+  ASSERT_THAT(requests, SizeIs(4));
+  EXPECT_THAT(requests[1].updates(),
+              ElementsAre(EqualsProto(
+                  MakeUpdate(Update::INSERT, Nexthop(4, 1, 1)))));
+  EXPECT_THAT(requests[2].updates(),
+              ElementsAre(EqualsProto(
+                  MakeUpdate(Update::MODIFY, Nexthop(2, 2, 1)))));
+  EXPECT_THAT(requests[3].updates(),
+              ElementsAre(EqualsProto(
+                  MakeUpdate(Update::DELETE, Nexthop(3, 1, 1)))));
+
+  // Once the switch has the desired entries, nothing is sent.
+  ASSERT_OK(ReconcileTableEntries(
+      session.get(), info_,
+      {Nexthop(1, 1, 1), Nexthop(2, 2, 1), Nexthop(4, 1, 1)}));
+  EXPECT_THAT(fake.WriteRequests(), SizeIs(4));
+}
+
+}  // namespace
+}  // namespace pdpi
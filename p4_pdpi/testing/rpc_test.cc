@@ -27,6 +27,7 @@
 #include "grpcpp/grpcpp.h"
 #include "gutil/status.h"
 #include "gutil/testing.h"
+#include "gutil/thread_pool.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.h"
@@ -731,6 +732,94 @@ static void RunWriteRpcStatusTest() {
       3, INPUT_IS_VALID);
 }
 
+// Prints the results of a batch translation done on the calling thread, and
+// checks that translating in parallel yields the same results.
+template <typename Output>
+static void CheckBatchResults(
+    const std::vector<absl::StatusOr<Output>>& serial,
+    const std::vector<absl::StatusOr<Output>>& parallel) {
+  for (int i = 0; i < serial.size(); ++i) {
+    std::cout << "--- Result " << i << ":" << std::endl;
+    if (serial[i].ok()) {
+      std::cout << serial[i]->DebugString() << std::endl;
+    } else {
+      std::cout << serial[i].status() << std::endl << std::endl;
+    }
+  }
+  if (serial.size() != parallel.size()) {
+    Fail("Parallel translation returned a different number of results");
+    return;
+  }
+  for (int i = 0; i < serial.size(); ++i) {
+    if (serial[i].status() != parallel[i].status() ||
+        (serial[i].ok() && !google::protobuf::util::MessageDifferencer::Equals(
+                               *serial[i], *parallel[i]))) {
+      Fail(absl::StrCat("Parallel translation differs for result ", i));
+    }
+  }
+}
+
+static void RunBatchTests(const pdpi::IrP4Info& info) {
+  gutil::ThreadPool pool(4);
+
+  const auto ir_entry = gutil::ParseProtoOrDie<pdpi::IrTableEntry>(R"PB(
+    table_name: "ternary_table"
+    matches {
+      name: "normal"
+      ternary {
+        value { hex_str: "0x52" }
+        mask { hex_str: "0x273" }
+      }
+    }
+    priority: 32
+    action {
+      name: "do_thing_3"
+      params {
+        name: "arg1"
+        value { hex_str: "0x23" }
+      }
+      params {
+        name: "arg2"
+        value { hex_str: "0x251" }
+      }
+    }
+  )PB");
+  const auto pi_entry = pdpi::IrTableEntryToPi(info, ir_entry);
+  CHECK_OK(pi_entry.status());
+
+  p4::v1::ReadResponse read_response;
+  *read_response.add_entities()->mutable_table_entry() = *pi_entry;
+  read_response.add_entities()->mutable_action_profile_member();
+  *read_response.add_entities()->mutable_table_entry() = *pi_entry;
+  read_response.mutable_entities(2)->mutable_table_entry()->set_priority(0);
+  *read_response.add_entities()->mutable_table_entry() = *pi_entry;
+
+  std::cout << TestHeader("Batch test: PiEntitiesToIr with invalid entities")
+            << std::endl
+            << std::endl;
+  std::cout << "--- PI (Input):" << std::endl;
+  std::cout << read_response.DebugString() << std::endl;
+  CheckBatchResults(
+      pdpi::PiEntitiesToIr(info, read_response.entities()),
+      pdpi::PiEntitiesToIr(info, read_response.entities(), &pool));
+
+  pdpi::IrWriteRequest write_request;
+  for (int i = 0; i < 3; ++i) {
+    auto& update = *write_request.add_updates();
+    update.set_type(p4::v1::Update::INSERT);
+    *update.mutable_table_entry() = ir_entry;
+  }
+  write_request.mutable_updates(1)->set_type(p4::v1::Update::UNSPECIFIED);
+
+  std::cout << TestHeader("Batch test: IrUpdatesToPi with invalid updates")
+            << std::endl
+            << std::endl;
+  std::cout << "--- IR (Input):" << std::endl;
+  std::cout << write_request.DebugString() << std::endl;
+  CheckBatchResults(pdpi::IrUpdatesToPi(info, write_request.updates()),
+                    pdpi::IrUpdatesToPi(info, write_request.updates(), &pool));
+}
+
 int main(int argc, char** argv) {
   CHECK(argc == 2);  // Usage: rpc_test <p4info file>.
   const auto p4info =
@@ -745,5 +834,6 @@ int main(int argc, char** argv) {
   RunUpdateTests(info);
   RunWriteRequestTests(info);
   RunWriteRpcStatusTest();
+  RunBatchTests(info);
   return 0;
 }
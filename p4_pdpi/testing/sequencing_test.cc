@@ -0,0 +1,137 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/sequencing.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/testing/test_p4info.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::p4::config::v1::P4Info;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(SequencingTest, InsertsComeAfterTheEntriesTheyReferTo) {
+  const std::vector<Update> updates = {
+      MakeUpdate(Update::INSERT, WcmpGroup(1, {10, 11})),
+      MakeUpdate(Update::INSERT, Nexthop(10, 1, 7)),
+      MakeUpdate(Update::INSERT, Neighbor(1, 7)),
+      MakeUpdate(Update::INSERT, Rif(1)),
+      MakeUpdate(Update::INSERT, Rif(2)),
+      MakeUpdate(Update::MODIFY, Nexthop(11, 1, 7)),
+  };
+  EXPECT_THAT(SequencePiUpdatesInBatches(TestIrP4Info(), updates),
+              IsOkAndHolds(ElementsAre(ElementsAre(3, 4), ElementsAre(2),
+                                       ElementsAre(1, 5), ElementsAre(0))));
+  EXPECT_THAT(SequencePiUpdatesInBatches(TestIrP4Info(), {}),
+              IsOkAndHolds(IsEmpty()));
+}
+
+TEST(SequencingTest, DeletesComeAfterTheEntriesThatReferToThem) {
+  const std::vector<Update> updates = {
+      MakeUpdate(Update::DELETE, Rif(1)),
+      MakeUpdate(Update::DELETE, Neighbor(1, 7)),
+      MakeUpdate(Update::DELETE, Nexthop(10, 1, 7)),
+      MakeUpdate(Update::DELETE, WcmpGroup(1, {10})),
+      MakeUpdate(Update::INSERT, Rif(2)),
+  };
+  EXPECT_THAT(SequencePiUpdatesInBatches(TestIrP4Info(), updates),
+              IsOkAndHolds(ElementsAre(ElementsAre(4), ElementsAre(3),
+                                       ElementsAre(2), ElementsAre(1),
+                                       ElementsAre(0))));
+}
+
+TEST(SequencingTest, FieldsReferringToTheSameTableReferToOneEntry) {
+  TableEntry leading_zeros = Nexthop(10, 1, 7);
+  leading_zeros.mutable_action()->mutable_action()->mutable_params(1)
+      ->set_value(std::string("\x00\x00\x07", 3));
+  const std::vector<Update> updates = {
+      MakeUpdate(Update::INSERT, Nexthop(10, 1, 7)),
+      MakeUpdate(Update::INSERT, Neighbor(2, 7)),
+      MakeUpdate(Update::INSERT, Neighbor(1, 8)),
+      MakeUpdate(Update::INSERT, leading_zeros),
+      MakeUpdate(Update::INSERT, Neighbor(1, 7)),
+  };
+  EXPECT_THAT(SequencePiUpdatesInBatches(TestIrP4Info(), updates),
+              IsOkAndHolds(ElementsAre(ElementsAre(1, 2, 4),
+                                       ElementsAre(0, 3))));
+}
+
+TEST(SequencingTest, CyclesAreRejected) {
+  P4Info p4info = TestP4Info();
+  // Lets router interfaces refer to nexthops.
+  auto* match_field = p4info.mutable_tables(0)->mutable_match_fields(0);
+  match_field->add_annotations("@refers_to(nexthop_table, nexthop_id)");
+  ASSERT_OK_AND_ASSIGN(const IrP4Info info, CreateIrP4Info(p4info));
+
+  std::vector<Update> updates = {
+      MakeUpdate(Update::INSERT, Rif(10)),
+      MakeUpdate(Update::INSERT, Nexthop(10, 10, 7)),
+  };
+  EXPECT_THAT(SequencePiUpdatesInBatches(info, updates),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  for (Update& update : updates) update.set_type(Update::DELETE);
+  EXPECT_THAT(SequencePiUpdatesInBatches(info, updates),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  // Without the cycle, the updates can be sequenced.
+  updates[0] = MakeUpdate(Update::DELETE, Rif(11));
+  EXPECT_THAT(SequencePiUpdatesInBatches(info, updates),
+              IsOkAndHolds(ElementsAre(ElementsAre(0, 1))));
+}
+
+TEST(SequencingTest, MalformedAnnotationsAreRejected) {
+  for (const std::string& annotation :
+       {"@refers_to(rif_table)", "@refers_to(unknown_table, rif_id)",
+        "@refers_to(rif_table, unknown_field)"}) {
+    P4Info p4info = TestP4Info();
+    p4info.mutable_tables(0)->mutable_match_fields(0)->add_annotations(
+        annotation);
+    ASSERT_OK_AND_ASSIGN(const IrP4Info info, CreateIrP4Info(p4info));
+    EXPECT_THAT(SequencePiUpdatesInBatches(info, {}),
+                StatusIs(absl::StatusCode::kInvalidArgument))
+        << annotation;
+  }
+}
+
+TEST(SequencingTest, ReferredTableIdsAreTheTablesEntriesMayReferTo) {
+  ASSERT_OK_AND_ASSIGN(const P4InfoReferences references,
+                       P4InfoReferences::Create(TestIrP4Info()));
+  EXPECT_THAT(references.ReferredTableIds(kRifTableId), IsEmpty());
+  EXPECT_THAT(references.ReferredTableIds(kNeighborTableId),
+              ElementsAre(kRifTableId));
+  EXPECT_THAT(references.ReferredTableIds(kNexthopTableId),
+              ElementsAre(kRifTableId, kNeighborTableId));
+  EXPECT_THAT(references.ReferredTableIds(kRouteTableId),
+              ElementsAre(kNexthopTableId));
+  EXPECT_THAT(references.ReferredTableIds(kAclTableId), IsEmpty());
+}
+
+}  // namespace
+}  // namespace pdpi
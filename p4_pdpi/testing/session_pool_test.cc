@@ -0,0 +1,148 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/session_pool.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "grpcpp/security/credentials.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/connection_management.h"
+#include "p4_pdpi/testing/fake_p4runtime_server.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::p4::v1::TableEntry;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::SizeIs;
+
+// Nothing listens on this address.
+constexpr char kUnreachableAddress[] = "localhost:1";
+
+TableEntry Entry(int id) {
+  TableEntry entry = gutil::ParseProtoOrDie<TableEntry>(R"pb(
+    table_id: 33554433
+    match { field_id: 1 }
+    action { action { action_id: 16777217 } }
+  )pb");
+  entry.mutable_match(0)->mutable_exact()->set_value(std::string(1, id));
+  return entry;
+}
+
+class SessionPoolTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    pool_ = P4RuntimeSessionPool::Create(
+        {{fake_.address(), 1}, {fake_.address(), 2}, {kUnreachableAddress, 3}},
+        grpc::InsecureChannelCredentials());
+  }
+
+  FakeP4RuntimeServer fake_;
+  std::unique_ptr<P4RuntimeSessionPool> pool_;
+};
+
+TEST_F(SessionPoolTest, SessionsAreEstablishedPerDevice) {
+  ASSERT_EQ(pool_->size(), 3);
+  EXPECT_EQ(pool_->device(2).address, kUnreachableAddress);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(P4RuntimeSession * session, pool_->session(i));
+    EXPECT_EQ(session->DeviceId(), pool_->device(i).device_id);
+  }
+  EXPECT_THAT(pool_->session(2).status().message(),
+              HasSubstr("Failed to establish session with device 3 at "
+                        "localhost:1"));
+  EXPECT_TRUE(fake_.WaitForClients(2, absl::Seconds(10)));
+}
+
+TEST_F(SessionPoolTest, EntriesAreInstalledAndReadPerDevice) {
+  const std::vector<TableEntry> entries = {Entry(1), Entry(2)};
+  std::vector<absl::Status> results = pool_->InstallPiTableEntries(entries);
+  ASSERT_THAT(results, SizeIs(3));
+  EXPECT_OK(results[0]);
+  EXPECT_OK(results[1]);
+  EXPECT_EQ(results[2], pool_->session(2).status());
+  EXPECT_THAT(fake_.TableEntries(1), SizeIs(2));
+  EXPECT_THAT(fake_.TableEntries(2), SizeIs(2));
+
+  // Errors of one device do not affect the others.
+  ASSERT_OK_AND_ASSIGN(P4RuntimeSession * session, pool_->session(1));
+  ASSERT_OK(InstallPiTableEntry(session, Entry(3)));
+  results = pool_->InstallPiTableEntries({Entry(3)});
+  EXPECT_OK(results[0]);
+  EXPECT_THAT(results[1], StatusIs(absl::StatusCode::kUnknown,
+                                   HasSubstr("ALREADY_EXISTS")));
+
+  const auto read = pool_->ReadPiTableEntries();
+  ASSERT_THAT(read, SizeIs(3));
+  EXPECT_THAT(read[0],
+              IsOkAndHolds(ElementsAre(EqualsProto(Entry(1)),
+                                       EqualsProto(Entry(2)),
+                                       EqualsProto(Entry(3)))));
+  EXPECT_THAT(read[1], IsOkAndHolds(SizeIs(3)));
+  EXPECT_EQ(read[2].status(), pool_->session(2).status());
+}
+
+TEST_F(SessionPoolTest, ForEachSessionReturnsTheResultsPerDevice) {
+  const std::vector<absl::Status> results =
+      pool_->ForEachSession([](P4RuntimeSession* session) -> absl::Status {
+        if (session->DeviceId() == 2) {
+          return gutil::InternalErrorBuilder() << "Device 2 failed.";
+        }
+        return absl::OkStatus();
+      });
+  EXPECT_THAT(results, ElementsAre(absl::OkStatus(),
+                                   StatusIs(absl::StatusCode::kInternal,
+                                            "Device 2 failed."),
+                                   pool_->session(2).status()));
+}
+
+TEST_F(SessionPoolTest, ForEachSessionRunsConcurrently) {
+  absl::Mutex mutex;
+  int num_started = 0;
+  // Each call only succeeds if the calls of both sessions overlap.
+  const std::vector<absl::Status> results =
+      pool_->ForEachSession([&](P4RuntimeSession*) -> absl::Status {
+        absl::MutexLock lock(&mutex);
+        ++num_started;
+        auto all_started = [&num_started] { return num_started == 2; };
+        if (!mutex.AwaitWithTimeout(absl::Condition(&all_started),
+                                    absl::Seconds(10))) {
+          return gutil::DeadlineExceededErrorBuilder()
+                 << "The other session was not used concurrently.";
+        }
+        return absl::OkStatus();
+      });
+  ASSERT_THAT(results, SizeIs(3));
+  EXPECT_OK(results[0]);
+  EXPECT_OK(results[1]);
+}
+
+}  // namespace
+}  // namespace pdpi
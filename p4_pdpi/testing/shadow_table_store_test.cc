@@ -0,0 +1,193 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/shadow_table_store.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "google/rpc/code.pb.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/testing/test_p4info.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::StatusIs;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+IrWriteResponse Response(const std::vector<google::rpc::Code>& codes) {
+  IrWriteResponse response;
+  for (google::rpc::Code code : codes) response.add_statuses()->set_code(code);
+  return response;
+}
+
+TEST(ShadowTableStoreTest, InsertModifyDelete) {
+  ShadowTableStore store(TestIrP4Info());
+  EXPECT_EQ(store.Lookup(Nexthop(1, 1, 1)), nullptr);
+  ASSERT_OK(store.Insert(Nexthop(1, 1, 1)));
+  EXPECT_THAT(store.Insert(Nexthop(1, 2, 1)),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+  ASSERT_NE(store.Lookup(Nexthop(1, 2, 1)), nullptr);
+  EXPECT_THAT(*store.Lookup(Nexthop(1, 2, 1)), EqualsProto(Nexthop(1, 1, 1)));
+  EXPECT_EQ(store.size(), 1);
+
+  ASSERT_OK(store.Modify(Nexthop(1, 2, 1)));
+  EXPECT_THAT(store.GetTableEntries(kNexthopTableId),
+              ElementsAre(EqualsProto(Nexthop(1, 2, 1))));
+  EXPECT_THAT(store.GetTableEntries(kRifTableId), IsEmpty());
+
+  ASSERT_OK(store.Delete(Nexthop(1, 3, 1)));
+  EXPECT_FALSE(store.Contains(Nexthop(1, 1, 1)));
+  EXPECT_EQ(store.size(), 0);
+  EXPECT_THAT(store.Delete(Nexthop(1, 1, 1)),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(store.Modify(Nexthop(1, 1, 1)),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(ShadowTableStoreTest, KeyIsTableMatchesAndPriority) {
+  ShadowTableStore store(TestIrP4Info());
+  ASSERT_OK(store.Insert(AclEntry()));
+
+  // The order of match fields and leading zeros do not matter.
+  TableEntry same_key = AclEntry();
+  same_key.mutable_match()->SwapElements(0, 1);
+  same_key.mutable_match(1)->mutable_optional()->set_value(
+      std::string("\x00\x01\x02", 3));
+  EXPECT_TRUE(store.Contains(same_key));
+
+  TableEntry unknown_table = AclEntry();
+  unknown_table.set_table_id(1);
+  EXPECT_FALSE(store.Contains(unknown_table));
+  EXPECT_THAT(store.Insert(unknown_table),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  TableEntry other_priority = AclEntry();
+  other_priority.set_priority(11);
+  EXPECT_FALSE(store.Contains(other_priority));
+  TableEntry other_mask = AclEntry();
+  other_mask.mutable_match(1)->mutable_ternary()->set_mask("\xff\xff\xff\x00");
+  EXPECT_FALSE(store.Contains(other_mask));
+  TableEntry fewer_matches = AclEntry();
+  fewer_matches.mutable_match()->RemoveLast();
+  EXPECT_FALSE(store.Contains(fewer_matches));
+}
+
+TEST(ShadowTableStoreTest, ApplyWriteResponseAppliesSuccessfulUpdates) {
+  ShadowTableStore store(TestIrP4Info());
+  std::vector<Update> updates = {
+      MakeUpdate(Update::INSERT, Nexthop(1, 1, 1)),
+      MakeUpdate(Update::INSERT, Nexthop(2, 1, 1))};
+  ASSERT_OK(store.ApplyWriteResponse(
+      updates, Response({google::rpc::OK, google::rpc::RESOURCE_EXHAUSTED})));
+  EXPECT_TRUE(store.Contains(Nexthop(1, 1, 1)));
+  EXPECT_FALSE(store.Contains(Nexthop(2, 1, 1)));
+
+  updates = {MakeUpdate(Update::MODIFY, Nexthop(1, 2, 1))};
+  ASSERT_OK(store.ApplyWriteResponse(updates, Response({google::rpc::OK})));
+  EXPECT_THAT(*store.Lookup(Nexthop(1, 1, 1)), EqualsProto(Nexthop(1, 2, 1)));
+
+  updates = {MakeUpdate(Update::DELETE, Nexthop(1, 2, 1))};
+  EXPECT_THAT(store.ApplyWriteResponse(updates, Response({})),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  ASSERT_OK(store.ApplyWriteResponse(updates, Response({google::rpc::OK})));
+  EXPECT_EQ(store.size(), 0);
+}
+
+TEST(ShadowTableStoreTest, ApplyWriteResponseRepairsOutOfSyncStore) {
+  ShadowTableStore store(TestIrP4Info());
+  ASSERT_OK(store.Insert(Nexthop(1, 1, 1)));
+  std::vector<Update> updates = {
+      MakeUpdate(Update::INSERT, Nexthop(1, 2, 1)),
+      MakeUpdate(Update::MODIFY, Nexthop(2, 1, 1))};
+  EXPECT_THAT(store.ApplyWriteResponse(
+                  updates, Response({google::rpc::OK, google::rpc::OK})),
+              StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(store.GetTableEntries(kNexthopTableId),
+              UnorderedElementsAre(EqualsProto(Nexthop(1, 2, 1)),
+                                   EqualsProto(Nexthop(2, 1, 1))));
+  EXPECT_EQ(store.size(), 2);
+}
+
+TEST(ShadowTableStoreTest, RemoveDuplicateInsertsRemovesEqualEntries) {
+  ShadowTableStore store(TestIrP4Info());
+  ASSERT_OK(store.Insert(Nexthop(1, 1, 1)));
+  const std::vector<Update> updates = {
+      MakeUpdate(Update::INSERT, Nexthop(1, 1, 1)),
+      MakeUpdate(Update::INSERT, Nexthop(2, 1, 1)),
+      MakeUpdate(Update::INSERT, Nexthop(2, 1, 1)),
+      MakeUpdate(Update::MODIFY, Nexthop(2, 2, 1)),
+      MakeUpdate(Update::INSERT, Nexthop(2, 2, 1)),
+  };
+  EXPECT_THAT(store.RemoveDuplicateInserts(updates),
+              ElementsAre(EqualsProto(updates[1]), EqualsProto(updates[3])));
+  EXPECT_THAT(store.RemoveDuplicateInserts({}), IsEmpty());
+}
+
+TEST(ShadowTableStoreTest, RemoveDuplicateInsertsKeepsConflictingEntries) {
+  ShadowTableStore store(TestIrP4Info());
+  ASSERT_OK(store.Insert(Nexthop(1, 1, 1)));
+  // Same keys as the installed or earlier inserted entries, other actions.
+  const std::vector<Update> updates = {
+      MakeUpdate(Update::INSERT, Nexthop(1, 2, 1)),
+      MakeUpdate(Update::INSERT, Nexthop(2, 1, 1)),
+      MakeUpdate(Update::INSERT, Nexthop(2, 1, 2)),
+      // Equal to the entry that is still installed.
+      MakeUpdate(Update::INSERT, Nexthop(1, 1, 1)),
+  };
+  EXPECT_THAT(store.RemoveDuplicateInserts(updates),
+              ElementsAre(EqualsProto(updates[0]), EqualsProto(updates[1]),
+                          EqualsProto(updates[2])));
+}
+
+TEST(ShadowTableStoreTest, RemoveDuplicateInsertsKeepsInsertsAfterDeletes) {
+  ShadowTableStore store(TestIrP4Info());
+  ASSERT_OK(store.Insert(Nexthop(1, 1, 1)));
+  const std::vector<Update> updates = {
+      MakeUpdate(Update::DELETE, Nexthop(1, 1, 1)),
+      MakeUpdate(Update::INSERT, Nexthop(1, 1, 1)),
+      MakeUpdate(Update::INSERT, Nexthop(1, 1, 1)),
+      MakeUpdate(Update::DELETE, Nexthop(1, 1, 1)),
+      MakeUpdate(Update::INSERT, Nexthop(1, 2, 1)),
+  };
+  EXPECT_THAT(store.RemoveDuplicateInserts(updates),
+              ElementsAre(EqualsProto(updates[0]), EqualsProto(updates[1]),
+                          EqualsProto(updates[3]), EqualsProto(updates[4])));
+}
+
+TEST(ShadowTableStoreTest, RemoveDuplicateInsertsKeepsInvalidEntries) {
+  ShadowTableStore store(TestIrP4Info());
+  TableEntry unknown_table = Nexthop(1, 1, 1);
+  unknown_table.set_table_id(1);
+  const std::vector<Update> updates = {
+      MakeUpdate(Update::INSERT, unknown_table),
+      MakeUpdate(Update::INSERT, unknown_table),
+  };
+  EXPECT_THAT(store.RemoveDuplicateInserts(updates),
+              ElementsAre(EqualsProto(updates[0]), EqualsProto(updates[1])));
+}
+
+}  // namespace
+}  // namespace pdpi
@@ -0,0 +1,130 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/table_entry_key.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/hash/hash_testing.h"
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/testing/test_p4info.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::StatusIs;
+using ::p4::v1::TableEntry;
+
+TEST(TableEntryKeyTest, IrKeyEqualsPiKey) {
+  const IrP4Info info = TestIrP4Info();
+  const CompiledIrP4Info compiled_info(info);
+  ASSERT_OK_AND_ASSIGN(const IrTableEntry ir,
+                       PiTableEntryToIr(info, AclEntry()));
+  ASSERT_OK_AND_ASSIGN(const TableEntryKey key,
+                       PiTableEntryKey(info, AclEntry()));
+  EXPECT_EQ(key.table_id(), kAclTableId);
+  EXPECT_EQ(key.priority(), 10);
+  EXPECT_THAT(PiTableEntryKey(compiled_info, AclEntry()),
+              gutil::IsOkAndHolds(key));
+  EXPECT_THAT(IrTableEntryKey(info, ir), gutil::IsOkAndHolds(key));
+  EXPECT_THAT(IrTableEntryKey(compiled_info, ir), gutil::IsOkAndHolds(key));
+}
+
+TEST(TableEntryKeyTest, KeyIgnoresMatchOrderLeadingZerosAndAction) {
+  const IrP4Info info = TestIrP4Info();
+  TableEntry entry = AclEntry();
+  entry.mutable_match()->SwapElements(0, 3);
+  entry.mutable_match(0)->mutable_lpm()->set_value(
+      std::string("\x00\x12\x00", 3));
+  entry.mutable_match(3)->mutable_optional()->set_value(
+      std::string("\x00\x01\x02", 3));
+  entry.mutable_action()->mutable_action()->add_params()->set_value("a");
+  ASSERT_OK_AND_ASSIGN(const TableEntryKey key, PiTableEntryKey(info, entry));
+  EXPECT_THAT(PiTableEntryKey(info, AclEntry()), gutil::IsOkAndHolds(key));
+}
+
+TEST(TableEntryKeyTest, KeysOfDifferentEntriesDiffer) {
+  const IrP4Info info = TestIrP4Info();
+  std::vector<TableEntry> entries(6, AclEntry());
+  entries[1].set_priority(11);
+  entries[2].mutable_match(1)->mutable_ternary()->set_mask("\xff\xff\xff\x00");
+  entries[3].mutable_match(2)->mutable_exact()->set_value("vrf-2");
+  entries[4].mutable_match(3)->mutable_lpm()->set_prefix_len(8);
+  entries[5].mutable_match()->RemoveLast();
+  std::vector<TableEntryKey> keys;
+  for (const TableEntry& entry : entries) {
+    ASSERT_OK_AND_ASSIGN(TableEntryKey key, PiTableEntryKey(info, entry));
+    keys.push_back(key);
+  }
+  keys.push_back(TableEntryKey());
+  for (int i = 0; i < keys.size(); ++i) {
+    for (int j = 0; j < keys.size(); ++j) {
+      EXPECT_EQ(keys[i] == keys[j], i == j) << i << " " << j;
+      // Exactly one of i < j, j < i and i == j holds.
+      EXPECT_EQ((keys[i] < keys[j]) + (keys[j] < keys[i]) + (i == j), 1)
+          << i << " " << j;
+    }
+  }
+  EXPECT_TRUE(absl::VerifyTypeImplementsAbslHashCorrectly(keys));
+
+  // Keys are ordered by table ID and priority first.
+  EXPECT_LT(keys[6], keys[0]);
+  EXPECT_LT(keys[0], keys[1]);
+}
+
+TEST(TableEntryKeyTest, InvalidEntriesHaveNoKey) {
+  const IrP4Info info = TestIrP4Info();
+  TableEntry unknown_table = AclEntry();
+  unknown_table.set_table_id(1);
+  EXPECT_THAT(PiTableEntryKey(info, unknown_table),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  TableEntry unknown_field = AclEntry();
+  unknown_field.mutable_match(0)->set_field_id(5);
+  EXPECT_THAT(PiTableEntryKey(info, unknown_field),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  TableEntry duplicate_field = AclEntry();
+  *duplicate_field.add_match() = AclEntry().match(0);
+  EXPECT_THAT(PiTableEntryKey(info, duplicate_field),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  TableEntry wrong_match_type = AclEntry();
+  wrong_match_type.mutable_match(0)->mutable_exact()->set_value("\x01");
+  EXPECT_THAT(PiTableEntryKey(info, wrong_match_type),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  TableEntry too_wide = AclEntry();
+  too_wide.mutable_match(0)->mutable_optional()->set_value(
+      std::string("\x02\x00", 2));
+  EXPECT_THAT(PiTableEntryKey(info, too_wide),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  ASSERT_OK_AND_ASSIGN(IrTableEntry wrong_format,
+                       PiTableEntryToIr(info, AclEntry()));
+  for (IrMatch& match : *wrong_format.mutable_matches()) {
+    if (match.has_ternary()) {
+      match.mutable_ternary()->mutable_value()->set_hex_str("0x1");
+    }
+  }
+  EXPECT_THAT(IrTableEntryKey(info, wrong_format),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace pdpi
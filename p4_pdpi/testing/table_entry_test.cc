@@ -25,6 +25,7 @@
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/pd.h"
 #include "p4_pdpi/testing/main_p4_pd.pb.h"
+#include "p4_pdpi/testing/main_p4_pd_conversions.h"
 #include "p4_pdpi/testing/test_helper.h"
 
 using ::p4::config::v1::P4Info;
@@ -50,6 +51,9 @@ static void RunPdTableEntryTest(const pdpi::IrP4Info& info,
   RunGenericPdTest<pdpi::TableEntry, pdpi::IrTableEntry, p4::v1::TableEntry>(
       info, test_name, pd, pdpi::PdTableEntryToIr, pdpi::IrTableEntryToPd,
       pdpi::IrTableEntryToPi, pdpi::PiTableEntryToIr, validity);
+  CheckGeneratedPdConversions<pdpi::TableEntry, pdpi::IrTableEntry>(
+      info, pd, pdpi::PdTableEntryToIr, pdpi::IrTableEntryToPd,
+      pdpi::PdTableEntryToIr, pdpi::IrTableEntryToPd);
 }
 
 static void RunPiTests(const pdpi::IrP4Info info) {
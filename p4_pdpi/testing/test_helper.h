@@ -15,18 +15,20 @@
 #ifndef P4_PDPI_TESTING_TEST_HELPER_H_
 #define P4_PDPI_TESTING_TEST_HELPER_H_
 
-#include <functional>
 #include <iostream>
 #include <string>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/util/message_differencer.h"
 #include "gutil/proto.h"
 #include "gutil/status.h"
 #include "gutil/testing.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
 
@@ -49,14 +51,131 @@ void Fail(const std::string& message) {
   std::cerr << "FAILURE REASON: " << message << std::endl;
 }
 
+// Fails unless the translations of a PI message and of its serialized form
+// either fail with the same status or return equal results.
+template <typename IR>
+void CheckSerializedPiToIr(const absl::StatusOr<IR>& ir,
+                           const absl::StatusOr<IR>& serialized_ir) {
+  if (ir.status() != serialized_ir.status()) {
+    Fail(absl::StrCat("Translation from serialized PI to IR returned \"",
+                      serialized_ir.status().ToString(),
+                      "\", but translation from PI returned \"",
+                      ir.status().ToString(), "\"."));
+    return;
+  }
+  if (ir.ok() && !google::protobuf::util::MessageDifferencer::Equals(
+                     *ir, *serialized_ir)) {
+    Fail(absl::StrCat("Translation from serialized PI to IR returned\n",
+                      serialized_ir->DebugString(),
+                      "but translation from PI returned\n", ir->DebugString()));
+  }
+}
+
+// Checks that translating the serialized `pi` to IR, with both an IrP4Info and
+// a CompiledIrP4Info, agrees with translating `pi`. Table entries and updates
+// are checked as part of a read response and write request, respectively.
+// Other PI messages cannot be translated from their serialized form, so there
+// is nothing to check for them.
+void CheckSerializedPiToIr(const pdpi::IrP4Info& info,
+                           const google::protobuf::Message& pi) {}
+
+void CheckSerializedPiToIr(const pdpi::IrP4Info& info,
+                           const p4::v1::WriteRequest& pi) {
+  const std::string serialized = pi.SerializeAsString();
+  const absl::StatusOr<pdpi::IrWriteRequest> ir =
+      pdpi::PiWriteRequestToIr(info, pi);
+  CheckSerializedPiToIr(ir,
+                        pdpi::SerializedPiWriteRequestToIr(info, serialized));
+  CheckSerializedPiToIr(ir, pdpi::SerializedPiWriteRequestToIr(
+                                pdpi::CompiledIrP4Info(info), serialized));
+}
+
+void CheckSerializedPiToIr(const pdpi::IrP4Info& info,
+                           const p4::v1::ReadResponse& pi) {
+  const std::string serialized = pi.SerializeAsString();
+  const absl::StatusOr<pdpi::IrReadResponse> ir =
+      pdpi::PiReadResponseToIr(info, pi);
+  CheckSerializedPiToIr(ir,
+                        pdpi::SerializedPiReadResponseToIr(info, serialized));
+  CheckSerializedPiToIr(ir, pdpi::SerializedPiReadResponseToIr(
+                                pdpi::CompiledIrP4Info(info), serialized));
+}
+
+void CheckSerializedPiToIr(const pdpi::IrP4Info& info,
+                           const p4::v1::Update& pi) {
+  p4::v1::WriteRequest write_request;
+  *write_request.add_updates() = pi;
+  CheckSerializedPiToIr(info, write_request);
+}
+
+void CheckSerializedPiToIr(const pdpi::IrP4Info& info,
+                           const p4::v1::TableEntry& pi) {
+  p4::v1::ReadResponse read_response;
+  *read_response.add_entities()->mutable_table_entry() = pi;
+  CheckSerializedPiToIr(info, read_response);
+}
+
+// Fails unless `translate`, an output-parameter overload of the translation
+// `name`, agrees with its value-returning overload, which returned `expected`.
+// It is run both with an output on the heap, which is not empty to check that
+// it is cleared, and with an output on an arena.
+template <typename T, typename Translate>
+void CheckOutputParameterOverload(const std::string& name,
+                                  const absl::StatusOr<T>& expected,
+                                  Translate translate) {
+  T heap_output = expected.ok() ? *expected : T();
+  google::protobuf::Arena arena;
+  T* arena_output = google::protobuf::Arena::CreateMessage<T>(&arena);
+  for (T* output : {&heap_output, arena_output}) {
+    const absl::Status status = translate(output);
+    if (status != expected.status()) {
+      Fail(absl::StrCat("Output-parameter overload of ", name, " returned \"",
+                        status.ToString(), "\", but value-returning one ",
+                        "returned \"", expected.status().ToString(), "\"."));
+      return;
+    }
+    if (status.ok() &&
+        !google::protobuf::util::MessageDifferencer::Equals(*expected,
+                                                            *output)) {
+      Fail(absl::StrCat("Output-parameter overload of ", name, " returned\n",
+                        output->DebugString(),
+                        "but value-returning one returned\n",
+                        expected->DebugString()));
+      return;
+    }
+  }
+}
+
+// Checks that the output-parameter overloads of the table entry translations
+// agree with the value-returning ones, for `pi` and, if it is valid, for its
+// IR. Other PI messages are not checked.
+void CheckOutputParameterOverloads(const pdpi::IrP4Info& info,
+                                   const google::protobuf::Message& pi) {}
+
+void CheckOutputParameterOverloads(const pdpi::IrP4Info& info,
+                                   const p4::v1::TableEntry& pi) {
+  const absl::StatusOr<pdpi::IrTableEntry> ir =
+      pdpi::PiTableEntryToIr(info, pi);
+  CheckOutputParameterOverload(
+      "PiTableEntryToIr", ir,
+      [&](pdpi::IrTableEntry* output) {
+        return pdpi::PiTableEntryToIr(info, pi, output);
+      });
+  if (!ir.ok()) return;
+  CheckOutputParameterOverload(
+      "IrTableEntryToPi", pdpi::IrTableEntryToPi(info, *ir),
+      [&](p4::v1::TableEntry* output) {
+        return pdpi::IrTableEntryToPi(info, *ir, output);
+      });
+}
+
 // Runs a generic test starting from an invalid PI and checks that it cannot be
 // translated to IR. If you want to test valid PI, instead write a generic PD
 // test.
 template <typename IR, typename PI>
 void RunGenericPiTest(
     const pdpi::IrP4Info& info, const std::string& test_name, const PI& pi,
-    const std::function<absl::StatusOr<IR>(const pdpi::IrP4Info&, const PI&)>&
-        pi_to_ir) {
+    absl::StatusOr<IR> (*pi_to_ir)(const pdpi::IrP4Info&, const PI&)) {
   // Input and header.
   std::cout << TestHeader(test_name) << std::endl << std::endl;
   std::cout << "--- PI (Input):" << std::endl;
@@ -64,6 +183,8 @@ void RunGenericPiTest(
 
   // Convert PI to IR.
   const auto& status_or_ir = pi_to_ir(info, pi);
+  CheckSerializedPiToIr(info, pi);
+  CheckOutputParameterOverloads(info, pi);
   if (!status_or_ir.ok()) {
     std::cout << "--- PI is invalid/unsupported:" << std::endl;
     std::cout << status_or_ir.status() << std::endl;
@@ -82,8 +203,7 @@ void RunGenericPiTest(
 template <typename IR, typename PI>
 void RunGenericIrTest(
     const pdpi::IrP4Info& info, const std::string& test_name, const IR& ir,
-    const std::function<absl::StatusOr<PI>(const pdpi::IrP4Info&, const IR&)>&
-        ir_to_pi) {
+    absl::StatusOr<PI> (*ir_to_pi)(const pdpi::IrP4Info&, const IR&)) {
   // Input and header.
   std::cout << TestHeader(test_name) << std::endl << std::endl;
   std::cout << "--- IR (Input):" << std::endl;
@@ -109,14 +229,12 @@ void RunGenericIrTest(
 template <typename PD, typename IR, typename PI>
 void RunGenericPdTest(
     const pdpi::IrP4Info& info, const std::string& test_name, const PD& pd,
-    const std::function<absl::StatusOr<IR>(const pdpi::IrP4Info&, const PD&)>&
-        pd_to_ir,
-    const std::function<absl::Status(const pdpi::IrP4Info&, const IR&,
-                                     google::protobuf::Message*)>& ir_to_pd,
-    const std::function<absl::StatusOr<PI>(const pdpi::IrP4Info&, const IR&)>&
-        ir_to_pi,
-    const std::function<absl::StatusOr<IR>(const pdpi::IrP4Info&, const PI&)>&
-        pi_to_ir,
+    absl::StatusOr<IR> (*pd_to_ir)(const pdpi::IrP4Info&,
+                                   const google::protobuf::Message&),
+    absl::Status (*ir_to_pd)(const pdpi::IrP4Info&, const IR&,
+                             google::protobuf::Message*),
+    absl::StatusOr<PI> (*ir_to_pi)(const pdpi::IrP4Info&, const IR&),
+    absl::StatusOr<IR> (*pi_to_ir)(const pdpi::IrP4Info&, const PI&),
     const InputValidity& validity) {
   // Input and header.
   std::cout << TestHeader(test_name) << std::endl << std::endl;
@@ -181,6 +299,8 @@ void RunGenericPdTest(
 
   // Convert PI back to IR.
   const auto& status_or_ir2 = pi_to_ir(info, pi);
+  CheckSerializedPiToIr(info, pi);
+  CheckOutputParameterOverloads(info, pi);
   if (!status_or_ir2.status().ok()) {
     Fail("Reverse translation from PI to IR failed.");
     std::cout << status_or_ir2.status().message() << std::endl;
@@ -212,4 +332,53 @@ void RunGenericPdTest(
   std::cout << std::endl;
 }
 
+// Checks that the PD <-> IR conversions that pdgen generates for the PD proto
+// agree with the reflective ones: `pd` is translated PD -> IR -> PD by both,
+// which must either fail with the same status or return equal results.
+template <typename PD, typename IR>
+void CheckGeneratedPdConversions(
+    const pdpi::IrP4Info& info, const PD& pd,
+    absl::StatusOr<IR> (*pd_to_ir)(const pdpi::IrP4Info&,
+                                   const google::protobuf::Message&),
+    absl::Status (*ir_to_pd)(const pdpi::IrP4Info&, const IR&,
+                             google::protobuf::Message*),
+    absl::StatusOr<IR> (*generated_pd_to_ir)(const PD&),
+    absl::Status (*generated_ir_to_pd)(const IR&, PD*)) {
+  const absl::StatusOr<IR> ir = pd_to_ir(info, pd);
+  const absl::StatusOr<IR> generated_ir = generated_pd_to_ir(pd);
+  if (ir.status() != generated_ir.status()) {
+    Fail(absl::StrCat("Generated translation from PD to IR returned \"",
+                      generated_ir.status().ToString(),
+                      "\", but reflective one returned \"",
+                      ir.status().ToString(), "\"."));
+    return;
+  }
+  if (!ir.ok()) return;
+  if (!google::protobuf::util::MessageDifferencer::Equals(*ir,
+                                                          *generated_ir)) {
+    Fail(absl::StrCat("Generated translation from PD to IR returned\n",
+                      generated_ir->DebugString(),
+                      "but reflective one returned\n", ir->DebugString()));
+    return;
+  }
+
+  PD pd2;
+  PD generated_pd2;
+  const absl::Status status = ir_to_pd(info, *ir, &pd2);
+  const absl::Status generated_status = generated_ir_to_pd(*ir, &generated_pd2);
+  if (status != generated_status) {
+    Fail(absl::StrCat("Generated translation from IR to PD returned \"",
+                      generated_status.ToString(),
+                      "\", but reflective one returned \"", status.ToString(),
+                      "\"."));
+    return;
+  }
+  if (status.ok() && !google::protobuf::util::MessageDifferencer::Equals(
+                         pd2, generated_pd2)) {
+    Fail(absl::StrCat("Generated translation from IR to PD returned\n",
+                      generated_pd2.DebugString(),
+                      "but reflective one returned\n", pd2.DebugString()));
+  }
+}
+
 #endif  // P4_PDPI_TESTING_TEST_HELPER_H_
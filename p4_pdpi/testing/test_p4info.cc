@@ -0,0 +1,346 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/testing/test_p4info.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "gutil/status.h"
+#include "gutil/testing.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+using ::p4::config::v1::P4Info;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+
+namespace {
+
+// A table and the values of its exact match fields, in the order of the
+// fields.
+using EntryKey = std::pair<uint32_t, std::vector<std::string>>;
+
+EntryKey KeyOf(const TableEntry& entry) {
+  EntryKey key = {entry.table_id(), {}};
+  for (const auto& match : entry.match()) {
+    if (match.has_exact()) key.second.push_back(match.exact().value());
+  }
+  return key;
+}
+
+// Appends the keys of the entries that `action` refers to to `keys`.
+void AppendReferredKeys(const p4::v1::Action& action,
+                        std::vector<EntryKey>& keys) {
+  if (action.action_id() == kSetNexthopActionId && action.params_size() == 2) {
+    keys.push_back({kRifTableId, {action.params(0).value()}});
+    keys.push_back({kNeighborTableId,
+                    {action.params(0).value(), action.params(1).value()}});
+  } else if (action.action_id() == kSetNexthopIdActionId &&
+             action.params_size() == 1) {
+    keys.push_back({kNexthopTableId, {action.params(0).value()}});
+  }
+}
+
+// Returns the keys of the entries that `entry` refers to.
+std::vector<EntryKey> ReferredKeys(const TableEntry& entry) {
+  std::vector<EntryKey> keys;
+  if (entry.table_id() == kNeighborTableId && entry.match_size() == 2) {
+    keys.push_back({kRifTableId, {entry.match(0).exact().value()}});
+  }
+  AppendReferredKeys(entry.action().action(), keys);
+  for (const auto& profile_action :
+       entry.action().action_profile_action_set().action_profile_actions()) {
+    AppendReferredKeys(profile_action.action(), keys);
+  }
+  return keys;
+}
+
+}  // namespace
+
+P4Info TestP4Info() {
+  return gutil::ParseProtoOrDie<P4Info>(R"pb(
+    tables {
+      preamble { id: 33554433 name: "ingress.rif_table" alias: "rif_table" }
+      match_fields { id: 1 name: "rif_id" bitwidth: 16 match_type: EXACT }
+      action_refs { id: 16777217 annotations: "@proto_id(1)" }
+      size: 1024
+    }
+    tables {
+      preamble {
+        id: 33554434
+        name: "ingress.neighbor_table"
+        alias: "neighbor_table"
+      }
+      match_fields {
+        id: 1
+        name: "rif_id"
+        annotations: "@refers_to(rif_table, rif_id)"
+        bitwidth: 16
+        match_type: EXACT
+      }
+      match_fields { id: 2 name: "neighbor_id" bitwidth: 16 match_type: EXACT }
+      action_refs { id: 16777217 annotations: "@proto_id(1)" }
+      size: 1024
+    }
+    tables {
+      preamble {
+        id: 33554435
+        name: "ingress.nexthop_table"
+        alias: "nexthop_table"
+      }
+      match_fields { id: 1 name: "nexthop_id" bitwidth: 16 match_type: EXACT }
+      action_refs { id: 16777218 annotations: "@proto_id(1)" }
+      size: 1024
+    }
+    tables {
+      preamble { id: 33554436 name: "ingress.wcmp_table" alias: "wcmp_table" }
+      match_fields { id: 1 name: "group_id" bitwidth: 16 match_type: EXACT }
+      action_refs { id: 16777219 annotations: "@proto_id(1)" }
+      size: 1024
+    }
+    tables {
+      preamble {
+        id: 33554437
+        name: "ingress.route_table"
+        alias: "route_table"
+      }
+      match_fields {
+        id: 1
+        name: "ipv4_dst"
+        annotations: "@format(IPV4_ADDRESS)"
+        bitwidth: 32
+        match_type: LPM
+      }
+      action_refs { id: 16777219 annotations: "@proto_id(1)" }
+      size: 1024
+    }
+    tables {
+      preamble { id: 33554438 name: "ingress.acl_table" alias: "acl_table" }
+      match_fields {
+        id: 1
+        name: "dst_ip"
+        annotations: "@format(IPV4_ADDRESS)"
+        bitwidth: 32
+        match_type: TERNARY
+      }
+      match_fields {
+        id: 2
+        name: "vrf"
+        match_type: EXACT
+        type_name { name: "string_id_t" }
+      }
+      match_fields { id: 3 name: "prefix" bitwidth: 16 match_type: LPM }
+      match_fields { id: 4 name: "port" bitwidth: 9 match_type: OPTIONAL }
+      action_refs { id: 16777217 annotations: "@proto_id(1)" }
+      size: 1024
+    }
+    actions { preamble { id: 16777217 name: "ingress.no_op" alias: "no_op" } }
+    actions {
+      preamble {
+        id: 16777218
+        name: "ingress.set_nexthop"
+        alias: "set_nexthop"
+      }
+      params {
+        id: 1
+        name: "rif_id"
+        annotations: "@refers_to(rif_table, rif_id)"
+        annotations: "@refers_to(neighbor_table, rif_id)"
+        bitwidth: 16
+      }
+      params {
+        id: 2
+        name: "neighbor_id"
+        annotations: "@refers_to(neighbor_table, neighbor_id)"
+        bitwidth: 16
+      }
+    }
+    actions {
+      preamble {
+        id: 16777219
+        name: "ingress.set_nexthop_id"
+        alias: "set_nexthop_id"
+      }
+      params {
+        id: 1
+        name: "nexthop_id"
+        annotations: "@refers_to(nexthop_table, nexthop_id)"
+        bitwidth: 16
+      }
+    }
+    type_info {
+      new_types {
+        key: "string_id_t"
+        value { translated_type { sdn_string {} } }
+      }
+    }
+  )pb");
+}
+
+IrP4Info TestIrP4Info() { return CreateIrP4Info(TestP4Info()).value(); }
+
+std::string Bytes(int value) {
+  return std::string({static_cast<char>(value >> 8), static_cast<char>(value)});
+}
+
+TableEntry Rif(int rif_id) {
+  TableEntry entry = gutil::ParseProtoOrDie<TableEntry>(R"pb(
+    table_id: 33554433
+    match { field_id: 1 }
+    action { action { action_id: 16777217 } }
+  )pb");
+  entry.mutable_match(0)->mutable_exact()->set_value(Bytes(rif_id));
+  return entry;
+}
+
+TableEntry Neighbor(int rif_id, int neighbor_id) {
+  TableEntry entry = gutil::ParseProtoOrDie<TableEntry>(R"pb(
+    table_id: 33554434
+    match { field_id: 1 }
+    match { field_id: 2 }
+    action { action { action_id: 16777217 } }
+  )pb");
+  entry.mutable_match(0)->mutable_exact()->set_value(Bytes(rif_id));
+  entry.mutable_match(1)->mutable_exact()->set_value(Bytes(neighbor_id));
+  return entry;
+}
+
+TableEntry Nexthop(int nexthop_id, int rif_id, int neighbor_id) {
+  TableEntry entry = gutil::ParseProtoOrDie<TableEntry>(R"pb(
+    table_id: 33554435
+    match { field_id: 1 }
+    action {
+      action {
+        action_id: 16777218
+        params { param_id: 1 }
+        params { param_id: 2 }
+      }
+    }
+  )pb");
+  entry.mutable_match(0)->mutable_exact()->set_value(Bytes(nexthop_id));
+  auto* action = entry.mutable_action()->mutable_action();
+  action->mutable_params(0)->set_value(Bytes(rif_id));
+  action->mutable_params(1)->set_value(Bytes(neighbor_id));
+  return entry;
+}
+
+TableEntry WcmpGroup(int group_id, const std::vector<int>& nexthop_ids) {
+  TableEntry entry = gutil::ParseProtoOrDie<TableEntry>(R"pb(
+    table_id: 33554436
+    match { field_id: 1 }
+  )pb");
+  entry.mutable_match(0)->mutable_exact()->set_value(Bytes(group_id));
+  for (int nexthop_id : nexthop_ids) {
+    auto* action = entry.mutable_action()
+                       ->mutable_action_profile_action_set()
+                       ->add_action_profile_actions();
+    action->set_weight(1);
+    action->mutable_action()->set_action_id(16777219);
+    auto* param = action->mutable_action()->add_params();
+    param->set_param_id(1);
+    param->set_value(Bytes(nexthop_id));
+  }
+  return entry;
+}
+
+TableEntry Route(int route_id, int nexthop_id) {
+  TableEntry entry = gutil::ParseProtoOrDie<TableEntry>(R"pb(
+    table_id: 33554437
+    match {
+      field_id: 1
+      lpm { prefix_len: 32 }
+    }
+    action {
+      action {
+        action_id: 16777219
+        params { param_id: 1 }
+      }
+    }
+  )pb");
+  entry.mutable_match(0)->mutable_lpm()->set_value(
+      std::string("\x0a\x00", 2) + Bytes(route_id));
+  entry.mutable_action()->mutable_action()->mutable_params(0)->set_value(
+      Bytes(nexthop_id));
+  return entry;
+}
+
+TableEntry AclEntry() {
+  return gutil::ParseProtoOrDie<TableEntry>(R"pb(
+    table_id: 33554438
+    match {
+      field_id: 4
+      optional { value: "\x01\x02" }
+    }
+    match {
+      field_id: 1
+      ternary { value: "\x0a\x00\x00\x01" mask: "\xff\xff\xff\xff" }
+    }
+    match {
+      field_id: 2
+      exact { value: "vrf-1" }
+    }
+    match {
+      field_id: 3
+      lpm { value: "\x12\x00" prefix_len: 7 }
+    }
+    priority: 10
+    action { action { action_id: 16777217 } }
+  )pb");
+}
+
+Update MakeUpdate(Update::Type type, const TableEntry& entry) {
+  Update update;
+  update.set_type(type);
+  *update.mutable_entity()->mutable_table_entry() = entry;
+  return update;
+}
+
+absl::Status ReferenceCheck(const Update& update,
+                            absl::Span<const TableEntry> installed) {
+  const TableEntry& entry = update.entity().table_entry();
+  if (update.type() == Update::INSERT || update.type() == Update::MODIFY) {
+    for (const EntryKey& referred : ReferredKeys(entry)) {
+      if (!absl::c_any_of(installed, [&](const TableEntry& installed_entry) {
+            return KeyOf(installed_entry) == referred;
+          })) {
+        return gutil::FailedPreconditionErrorBuilder()
+               << "Entry refers to a missing entry of table " << referred.first
+               << ".";
+      }
+    }
+  } else if (update.type() == Update::DELETE) {
+    const EntryKey key = KeyOf(entry);
+    for (const TableEntry& installed_entry : installed) {
+      if (absl::c_linear_search(ReferredKeys(installed_entry), key)) {
+        return gutil::FailedPreconditionErrorBuilder()
+               << "Entry is referred to by an entry of table "
+               << installed_entry.table_id() << ".";
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace pdpi
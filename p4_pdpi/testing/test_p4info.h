@@ -0,0 +1,87 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_P4_PDPI_TESTING_TEST_P4INFO_H_
+#define GOOGLE_P4_PDPI_TESTING_TEST_P4INFO_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+// A small P4Info for tests of table entry keys, shadow tables, reconciliation
+// and sequencing, and builders of PI table entries for its tables. Unless
+// noted otherwise, match fields and action parameters are 16 bits wide.
+//
+// - rif_table: exact `rif_id`. Action no_op.
+// - neighbor_table: exact `rif_id`, which refers to rif_table, and exact
+//   `neighbor_id`. Action no_op.
+// - nexthop_table: exact `nexthop_id`. Action set_nexthop, whose `rif_id`
+//   refers to rif_table and neighbor_table, and whose `neighbor_id` refers to
+//   neighbor_table.
+// - wcmp_table: exact `group_id`. Action sets of set_nexthop_id, whose
+//   `nexthop_id` refers to nexthop_table.
+// - route_table: LPM `ipv4_dst` of 32 bits. Action set_nexthop_id.
+// - acl_table: ternary `dst_ip` of 32 bits formatted as IPv4 address, exact
+//   `vrf` of type string_id_t (an SDN string), LPM `prefix` and optional `port`
+//   of 9 bits. Action no_op.
+constexpr uint32_t kRifTableId = 33554433;
+constexpr uint32_t kNeighborTableId = 33554434;
+constexpr uint32_t kNexthopTableId = 33554435;
+constexpr uint32_t kWcmpTableId = 33554436;
+constexpr uint32_t kRouteTableId = 33554437;
+constexpr uint32_t kAclTableId = 33554438;
+
+constexpr uint32_t kNoOpActionId = 16777217;
+constexpr uint32_t kSetNexthopActionId = 16777218;
+constexpr uint32_t kSetNexthopIdActionId = 16777219;
+
+p4::config::v1::P4Info TestP4Info();
+IrP4Info TestIrP4Info();
+
+// Returns `value` as 16 bit bytestring.
+std::string Bytes(int value);
+
+p4::v1::TableEntry Rif(int rif_id);
+p4::v1::TableEntry Neighbor(int rif_id, int neighbor_id);
+p4::v1::TableEntry Nexthop(int nexthop_id, int rif_id, int neighbor_id);
+// Returns a group with an action of weight 1 per nexthop.
+p4::v1::TableEntry WcmpGroup(int group_id,
+                             const std::vector<int>& nexthop_ids);
+// Returns the /32 route to the address 10.0.0.0 + `route_id`.
+p4::v1::TableEntry Route(int route_id, int nexthop_id);
+// Returns an entry that matches on all fields of acl_table, with priority 10.
+p4::v1::TableEntry AclEntry();
+
+p4::v1::Update MakeUpdate(p4::v1::Update::Type type,
+                          const p4::v1::TableEntry& entry);
+
+// An update check for FakeP4RuntimeServer that enforces the references of the
+// tables above, comparing values bytewise. Returns FailedPrecondition for
+// INSERTs and MODIFYs of entries that refer to entries that are not
+// `installed`, and for DELETEs of entries that `installed` entries refer to.
+absl::Status ReferenceCheck(const p4::v1::Update& update,
+                            absl::Span<const p4::v1::TableEntry> installed);
+
+}  // namespace pdpi
+
+#endif  // GOOGLE_P4_PDPI_TESTING_TEST_P4INFO_H_
@@ -14,17 +14,337 @@
 
 #include "p4_pdpi/utils/hex_string.h"
 
+#include <array>
 #include <bitset>
 #include <cstdint>
 #include <cstring>
 #include <string>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 #include "glog/logging.h"
 #include "gutil/status.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PDPI_HEX_STRING_X86 1
+#include <immintrin.h>
+#endif
+
 namespace pdpi {
+namespace {
+
+// -- Scalar Kernels -----------------------------------------------------------
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+// The value of every character as a hex digit, or -1.
+constexpr std::array<int8_t, 256> MakeHexDigitValues(bool allow_upper_case) {
+  std::array<int8_t, 256> values = {};
+  for (int c = 0; c < 256; ++c) values[c] = -1;
+  for (int i = 0; i < 16; ++i) values[kHexDigits[i]] = i;
+  if (allow_upper_case) {
+    for (int i = 10; i < 16; ++i) values['A' + i - 10] = i;
+  }
+  return values;
+}
+constexpr std::array<int8_t, 256> kLowerCaseHexDigitValues =
+    MakeHexDigitValues(/*allow_upper_case=*/false);
+constexpr std::array<int8_t, 256> kHexDigitValues =
+    MakeHexDigitValues(/*allow_upper_case=*/true);
+
+void BytesToHexDigitsScalar(absl::string_view bytes, char* out) {
+  for (const char byte : bytes) {
+    *out++ = kHexDigits[static_cast<uint8_t>(byte) >> 4];
+    *out++ = kHexDigits[byte & 0xf];
+  }
+}
+
+// `digits` must have an even size.
+bool HexDigitsToBytesScalar(absl::string_view digits, char* out,
+                            bool allow_upper_case) {
+  const auto& values =
+      allow_upper_case ? kHexDigitValues : kLowerCaseHexDigitValues;
+  for (int i = 0; i < digits.size(); i += 2) {
+    const int high = values[static_cast<uint8_t>(digits[i])];
+    const int low = values[static_cast<uint8_t>(digits[i + 1])];
+    if (high < 0 || low < 0) return false;
+    *out++ = high << 4 | low;
+  }
+  return true;
+}
+
+// -- Vectorized Kernels -------------------------------------------------------
+
+// Each kernel converts as many whole blocks as possible and returns the number
+// of converted bytes; the rest is left to the next smaller kernel.
+
+#ifdef PDPI_HEX_STRING_X86
+
+bool CpuSupportsSsse3() {
+  static const bool kSupported = __builtin_cpu_supports("ssse3");
+  return kSupported;
+}
+
+bool CpuSupportsAvx2() {
+  static const bool kSupported = __builtin_cpu_supports("avx2");
+  return kSupported;
+}
+
+__attribute__((target("ssse3"))) int BytesToHexDigitsSsse3(
+    absl::string_view bytes, char* out) {
+  const __m128i digits = _mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(kHexDigits));
+  const __m128i low_nibbles = _mm_set1_epi8(0x0f);
+  int i = 0;
+  for (; i + 16 <= bytes.size(); i += 16) {
+    const __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes.data() + i));
+    const __m128i high =
+        _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(in, 4),
+                                               low_nibbles));
+    const __m128i low =
+        _mm_shuffle_epi8(digits, _mm_and_si128(in, low_nibbles));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i),
+                     _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16),
+                     _mm_unpackhi_epi8(high, low));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) int BytesToHexDigitsAvx2(
+    absl::string_view bytes, char* out) {
+  const __m256i digits = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(kHexDigits)));
+  const __m256i low_nibbles = _mm256_set1_epi8(0x0f);
+  int i = 0;
+  for (; i + 32 <= bytes.size(); i += 32) {
+    const __m256i in = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(bytes.data() + i));
+    const __m256i high = _mm256_shuffle_epi8(
+        digits, _mm256_and_si256(_mm256_srli_epi16(in, 4), low_nibbles));
+    const __m256i low =
+        _mm256_shuffle_epi8(digits, _mm256_and_si256(in, low_nibbles));
+    // Interleaving works within 128-bit lanes, so the lanes are reordered.
+    const __m256i first = _mm256_unpacklo_epi8(high, low);
+    const __m256i second = _mm256_unpackhi_epi8(high, low);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i),
+                        _mm256_permute2x128_si256(first, second, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 32),
+                        _mm256_permute2x128_si256(first, second, 0x31));
+  }
+  return i;
+}
+
+// Returns 0xff for the bytes of `x` in [low, high], and 0 for the others.
+__attribute__((target("ssse3"))) __m128i InRange(__m128i x, char low,
+                                                 char high) {
+  // Unsigned comparison of bytes, using min/max.
+  return _mm_and_si128(
+      _mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8(low)), x),
+      _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(high)), x));
+}
+
+__attribute__((target("avx2"))) __m256i InRange(__m256i x, char low,
+                                                char high) {
+  return _mm256_and_si256(
+      _mm256_cmpeq_epi8(_mm256_max_epu8(x, _mm256_set1_epi8(low)), x),
+      _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(high)), x));
+}
+
+// Returns the values of the 16 hex digits in `in`, and clears `*valid` if any
+// of them is not a hex digit.
+__attribute__((target("ssse3"))) __m128i DecodeHexDigits(__m128i in,
+                                                         bool allow_upper_case,
+                                                         bool* valid) {
+  const __m128i letters =
+      allow_upper_case ? _mm_or_si128(in, _mm_set1_epi8(0x20)) : in;
+  const __m128i is_digit = InRange(in, '0', '9');
+  const __m128i is_letter = InRange(letters, 'a', 'f');
+  if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff) {
+    *valid = false;
+  }
+  return _mm_or_si128(
+      _mm_and_si128(is_digit, _mm_sub_epi8(in, _mm_set1_epi8('0'))),
+      _mm_and_si128(is_letter,
+                    _mm_sub_epi8(letters, _mm_set1_epi8('a' - 10))));
+}
+
+// Same as above, for 32 hex digits.
+__attribute__((target("avx2"))) __m256i DecodeHexDigits(__m256i in,
+                                                        bool allow_upper_case,
+                                                        bool* valid) {
+  const __m256i letters =
+      allow_upper_case ? _mm256_or_si256(in, _mm256_set1_epi8(0x20)) : in;
+  const __m256i is_digit = InRange(in, '0', '9');
+  const __m256i is_letter = InRange(letters, 'a', 'f');
+  if (_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter)) != -1) {
+    *valid = false;
+  }
+  return _mm256_or_si256(
+      _mm256_and_si256(is_digit, _mm256_sub_epi8(in, _mm256_set1_epi8('0'))),
+      _mm256_and_si256(is_letter,
+                       _mm256_sub_epi8(letters, _mm256_set1_epi8('a' - 10))));
+}
+
+// Returns the number of converted digits, or -1 if there is an invalid one.
+__attribute__((target("ssse3"))) int HexDigitsToBytesSsse3(
+    absl::string_view digits, char* out, bool allow_upper_case) {
+  // Combines the pairs of digit values (high, low) to high * 16 + low.
+  const __m128i weights = _mm_set1_epi16(0x0110);
+  bool valid = true;
+  int i = 0;
+  for (; i + 32 <= digits.size(); i += 32) {
+    const __m128i first = DecodeHexDigits(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits.data() + i)),
+        allow_upper_case, &valid);
+    const __m128i second =
+        DecodeHexDigits(_mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                           digits.data() + i + 16)),
+                       allow_upper_case, &valid);
+    if (!valid) return -1;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2),
+                     _mm_packus_epi16(_mm_maddubs_epi16(first, weights),
+                                      _mm_maddubs_epi16(second, weights)));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) int HexDigitsToBytesAvx2(
+    absl::string_view digits, char* out, bool allow_upper_case) {
+  const __m256i weights = _mm256_set1_epi16(0x0110);
+  bool valid = true;
+  int i = 0;
+  for (; i + 64 <= digits.size(); i += 64) {
+    const __m256i first = DecodeHexDigits(
+        _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(digits.data() + i)),
+        allow_upper_case, &valid);
+    const __m256i second = DecodeHexDigits(
+        _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(digits.data() + i + 32)),
+        allow_upper_case, &valid);
+    if (!valid) return -1;
+    // Packing works within 128-bit lanes, so the lanes are reordered.
+    const __m256i packed =
+        _mm256_packus_epi16(_mm256_maddubs_epi16(first, weights),
+                            _mm256_maddubs_epi16(second, weights));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i / 2),
+                        _mm256_permute4x64_epi64(packed, 0xd8));
+  }
+  return i;
+}
+
+#endif  // PDPI_HEX_STRING_X86
+
+// Returns the error that converting the hex digits `digits` to `num_bits` bits
+// results in: the first invalid character or lost bit, starting from the least
+// significant digit.
+absl::Status HexDigitsToBitsError(absl::string_view digits, int num_bits) {
+  for (int i = 0; i < digits.size(); ++i) {
+    const char ith_char = digits[digits.size() - i - 1];
+    ASSIGN_OR_RETURN(const int ith_digit, HexCharToDigit(ith_char),
+                     _ << " while trying to convert hex string: " << digits);
+    for (int j = 0; j < 4; ++j) {
+      // k is the index of the j-th bit of the i-th hex digit.
+      const int k = 4 * i + j;
+      const bool kth_bit = (ith_digit >> j) % 2 == 1;
+      if (kth_bit && k >= num_bits) {
+        return gutil::InvalidArgumentErrorBuilder()
+               << "hex string '0x" << digits << "' has bit #" << (k + 1)
+               << " set to 1; conversion to " << num_bits
+               << " bits would lose information";
+      }
+    }
+  }
+  return gutil::InternalErrorBuilder()
+         << "hex string '0x" << digits << "' converts to " << num_bits
+         << " bits without error";
+}
+
+// Returns true iff `bytes` has no bits set beyond the first num_bits.
+bool FitsInBits(absl::string_view bytes, int num_bits) {
+  const int excess_bits = 8 * static_cast<int>(bytes.size()) - num_bits;
+  for (int i = 0; i < excess_bits / 8; ++i) {
+    if (bytes[i] != 0) return false;
+  }
+  return excess_bits <= 0 || excess_bits % 8 == 0 ||
+         (static_cast<uint8_t>(bytes[excess_bits / 8]) >>
+          (8 - excess_bits % 8)) == 0;
+}
+
+}  // namespace
+
+// -- Conversions between Byte Strings and Hex Strings -------------------------
+
+void BytesToHexDigits(absl::string_view bytes, char* out) {
+  int done = 0;
+#ifdef PDPI_HEX_STRING_X86
+  if (CpuSupportsAvx2()) done += BytesToHexDigitsAvx2(bytes, out);
+  if (CpuSupportsSsse3()) {
+    done += BytesToHexDigitsSsse3(bytes.substr(done), out + 2 * done);
+  }
+#endif
+  BytesToHexDigitsScalar(bytes.substr(done), out + 2 * done);
+}
+
+bool HexDigitsToBytes(absl::string_view digits, char* out,
+                      bool allow_upper_case) {
+  if (digits.size() % 2 == 1) {
+    const auto& values =
+        allow_upper_case ? kHexDigitValues : kLowerCaseHexDigitValues;
+    const int value = values[static_cast<uint8_t>(digits[0])];
+    if (value < 0) return false;
+    *out++ = value;
+    digits.remove_prefix(1);
+  }
+#ifdef PDPI_HEX_STRING_X86
+  if (CpuSupportsAvx2()) {
+    const int done = HexDigitsToBytesAvx2(digits, out, allow_upper_case);
+    if (done < 0) return false;
+    digits.remove_prefix(done);
+    out += done / 2;
+  }
+  if (CpuSupportsSsse3()) {
+    const int done = HexDigitsToBytesSsse3(digits, out, allow_upper_case);
+    if (done < 0) return false;
+    digits.remove_prefix(done);
+    out += done / 2;
+  }
+#endif
+  return HexDigitsToBytesScalar(digits, out, allow_upper_case);
+}
+
+std::string ByteStringToHexString(absl::string_view byte_string) {
+  std::string hex_string(2 + 2 * byte_string.size(), '\0');
+  hex_string[0] = '0';
+  hex_string[1] = 'x';
+  BytesToHexDigits(byte_string, &hex_string[2]);
+  return hex_string;
+}
+
+absl::StatusOr<std::string> HexStringToByteString(absl::string_view hex_string,
+                                                  int num_bits) {
+  if (!absl::ConsumePrefix(&hex_string, "0x")) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "missing '0x'-prefix in hexadecimal string: " << hex_string;
+  }
+  std::string bytes((hex_string.size() + 1) / 2, '\0');
+  if (!HexDigitsToBytes(hex_string, &bytes[0]) ||
+      !FitsInBits(bytes, num_bits)) {
+    return HexDigitsToBitsError(hex_string, num_bits);
+  }
+  // Only leading zero bytes are removed here.
+  const int num_bytes = (num_bits + 7) / 8;
+  if (bytes.size() > num_bytes) {
+    bytes.erase(0, bytes.size() - num_bytes);
+  } else {
+    bytes.insert(0, num_bytes - bytes.size(), '\0');
+  }
+  return bytes;
+}
 
 // -- Conversions from Hex Strings ---------------------------------------------
 
@@ -21,15 +21,12 @@
 
 #include <stddef.h>
 
-#include <algorithm>
 #include <bitset>
 #include <cstdint>
 #include <string>
 
 #include "absl/status/statusor.h"
-#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
-#include "absl/strings/strip.h"
 #include "gutil/status.h"
 
 namespace pdpi {
@@ -69,66 +66,75 @@ absl::StatusOr<int64_t> HexStringToInt64(absl::string_view hex_string);
 absl::StatusOr<uint32_t> HexStringToUint32(absl::string_view hex_string);
 absl::StatusOr<uint64_t> HexStringToUint64(absl::string_view hex_string);
 
+// -- Conversions between Byte Strings and Hex Strings -------------------------
+
+// Byte strings are interpreted as big endian numbers, as in P4Runtime.
+
+// Returns the hex string with two digits per byte of `byte_string`, e.g.
+// "0x00ff" for "\x00\xff".
+std::string ByteStringToHexString(absl::string_view byte_string);
+
+// Returns the byte string of ceil(num_bits / 8) bytes given by the hex string,
+// or an error status under the same conditions as
+// `HexStringToAnyLargeEnoughBitset<num_bits>`.
+absl::StatusOr<std::string> HexStringToByteString(absl::string_view hex_string,
+                                                  int num_bits);
+
+// The kernels of the conversions above, which work on raw buffers. They use
+// SSSE3 or AVX2 instructions if the CPU supports them.
+
+// Writes the 2 * bytes.size() lower case hex digits of `bytes` to `out`.
+void BytesToHexDigits(absl::string_view bytes, char* out);
+
+// Writes the (digits.size() + 1) / 2 bytes given by the hex digits `digits`
+// (without "0x"-prefix) to `out`; an odd number of digits is read as if there
+// was a leading '0'. Returns false iff `digits` contains a character that is
+// not a hex digit, where upper case digits only count if `allow_upper_case`.
+bool HexDigitsToBytes(absl::string_view digits, char* out,
+                      bool allow_upper_case = true);
+
 // == END OF PUBLIC INTERFACE ==================================================
 
 char HexDigitToChar(int digit);
 absl::StatusOr<int> HexCharToDigit(char hex_char);
 
 template <std::size_t num_bits>
-std::string BitsetToHexString(const std::bitset<num_bits>& bitset) {
-  // Each hexadecimal digit is given by 4 bits in the bitset.
-  const int num_hex_digits = (num_bits + 3) / 4;  // ceil(num_bits / 4.0)
+std::string BitsetToByteString(std::bitset<num_bits> bitset) {
+  std::string bytes((num_bits + 7) / 8, '\0');
+  for (int i = static_cast<int>(bytes.size()) - 1; i >= 0; --i) {
+    bytes[i] = (bitset & std::bitset<num_bits>(0xff)).to_ulong();
+    bitset >>= 8;
+  }
+  return bytes;
+}
 
-  // Construct hex_string in reverse order, starting from least significant
-  // digit.
-  std::string hex_string;
-  for (int i = 0; i < num_hex_digits; ++i) {
-    int ith_digit = 0;
-    // The ith digit is given by bits 4i+3 to 4i; we set the bits from most to
-    // least significant.
-    for (int k = 4 * i + 3; k >= 4 * i; --k) {
-      int kth_bit = (k < num_bits) ? bitset[k] : 0;  // Implicit bits are 0.
-      ith_digit = (ith_digit << 1) | kth_bit;
-    }
-    hex_string.push_back(HexDigitToChar(ith_digit));
+// `bytes` must not have bits set beyond the first num_bits.
+template <std::size_t num_bits>
+std::bitset<num_bits> ByteStringToBitset(absl::string_view bytes) {
+  std::bitset<num_bits> bitset;
+  for (const char byte : bytes) {
+    bitset <<= 8;
+    bitset |= std::bitset<num_bits>(static_cast<uint8_t>(byte));
   }
+  return bitset;
+}
 
-  // Reverse string and prepend "0x" prefix
-  std::reverse(hex_string.begin(), hex_string.end());
-  return absl::StrCat("0x", hex_string);
+template <std::size_t num_bits>
+std::string BitsetToHexString(const std::bitset<num_bits>& bitset) {
+  std::string hex_string = ByteStringToHexString(BitsetToByteString(bitset));
+  // Each hexadecimal digit is given by 4 bits in the bitset, so the leading
+  // digit only consists of implicit 0 bits if num_bits % 8 is in [1, 4].
+  const int num_hex_digits = (num_bits + 3) / 4;  // ceil(num_bits / 4.0)
+  hex_string.erase(2, hex_string.size() - 2 - num_hex_digits);
+  return hex_string;
 }
 
 template <std::size_t num_bits>
 absl::StatusOr<std::bitset<num_bits>> HexStringToAnyLargeEnoughBitset(
     absl::string_view hex_string) {
-  if (!absl::ConsumePrefix(&hex_string, "0x")) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "missing '0x'-prefix in hexadecimal string: " << hex_string;
-  }
-
-  // Compute and set bits from least to most significant.
-  std::bitset<num_bits> bitset;
-  for (int i = 0; i < hex_string.size(); ++i) {
-    const char ith_char = hex_string[hex_string.size() - i - 1];
-    ASSIGN_OR_RETURN(
-        const int ith_digit, HexCharToDigit(ith_char),
-        _ << " while trying to convert hex string: " << hex_string);
-    for (int j = 0; j < 4; ++j) {
-      // k is the index of the j-th bit of the i-th hex digit.
-      const int k = 4 * i + j;
-      const bool kth_bit = (ith_digit >> j) % 2 == 1;
-      if (!kth_bit) continue;
-      if (k < num_bits) {
-        bitset.set(k, kth_bit);
-      } else {
-        return gutil::InvalidArgumentErrorBuilder()
-               << "hex string '0x" << hex_string << "' has bit #" << (k + 1)
-               << " set to 1; conversion to " << num_bits
-               << " bits would lose information";
-      }
-    }
-  }
-  return bitset;
+  ASSIGN_OR_RETURN(const std::string bytes,
+                   HexStringToByteString(hex_string, num_bits));
+  return ByteStringToBitset<num_bits>(bytes);
 }
 
 template <std::size_t num_bits>
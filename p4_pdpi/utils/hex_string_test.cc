@@ -16,6 +16,11 @@
 
 #include <iostream>
 #include <limits>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/string_view.h"
 
 #define TEST_PURE(function_call)                                       \
   do {                                                                 \
@@ -35,6 +40,7 @@
   } while (false)
 
 using ::pdpi::BitsetToHexString;
+using ::pdpi::ByteStringToHexString;
 using ::pdpi::HexStringToBitset;
 using ::pdpi::HexStringToInt;
 using ::pdpi::HexStringToInt32;
@@ -42,6 +48,14 @@ using ::pdpi::HexStringToInt64;
 using ::pdpi::HexStringToUint32;
 using ::pdpi::HexStringToUint64;
 
+// Byte strings are printed escaped.
+absl::StatusOr<std::string> HexStringToEscapedByteString(
+    absl::string_view hex_string, int num_bits) {
+  ASSIGN_OR_RETURN(std::string byte_string,
+                   pdpi::HexStringToByteString(hex_string, num_bits));
+  return absl::CEscape(byte_string);
+}
+
 int main() {
   // BitsetToHexString.
   TEST_PURE(BitsetToHexString(std::bitset<1>("0")));
@@ -75,6 +89,9 @@ int main() {
   TEST_STATUSOR(HexStringToBitset<7>("0xf0"));
   TEST_STATUSOR(HexStringToBitset<8>("0xf0"));
   TEST_STATUSOR(HexStringToBitset<8>("0x00ff"));
+  TEST_STATUSOR(HexStringToBitset<8>("0xfg"));
+  TEST_STATUSOR(HexStringToBitset<8>("0xgf"));
+  TEST_STATUSOR(HexStringToBitset<8>("0xAB"));
 
   // HexStringToInt.
   TEST_STATUSOR(HexStringToInt("0x0"));
@@ -115,4 +132,34 @@ int main() {
   TEST_STATUSOR(HexStringToUint64("0xffffffffffffffff"));
   TEST_STATUSOR(HexStringToUint64("0x0ffffffffffffffff"));
   TEST_STATUSOR(HexStringToUint64("0x1ffffffffffffffff"));
+
+  // ByteStringToHexString.
+  TEST_PURE(ByteStringToHexString(""));
+  TEST_PURE(ByteStringToHexString(std::string("\x00\x01", 2)));
+  TEST_PURE(ByteStringToHexString("\x12\x34\x56\x78\x9a\xbc\xde\xf0"));
+  // Long enough to use the vectorized kernels.
+  TEST_PURE(ByteStringToHexString(std::string(17, '\xa5')));
+  TEST_PURE(ByteStringToHexString(std::string(49, '\x5a')));
+
+  // HexStringToByteString.
+  TEST_STATUSOR(HexStringToEscapedByteString("0x", 8));
+  TEST_STATUSOR(HexStringToEscapedByteString("0x1", 1));
+  TEST_STATUSOR(HexStringToEscapedByteString("0x0001", 1));
+  TEST_STATUSOR(HexStringToEscapedByteString("0x2", 1));
+  TEST_STATUSOR(HexStringToEscapedByteString("0xabc", 16));
+  TEST_STATUSOR(HexStringToEscapedByteString("0xABC", 12));
+  TEST_STATUSOR(HexStringToEscapedByteString("0x1abc", 12));
+  TEST_STATUSOR(HexStringToEscapedByteString("abc", 12));
+  TEST_STATUSOR(HexStringToEscapedByteString("0xa-c", 12));
+  TEST_STATUSOR(HexStringToEscapedByteString(
+      "0x0123456789abcdef0123456789ABCDEF", 128));
+  TEST_STATUSOR(HexStringToEscapedByteString(
+      "0x0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef0",
+      260));
+  TEST_STATUSOR(HexStringToEscapedByteString(
+      "0x0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef",
+      255));
+  TEST_STATUSOR(HexStringToEscapedByteString(
+      "0x0123456789abcdef0123456789abcdef01234567x9abcdef0123456789abcdef",
+      256));
 }
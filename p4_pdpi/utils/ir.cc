@@ -14,29 +14,20 @@
 
 #include "p4_pdpi/utils/ir.h"
 
-#include <arpa/inet.h>
-#include <ctype.h>
 #include <endian.h>
-#include <errno.h>
-#include <net/ethernet.h>
-#include <netinet/ether.h>
-#include <netinet/in.h>
+#include <stdint.h>
 #include <string.h>
-#include <sys/socket.h>
-#include <sys/types.h>
 
 #include <algorithm>
+#include <array>
 #include <string>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
-#include "absl/strings/ascii.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
-#include "absl/strings/str_join.h"
-#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
 #include "google/protobuf/map.h"
@@ -47,6 +38,7 @@
 #include "p4/config/v1/p4types.pb.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/utils/hex_string.h"
 
 namespace pdpi {
 
@@ -55,60 +47,456 @@ using ::pdpi::IrValue;
 
 namespace {
 
-bool IsValidMac(std::string s) {
-  for (auto i = 0; i < 17; ++i) {
-    if (i % 3 != 2 && (!isxdigit(s[i]) || absl::ascii_isupper(s[i]))) {
-      return false;
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+// The value of every character as a lower case hexadecimal digit, or -1.
+constexpr std::array<int8_t, 256> MakeHexDigitValues() {
+  std::array<int8_t, 256> values = {};
+  for (int c = 0; c < 256; ++c) values[c] = -1;
+  for (int i = 0; i < 16; ++i) values[kHexDigits[i]] = i;
+  return values;
+}
+constexpr std::array<int8_t, 256> kHexDigitValues = MakeHexDigitValues();
+
+int HexDigitValue(char c) { return kHexDigitValues[static_cast<uint8_t>(c)]; }
+
+// The decimal representation of every byte value.
+struct DecimalByte {
+  char digits[3];
+  int size;
+};
+constexpr std::array<DecimalByte, 256> MakeDecimalBytes() {
+  std::array<DecimalByte, 256> decimals = {};
+  for (int value = 0; value < 256; ++value) {
+    DecimalByte& decimal = decimals[value];
+    if (value >= 100) decimal.digits[decimal.size++] = '0' + value / 100;
+    if (value >= 10) decimal.digits[decimal.size++] = '0' + value / 10 % 10;
+    decimal.digits[decimal.size++] = '0' + value % 10;
+  }
+  return decimals;
+}
+constexpr std::array<DecimalByte, 256> kDecimalBytes = MakeDecimalBytes();
+
+// Maximum lengths of the string representations of addresses.
+constexpr int kMaxMacStringSize = 17;
+constexpr int kMaxIpv4StringSize = 15;
+constexpr int kMaxIpv6StringSize = 45;
+
+// The formatters below write the string representation of the address at
+// `bytes` to `out`, which must have room for the maximum length of the
+// representation, and return the end of the written string. They produce the
+// same representations as ether_ntoa (zero padded) and inet_ntop.
+
+char *WriteMac(const char *bytes, char *out) {
+  for (int i = 0; i < kNumBytesInMac; ++i) {
+    if (i != 0) *out++ = ':';
+    const uint8_t byte = bytes[i];
+    *out++ = kHexDigits[byte >> 4];
+    *out++ = kHexDigits[byte & 0xf];
+  }
+  return out;
+}
+
+char *WriteIpv4(const char *bytes, char *out) {
+  for (int i = 0; i < kNumBytesInIpv4; ++i) {
+    if (i != 0) *out++ = '.';
+    const DecimalByte &decimal = kDecimalBytes[static_cast<uint8_t>(bytes[i])];
+    memcpy(out, decimal.digits, decimal.size);
+    out += decimal.size;
+  }
+  return out;
+}
+
+// Produces exactly what glibc's inet_ntop produces, which the existing output
+// relies on: the first longest run of at least two zero words is compressed to
+// "::", and IPv4-mapped and IPv4-compatible addresses (e.g. "::ffff:1.2.3.4"
+// and "::1.2.3.4") end in dotted decimal. The latter deviates from RFC 5952,
+// which would print "::102:304".
+char *WriteIpv6(const char *bytes, char *out) {
+  constexpr int kNumWords = kNumBytesInIpv6 / 2;
+  uint16_t words[kNumWords];
+  for (int i = 0; i < kNumWords; ++i) {
+    words[i] = static_cast<uint8_t>(bytes[2 * i]) << 8 |
+               static_cast<uint8_t>(bytes[2 * i + 1]);
+  }
+
+  int best_start = -1, best_length = 0;
+  for (int i = 0; i < kNumWords;) {
+    if (words[i] != 0) {
+      ++i;
+      continue;
+    }
+    int end = i;
+    while (end < kNumWords && words[end] == 0) ++end;
+    if (end - i > best_length) {
+      best_start = i;
+      best_length = end - i;
+    }
+    i = end;
+  }
+  if (best_length < 2) best_start = -1;
+
+  for (int i = 0; i < kNumWords; ++i) {
+    if (best_start != -1 && i >= best_start && i < best_start + best_length) {
+      if (i == best_start) *out++ = ':';
+      continue;
+    }
+    if (i != 0) *out++ = ':';
+    if (i == 6 && best_start == 0 &&
+        (best_length == 6 || (best_length == 5 && words[5] == 0xffff))) {
+      return WriteIpv4(bytes + 12, out);
     }
-    if (i % 3 == 2 && s[i] != ':') {
+    // Hexadecimal without leading zeros.
+    bool leading = true;
+    for (int shift = 12; shift >= 0; shift -= 4) {
+      const int digit = words[i] >> shift & 0xf;
+      if (leading && digit == 0 && shift != 0) continue;
+      leading = false;
+      *out++ = kHexDigits[digit];
+    }
+  }
+  if (best_start != -1 && best_start + best_length == kNumWords) *out++ = ':';
+  return out;
+}
+
+// The parsers below write the address represented by the given string to
+// `out`, and return false if the string is not a valid representation. They
+// accept exactly what ether_aton and inet_pton accept, except that hexadecimal
+// digits must be lower case, and only the MAC address format
+// xx:xx:xx:xx:xx:xx is accepted.
+
+bool ParseMac(absl::string_view mac, char *out) {
+  if (mac.size() != kMaxMacStringSize) return false;
+  for (int i = 0; i < kNumBytesInMac; ++i) {
+    const int high = HexDigitValue(mac[3 * i]);
+    const int low = HexDigitValue(mac[3 * i + 1]);
+    if (high < 0 || low < 0) return false;
+    if (i + 1 < kNumBytesInMac && mac[3 * i + 2] != ':') return false;
+    out[i] = high << 4 | low;
+  }
+  return true;
+}
+
+bool ParseIpv4(absl::string_view ipv4, char *out) {
+  int octets = 0;
+  int value = 0;
+  bool saw_digit = false;
+  for (const char c : ipv4) {
+    if (c >= '0' && c <= '9') {
+      // Leading zeros are not allowed.
+      if (saw_digit && value == 0) return false;
+      value = value * 10 + (c - '0');
+      if (value > 255) return false;
+      if (!saw_digit) {
+        if (++octets > kNumBytesInIpv4) return false;
+        saw_digit = true;
+      }
+    } else if (c == '.' && saw_digit) {
+      if (octets == kNumBytesInIpv4) return false;
+      out[octets - 1] = value;
+      value = 0;
+      saw_digit = false;
+    } else {
       return false;
     }
   }
-  return s.size() == 17;
+  if (octets < kNumBytesInIpv4) return false;
+  out[octets - 1] = value;
+  return true;
 }
 
-bool IsValidIpv6(std::string s) {
-  // This function checks extra requirements that are not covered by inet_ntop.
-  for (int i = 0; i < s.size(); ++i) {
-    if (s[i] == '.') {
-      // TODO: Remove this when we find a way to get the inet_pton
-      // library to ignore mixed mode IPv6 addresses
+bool ParseIpv6(absl::string_view ipv6, char *out) {
+  char result[kNumBytesInIpv6] = {};
+  char *next = result;
+  char *const end = result + kNumBytesInIpv6;
+  // Where "::" was found, if at all.
+  char *compressed = nullptr;
+
+  if (ipv6.empty()) return false;
+  int i = 0;
+  // A leading "::" needs special handling.
+  if (ipv6[0] == ':') {
+    if (ipv6.size() < 2 || ipv6[1] != ':') return false;
+    i = 1;
+  }
+  int word_start = i;
+  int digits = 0;
+  uint32_t word = 0;
+  while (i < ipv6.size()) {
+    const char c = ipv6[i++];
+    const int digit = HexDigitValue(c);
+    if (digit >= 0) {
+      if (digits == 4) return false;
+      word = word << 4 | digit;
+      ++digits;
       continue;
     }
-    if (s[i] == ':') {
+    if (c == ':') {
+      word_start = i;
+      if (digits == 0) {
+        if (compressed != nullptr) return false;
+        compressed = next;
+        continue;
+      }
+      if (i == ipv6.size() || next + 2 > end) return false;
+      *next++ = word >> 8;
+      *next++ = word & 0xff;
+      digits = 0;
+      word = 0;
       continue;
     }
-    if (!isxdigit(s[i]) || absl::ascii_isupper(s[i])) {
-      return false;
+    // A trailing IPv4 address.
+    if (c == '.' && next + kNumBytesInIpv4 <= end &&
+        ParseIpv4(ipv6.substr(word_start), next)) {
+      next += kNumBytesInIpv4;
+      digits = 0;
+      break;
     }
-  }
+    return false;
+  }
+  if (digits > 0) {
+    if (next + 2 > end) return false;
+    *next++ = word >> 8;
+    *next++ = word & 0xff;
+  }
+  if (compressed != nullptr) {
+    // "::" must stand for at least one zero word.
+    if (next == end) return false;
+    const int size = next - compressed;
+    memmove(end - size, compressed, size);
+    memset(compressed, 0, end - size - compressed);
+    next = end;
+  }
+  if (next != end) return false;
+  memcpy(out, result, kNumBytesInIpv6);
   return true;
 }
 
-}  // namespace
+// Returns the number of bytes of a normalized byte string of `bitwidth` bits.
+int NormalizedSize(int bitwidth) {
+  return std::max(0, (bitwidth + static_cast<int>(kNumBitsInByte) - 1) /
+                         static_cast<int>(kNumBitsInByte));
+}
 
-absl::StatusOr<std::string> ArbitraryToNormalizedByteString(
-    const std::string &bytes, int expected_bitwidth) {
-  std::string stripped_value = bytes;
-  // Remove leading zeros
-  stripped_value.erase(0, std::min(stripped_value.find_first_not_of('\x00'),
-                                   stripped_value.size() - 1));
-  int length = GetBitwidthOfByteString(stripped_value);
-  if (length > expected_bitwidth) {
+absl::Status CheckFitsInline(int size) {
+  if (size > InlineByteString::kCapacity) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Bytestring of " << size << " bytes does not fit in "
+           << InlineByteString::kCapacity << " bytes";
+  }
+  return absl::OkStatus();
+}
+
+// Removes the leading zeros of `bytes`, but keeps at least one byte.
+absl::string_view StripLeadingZeros(absl::string_view bytes) {
+  if (bytes.empty()) return bytes;
+  bytes.remove_prefix(
+      std::min(bytes.find_first_not_of('\x00'), bytes.size() - 1));
+  return bytes;
+}
+
+// Writes `bytes` as a normalized byte string of `bitwidth` bits to the
+// NormalizedSize(bitwidth) bytes at `out`.
+absl::Status WriteNormalizedByteString(absl::string_view bytes, int bitwidth,
+                                       char *out) {
+  absl::string_view stripped_value = StripLeadingZeros(bytes);
+  int length = 0;
+  if (!stripped_value.empty()) {
+    length = (static_cast<int>(stripped_value.size()) - 1) * kNumBitsInByte;
+    for (uint8_t msb = stripped_value[0]; msb != 0; msb >>= 1) ++length;
+  }
+  if (length > bitwidth) {
     return gutil::InvalidArgumentErrorBuilder()
            << "Bytestring of length " << length << " bits does not fit in "
-           << expected_bitwidth << " bits";
+           << bitwidth << " bits";
+  }
+
+  const int size = NormalizedSize(bitwidth);
+  // A single zero byte is left of an all-zero value, which may not fit.
+  if (stripped_value.size() > size) {
+    stripped_value.remove_prefix(stripped_value.size() - size);
+  }
+  const int pad = size - static_cast<int>(stripped_value.size());
+  memset(out, 0, pad);
+  memcpy(out + pad, stripped_value.data(), stripped_value.size());
+  return absl::OkStatus();
+}
+
+absl::Status CheckUintBitwidth(int bitwidth) {
+  if (bitwidth <= 0 || bitwidth > 64) {
+    return absl::Status(absl::StatusCode::kInvalidArgument,
+                        absl::StrCat("Cannot convert value with "
+                                     "bitwidth ",
+                                     bitwidth, " to ByteString"));
   }
+  return absl::OkStatus();
+}
 
-  int total_bytes;
-  if (expected_bitwidth % 8) {
-    total_bytes = expected_bitwidth / 8 + 1;
+// Writes `value` as a normalized byte string of `bitwidth` bits to the
+// NormalizedSize(bitwidth) bytes at `out`. The value is first truncated to the
+// smallest unsigned integer type that fits `bitwidth`.
+absl::Status WriteNormalizedUint(uint64_t value, int bitwidth, char *out) {
+  int width;
+  if (bitwidth <= 8) {
+    width = sizeof(uint8_t);
+  } else if (bitwidth <= 16) {
+    width = sizeof(uint16_t);
+  } else if (bitwidth <= 32) {
+    width = sizeof(uint32_t);
   } else {
-    total_bytes = expected_bitwidth / 8;
+    width = sizeof(uint64_t);
+  }
+  const uint64_t nb_value = htobe64(value);  // network byte order
+  absl::string_view bytes(reinterpret_cast<const char *>(&nb_value),
+                          sizeof(nb_value));
+  bytes.remove_prefix(sizeof(nb_value) - width);
+  return WriteNormalizedByteString(bytes, bitwidth, out);
+}
+
+absl::Status CheckEqualLengths(absl::string_view left,
+                               absl::string_view right) {
+  if (left.size() != right.size()) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Cannot find intersection. \"" << absl::CEscape(left) << "\"("
+           << left.size() << " bytes) and \"" << absl::CEscape(right) << "\"("
+           << right.size() << " bytes) are of unequal length";
+  }
+  return absl::OkStatus();
+}
+
+// Writes the bitwise AND of the equally long `left` and `right` to `out`.
+void WriteIntersection(absl::string_view left, absl::string_view right,
+                       char *out) {
+  for (int i = 0; i < left.size(); ++i) {
+    out[i] = left[i] & right[i];
+  }
+}
+
+absl::Status CheckPrefixLen(int prefix_len, int bitwidth) {
+  if (prefix_len > bitwidth) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Prefix length " << prefix_len
+           << " cannot be greater than bitwidth " << bitwidth;
+  }
+  return absl::OkStatus();
+}
+
+// Writes the mask for `prefix_len` as a normalized byte string of `bitwidth`
+// bits to the NormalizedSize(bitwidth) bytes at `out`.
+void WriteMask(int prefix_len, int bitwidth, char *out) {
+  if (bitwidth % 8) {
+    int msb = bitwidth % 8;
+    *out++ = (0xff >> (kNumBitsInByte - msb) & 0xff);
+    prefix_len -= msb;
+    bitwidth -= msb;
+  }
+  for (int i = bitwidth; i > 0; i -= kNumBitsInByte) {
+    if (prefix_len >= (int)kNumBitsInByte) {
+      *out++ = '\xff';
+    } else {
+      if (prefix_len > 0) {
+        *out++ = (0xff << (kNumBitsInByte - prefix_len) & 0xff);
+      } else {
+        *out++ = '\x00';
+      }
+    }
+    prefix_len -= kNumBitsInByte;
+  }
+}
+
+// Returns the IR hex string ("0x" followed by the digits without leading
+// zeros) of the normalized byte string `bytes`.
+std::string ToIrHexString(absl::string_view bytes) {
+  std::string hex_string =
+      ByteStringToHexString(NormalizedToCanonicalByteStringView(bytes));
+  hex_string.erase(2, std::min(hex_string.find_first_not_of('0', 2) - 2,
+                               hex_string.size() - 3));
+  return hex_string;
+}
+
+// Decodes the IR value, which must not have the string format, to a byte
+// string. Values that fit are decoded to `inline_bytes` without allocating
+// memory, others to `heap_bytes`. Points `byte_string` to the result.
+absl::Status DecodeIrValue(const IrValue &ir_value,
+                           InlineByteString *inline_bytes,
+                           std::string *heap_bytes,
+                           absl::string_view *byte_string) {
+  switch (ir_value.format_case()) {
+    case IrValue::kMac: {
+      if (!ParseMac(ir_value.mac(), inline_bytes->Resize(kNumBytesInMac))) {
+        // Produces the error message.
+        return MacToNormalizedByteString(ir_value.mac()).status();
+      }
+      *byte_string = inline_bytes->view();
+      break;
+    }
+    case IrValue::kIpv4: {
+      if (!ParseIpv4(ir_value.ipv4(), inline_bytes->Resize(kNumBytesInIpv4))) {
+        return Ipv4ToNormalizedByteString(ir_value.ipv4()).status();
+      }
+      *byte_string = inline_bytes->view();
+      break;
+    }
+    case IrValue::kIpv6: {
+      if (!ParseIpv6(ir_value.ipv6(), inline_bytes->Resize(kNumBytesInIpv6))) {
+        return Ipv6ToNormalizedByteString(ir_value.ipv6()).status();
+      }
+      *byte_string = inline_bytes->view();
+      break;
+    }
+    case IrValue::kHexStr: {
+      const std::string &hex_str = ir_value.hex_str();
+      if (!absl::StartsWith(hex_str, "0x")) {
+        return gutil::InvalidArgumentErrorBuilder()
+               << "IR Value \"" << hex_str
+               << "\" with hex string format does not start with 0x";
+      }
+      absl::string_view stripped_hex = absl::StripPrefix(hex_str, "0x");
+      const int size = (stripped_hex.size() + 1) / 2;
+      char *out;
+      if (size <= InlineByteString::kCapacity) {
+        out = inline_bytes->Resize(size);
+        *byte_string = inline_bytes->view();
+      } else {
+        heap_bytes->resize(size);
+        out = &(*heap_bytes)[0];
+        *byte_string = *heap_bytes;
+      }
+      if (!HexDigitsToBytes(stripped_hex, out, /*allow_upper_case=*/false)) {
+        return gutil::InvalidArgumentErrorBuilder()
+               << "IR Value \"" << hex_str
+               << "\" contains non-hexadecimal characters";
+      }
+      break;
+    }
+    default: {
+      ASSIGN_OR_RETURN(
+          const std::string format_case_name,
+          gutil::GetOneOfFieldName(ir_value, std::string("format")));
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unexpected format: " << format_case_name;
+    }
   }
-  std::string zeros =
-      std::string(total_bytes - stripped_value.length(), '\x00');
-  return zeros.append(stripped_value);
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<std::string> ArbitraryToNormalizedByteString(
+    absl::string_view bytes, int expected_bitwidth) {
+  std::string normalized(NormalizedSize(expected_bitwidth), '\x00');
+  RETURN_IF_ERROR(
+      WriteNormalizedByteString(bytes, expected_bitwidth, &normalized[0]));
+  return normalized;
+}
+
+absl::Status ArbitraryToNormalizedByteString(absl::string_view bytes,
+                                             int expected_bitwidth,
+                                             InlineByteString *normalized) {
+  const int size = NormalizedSize(expected_bitwidth);
+  RETURN_IF_ERROR(CheckFitsInline(size));
+  return WriteNormalizedByteString(bytes, expected_bitwidth,
+                                   normalized->Resize(size));
 }
 
 absl::StatusOr<uint64_t> ArbitraryByteStringToUint(const std::string &bytes,
@@ -119,8 +507,9 @@ absl::StatusOr<uint64_t> ArbitraryByteStringToUint(const std::string &bytes,
                                      "bitwidth ",
                                      bitwidth, " to uint"));
   }
-  ASSIGN_OR_RETURN(const auto &stripped_value,
-                   ArbitraryToNormalizedByteString(bytes, bitwidth));
+  InlineByteString stripped_value;
+  RETURN_IF_ERROR(
+      ArbitraryToNormalizedByteString(bytes, bitwidth, &stripped_value));
   uint64_t nb_value;  // network byte order
   char value[sizeof(nb_value)];
   const int pad = static_cast<int>(sizeof(nb_value)) -
@@ -136,140 +525,97 @@ absl::StatusOr<uint64_t> ArbitraryByteStringToUint(const std::string &bytes,
 
 absl::StatusOr<std::string> UintToNormalizedByteString(uint64_t value,
                                                        int bitwidth) {
-  if (bitwidth <= 0 || bitwidth > 64) {
-    return absl::Status(absl::StatusCode::kInvalidArgument,
-                        absl::StrCat("Cannot convert value with "
-                                     "bitwidth ",
-                                     bitwidth, " to ByteString"));
-  }
-  std::string bytes = "";
-  if (bitwidth <= 8) {
-    uint8_t tmp = static_cast<uint8_t>(value);
-    bytes.assign(reinterpret_cast<char *>(&tmp), sizeof(uint8_t));
-  } else if (bitwidth <= 16) {
-    uint16_t tmp = htons(static_cast<uint16_t>(value));
-    bytes.assign(reinterpret_cast<char *>(&tmp), sizeof(uint16_t));
-  } else if (bitwidth <= 32) {
-    uint32_t tmp = htonl(static_cast<uint32_t>(value));
-    bytes.assign(reinterpret_cast<char *>(&tmp), sizeof(uint32_t));
-  } else {
-    uint64_t tmp =
-        (htonl(1) == 1)
-            ? value
-            : (static_cast<uint64_t>(htonl(value)) << 32) | htonl(value >> 32);
-    bytes.assign(reinterpret_cast<char *>(&tmp), sizeof(uint64_t));
-  }
-
-  ASSIGN_OR_RETURN(auto normalized_str,
-                   ArbitraryToNormalizedByteString(bytes, bitwidth));
+  RETURN_IF_ERROR(CheckUintBitwidth(bitwidth));
+  std::string normalized(NormalizedSize(bitwidth), '\x00');
+  RETURN_IF_ERROR(WriteNormalizedUint(value, bitwidth, &normalized[0]));
+  return normalized;
+}
 
-  return normalized_str;
+absl::Status UintToNormalizedByteString(uint64_t value, int bitwidth,
+                                        InlineByteString *normalized) {
+  RETURN_IF_ERROR(CheckUintBitwidth(bitwidth));
+  return WriteNormalizedUint(value, bitwidth,
+                             normalized->Resize(NormalizedSize(bitwidth)));
 }
 
 absl::StatusOr<std::string> NormalizedByteStringToMac(
-    const std::string &bytes) {
+    absl::string_view bytes) {
   if (bytes.size() != kNumBytesInMac) {
     return gutil::InvalidArgumentErrorBuilder()
            << "Expected length of input string to be " << kNumBytesInMac
            << ", but got " << bytes.size() << " instead";
   }
-  struct ether_addr byte_string;
-  for (int i = 0; i < bytes.size(); ++i) {
-    byte_string.ether_addr_octet[i] = bytes[i] & 0xFF;
-  }
-  std::string mac = std::string(ether_ntoa(&byte_string));
-  std::vector<std::string> parts = absl::StrSplit(mac, ':');
-  // ether_ntoa returns a string that is not zero padded. Add zero padding.
-  for (int i = 0; i < parts.size(); ++i) {
-    if (parts[i].size() == 1) {
-      parts[i] = absl::StrCat("0", parts[i]);
-    }
-  }
-  return absl::StrJoin(parts, ":");
+  char mac[kMaxMacStringSize];
+  return std::string(mac, WriteMac(bytes.data(), mac));
 }
 
 absl::StatusOr<std::string> MacToNormalizedByteString(const std::string &mac) {
-  if (!IsValidMac(mac)) {
+  std::string bytes(kNumBytesInMac, '\x00');
+  if (!ParseMac(mac, &bytes[0])) {
     return gutil::InvalidArgumentErrorBuilder()
            << "String cannot be parsed as MAC address: " << mac
            << ". It must be of the format xx:xx:xx:xx:xx:xx where x is a lower "
               "case hexadecimal character";
   }
-  struct ether_addr *byte_string = ether_aton(mac.c_str());
-  if (byte_string == nullptr) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "String cannot be parsed as MAC address: " << mac;
-  }
-  return std::string((const char *)byte_string->ether_addr_octet,
-                     sizeof(byte_string->ether_addr_octet));
+  return bytes;
 }
 
 absl::StatusOr<std::string> NormalizedByteStringToIpv4(
-    const std::string &bytes) {
+    absl::string_view bytes) {
   if (bytes.size() != kNumBytesInIpv4) {
     return gutil::InvalidArgumentErrorBuilder()
            << "Expected length of input string to be " << kNumBytesInIpv4
            << ", but got " << bytes.size() << " instead";
   }
-  char result[INET_ADDRSTRLEN];
-  auto result_valid = inet_ntop(AF_INET, bytes.c_str(), result, sizeof(result));
-  if (!result_valid) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "Conversion of IPv4 address to string failed with error code: "
-           << errno;
-  }
-  return std::string(result);
+  char ipv4[kMaxIpv4StringSize];
+  return std::string(ipv4, WriteIpv4(bytes.data(), ipv4));
 }
 
 absl::StatusOr<std::string> Ipv4ToNormalizedByteString(
     const std::string &ipv4) {
-  char ip_addr[kNumBytesInIpv4];
-  if (inet_pton(AF_INET, ipv4.c_str(), &ip_addr) == 0) {
+  std::string bytes(kNumBytesInIpv4, '\x00');
+  if (!ParseIpv4(ipv4, &bytes[0])) {
     return gutil::InvalidArgumentErrorBuilder()
            << "Invalid IPv4 address: " << ipv4;
   }
-  return std::string(ip_addr, kNumBytesInIpv4);
+  return bytes;
 }
 
 absl::StatusOr<std::string> NormalizedByteStringToIpv6(
-    const std::string &bytes) {
+    absl::string_view bytes) {
   if (bytes.size() != kNumBytesInIpv6) {
     return gutil::InvalidArgumentErrorBuilder()
            << "Expected length of input string to be " << kNumBytesInIpv6
            << ", but got " << bytes.size() << " instead";
   }
-  char result[INET6_ADDRSTRLEN];
-  auto result_valid =
-      inet_ntop(AF_INET6, bytes.c_str(), result, sizeof(result));
-  if (!result_valid) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "Conversion of IPv6 address to string failed with error code: "
-           << errno;
-  }
-  return std::string(result);
+  char ipv6[kMaxIpv6StringSize];
+  return std::string(ipv6, WriteIpv6(bytes.data(), ipv6));
 }
 
 absl::StatusOr<std::string> Ipv6ToNormalizedByteString(
     const std::string &ipv6) {
-  if (!IsValidIpv6(ipv6)) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "String cannot be parsed as an IPv6 address. It must contain "
-              "lower case hexadecimal characters";
-  }
-  char ip6_addr[kNumBytesInIpv6];
-  if (inet_pton(AF_INET6, ipv6.c_str(), &ip6_addr) == 0) {
+  std::string bytes(kNumBytesInIpv6, '\x00');
+  if (!ParseIpv6(ipv6, &bytes[0])) {
+    if (!std::all_of(ipv6.begin(), ipv6.end(), [](const char c) {
+          return HexDigitValue(c) >= 0 || c == ':' || c == '.';
+        })) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "String cannot be parsed as an IPv6 address. It must contain "
+                "lower case hexadecimal characters";
+    }
     return gutil::InvalidArgumentErrorBuilder()
            << "Invalid IPv6 address: " << ipv6;
   }
-  return std::string(ip6_addr, kNumBytesInIpv6);
+  return bytes;
 }
 
 std::string NormalizedToCanonicalByteString(std::string bytes) {
+  return std::string(NormalizedToCanonicalByteStringView(bytes));
+}
+
+absl::string_view NormalizedToCanonicalByteStringView(absl::string_view bytes) {
   // Remove leading zeros
-  std::string canonical = bytes;
-  canonical.erase(
-      0, std::min(canonical.find_first_not_of('\x00'), canonical.size() - 1));
-  return canonical;
+  return StripLeadingZeros(bytes);
 }
 
 uint32_t GetBitwidthOfByteString(const std::string &input_string) {
@@ -328,12 +674,22 @@ absl::StatusOr<Format> GetFormat(const std::vector<std::string> &annotations,
 
 absl::StatusOr<IrValue> ArbitraryByteStringToIrValue(const Format &format,
                                                      const int bitwidth,
-                                                     const std::string &bytes) {
+                                                     absl::string_view bytes) {
   IrValue result;
-  std::string normalized_bytes;
+  // Values that fit are normalized without allocating memory.
+  InlineByteString inline_bytes;
+  std::string heap_bytes;
+  absl::string_view normalized_bytes;
   if (format != Format::STRING) {
-    ASSIGN_OR_RETURN(normalized_bytes,
-                     ArbitraryToNormalizedByteString(bytes, bitwidth));
+    if (NormalizedSize(bitwidth) <= InlineByteString::kCapacity) {
+      RETURN_IF_ERROR(
+          ArbitraryToNormalizedByteString(bytes, bitwidth, &inline_bytes));
+      normalized_bytes = inline_bytes.view();
+    } else {
+      ASSIGN_OR_RETURN(heap_bytes,
+                       ArbitraryToNormalizedByteString(bytes, bitwidth));
+      normalized_bytes = heap_bytes;
+    }
   }
   switch (format) {
     case Format::MAC: {
@@ -352,15 +708,11 @@ absl::StatusOr<IrValue> ArbitraryByteStringToIrValue(const Format &format,
       break;
     }
     case Format::STRING: {
-      result.set_str(bytes);
+      result.set_str(bytes.data(), bytes.size());
       break;
     }
     case Format::HEX_STRING: {
-      auto hex_string = absl::BytesToHexString(
-          NormalizedToCanonicalByteString(normalized_bytes));
-      hex_string.erase(0, std::min(hex_string.find_first_not_of('0'),
-                                   hex_string.size() - 1));
-      result.set_hex_str(absl::StrCat("0x", hex_string));
+      result.set_hex_str(ToIrHexString(normalized_bytes));
       break;
     }
     default:
@@ -430,66 +782,37 @@ absl::Status ValidateIrValueFormat(const IrValue &ir_value,
 
 absl::StatusOr<std::string> IrValueToNormalizedByteString(
     const IrValue &ir_value, const int bitwidth) {
-  std::string byte_string;
-  const auto &format_case = ir_value.format_case();
-  ASSIGN_OR_RETURN(const std::string format_case_name,
-                   gutil::GetOneOfFieldName(ir_value, std::string("format")));
-  switch (format_case) {
-    case IrValue::kMac: {
-      ASSIGN_OR_RETURN(byte_string, MacToNormalizedByteString(ir_value.mac()));
-      break;
-    }
-    case IrValue::kIpv4: {
-      ASSIGN_OR_RETURN(byte_string,
-                       Ipv4ToNormalizedByteString(ir_value.ipv4()));
-      break;
-    }
-    case IrValue::kIpv6: {
-      ASSIGN_OR_RETURN(byte_string,
-                       Ipv6ToNormalizedByteString(ir_value.ipv6()));
-      break;
-    }
-    case IrValue::kStr: {
-      byte_string = ir_value.str();
-      break;
-    }
-    case IrValue::kHexStr: {
-      const std::string &hex_str = ir_value.hex_str();
-      if (!absl::StartsWith(hex_str, "0x")) {
-        return gutil::InvalidArgumentErrorBuilder()
-               << "IR Value \"" << hex_str
-               << "\" with hex string format does not start with 0x";
-      }
-      absl::string_view stripped_hex = absl::StripPrefix(hex_str, "0x");
-      if (!std::all_of(stripped_hex.begin(), stripped_hex.end(),
-                       [](const char c) {
-                         return std::isxdigit(c) != 0 && c == std::tolower(c);
-                       })) {
-        return gutil::InvalidArgumentErrorBuilder()
-               << "IR Value \"" << hex_str
-               << "\" contains non-hexadecimal characters";
-      }
-
-      if (stripped_hex.size() % 2) {
-        byte_string = absl::HexStringToBytes(absl::StrCat("0", stripped_hex));
-      } else {
-        byte_string = absl::HexStringToBytes(stripped_hex);
-      }
-      break;
-    }
-    default:
-      return gutil::InvalidArgumentErrorBuilder()
-             << "Unexpected format: " << format_case_name;
-  }
-
-  std::string result = byte_string;
-  if (format_case != IrValue::kStr) {
-    ASSIGN_OR_RETURN(result,
-                     ArbitraryToNormalizedByteString(byte_string, bitwidth));
-  }
+  if (ir_value.format_case() == IrValue::kStr) return ir_value.str();
+  InlineByteString inline_bytes;
+  std::string heap_bytes;
+  absl::string_view byte_string;
+  RETURN_IF_ERROR(
+      DecodeIrValue(ir_value, &inline_bytes, &heap_bytes, &byte_string));
+  std::string result(NormalizedSize(bitwidth), '\x00');
+  RETURN_IF_ERROR(WriteNormalizedByteString(byte_string, bitwidth, &result[0]));
   return result;
 }
 
+absl::Status IrValueToNormalizedByteString(const IrValue &ir_value,
+                                           int bitwidth,
+                                           InlineByteString *normalized) {
+  if (ir_value.format_case() == IrValue::kStr) {
+    const std::string &str = ir_value.str();
+    RETURN_IF_ERROR(CheckFitsInline(str.size()));
+    memcpy(normalized->Resize(str.size()), str.data(), str.size());
+    return absl::OkStatus();
+  }
+  InlineByteString inline_bytes;
+  std::string heap_bytes;
+  absl::string_view byte_string;
+  RETURN_IF_ERROR(
+      DecodeIrValue(ir_value, &inline_bytes, &heap_bytes, &byte_string));
+  const int size = NormalizedSize(bitwidth);
+  RETURN_IF_ERROR(CheckFitsInline(size));
+  return WriteNormalizedByteString(byte_string, bitwidth,
+                                   normalized->Resize(size));
+}
+
 absl::StatusOr<IrValue> FormattedStringToIrValue(const std::string &value,
                                                  Format format) {
   IrValue result;
@@ -549,50 +872,36 @@ bool IsAllZeros(const std::string &s) {
 
 absl::StatusOr<std::string> Intersection(const std::string &left,
                                          const std::string &right) {
-  if (left.size() != right.size()) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "Cannot find intersection. \"" << absl::CEscape(left) << "\"("
-           << left.size() << " bytes) and \"" << absl::CEscape(right) << "\"("
-           << right.size() << " bytes) are of unequal length";
-  }
-  std::string result = "";
-  for (int i = 0; i < left.size(); ++i) {
-    char left_c = left[i];
-    char right_c = right[i];
-    result += (left_c & right_c);
-  }
+  RETURN_IF_ERROR(CheckEqualLengths(left, right));
+  std::string result(left.size(), '\x00');
+  WriteIntersection(left, right, &result[0]);
   return result;
 }
 
-absl::StatusOr<std::string> PrefixLenToMask(int prefix_len, int bitwidth) {
-  if (prefix_len > bitwidth) {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "Prefix length " << prefix_len
-           << " cannot be greater than bitwidth " << bitwidth;
-  }
+absl::Status Intersection(absl::string_view left, absl::string_view right,
+                          InlineByteString *intersection) {
+  RETURN_IF_ERROR(CheckEqualLengths(left, right));
+  RETURN_IF_ERROR(CheckFitsInline(left.size()));
+  WriteIntersection(left, right, intersection->Resize(left.size()));
+  return absl::OkStatus();
+}
 
-  std::string result;
-  if (bitwidth % 8) {
-    int msb = bitwidth % 8;
-    result += (0xff >> (kNumBitsInByte - msb) & 0xff);
-    prefix_len -= msb;
-    bitwidth -= msb;
-  }
-  for (int i = bitwidth; i > 0; i -= kNumBitsInByte) {
-    if (prefix_len >= (int)kNumBitsInByte) {
-      result += '\xff';
-    } else {
-      if (prefix_len > 0) {
-        result += (0xff << (kNumBitsInByte - prefix_len) & 0xff);
-      } else {
-        result += '\x00';
-      }
-    }
-    prefix_len -= kNumBitsInByte;
-  }
+absl::StatusOr<std::string> PrefixLenToMask(int prefix_len, int bitwidth) {
+  RETURN_IF_ERROR(CheckPrefixLen(prefix_len, bitwidth));
+  std::string result(NormalizedSize(bitwidth), '\x00');
+  WriteMask(prefix_len, bitwidth, &result[0]);
   return result;
 }
 
+absl::Status PrefixLenToMask(int prefix_len, int bitwidth,
+                             InlineByteString *mask) {
+  RETURN_IF_ERROR(CheckPrefixLen(prefix_len, bitwidth));
+  const int size = NormalizedSize(bitwidth);
+  RETURN_IF_ERROR(CheckFitsInline(size));
+  WriteMask(prefix_len, bitwidth, mask->Resize(size));
+  return absl::OkStatus();
+}
+
 bool RequiresPriority(const IrTableDefinition &ir_table_definition) {
   const auto &matches = ir_table_definition.match_fields_by_name();
   for (auto it = matches.begin(); it != matches.end(); it++) {
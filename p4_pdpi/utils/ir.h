@@ -22,6 +22,7 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "google/rpc/code.pb.h"
 #include "gutil/status.h"
 #include "p4_pdpi/ir.pb.h"
@@ -56,6 +57,41 @@ const uint32_t kNumBytesInIpv4 = kNumBitsInIpv4 / kNumBitsInByte;
 const uint32_t kNumBitsInIpv6 = 128;
 const uint32_t kNumBytesInIpv6 = kNumBitsInIpv6 / kNumBitsInByte;
 
+// A byte string of at most kCapacity bytes, stored inline. Values of the common
+// bitwidths (up to IPv6 addresses) fit, so the InlineByteString variants of the
+// functions below convert them without allocating memory.
+class InlineByteString {
+ public:
+  static constexpr int kCapacity = kNumBytesInIpv6;
+
+  InlineByteString() = default;
+
+  const char* data() const { return data_; }
+  int size() const { return size_; }
+  absl::string_view view() const { return absl::string_view(data_, size_); }
+  std::string ToString() const { return std::string(data_, size_); }
+
+  // Sets the size to `size` bytes, which must be at most kCapacity, and returns
+  // the (uninitialized) bytes.
+  char* Resize(int size) {
+    size_ = size;
+    return data_;
+  }
+
+  friend bool operator==(const InlineByteString& left,
+                         const InlineByteString& right) {
+    return left.view() == right.view();
+  }
+  friend bool operator!=(const InlineByteString& left,
+                         const InlineByteString& right) {
+    return !(left == right);
+  }
+
+ private:
+  char data_[kCapacity];
+  int size_ = 0;
+};
+
 // Returns the format for value, given the annotations on it, it's bitwidth
 // and named type (if any).
 absl::StatusOr<Format> GetFormat(const std::vector<std::string> &annotations,
@@ -69,11 +105,16 @@ absl::Status ValidateIrValueFormat(const IrValue &ir_value,
 // Converts the IR value to a PI byte string and returns it.
 absl::StatusOr<std::string> IrValueToNormalizedByteString(
     const IrValue &ir_value, const int bitwidth);
+// Same as above, but writes the result to `normalized`. Returns an error if the
+// result does not fit in an InlineByteString.
+absl::Status IrValueToNormalizedByteString(const IrValue& ir_value,
+                                           int bitwidth,
+                                           InlineByteString* normalized);
 
 // Converts the PI value to an IR value and returns it.
 absl::StatusOr<IrValue> ArbitraryByteStringToIrValue(const Format &format,
                                                      const int bitwidth,
-                                                     const std::string &bytes);
+                                                     absl::string_view bytes);
 
 // Returns an IrValue based on a string value and a format. The value is
 // expected to already be formatted correctly, and is just copied to the correct
@@ -88,7 +129,12 @@ absl::StatusOr<std::string> IrValueToFormattedString(const IrValue &value,
 
 // Returns a string of length ceil(expected_bitwidth/8).
 absl::StatusOr<std::string> ArbitraryToNormalizedByteString(
-    const std::string &bytes, int expected_bitwidth);
+    absl::string_view bytes, int expected_bitwidth);
+// Same as above, but writes the result to `normalized`. Returns an error if the
+// result does not fit in an InlineByteString.
+absl::Status ArbitraryToNormalizedByteString(absl::string_view bytes,
+                                             int expected_bitwidth,
+                                             InlineByteString* normalized);
 
 // Convert the given byte string into a uint value.
 absl::StatusOr<uint64_t> ArbitraryByteStringToUint(const std::string &bytes,
@@ -97,10 +143,14 @@ absl::StatusOr<uint64_t> ArbitraryByteStringToUint(const std::string &bytes,
 // Convert the given uint to byte string.
 absl::StatusOr<std::string> UintToNormalizedByteString(uint64_t value,
                                                        int bitwidth);
+// Same as above, but writes the result to `normalized`.
+absl::Status UintToNormalizedByteString(uint64_t value, int bitwidth,
+                                        InlineByteString* normalized);
 
 // Convert the given byte string into a : separated MAC representation.
 // Input string should be 6 bytes long.
-absl::StatusOr<std::string> NormalizedByteStringToMac(const std::string &bytes);
+absl::StatusOr<std::string> NormalizedByteStringToMac(
+    absl::string_view bytes);
 
 // Convert the given : separated MAC representation into a byte string.
 absl::StatusOr<std::string> MacToNormalizedByteString(const std::string &mac);
@@ -108,7 +158,7 @@ absl::StatusOr<std::string> MacToNormalizedByteString(const std::string &mac);
 // Convert the given byte string into a . separated IPv4 representation.
 // Input should be 4 bytes long.
 absl::StatusOr<std::string> NormalizedByteStringToIpv4(
-    const std::string &bytes);
+    absl::string_view bytes);
 
 // Convert the given . separated IPv4 representation into a byte string.
 absl::StatusOr<std::string> Ipv4ToNormalizedByteString(const std::string &ipv4);
@@ -116,13 +166,16 @@ absl::StatusOr<std::string> Ipv4ToNormalizedByteString(const std::string &ipv4);
 // Convert the given byte string into a : separated IPv6 representation.
 // Input should be 16 bytes long.
 absl::StatusOr<std::string> NormalizedByteStringToIpv6(
-    const std::string &bytes);
+    absl::string_view bytes);
 
 // Convert the given : separated IPv6 representation into a byte string.
 absl::StatusOr<std::string> Ipv6ToNormalizedByteString(const std::string &ipv6);
 
 // Convert a normalized byte string to its canonical form.
 std::string NormalizedToCanonicalByteString(std::string bytes);
+// Same as above, but returns the canonical form as a view into `bytes`, which
+// needs no copy since it is a suffix of the normalized form.
+absl::string_view NormalizedToCanonicalByteStringView(absl::string_view bytes);
 
 // Returns the number of bits used by the PI byte string interpreted as an
 // unsigned integer.
@@ -134,9 +187,17 @@ bool IsAllZeros(const std::string &s);
 // Returns the intersection of two (normalized) byte strings.
 absl::StatusOr<std::string> Intersection(const std::string &left,
                                          const std::string &right);
+// Same as above, but writes the result to `intersection`. Returns an error if
+// the result does not fit in an InlineByteString.
+absl::Status Intersection(absl::string_view left, absl::string_view right,
+                          InlineByteString* intersection);
 
 // Returns the (normalized) mask for a given prefix length.
 absl::StatusOr<std::string> PrefixLenToMask(int prefix_len, int bitwidth);
+// Same as above, but writes the result to `mask`. Returns an error if the
+// result does not fit in an InlineByteString.
+absl::Status PrefixLenToMask(int prefix_len, int bitwidth,
+                             InlineByteString* mask);
 
 bool RequiresPriority(const IrTableDefinition &ir_table_definition);
 
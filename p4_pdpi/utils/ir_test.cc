@@ -14,7 +14,10 @@
 
 #include "p4_pdpi/utils/ir.h"
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
 #include <stdint.h>
+#include <sys/socket.h>
 
 #include <string>
 #include <tuple>
@@ -393,6 +396,71 @@ TEST(Ipv6ToNormalizedByteStringTest, InvalidIpv6) {
             absl::StatusCode::kInvalidArgument);
 }
 
+// The address formatters and parsers are hand-written; check that they agree
+// with libc.
+
+TEST(NormalizedByteStringToIpv4Test, MatchesInetNtop) {
+  for (int value = 0; value < 256; ++value) {
+    const std::string bytes = {static_cast<char>(value), 0, 1,
+                               static_cast<char>(255 - value)};
+    char expected[INET_ADDRSTRLEN];
+    ASSERT_NE(inet_ntop(AF_INET, bytes.data(), expected, sizeof(expected)),
+              nullptr);
+    ASSERT_OK_AND_ASSIGN(auto actual, NormalizedByteStringToIpv4(bytes));
+    EXPECT_EQ(actual, expected);
+  }
+}
+
+TEST(NormalizedByteStringToIpv6Test, MatchesInetNtop) {
+  // All combinations of zero and non-zero words, which covers all runs of
+  // zeros that can be compressed.
+  for (int non_zero_words = 0; non_zero_words < 256; ++non_zero_words) {
+    for (const uint16_t word : {0x0001, 0x00f0, 0x0abc, 0xffff}) {
+      std::string bytes(kNumBytesInIpv6, '\x00');
+      for (int i = 0; i < 8; ++i) {
+        if (non_zero_words & (1 << i)) {
+          bytes[2 * i] = word >> 8;
+          bytes[2 * i + 1] = word & 0xff;
+        }
+      }
+      char expected[INET6_ADDRSTRLEN];
+      ASSERT_NE(inet_ntop(AF_INET6, bytes.data(), expected, sizeof(expected)),
+                nullptr);
+      ASSERT_OK_AND_ASSIGN(auto actual, NormalizedByteStringToIpv6(bytes));
+      EXPECT_EQ(actual, expected);
+    }
+  }
+}
+
+TEST(Ipv4ToNormalizedByteStringTest, MatchesInetPton) {
+  for (const std::string ipv4 :
+       {"0.0.0.0", "255.255.255.255", "10.0.12.1", "1.2.3", "1.2.3.4.",
+        ".1.2.3.4", "1.2.3.4.5", "256.1.1.1", "01.2.3.4", "1.2.3.00",
+        "1.2.3.4 ", "1.2..4", "", "a.b.c.d", "1.2.3.-4"}) {
+    char expected[kNumBytesInIpv4];
+    const bool valid = inet_pton(AF_INET, ipv4.c_str(), expected) == 1;
+    const auto actual = Ipv4ToNormalizedByteString(ipv4);
+    ASSERT_EQ(actual.ok(), valid) << ipv4;
+    if (valid) EXPECT_EQ(*actual, std::string(expected, kNumBytesInIpv4));
+  }
+}
+
+TEST(Ipv6ToNormalizedByteStringTest, MatchesInetPton) {
+  for (const std::string ipv6 :
+       {"::", "::1", "1::", "1:2:3:4:5:6:7:8", "1:2:3:4:5:6:7::",
+        "::2:3:4:5:6:7:8", "1:2:3:4:5:6:7:8:9", "1:2:3:4:5:6:7:8::",
+        ":1:2:3:4:5:6:7:8", "1:2:3:4:5:6:7:", "1::2::3", ":::", "12345::",
+        "0001:02:003::", "::ffff:1.2.3.4", "::1.2.3.4", "1:2:3:4:5:6:1.2.3.4",
+        "1:2:3:4:5:6:7:1.2.3.4", "::1.2.3", "::1.2.3.4.5", "::1.2.3.04",
+        "1.2.3.4", "::1.2.3.4:1", "", ":", "abcd:ef01::", "::ab.1.2.3"}) {
+    char expected[kNumBytesInIpv6];
+    const bool valid = inet_pton(AF_INET6, ipv6.c_str(), expected) == 1;
+    const auto actual = Ipv6ToNormalizedByteString(ipv6);
+    ASSERT_EQ(actual.ok(), valid) << ipv6;
+    if (valid) EXPECT_EQ(*actual, std::string(expected, kNumBytesInIpv6));
+  }
+}
+
 TEST(GetFormatTest, MacAnnotationPass) {
   std::vector<std::string> annotations = {"@format(MAC_ADDRESS)"};
   ASSERT_OK_AND_ASSIGN(auto format, GetFormat(annotations, kNumBitsInMac,
@@ -521,4 +589,94 @@ TEST(PrefixLenToMaskTest, GenericValueTest) {
   EXPECT_EQ(result, expected);
 }
 
+TEST(InlineByteStringTest, ArbitraryToNormalizedByteStringMatchesString) {
+  for (const auto& [bytes, bitwidth] :
+       std::vector<std::tuple<std::string, int>>{
+           {std::string("\x00\x00\x01", 3), 1},
+           {std::string("\x00", 1), 9},
+           {"\x12\x34", 13},
+           {std::string(16, '\xff'), 128},
+       }) {
+    ASSERT_OK_AND_ASSIGN(const std::string expected,
+                         ArbitraryToNormalizedByteString(bytes, bitwidth));
+    InlineByteString actual;
+    ASSERT_OK(ArbitraryToNormalizedByteString(bytes, bitwidth, &actual));
+    EXPECT_EQ(actual.view(), expected);
+  }
+}
+
+TEST(InlineByteStringTest, ArbitraryToNormalizedByteStringTooLong) {
+  InlineByteString result;
+  EXPECT_EQ(ArbitraryToNormalizedByteString("\x12\x34", 12, &result).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(ArbitraryToNormalizedByteString("\x01", 129, &result).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(InlineByteStringTest, IrValueToNormalizedByteStringMatchesString) {
+  std::vector<std::tuple<IrValue, int>> values(5);
+  std::get<0>(values[0]).set_mac("01:02:03:04:05:06");
+  std::get<1>(values[0]) = 48;
+  std::get<0>(values[1]).set_ipv4("10.0.0.1");
+  std::get<1>(values[1]) = 32;
+  std::get<0>(values[2]).set_ipv6("2001:db8::1");
+  std::get<1>(values[2]) = 128;
+  std::get<0>(values[3]).set_hex_str("0x0abc");
+  std::get<1>(values[3]) = 12;
+  std::get<0>(values[4]).set_str("abc");
+  for (const auto& [value, bitwidth] : values) {
+    ASSERT_OK_AND_ASSIGN(const std::string expected,
+                         IrValueToNormalizedByteString(value, bitwidth));
+    InlineByteString actual;
+    ASSERT_OK(IrValueToNormalizedByteString(value, bitwidth, &actual));
+    EXPECT_EQ(actual.view(), expected);
+  }
+}
+
+TEST(InlineByteStringTest, IrValueToNormalizedByteStringErrors) {
+  InlineByteString result;
+  IrValue value;
+  value.set_ipv4("10.0.0");
+  EXPECT_EQ(IrValueToNormalizedByteString(value, 32, &result).code(),
+            absl::StatusCode::kInvalidArgument);
+  value.set_hex_str("0x1ff");
+  EXPECT_EQ(IrValueToNormalizedByteString(value, 8, &result).code(),
+            absl::StatusCode::kInvalidArgument);
+  value.set_hex_str("0x1");
+  EXPECT_EQ(IrValueToNormalizedByteString(value, 129, &result).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_FALSE(IrValueToNormalizedByteString(IrValue(), 8, &result).ok());
+}
+
+TEST(InlineByteStringTest, UintToNormalizedByteString) {
+  InlineByteString result;
+  ASSERT_OK(UintToNormalizedByteString(0x1122, 13, &result));
+  EXPECT_EQ(result.view(), std::string("\x11\x22"));
+  EXPECT_EQ(UintToNormalizedByteString(1, 65, &result).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(InlineByteStringTest, NormalizedToCanonicalByteStringView) {
+  EXPECT_EQ(NormalizedToCanonicalByteStringView(std::string("\x00\x01\x00", 3)),
+            std::string("\x01\x00", 2));
+  EXPECT_EQ(NormalizedToCanonicalByteStringView(std::string("\x00\x00", 2)),
+            std::string("\x00", 1));
+}
+
+TEST(InlineByteStringTest, Intersection) {
+  InlineByteString result;
+  ASSERT_OK(Intersection("\x41\x42\x43", "\xff\x0f\xf0", &result));
+  EXPECT_EQ(result.view(), "\x41\x02\x40");
+  EXPECT_EQ(Intersection("\x41", "\x41\x42", &result).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(InlineByteStringTest, PrefixLenToMask) {
+  InlineByteString result;
+  ASSERT_OK(PrefixLenToMask(23, 33, &result));
+  EXPECT_EQ(result.view(), std::string("\x01\xff\xff\xfc\x00", 5));
+  EXPECT_EQ(PrefixLenToMask(33, 32, &result).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
 }  // namespace pdpi
@@ -40,6 +40,13 @@ def p4_pdpi_deps():
             remote = "https://github.com/googleapis/googleapis",
             shallow_since = "1591402163 -0700",
         )
+    if not native.existing_rule("com_github_google_benchmark"):
+        http_archive(
+            name = "com_github_google_benchmark",
+            url = "https://github.com/google/benchmark/archive/v1.5.2.tar.gz",
+            strip_prefix = "benchmark-1.5.2",
+            sha256 = "dccbdab796baa1043f04982147e67bb6e118fe610da2c65f88912d73987e700c",
+        )
     if not native.existing_rule("com_github_google_glog"):
         http_archive(
             name = "com_github_google_glog",